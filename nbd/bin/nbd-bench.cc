@@ -0,0 +1,341 @@
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/range/adaptor/transformed.hpp>
+
+#include <elle/das/cli.hh>
+#include <elle/das/named.hh>
+#include <elle/nbd/Server.hh>
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/network/TCPSocket.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/sleep.hh>
+
+using boost::adaptors::transformed;
+using boost::endian::endian_reverse;
+
+ELLE_DAS_SYMBOL(concurrency);
+ELLE_DAS_SYMBOL(help);
+ELLE_DAS_SYMBOL(latency);
+ELLE_DAS_SYMBOL(operations);
+ELLE_DAS_SYMBOL(size);
+ELLE_DAS_SYMBOL(structured);
+
+ELLE_LOG_COMPONENT("nbd-bench");
+
+/// A device in memory, optionally emulating the latency of actual storage.
+class MemoryDevice
+  : public elle::nbd::Server::Device
+{
+public:
+  using Super = elle::nbd::Server::Device;
+  MemoryDevice(std::size_t size, elle::Duration latency)
+    : Super("memory", size)
+    , _data(size)
+    , _latency(latency)
+  {
+    std::memset(this->_data.mutable_contents(), 0, size);
+  }
+
+  elle::Buffer
+  read(uint64_t offset, uint32_t length) override
+  {
+    this->_wait();
+    return elle::Buffer(this->_data.contents() + offset, length);
+  }
+
+  void
+  write(uint64_t offset, elle::Buffer data) override
+  {
+    this->_wait();
+    std::memcpy(this->_data.mutable_contents() + offset,
+                data.contents(), data.size());
+  }
+
+  void
+  write_zeroes(uint64_t offset, uint32_t length) override
+  {
+    this->_wait();
+    std::memset(this->_data.mutable_contents() + offset, 0, length);
+  }
+
+  void
+  sync() override
+  {}
+
+private:
+  void
+  _wait()
+  {
+    if (this->_latency != elle::Duration::zero())
+      elle::reactor::sleep(this->_latency);
+  }
+
+  ELLE_ATTRIBUTE(elle::Buffer, data);
+  ELLE_ATTRIBUTE(elle::Duration, latency);
+};
+
+static
+void
+put_16(elle::Buffer& buffer, uint16_t i)
+{
+  i = endian_reverse(i);
+  buffer.append(&i, sizeof i);
+}
+
+static
+void
+put_32(elle::Buffer& buffer, uint32_t i)
+{
+  i = endian_reverse(i);
+  buffer.append(&i, sizeof i);
+}
+
+static
+void
+put_64(elle::Buffer& buffer, uint64_t i)
+{
+  i = endian_reverse(i);
+  buffer.append(&i, sizeof i);
+}
+
+template <typename T>
+static
+T
+get(elle::reactor::network::Socket& sock)
+{
+  auto data = sock.read(sizeof(T));
+  T res;
+  std::memcpy(&res, data.contents(), sizeof(T));
+  return endian_reverse(res);
+}
+
+/// Minimal NBD client keeping several commands in flight.
+class Client
+{
+public:
+  Client(int port, bool structured)
+    : _sock("127.0.0.1", port)
+    , _structured(structured)
+    , _handle(0)
+  {
+    auto& sock = this->_sock;
+    auto const greeting = sock.read(16);
+    if (greeting != elle::ConstWeakBuffer("NBDMAGICIHAVEOPT"))
+      elle::err("invalid server greeting");
+    get<uint16_t>(sock);
+    // Fixed newstyle, no zeroes.
+    sock.write(endian_reverse(uint32_t(3)));
+    auto const option = [&] (uint32_t option, std::string const& data)
+      {
+        auto request = elle::Buffer("IHAVEOPT");
+        put_32(request, option);
+        put_32(request, data.size());
+        request.append(data.data(), data.size());
+        sock.write(request);
+      };
+    if (structured)
+    {
+      option(8, "");
+      get<uint64_t>(sock);
+      get<uint32_t>(sock);
+      auto const reply = get<uint32_t>(sock);
+      sock.read(get<uint32_t>(sock));
+      if (reply != 1)
+        elle::err("server refused structured replies: {:x}", reply);
+    }
+    option(1, "memory");
+    get<uint64_t>(sock);
+    get<uint16_t>(sock);
+  }
+
+  /// Read or write 4 KiB at @a offset and wait for the reply.
+  void
+  run(bool write, uint64_t offset, elle::ConstWeakBuffer data)
+  {
+    auto const handle = ++this->_handle;
+    auto request = elle::Buffer();
+    put_32(request, 0x25609513);
+    put_16(request, 0);
+    put_16(request, write ? 1 : 0);
+    request.append(&handle, sizeof handle);
+    put_64(request, offset);
+    put_32(request, data.size());
+    if (write)
+      request.append(data.contents(), data.size());
+    auto& pending = this->_pending[handle];
+    pending.length = write ? 0 : data.size();
+    this->_sock.write(request);
+    elle::reactor::wait(pending.done);
+    this->_pending.erase(handle);
+  }
+
+  /// Dispatch replies to the commands waiting for them.
+  void
+  receive()
+  {
+    auto& sock = this->_sock;
+    while (true)
+    {
+      auto const magic = get<uint32_t>(sock);
+      auto done = true;
+      auto error = uint32_t(0);
+      uint64_t handle;
+      if (magic == 0x67446698)
+      {
+        error = get<uint32_t>(sock);
+        sock.read(elle::WeakBuffer(&handle, sizeof handle));
+        auto const length = this->_pending.at(handle).length;
+        if (!error && length)
+          sock.read(length);
+      }
+      else if (magic == 0x668e33ef)
+      {
+        done = get<uint16_t>(sock) & 1;
+        auto const type = get<uint16_t>(sock);
+        sock.read(elle::WeakBuffer(&handle, sizeof handle));
+        sock.read(get<uint32_t>(sock));
+        if (type & (1 << 15))
+          error = type;
+      }
+      else
+        elle::err("invalid reply magic: {:x}", magic);
+      if (error)
+        elle::err("command {} failed: {}", handle, error);
+      if (done)
+        this->_pending.at(handle).done.open();
+    }
+  }
+
+private:
+  struct Pending
+  {
+    uint32_t length;
+    elle::reactor::Barrier done;
+  };
+  ELLE_ATTRIBUTE(elle::reactor::network::TCPSocket, sock);
+  ELLE_ATTRIBUTE(bool, structured);
+  ELLE_ATTRIBUTE(uint64_t, handle);
+  ELLE_ATTRIBUTE((std::unordered_map<uint64_t, Pending>), pending);
+};
+
+/// Drive random 4 KiB reads and writes at increasing queue depths against an
+/// in-memory device served on the loopback interface, and print the IOPS.
+static
+void
+_nbd_bench(int operations,
+           std::size_t size,
+           int concurrency,
+           int latency,
+           bool structured)
+{
+  MemoryDevice device(size, std::chrono::microseconds(latency));
+  elle::nbd::Server server(boost::asio::ip::address_v4::loopback(), 0);
+  server.concurrency(concurrency);
+  server.add(device);
+  elle::reactor::Barrier listening;
+  int port = 0;
+  server.listening().connect(
+    [&] (int p)
+    {
+      port = p;
+      listening.open();
+    });
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+  {
+    scope.run_background("server", [&] { server.run(); });
+    elle::reactor::wait(listening);
+    for (auto depth: {1, 32, 128})
+    {
+      Client client(port, structured);
+      auto const block = std::size_t(4096);
+      auto data = elle::Buffer(block);
+      std::memset(data.mutable_contents(), 'x', block);
+      auto const start = std::chrono::steady_clock::now();
+      elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+      {
+        auto& receiver =
+          s.run_background("receive", [&] { client.receive(); });
+        auto remaining = operations;
+        elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& q)
+        {
+          for (int i = 0; i < depth; ++i)
+            q.run_background(
+              elle::print("queue {}", i),
+              [&, i]
+              {
+                auto random = std::minstd_rand(i);
+                auto blocks =
+                  std::uniform_int_distribution<uint64_t>(0, size / block - 1);
+                while (remaining > 0)
+                {
+                  --remaining;
+                  client.run(random() % 2, blocks(random) * block, data);
+                }
+              });
+        };
+        receiver.terminate_now();
+      };
+      auto const elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+      elle::print(std::cout, "queue depth {}: {} IOPS\n",
+                  depth, int(operations / elapsed.count()));
+    }
+    scope.terminate_now();
+  };
+}
+
+auto const nbd_bench = elle::das::named::function(
+  _nbd_bench,
+  operations = 100000,
+  size = 256 * 1024 * 1024,
+  concurrency = 128,
+  latency = 0,
+  structured = true);
+
+int main(int argc, char** argv)
+{
+  auto const proto = nbd_bench.prototype().extend(help = false);
+  elle::reactor::Scheduler sched;
+  elle::reactor::Thread main(
+    sched, "nbd-bench",
+    [&]
+    {
+      auto opts = elle::das::cli::Options{
+        {"operations", {'n', "Operations per queue depth"}},
+        {"size", {'s', "Size of the device in bytes"}},
+        {"concurrency", {'c', "Commands processed concurrently by the server"}},
+        {"latency", {'l', "Emulated device latency in microseconds"}},
+        {"structured", {'S', "Negotiate structured replies"}},
+      };
+      elle::das::cli::call(
+        proto,
+        [&] (bool help, auto&& ... rest) -> void
+        {
+          if (help)
+             elle::print(std::cout,
+                         "{}: benchmark the NBD server over loopback.\n{}",
+                         argv[0],
+                         elle::das::cli::help(proto, opts));
+          else
+            _nbd_bench(std::forward<decltype(rest)>(rest)...);
+        },
+        elle::make_vector(
+          elle::as_range(argv + 1, argv + argc) |
+          transformed([](char const* s) { return std::string(s); })),
+        opts);
+    });
+  try
+  {
+    sched.run();
+  }
+  catch (elle::Error const& e)
+  {
+    elle::print(std::cerr, "{}: fatal error: {}\n", argv[0], e);
+    return 1;
+  }
+}
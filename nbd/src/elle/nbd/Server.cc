@@ -1,5 +1,6 @@
 #include <elle/nbd/Server.hh>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 
@@ -8,11 +9,15 @@
 
 #include <elle/bitfield.hh>
 #include <elle/enum.hh>
+#include <elle/finally.hh>
 #include <elle/log.hh>
 #include <elle/reactor/Scope.hh>
+#include <elle/reactor/mutex.hh>
 #include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/TCPSocket.hh>
 #include <elle/reactor/scheduler.hh>
+#include <elle/reactor/semaphore.hh>
+#include <elle/unreachable.hh>
 #include <elle/utility/Move.hh>
 #include <elle/Exit.hh>
 
@@ -98,6 +103,32 @@ namespace elle
       (block_status, 7),
       (resize, 8));
 
+    ELLE_ENUM(
+      CommandFlag,
+      // Reply once the data reached permanent storage.
+      (fua, 1 << 0),
+      // Write zeroes without punching holes.
+      (no_hole, 1 << 1),
+      // Reply to reads with a single chunk.
+      (df, 1 << 2));
+
+    // Structured reply chunk flags.
+    ELLE_ENUM(
+      ReplyFlag,
+      // Last chunk of the reply.
+      (done, 1 << 0));
+
+    // Structured reply chunk types.
+    ELLE_ENUM(
+      ReplyType,
+      (none, 0),
+      // Offset followed by data.
+      (offset_data, 1),
+      // Offset and size of an area that reads as zeroes.
+      (offset_hole, 2),
+      // Error code, message length and message.
+      (error, (1 << 15) | 1));
+
     ELLE_ENUM(
       TransmissionFlag,
       (has_flags, 1 << 0),
@@ -156,9 +187,42 @@ namespace elle
         *reinterpret_cast<uint64_t*>(sock.read(8).contents()));
     }
 
+    static
+    void
+    put_16(elle::Buffer& buffer, uint16_t i)
+    {
+      i = endian_reverse(i);
+      buffer.append(&i, sizeof i);
+    }
+
+    static
+    void
+    put_32(elle::Buffer& buffer, uint32_t i)
+    {
+      i = endian_reverse(i);
+      buffer.append(&i, sizeof i);
+    }
+
+    static
+    void
+    put_64(elle::Buffer& buffer, uint64_t i)
+    {
+      i = endian_reverse(i);
+      buffer.append(&i, sizeof i);
+    }
+
+    /// Whether @a size bytes at @a data are all zero.
+    static
+    bool
+    zero(uint8_t const* data, std::size_t size)
+    {
+      return std::all_of(data, data + size, [] (uint8_t b) { return !b; });
+    }
+
     Server::Server(boost::asio::ip::address host, int port)
       : _host(host)
       , _port(port)
+      , _concurrency(64)
       , _server()
     {}
 
@@ -175,147 +239,11 @@ namespace elle
             auto sock = std::make_shared(std::move(*this->_server.accept()));
             scope.run_background(
               elle::print("{}", sock->peer()),
-              [&, sock] {
+              [this, sock] {
                 try
                 {
                   ELLE_TRACE_SCOPE("handle connection from {}", sock->peer());
-                  bool zeroes = true;
-                  ELLE_DEBUG("initiate handshake")
-                  {
-                    sock->write("NBDMAGIC");
-                    sock->write("IHAVEOPT");
-                    sock->write(endian_reverse(uint16_t(HandshakeFlag::fixed_newstyle |
-                                                        HandshakeFlag::no_zeroes)));
-                    {
-                      auto flags = HandshakeFlag(read_32(*sock));
-                      auto const consume = [&] (HandshakeFlag flag)
-                                           {
-                                             auto res = bool(flags & flag);
-                                             flags = flags & ~flag;
-                                             return res;
-                                           };
-                      if (consume(HandshakeFlag::fixed_newstyle))
-                        ELLE_DEBUG("client supports fixed newstyle handshake");
-                      else
-                        ELLE_TRACE(
-                          "client does not support fixed newstyle handshake");
-                      if (consume(HandshakeFlag::no_zeroes))
-                      {
-                        zeroes = false;
-                        ELLE_DEBUG("client requires no zeroes");
-                      }
-                      if (bool(flags))
-                      {
-                        ELLE_WARN("rejecting client with unknown flags: %x", flags);
-                        return;
-                      }
-                    }
-                  }
-                  auto& device = this->_options_haggling(*sock, zeroes);
-                  while (true)
-                  {
-                    // Consume magic number
-                    {
-                      static constexpr uint8_t magic_expected[4] =
-                        {0x25, 0x60, 0x95, 0x13};
-                      auto magic = sock->read(4);
-                      if (magic != elle::ConstWeakBuffer(magic_expected))
-                        ELLE_WARN("invalid request magic: {}", magic);
-                    }
-                    auto flags = read_16(*sock);
-                    auto cmd = Command(read_16(*sock));
-                    auto handle =
-                      *reinterpret_cast<uint64_t*>(sock->read(8).contents());
-                    auto offset = read_64(*sock);
-                    auto length = read_32(*sock);
-                    auto const resp =
-                      [&] (Error error = Error::none)
-                      {
-                        static constexpr uint8_t magic[4] =
-                          {0x67, 0x44, 0x66, 0x98};
-                        sock->write(magic);
-                        sock->write(uint32_t(error));
-                        sock->write(handle);
-                      };
-                    ELLE_DUMP_SCOPE("received command: {}({}, {}, {}, {})",
-                                    cmd, flags, handle, offset, length);
-                    if (offset + length > device.size())
-                      if (cmd == Command::write || cmd == Command::write_zeroes)
-                      {
-                        ELLE_TRACE("{} is out of bound", cmd);
-                        resp(Error::nospc);
-                        break;
-                      }
-                      else if (cmd == Command::read || cmd == Command::trim)
-                      {
-                        ELLE_TRACE("{} is out of bound", cmd);
-                        resp(Error::inval);
-                        break;
-                      }
-                    switch (cmd)
-                    {
-                      case Command::read:
-                      {
-                        ELLE_TRACE_SCOPE("read {} bytes at {}", length, offset);
-                        resp();
-                        auto data = device.read(offset, length);
-                        sock->write(data);
-                        break;
-                      }
-                      case Command::write:
-                      case Command::write_zeroes:
-                      {
-                        ELLE_TRACE_SCOPE(
-                          "write {} {} at {}", length,
-                          cmd == Command::write ? "bytes" : "zeroes", offset);
-                        if (cmd == Command::write)
-                          // FIXME: use kernel level no-copy
-                          device.write(offset, sock->read(length));
-                        else
-                          device.write_zeroes(offset, length);
-                        resp();
-                        break;
-                      }
-                      case Command::disc:
-                      {
-                        ELLE_TRACE_SCOPE("client requests disconnect");
-                        throw elle::Exit();
-                      }
-                      case Command::flush:
-                      {
-                        ELLE_TRACE_SCOPE("flush");
-                        device.sync();
-                        resp();
-                        break;
-                      }
-                      case Command::trim:
-                      {
-                        ELLE_TRACE_SCOPE("trim {} bytes at {}", length, offset);
-                        device.trim(offset, length);
-                        resp();
-                        break;
-                      }
-                      case Command::cache:
-                      {
-                        ELLE_TRACE_SCOPE("cache {} bytes at {}", length, offset);
-                        device.cache(offset, length);
-                        resp();
-                        break;
-                      }
-                      case Command::block_status:
-                      case Command::resize:
-                      {
-                        ELLE_TRACE_SCOPE("unsupported {} request", cmd);
-                        resp(Error::inval);
-                        break;
-                      }
-                      default:
-                      {
-                        ELLE_WARN("unrecognized client request: {}", int(cmd));
-                        resp(Error::inval);
-                      }
-                    }
-                  }
+                  this->_serve(*sock);
                 }
                 catch (elle::Exit const&)
                 {
@@ -334,9 +262,301 @@ namespace elle
         };
     }
 
+    void
+    Server::_serve(reactor::network::Socket& sock)
+    {
+      bool zeroes = true;
+      ELLE_DEBUG("initiate handshake")
+      {
+        sock.write("NBDMAGIC");
+        sock.write("IHAVEOPT");
+        sock.write(endian_reverse(uint16_t(HandshakeFlag::fixed_newstyle |
+                                           HandshakeFlag::no_zeroes)));
+        auto flags = HandshakeFlag(read_32(sock));
+        auto const consume = [&] (HandshakeFlag flag)
+                             {
+                               auto res = bool(flags & flag);
+                               flags = flags & ~flag;
+                               return res;
+                             };
+        if (consume(HandshakeFlag::fixed_newstyle))
+          ELLE_DEBUG("client supports fixed newstyle handshake");
+        else
+          ELLE_TRACE("client does not support fixed newstyle handshake");
+        if (consume(HandshakeFlag::no_zeroes))
+        {
+          zeroes = false;
+          ELLE_DEBUG("client requires no zeroes");
+        }
+        if (bool(flags))
+        {
+          ELLE_WARN("rejecting client with unknown flags: %x", flags);
+          return;
+        }
+      }
+      bool structured = false;
+      auto& device = this->_options_haggling(sock, zeroes, structured);
+      this->_transmission(sock, device, structured);
+    }
+
+    void
+    Server::_transmission(reactor::network::Socket& sock,
+                          Device& device,
+                          bool structured)
+    {
+      // Replies of concurrent commands must not interleave.
+      reactor::Mutex write_mutex;
+      reactor::Semaphore slots(this->_concurrency);
+      auto const simple_reply =
+        [&] (uint64_t handle, Error error, elle::ConstWeakBuffer data = {})
+        {
+          auto header = elle::Buffer();
+          put_32(header, 0x67446698);
+          put_32(header, uint32_t(error));
+          header.append(&handle, sizeof handle);
+          reactor::Lock lock(write_mutex);
+          sock.write(header);
+          if (error == Error::none && data.size())
+            sock.write(data);
+        };
+      auto const chunk_header =
+        [&] (uint64_t handle, ReplyType type, bool done, uint32_t length)
+        {
+          auto res = elle::Buffer();
+          put_32(res, 0x668e33ef);
+          put_16(res, done ? uint16_t(ReplyFlag::done) : 0);
+          put_16(res, uint16_t(type));
+          res.append(&handle, sizeof handle);
+          put_32(res, length);
+          return res;
+        };
+      // Send a read reply, as offset data and hole chunks when structured
+      // replies were negotiated so sparse areas need not be transferred.
+      auto const read_reply =
+        [&] (uint64_t handle, uint64_t offset, Error error,
+             elle::ConstWeakBuffer data, bool fragment)
+        {
+          if (!structured)
+            return simple_reply(handle, error, data);
+          if (error != Error::none)
+          {
+            auto header = chunk_header(handle, ReplyType::error, true, 6);
+            put_32(header, uint32_t(error));
+            put_16(header, 0);
+            reactor::Lock lock(write_mutex);
+            sock.write(header);
+            return;
+          }
+          reactor::Lock lock(write_mutex);
+          if (data.size() == 0)
+          {
+            auto header = chunk_header(handle, ReplyType::none, true, 0);
+            sock.write(header);
+            return;
+          }
+          auto constexpr block = std::size_t(4096);
+          auto const size = data.size();
+          auto const is_hole = [&] (std::size_t start)
+            {
+              return fragment &&
+                zero(data.contents() + start, std::min(block, size - start));
+            };
+          for (auto start = std::size_t(0); start < size;)
+          {
+            auto const hole = is_hole(start);
+            auto end = start + block;
+            while (end < size && is_hole(end) == hole)
+              end += block;
+            end = std::min(end, size);
+            auto const done = end == size;
+            if (hole)
+            {
+              auto header =
+                chunk_header(handle, ReplyType::offset_hole, done, 12);
+              put_64(header, offset + start);
+              put_32(header, end - start);
+              sock.write(header);
+            }
+            else
+            {
+              auto header = chunk_header(
+                handle, ReplyType::offset_data, done, 8 + end - start);
+              put_64(header, offset + start);
+              sock.write(header);
+              sock.write(elle::ConstWeakBuffer(data.contents() + start,
+                                               end - start));
+            }
+            start = end;
+          }
+        };
+      auto const handle_command =
+        [&] (Command cmd, uint16_t flags, uint64_t handle,
+             uint64_t offset, uint32_t length, elle::Buffer& payload)
+        {
+          auto const fua = bool(flags & uint16_t(CommandFlag::fua));
+          try
+          {
+            switch (cmd)
+            {
+              case Command::read:
+              {
+                ELLE_TRACE_SCOPE("read {} bytes at {}", length, offset);
+                auto data = device.read(offset, length);
+                if (data.size() != length)
+                  elle::err("device read {} bytes instead of {}",
+                            data.size(), length);
+                read_reply(handle, offset, Error::none, data,
+                           !(flags & uint16_t(CommandFlag::df)));
+                return;
+              }
+              case Command::write:
+              case Command::write_zeroes:
+              {
+                ELLE_TRACE_SCOPE(
+                  "write {} {} at {}", length,
+                  cmd == Command::write ? "bytes" : "zeroes", offset);
+                if (cmd == Command::write)
+                  device.write(offset, std::move(payload));
+                else
+                  device.write_zeroes(offset, length);
+                if (fua)
+                  device.sync();
+                break;
+              }
+              case Command::flush:
+              {
+                ELLE_TRACE_SCOPE("flush");
+                device.sync();
+                break;
+              }
+              case Command::trim:
+              {
+                ELLE_TRACE_SCOPE("trim {} bytes at {}", length, offset);
+                device.trim(offset, length);
+                if (fua)
+                  device.sync();
+                break;
+              }
+              case Command::cache:
+              {
+                ELLE_TRACE_SCOPE("cache {} bytes at {}", length, offset);
+                device.cache(offset, length);
+                break;
+              }
+              default:
+                elle::unreachable();
+            }
+          }
+          catch (elle::reactor::network::Error const&)
+          {
+            throw;
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_WARN("{} failed: {}", cmd, e);
+            if (cmd == Command::read)
+              read_reply(handle, offset, Error::io, {}, false);
+            else
+              simple_reply(handle, Error::io);
+            return;
+          }
+          simple_reply(handle, Error::none);
+        };
+      elle::With<elle::reactor::Scope>() <<
+        [&] (elle::reactor::Scope& handlers)
+        {
+          while (true)
+          {
+            // Consume magic number
+            {
+              static constexpr uint8_t magic_expected[4] =
+                {0x25, 0x60, 0x95, 0x13};
+              auto magic = sock.read(4);
+              if (magic != elle::ConstWeakBuffer(magic_expected))
+                ELLE_WARN("invalid request magic: {}", magic);
+            }
+            auto flags = read_16(sock);
+            auto cmd = Command(read_16(sock));
+            auto handle =
+              *reinterpret_cast<uint64_t*>(sock.read(8).contents());
+            auto offset = read_64(sock);
+            auto length = read_32(sock);
+            ELLE_DUMP_SCOPE("received command: {}({}, {}, {}, {})",
+                            cmd, flags, handle, offset, length);
+            // The payload follows the request and must be consumed even if
+            // the command is refused.
+            auto payload = cmd == Command::write ?
+              sock.read(length) : elle::Buffer();
+            if (length > device.size() || offset > device.size() - length)
+              if (cmd == Command::write || cmd == Command::write_zeroes)
+              {
+                ELLE_TRACE("{} is out of bound", cmd);
+                simple_reply(handle, Error::nospc);
+                continue;
+              }
+              else if (cmd == Command::read || cmd == Command::trim)
+              {
+                ELLE_TRACE("{} is out of bound", cmd);
+                if (cmd == Command::read)
+                  read_reply(handle, offset, Error::inval, {}, false);
+                else
+                  simple_reply(handle, Error::inval);
+                continue;
+              }
+            switch (cmd)
+            {
+              case Command::disc:
+              {
+                ELLE_TRACE_SCOPE("client requests disconnect");
+                // Let in-flight commands reply before leaving.
+                reactor::wait(handlers);
+                throw elle::Exit();
+              }
+              case Command::flush:
+                // Flush covers every write completed so far: wait for
+                // in-flight ones before syncing.
+                reactor::wait(handlers);
+                [[fallthrough]];
+              case Command::read:
+              case Command::write:
+              case Command::write_zeroes:
+              case Command::trim:
+              case Command::cache:
+              {
+                while (!slots.acquire())
+                  reactor::wait(slots);
+                handlers.run_background(
+                  elle::print("{}({})", cmd, handle),
+                  [&, cmd, flags, handle, offset, length,
+                   payload = elle::utility::move_on_copy(std::move(payload))]
+                  {
+                    elle::SafeFinally release([&] { slots.release(); });
+                    handle_command(
+                      cmd, flags, handle, offset, length, payload.value);
+                  });
+                break;
+              }
+              case Command::block_status:
+              case Command::resize:
+              {
+                ELLE_TRACE_SCOPE("unsupported {} request", cmd);
+                simple_reply(handle, Error::inval);
+                break;
+              }
+              default:
+              {
+                ELLE_WARN("unrecognized client request: {}", int(cmd));
+                simple_reply(handle, Error::inval);
+              }
+            }
+          }
+        };
+    }
+
     Server::Device&
     Server::_options_haggling(reactor::network::Socket& sock,
-                              bool zeroes)
+                              bool zeroes,
+                              bool& structured)
     {
       ELLE_DEBUG("initiate options haggling")
         while (true)
@@ -375,11 +595,12 @@ namespace elle
               sock.write(endian_reverse(uint64_t(size)));
               sock.write(endian_reverse(
                             uint16_t(
-                              TransmissionFlag::has_flags  |
-                              TransmissionFlag::send_flush |
-                              TransmissionFlag::send_fua   |
-                              TransmissionFlag::send_trim  |
-                              TransmissionFlag::send_df    |
+                              TransmissionFlag::has_flags      |
+                              TransmissionFlag::send_flush     |
+                              TransmissionFlag::send_fua       |
+                              TransmissionFlag::send_trim      |
+                              TransmissionFlag::send_df        |
+                              TransmissionFlag::can_multi_conn |
                               TransmissionFlag::send_cache)));
             };
           switch (option)
@@ -464,11 +685,11 @@ namespace elle
             case Option::structured_replies:
             {
               if (data.size() == 0)
-                // nbd-client doesn't seem to negotiate structured
-                // replies, so I have no reliable way of testing it
-                // for now.
-                resp(Option::structured_replies,
-                     Response::err_unsup);
+              {
+                ELLE_TRACE("enable structured replies");
+                structured = true;
+                resp(Option::structured_replies, Response::ack);
+              }
               else
                 resp(Option::structured_replies,
                      Response::err_invalid);
@@ -24,12 +24,21 @@ namespace elle
       Server(boost::asio::ip::address host, int port = 10809);
       ELLE_ATTRIBUTE_R(boost::asio::ip::address, host);
       ELLE_ATTRIBUTE_R(int, port);
+      /// Maximum number of commands processed concurrently per connection.
+      ///
+      /// Commands are read as they arrive and handled by up to `concurrency`
+      /// threads, each sending its reply as soon as it completes, so several
+      /// requests from a client can be in flight in the device at once.
+      ELLE_ATTRIBUTE_RW(int, concurrency);
 
     /*--------.
     | Devices |
     `--------*/
     public:
       /// A block device to register and expose on a `Server`.
+      ///
+      /// Commands are processed concurrently: methods may be called by
+      /// several reactor threads at once, from one or more connections.
       class Device
       {
       /*-------------.
@@ -122,8 +131,16 @@ namespace elle
       /// Signal that we are extended on the given port.
       ELLE_ATTRIBUTE_RX(boost::signals2::signal<void (int)>, listening);
     private:
+      void
+      _serve(reactor::network::Socket& sock);
       Device&
-      _options_haggling(reactor::network::Socket& sock, bool zeroes);
+      _options_haggling(reactor::network::Socket& sock,
+                        bool zeroes,
+                        bool& structured);
+      void
+      _transmission(reactor::network::Socket& sock,
+                    Device& device,
+                    bool structured);
       ELLE_ATTRIBUTE(elle::reactor::network::TCPServer, server);
     };
   }
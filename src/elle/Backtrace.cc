@@ -7,13 +7,20 @@
 #include <cxxabi.h>
 #include <cmath>
 
+#include <atomic>
 #include <cstdlib>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <typeindex>
+#include <unordered_set>
+#include <vector>
 
 #include <elle/err.hh>
 #include <elle/printf.hh>
+#include <elle/unreachable.hh>
 #include <elle/utils.hh>
 
 ELLE_LOG_COMPONENT("elle.Backtrace");
@@ -85,6 +92,78 @@ namespace elle
       return demangle_impl(sym, res, _);
     }
 
+    /// The capture configuration.
+    ///
+    /// Read from the environment with ::getenv rather than elle::os, which
+    /// may itself throw exceptions.
+    struct Config
+    {
+      Config()
+        : policy(Backtrace::Policy::always)
+        , rate(1)
+        , depth(Backtrace::max_depth)
+        , excluded(nullptr)
+      {
+        if (auto const env = ::getenv("ELLE_BACKTRACE"))
+        {
+          auto const value = std::string(env);
+          if (value == "never")
+            this->policy = Backtrace::Policy::never;
+          else if (value != "always")
+            if (auto const r = std::strtoul(env, nullptr, 10))
+            {
+              this->policy = Backtrace::Policy::sampled;
+              this->rate = r;
+            }
+        }
+        if (auto const env = ::getenv("ELLE_BACKTRACE_DEPTH"))
+          if (auto const d = std::strtoul(env, nullptr, 10))
+            this->depth = std::min<unsigned>(d, Backtrace::max_depth);
+      }
+
+      std::atomic<Backtrace::Policy> policy;
+      std::atomic<unsigned> rate;
+      std::atomic<unsigned> depth;
+      using Excluded = std::unordered_set<std::type_index>;
+      /// The excluded types, null if none, read without locking.
+      ///
+      /// Published copy-on-write: sets are never modified once visible, and
+      /// never freed since throwers may still be reading them.
+      std::atomic<Excluded const*> excluded;
+      /// Serializes updates of excluded.
+      std::mutex mutex;
+      /// Every published set.
+      std::vector<std::unique_ptr<Excluded const>> versions;
+    };
+
+    Config&
+    config()
+    {
+      static auto res = Config{};
+      return res;
+    }
+
+    /// Whether the policy captures the next backtrace.
+    bool
+    sample()
+    {
+      auto& c = config();
+      switch (c.policy.load(std::memory_order_relaxed))
+      {
+      case Backtrace::Policy::always:
+        return true;
+      case Backtrace::Policy::never:
+        return false;
+      case Backtrace::Policy::sampled:
+        {
+          // Per thread, so that concurrent throwers do not contend.
+          static thread_local auto count = 0u;
+          return count++ % c.rate.load(std::memory_order_relaxed) == 0;
+        }
+      }
+      elle::unreachable();
+    }
+
     template <typename T = int>
     T
     from_hex(std::string const& str)
@@ -215,6 +294,80 @@ namespace elle
     }
   }
 
+  /*-------.
+  | Policy |
+  `-------*/
+
+  void
+  Backtrace::policy(Policy policy, unsigned rate)
+  {
+    auto& c = config();
+    c.rate = std::max(rate, 1u);
+    c.policy = policy;
+  }
+
+  auto
+  Backtrace::policy()
+    -> Policy
+  {
+    return config().policy;
+  }
+
+  void
+  Backtrace::depth(unsigned depth)
+  {
+    config().depth = std::min(depth, max_depth);
+  }
+
+  unsigned
+  Backtrace::depth()
+  {
+    return config().depth.load(std::memory_order_relaxed);
+  }
+
+  void
+  Backtrace::exclude(std::type_info const& type, bool excluded)
+  {
+    auto& c = config();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    auto const current = c.excluded.load();
+    auto set = current ? Config::Excluded(*current) : Config::Excluded();
+    if (excluded)
+      set.emplace(type);
+    else
+      set.erase(type);
+    if (set.empty())
+      c.excluded = nullptr;
+    else
+    {
+      c.versions.emplace_back(
+        std::make_unique<Config::Excluded const>(std::move(set)));
+      c.excluded = c.versions.back().get();
+    }
+  }
+
+  Backtrace
+  Backtrace::capture(unsigned skip)
+  {
+    if (sample())
+      // Skip this function too.
+      return {now, skip + 1, Backtrace::depth()};
+    else
+      return {};
+  }
+
+  Backtrace
+  Backtrace::capture(std::type_info const& type, unsigned skip)
+  {
+    auto const excluded = config().excluded.load(std::memory_order_acquire);
+    if (excluded && excluded->count(type))
+      return {};
+    if (sample())
+      return {now, skip + 1, Backtrace::depth()};
+    else
+      return {};
+  }
+
   std::ostream&
   operator<< (std::ostream& out, const Backtrace& bt)
   {
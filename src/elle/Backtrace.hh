@@ -2,6 +2,7 @@
 
 #include <array>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 #include <elle/compiler.hh>
@@ -79,13 +80,15 @@ namespace elle ELLE_API
 
     /// The backtrace leading to the call to this constructor.
     ///
-    /// I.e., does not include the call to this ctor.
+    /// I.e., does not include the call to this ctor. Always unwinds up to
+    /// max_depth frames, whatever depth().
     ELLE_COMPILER_ATTRIBUTE_ALWAYS_INLINE
     Backtrace(now_t, unsigned skip = 0);
 
     /// The backtrace leading to the call to this function.
     ///
-    /// I.e., does not include the call to this function.
+    /// I.e., does not include the call to this function. Like the `now`
+    /// constructor, ignores the policy and depth().
     static inline ELLE_COMPILER_ATTRIBUTE_ALWAYS_INLINE
     Backtrace
     current(unsigned skip = 0);
@@ -96,12 +99,79 @@ namespace elle ELLE_API
     std::vector<Frame> const&
     frames() const;
 
+  /*-------.
+  | Policy |
+  `-------*/
+  public:
+    /// When exceptions capture their backtrace.
+    enum class Policy
+    {
+      /// Capture every backtrace.
+      always,
+      /// Capture one backtrace out of a given rate.
+      sampled,
+      /// Never capture.
+      never,
+    };
+    /// The maximum number of frames captured.
+    static constexpr unsigned max_depth = 128;
+    /// Set when exceptions capture their backtrace.
+    ///
+    /// Defaults to the ELLE_BACKTRACE environment variable: `always`,
+    /// `never`, or a number N to capture one backtrace out of N per thread.
+    ///
+    /// @param policy The capture policy.
+    /// @param rate With Policy::sampled, capture one backtrace out of @a rate.
+    static
+    void
+    policy(Policy policy, unsigned rate = 1);
+    static
+    Policy
+    policy();
+    /// Set the number of frames captured, at most max_depth.
+    ///
+    /// Defaults to the ELLE_BACKTRACE_DEPTH environment variable, or
+    /// max_depth. Unwinding costs grow with the number of frames. Only
+    /// applies to capture(), explicit backtraces are complete.
+    static
+    void
+    depth(unsigned depth);
+    static
+    unsigned
+    depth();
+    /// Opt exceptions of a given type out of capture, whatever the policy.
+    ///
+    /// Only exceptions that name their type when capturing, through
+    /// capture(std::type_info const&, unsigned), honor this.
+    ///
+    /// @param type The type of the exceptions.
+    /// @param excluded Whether to exclude the type, or include it back.
+    static
+    void
+    exclude(std::type_info const& type, bool excluded = true);
+    /// The backtrace leading to the call to this function if the policy
+    /// captures it, an empty one otherwise.
+    ///
+    /// Symbols are only resolved when the frames are first looked at.
+    static
+    Backtrace
+    capture(unsigned skip = 0);
+    /// The backtrace leading to the call to this function if the policy
+    /// captures it for an exception of type @a type, an empty one otherwise.
+    static
+    Backtrace
+    capture(std::type_info const& type, unsigned skip = 0);
+
   private:
+    /// The backtrace leading to the call to this constructor, at most
+    /// @a depth frames.
+    ELLE_COMPILER_ATTRIBUTE_ALWAYS_INLINE
+    Backtrace(now_t, unsigned skip, unsigned depth);
     void _resolve();
     std::vector<Frame> _frames;
     bool _resolved = false;
     unsigned _skip = 0;
-    static constexpr size_t _callstack_size = 128;
+    static constexpr size_t _callstack_size = max_depth;
     std::array<void*, _callstack_size> _callstack;
     unsigned _frame_count = 0;
   };
@@ -4,11 +4,15 @@ namespace elle
 {
   inline
   Backtrace::Backtrace(now_t, unsigned skip)
+    : Backtrace(now, skip, max_depth)
+  {}
+
+  inline
+  Backtrace::Backtrace(now_t, unsigned skip, unsigned depth)
   {
     ELLE_LOG_COMPONENT("elle.Backtrace");
 #if ELLE_HAVE_BACKTRACE
-    this->_frame_count = ::backtrace(this->_callstack.data(),
-                                     this->_callstack.size());
+    this->_frame_count = ::backtrace(this->_callstack.data(), depth);
     ELLE_DEBUG("backtrace returned %s frames",
                this->_frame_count);
     this->_skip = skip;
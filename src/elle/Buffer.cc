@@ -7,6 +7,7 @@
 
 #include <boost/range/algorithm/count_if.hpp>
 
+#include <elle/BufferPool.hh>
 #include <elle/Exception.hh>
 #include <elle/IOStream.hh>
 #include <elle/assert.hh>
@@ -18,8 +19,6 @@ ELLE_LOG_COMPONENT("elle.Buffer");
 
 namespace
 {
-  constexpr auto elle_buffer_initial_size = elle::Buffer::Size(sizeof(void*));
-
   // FIXME: std::string_view.
   // FIXME: make sure uint32_t is large enough.
   void
@@ -70,13 +69,17 @@ namespace elle
   `-------------------*/
 
   /// A StreamBuffer to write into a Buffer.
+  ///
+  /// The put area spans the whole spare capacity of the buffer, which grows
+  /// geometrically, and large writes are copied straight to its tail.
   template <typename BufferType>
   class OutputStreamBuffer
     : public StreamBuffer
   {
   public:
+    /// Append to @a buffer, reserving room for @a expected more bytes.
     explicit
-    OutputStreamBuffer(BufferType& buffer);
+    OutputStreamBuffer(BufferType& buffer, Buffer::Size expected = 0);
 
   protected:
     virtual
@@ -88,6 +91,8 @@ namespace elle
     virtual
     void
     flush(StreamBuffer::Size size);
+    std::streamsize
+    xsputn(char const* data, std::streamsize size) override;
 
   private:
     size_t _old_size;
@@ -148,29 +153,29 @@ namespace elle
   `-------*/
 
   // Note that an empty buffer has a valid pointer to a memory region with
-  // a size of zero.
+  // a size of zero: its inline storage.
   Buffer::Buffer()
     : _size(0)
-    , _capacity(elle_buffer_initial_size)
-    , _contents(static_cast<Byte*>(malloc(elle_buffer_initial_size)))
+    , _capacity(inline_size)
+    , _contents(this->_small)
+    , _pooled(false)
+  {}
+
+  Buffer::Buffer(Size size, BufferPool& pool)
+    : Buffer()
   {
-    if (this->_contents == nullptr)
-      throw std::bad_alloc();
+    if (inline_size < size)
+    {
+      this->_contents = pool._get(size, this->_capacity);
+      this->_pooled = true;
+    }
+    this->_size = size;
   }
 
   Buffer::Buffer(void const* data, Buffer::Size size)
-    : _size(0)
-    , _capacity(0)
-    , _contents(nullptr)
+    : Buffer()
   {
-    if (size == 0)
-    {
-      this->_capacity = elle_buffer_initial_size;
-      if ((this->_contents =
-           static_cast<Byte*>(::malloc(_capacity))) == nullptr)
-        throw std::bad_alloc();
-    }
-    else
+    if (size != 0)
       this->append(data, size);
   }
 
@@ -186,18 +191,20 @@ namespace elle
     : _size(0)
     , _capacity(0)
     , _contents(nullptr)
+    , _pooled(false)
   {
     (*this) = std::move(other);
   }
 
   Buffer::Buffer(Buffer const& source)
-    : _size(source._size)
-    , _capacity(source._size)
-    , _contents(static_cast<Byte*>(::malloc(this->_capacity)))
+    : Buffer()
   {
-    if (!this->_contents)
-      throw std::bad_alloc();
-    memcpy(this->_contents, source._contents, this->_size);
+    if (source._size != 0)
+    {
+      this->capacity(source._size);
+      memcpy(this->_contents, source._contents, source._size);
+      this->_size = source._size;
+    }
   }
 
   Buffer::Buffer(ConstWeakBuffer const& source)
@@ -207,11 +214,24 @@ namespace elle
   Buffer&
   Buffer::operator = (Buffer&& other)
   {
-    ::free(this->_contents);
+    if (this == &other)
+      return *this;
+    this->_free();
+    if (other._inline())
+    {
+      memcpy(this->_small, other._small, other._size);
+      this->_contents = this->_small;
+      this->_capacity = inline_size;
+    }
+    else
+    {
+      this->_contents = other._contents;
+      this->_capacity = other._capacity;
+    }
     this->_size = other._size;
-    this->_capacity = other._capacity;
-    this->_contents = other._contents;
+    this->_pooled = other._pooled;
     other._contents = nullptr;
+    other._pooled = false;
     other._size = 0;
     other._capacity = 0;
     return *this;
@@ -219,14 +239,46 @@ namespace elle
 
   Buffer::~Buffer()
   {
-    ::free(this->_contents);
+    this->_free();
+  }
+
+  void
+  Buffer::_free()
+  {
+    if (this->_inline())
+      return;
+    if (this->_pooled && this->_contents)
+      BufferPool::_put(this->_contents, this->_capacity);
+    else
+      ::free(this->_contents);
+    this->_pooled = false;
   }
 
   void
-  Buffer::capacity(Size capacity_)
+  Buffer::capacity(Size capacity)
   {
-    auto const capacity = std::max(capacity_, elle_buffer_initial_size);
-    if (auto tmp = ::realloc(this->_contents, capacity))
+    if (capacity <= inline_size)
+    {
+      this->_size = std::min(this->_size, capacity);
+      if (!this->_inline())
+      {
+        if (this->_size != 0)
+          memcpy(this->_small, this->_contents, this->_size);
+        this->_free();
+        this->_contents = this->_small;
+        this->_capacity = inline_size;
+      }
+    }
+    else if (this->_inline())
+    {
+      auto tmp = static_cast<Byte*>(::malloc(capacity));
+      if (!tmp)
+        throw std::bad_alloc();
+      memcpy(tmp, this->_small, this->_size);
+      this->_contents = tmp;
+      this->_capacity = capacity;
+    }
+    else if (auto tmp = ::realloc(this->_contents, capacity))
     {
       this->_contents = static_cast<Byte*>(tmp);
       this->_capacity = capacity;
@@ -268,7 +320,17 @@ namespace elle
   Buffer::ContentPair
   Buffer::release()
   {
-    auto res = ContentPair{ContentPtr{this->_contents}, this->_size};
+    auto contents = this->_contents;
+    // Inline content must be moved to the heap to be owned by the caller.
+    if (this->_inline())
+    {
+      contents = static_cast<Byte*>(::malloc(std::max(this->_size, Size(1))));
+      if (!contents)
+        throw std::bad_alloc();
+      memcpy(contents, this->_small, this->_size);
+    }
+    auto res = ContentPair{ContentPtr{contents}, this->_size};
+    this->_pooled = false;
     this->_contents = nullptr;
     this->_size = 0;
     this->_capacity = 0;
@@ -387,15 +449,8 @@ namespace elle
   void
   Buffer::shrink_to_fit()
   {
-    auto capacity = std::max(elle_buffer_initial_size, this->_size);
-    if (capacity < this->_capacity)
-    {
-      void* tmp = ::realloc(_contents, capacity);
-      if (tmp == nullptr)
-        throw std::bad_alloc();
-      this->_contents = static_cast<Byte*>(tmp);
-      this->_capacity = capacity;
-    }
+    if (!this->_inline() && this->_size < this->_capacity)
+      this->capacity(this->_size);
   }
 
 
@@ -405,6 +460,12 @@ namespace elle
     return new OutputStreamBuffer<elle::Buffer>(*this);
   }
 
+  std::streambuf*
+  Buffer::ostreambuf(Size expected)
+  {
+    return new OutputStreamBuffer<elle::Buffer>(*this, expected);
+  }
+
   std::streambuf*
   Buffer::istreambuf() const
   {
@@ -642,6 +703,142 @@ namespace elle
     return {reinterpret_cast<char const*>(this->contents()), this->size()};
   }
 
+  /*-------------.
+  | SharedBuffer |
+  `-------------*/
+
+  SharedBuffer::SharedBuffer(Buffer&& buffer)
+    : _buffer(std::make_shared<Buffer const>(std::move(buffer)))
+    , _contents(this->_buffer->contents())
+    , _size(this->_buffer->size())
+  {}
+
+  SharedBuffer::SharedBuffer(ConstWeakBuffer const& data)
+    : SharedBuffer(Buffer(data))
+  {}
+
+  SharedBuffer::SharedBuffer(SharedBuffer&& source)
+    : _buffer(std::move(source._buffer))
+    , _contents(source._contents)
+    , _size(source._size)
+  {
+    source._contents = nullptr;
+    source._size = 0;
+  }
+
+  SharedBuffer::SharedBuffer(std::shared_ptr<Buffer const> buffer,
+                             ConstWeakBuffer const& content)
+    : _buffer(std::move(buffer))
+    , _contents(content.contents())
+    , _size(content.size())
+  {}
+
+  SharedBuffer&
+  SharedBuffer::operator = (SharedBuffer&& source)
+  {
+    if (this != &source)
+    {
+      this->_buffer = std::move(source._buffer);
+      this->_contents = source._contents;
+      this->_size = source._size;
+      source._contents = nullptr;
+      source._size = 0;
+    }
+    return *this;
+  }
+
+  Buffer::Byte
+  SharedBuffer::operator [](unsigned i) const
+  {
+    ELLE_ASSERT_LT(i, this->_size);
+    return this->_contents[i];
+  }
+
+  SharedBuffer
+  SharedBuffer::range(int start) const
+  {
+    return {this->_buffer, ConstWeakBuffer(*this).range(start)};
+  }
+
+  SharedBuffer
+  SharedBuffer::range(int start, int end) const
+  {
+    return {this->_buffer, ConstWeakBuffer(*this).range(start, end)};
+  }
+
+  long
+  SharedBuffer::use_count() const
+  {
+    return this->_buffer.use_count();
+  }
+
+  bool
+  SharedBuffer::operator ==(SharedBuffer const& other) const
+  {
+    return ConstWeakBuffer(*this) == ConstWeakBuffer(other);
+  }
+
+  bool
+  SharedBuffer::operator ==(ConstWeakBuffer const& other) const
+  {
+    return ConstWeakBuffer(*this) == other;
+  }
+
+  bool
+  SharedBuffer::operator ==(std::string const& other) const
+  {
+    return *this == ConstWeakBuffer(other);
+  }
+
+  bool
+  SharedBuffer::operator ==(char const* other) const
+  {
+    return *this == ConstWeakBuffer(other);
+  }
+
+  bool
+  SharedBuffer::operator <(SharedBuffer const& other) const
+  {
+    return ConstWeakBuffer(*this) < ConstWeakBuffer(other);
+  }
+
+  bool
+  SharedBuffer::empty() const
+  {
+    return this->size() == 0;
+  }
+
+  std::string
+  SharedBuffer::string() const
+  {
+    return {reinterpret_cast<char const*>(this->contents()), this->size()};
+  }
+
+  std::streambuf*
+  SharedBuffer::istreambuf() const
+  {
+    return new InputStreamBuffer<SharedBuffer>(*this);
+  }
+
+  SharedBuffer::const_iterator
+  SharedBuffer::begin() const
+  {
+    return this->contents();
+  }
+
+  SharedBuffer::const_iterator
+  SharedBuffer::end() const
+  {
+    return this->contents() + this->size();
+  }
+
+  std::ostream&
+  operator <<(std::ostream& stream,
+              SharedBuffer const& buffer)
+  {
+    return stream << ConstWeakBuffer(buffer);
+  }
+
 
   /*------------------.
   | InputStreamBuffer |
@@ -696,26 +893,57 @@ namespace elle
   class InputStreamBuffer<ConstWeakBuffer>;
   template
   class InputStreamBuffer<WeakBuffer>;
+  template
+  class InputStreamBuffer<SharedBuffer>;
 
   /*-------------------.
   | OutputStreamBuffer |
   `-------------------*/
 
   template <typename BufferType>
-  OutputStreamBuffer<BufferType>::OutputStreamBuffer(BufferType& buffer)
+  OutputStreamBuffer<BufferType>::OutputStreamBuffer(BufferType& buffer,
+                                                     Buffer::Size expected)
     : _old_size(buffer.size())
     , _buffer(buffer)
-  {}
+  {
+    if (this->_buffer.capacity() < this->_old_size + expected)
+      this->_buffer.capacity(this->_old_size + expected);
+  }
 
   template <typename BufferType>
   WeakBuffer
   OutputStreamBuffer<BufferType>::write_buffer()
   {
-    _buffer.capacity(this->_old_size + 512);
-    ELLE_DEBUG("%s: grow buffer capacity from %s to %s bytes",
-               *this, this->_old_size, this->_buffer.capacity());
+    // Always hand out at least 512 bytes, growing geometrically so that
+    // streaming N bytes costs O(log N) reallocations.
+    auto const capacity = this->_buffer.capacity();
+    if (capacity < this->_old_size + 512)
+    {
+      this->_buffer.capacity(
+        std::max(Buffer::_next_size(capacity), this->_old_size + 512));
+      ELLE_DEBUG("%s: grow buffer capacity from %s to %s bytes",
+                 *this, capacity, this->_buffer.capacity());
+    }
     return {(char*)_buffer.mutable_contents() + this->_old_size,
-            512};
+            this->_buffer.capacity() - this->_old_size};
+  }
+
+  template <typename BufferType>
+  std::streamsize
+  OutputStreamBuffer<BufferType>::xsputn(char const* data,
+                                         std::streamsize size)
+  {
+    // Small writes go through the put area, which write_buffer sets up with
+    // at least 512 bytes, so they stay pending until the next sync.
+    if (size <= this->epptr() - this->pptr() || size < 512)
+      return StreamBuffer::xsputn(data, size);
+    // Large write that does not fit in the put area: commit pending bytes and
+    // append directly instead of bouncing through overflow.
+    this->sync();
+    ELLE_DEBUG("%s: write %s bytes directly", *this, size);
+    this->_buffer.append(data, size);
+    this->_old_size += size;
+    return size;
   }
 
   template <typename BufferType>
@@ -789,4 +1017,10 @@ namespace std
   {
     return hash<elle::ConstWeakBuffer>()(buffer);
   }
+
+  elle::Buffer::Size
+  hash<elle::SharedBuffer>::operator()(elle::SharedBuffer const& buffer) const
+  {
+    return hash<elle::ConstWeakBuffer>()(buffer);
+  }
 }
@@ -20,6 +20,7 @@ namespace elle
     };
   }
 
+  class BufferPool;
   class WeakBuffer;
 
   /*-------.
@@ -28,9 +29,16 @@ namespace elle
 
   /// @brief A memory zone.
   ///
-  /// The Buffer owns the pointed memory at every moment.
+  /// The Buffer owns the pointed memory at every moment. Payloads of up to
+  /// inline_size bytes are stored inline and do not allocate; moving such a
+  /// buffer thus copies its content and changes its contents() address, so
+  /// views of a small buffer do not survive a move, while views of heap
+  /// content do. The inline storage fits a digest and brings a Buffer to 64
+  /// bytes, one cache line, in exchange for a malloc per empty or small
+  /// buffer.
   ///
   /// @see WeakBuffer for a buffer that doesn't own the memory.
+  /// @see SharedBuffer for a buffer that shares its memory.
   class ELLE_API Buffer
     : private boost::totally_ordered<Buffer>
   {
@@ -50,6 +58,8 @@ namespace elle
     using ContentPtr = std::unique_ptr<Byte, detail::MallocDeleter>;
     /// Content owned by a Buffer: data and size.
     using ContentPair = std::pair<ContentPtr, Size>;
+    /// Capacity of the inline storage used for small payloads.
+    static constexpr Size inline_size = 32;
 
   /*-------------.
   | Construction |
@@ -62,6 +72,9 @@ namespace elle
       typename T,
       std::enable_if_t<std::is_integral<T>::value, int> = 0>
     Buffer(T size);
+    /// An uninitialized buffer of the specified size, whose memory is taken
+    /// from and given back to @a pool.
+    Buffer(Size size, BufferPool& pool);
     /// A buffer containing a copy of the given data.
     Buffer(void const* data, Size size);
     /// A buffer containing a copy of the given data.
@@ -105,7 +118,19 @@ namespace elle
     void
     shrink_to_fit();
   private:
+    template <typename>
+    friend class OutputStreamBuffer;
     static Size _next_size(Size);
+    /// Whether the content is stored inline.
+    bool
+    _inline() const;
+    /// Free or give back the heap memory, if any.
+    void
+    _free();
+    /// Inline storage for small payloads.
+    Byte _small[inline_size];
+    /// Whether the memory comes from a BufferPool.
+    bool _pooled;
 
   public:
     static constexpr Size max_size = std::numeric_limits<Size>::max();
@@ -167,6 +192,10 @@ namespace elle
     /// Construct an output streambuf from the buffer.
     std::streambuf* ostreambuf();
 
+    /// Construct an output streambuf from the buffer, reserving room for
+    /// @a expected more bytes.
+    std::streambuf* ostreambuf(Size expected);
+
     /// Construct an input streambuf from the buffer.
     std::streambuf* istreambuf() const;
 
@@ -414,6 +443,119 @@ namespace elle
     istreambuf() const;
   };
 
+  /*-------------.
+  | SharedBuffer |
+  `-------------*/
+
+  /// @brief An immutable, reference-counted memory zone.
+  ///
+  /// Copies and ranges of a SharedBuffer refer to the same memory and cost
+  /// O(1); the memory is released with the last SharedBuffer referring to
+  /// it. A Buffer can be moved to a SharedBuffer without copying its content.
+  class ELLE_API SharedBuffer
+    : private boost::totally_ordered<SharedBuffer>
+  {
+  /*------.
+  | Types |
+  `------*/
+  public:
+    using Self = SharedBuffer;
+    /// Size of a Buffer.
+    using Size = Buffer::Size;
+
+  /*-------------.
+  | Construction |
+  `-------------*/
+  public:
+    /// An empty buffer.
+    SharedBuffer();
+    /// Take ownership of the content of @a buffer, without copying it.
+    SharedBuffer(Buffer&& buffer) /* implicit */;
+    /// A buffer containing a copy of the given data.
+    explicit
+    SharedBuffer(ConstWeakBuffer const& data);
+    /// A buffer sharing the memory of @a source.
+    SharedBuffer(SharedBuffer const& source) = default;
+    /// Steal the reference of the moved buffer.
+    SharedBuffer(SharedBuffer&& source);
+    SharedBuffer&
+    operator = (SharedBuffer const& source) = default;
+    SharedBuffer&
+    operator = (SharedBuffer&& source);
+  private:
+    SharedBuffer(std::shared_ptr<Buffer const> buffer,
+                 ConstWeakBuffer const& content);
+
+  /*--------.
+  | Content |
+  `--------*/
+  public:
+    /// Get byte at position @a i.
+    Buffer::Byte
+    operator [](unsigned i) const;
+    /// A subset of this buffer, sharing its memory.
+    SharedBuffer
+    range(int start) const;
+    /// A subset of this buffer, sharing its memory.
+    SharedBuffer
+    range(int start, int end) const;
+    /// A view on the content, valid as long as this buffer is.
+    operator ConstWeakBuffer() const;
+    /// Number of SharedBuffers referring to this memory.
+    long
+    use_count() const;
+    /// Memory owner.
+    ELLE_ATTRIBUTE(std::shared_ptr<Buffer const>, buffer);
+    /// Buffer constant data.
+    ELLE_ATTRIBUTE_R(Buffer::Byte const*, contents);
+    /// Size of the buffer.
+    ELLE_ATTRIBUTE_R(Size, size);
+
+  /*---------------------.
+  | Relational Operators |
+  `---------------------*/
+  public:
+    bool
+    operator ==(SharedBuffer const& other) const;
+    bool
+    operator ==(ConstWeakBuffer const& other) const;
+    bool
+    operator ==(std::string const& other) const;
+    bool
+    operator ==(char const* other) const;
+    bool
+    operator <(SharedBuffer const& other) const;
+
+  /*-----------.
+  | Properties |
+  `-----------*/
+  public:
+    /// Whether the size is 0.
+    bool
+    empty() const;
+    /// The content of the buffer as a string.
+    std::string
+    string() const;
+
+  /*--------------.
+  | Serialization |
+  `--------------*/
+  public:
+    /// Construct an input streambuf from the buffer.
+    std::streambuf*
+    istreambuf() const;
+
+  /*---------.
+  | Iterable |
+  `---------*/
+  public:
+    using const_iterator = Buffer::Byte const*;
+    const_iterator
+    begin() const;
+    const_iterator
+    end() const;
+  };
+
   /*----------.
   | Operators |
   `----------*/
@@ -423,6 +565,11 @@ namespace elle
   operator <<(std::ostream& stream,
               ConstWeakBuffer const& buffer);
 
+  ELLE_API
+  std::ostream&
+  operator <<(std::ostream& stream,
+              SharedBuffer const& buffer);
+
 }
 
 /*-----.
@@ -446,6 +593,14 @@ namespace std
     elle::Buffer::Size
     operator()(elle::Buffer const& buffer) const;
   };
+
+  template<>
+  struct ELLE_API hash<elle::SharedBuffer>
+  {
+  public:
+    elle::Buffer::Size
+    operator()(elle::SharedBuffer const& buffer) const;
+  };
 }
 
 #include <elle/Buffer.hxx>
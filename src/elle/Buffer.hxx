@@ -22,12 +22,17 @@ namespace elle
             std::enable_if_t<std::is_integral<T>::value, int>>
   Buffer::Buffer(T size)
     : _size(static_cast<Size>(size))
-    , _capacity(size)
-    , _contents(nullptr)
+    , _capacity(inline_size)
+    , _contents(this->_small)
+    , _pooled(false)
   {
-    if ((this->_contents =
-         static_cast<Byte*>(::malloc(this->_capacity))) == nullptr)
-      throw std::bad_alloc();
+    if (inline_size < this->_size)
+    {
+      this->_capacity = this->_size;
+      if ((this->_contents =
+           static_cast<Byte*>(::malloc(this->_capacity))) == nullptr)
+        throw std::bad_alloc();
+    }
   }
 
   inline
@@ -126,4 +131,24 @@ namespace elle
   {
     return this->_contents;
   }
+
+  inline
+  bool
+  Buffer::_inline() const
+  {
+    return this->_contents == this->_small;
+  }
+
+  inline
+  SharedBuffer::SharedBuffer()
+    : _buffer()
+    , _contents(nullptr)
+    , _size(0)
+  {}
+
+  inline
+  SharedBuffer::operator ConstWeakBuffer() const
+  {
+    return {this->_contents, this->_size};
+  }
 }
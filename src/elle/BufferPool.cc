@@ -0,0 +1,127 @@
+#include <elle/BufferPool.hh>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+namespace elle
+{
+  namespace
+  {
+    using Size = BufferPool::Size;
+
+    constexpr
+    std::array<Size, BufferPool::classes>
+    class_sizes()
+    {
+      auto res = std::array<Size, BufferPool::classes>{};
+      for (auto i = 0; i < BufferPool::classes; ++i)
+        res[i] = (Size(2) << (8 + i / 2)) * (i % 2 ? 3 : 2) / 2;
+      return res;
+    }
+
+    constexpr auto sizes = class_sizes();
+
+    /// Index of the smallest class fitting @a size, or `classes`.
+    int
+    class_index(Size size)
+    {
+      return std::lower_bound(sizes.begin(), sizes.end(), size) - sizes.begin();
+    }
+
+    // Set once the pool of this thread is destroyed, so buffers destroyed
+    // later during thread exit free their memory directly.
+    thread_local bool destroyed = false;
+  }
+
+  /*-------------.
+  | Construction |
+  `-------------*/
+
+  BufferPool::BufferPool()
+    : _hits(0)
+    , _misses(0)
+    , _cached(0)
+    , _high_water(64 * 1024 * 1024)
+    , _free(classes)
+  {}
+
+  BufferPool::~BufferPool()
+  {
+    this->trim();
+    destroyed = true;
+  }
+
+  BufferPool&
+  BufferPool::local()
+  {
+    static thread_local BufferPool pool;
+    return pool;
+  }
+
+  /*-------------.
+  | Size classes |
+  `-------------*/
+
+  Size
+  BufferPool::class_size(Size size)
+  {
+    auto const i = class_index(size);
+    return i < classes ? sizes[i] : 0;
+  }
+
+  /*-----------.
+  | Operations |
+  `-----------*/
+
+  void
+  BufferPool::trim(Size keep)
+  {
+    // Free the largest blocks first.
+    for (auto i = classes - 1; i >= 0 && keep < this->_cached; --i)
+      while (!this->_free[i].empty() && keep < this->_cached)
+      {
+        ::free(this->_free[i].back());
+        this->_free[i].pop_back();
+        this->_cached -= sizes[i];
+      }
+  }
+
+  Buffer::Byte*
+  BufferPool::_get(Size size, Size& capacity)
+  {
+    auto const i = class_index(size);
+    if (i < classes && !this->_free[i].empty())
+    {
+      ++this->_hits;
+      auto res = this->_free[i].back();
+      this->_free[i].pop_back();
+      this->_cached -= sizes[i];
+      capacity = sizes[i];
+      return res;
+    }
+    ++this->_misses;
+    capacity = i < classes ? sizes[i] : size;
+    if (auto res = static_cast<Buffer::Byte*>(::malloc(capacity)))
+      return res;
+    else
+      throw std::bad_alloc();
+  }
+
+  void
+  BufferPool::_put(Buffer::Byte* block, Size capacity)
+  {
+    auto const i = class_index(capacity);
+    if (!destroyed && i < classes && sizes[i] == capacity)
+    {
+      auto& pool = BufferPool::local();
+      if (pool._cached + capacity <= pool._high_water)
+      {
+        pool._free[i].push_back(block);
+        pool._cached += capacity;
+        return;
+      }
+    }
+    ::free(block);
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+
+namespace elle
+{
+  /// A per-thread cache of Buffer memory, by size class.
+  ///
+  /// Buffers constructed from the pool get their memory from a free list
+  /// holding blocks of the smallest size class fitting the requested size,
+  /// and give it back to the pool of the thread destroying them. Since
+  /// coroutines of a Scheduler share its thread, they share its pool;
+  /// background threads use their own.
+  ///
+  /// Blocks given back while more than `high_water` bytes are cached are
+  /// freed instead. Sizes above the largest class are not pooled.
+  ///
+  /// @code{.cc}
+  ///
+  /// while (true)
+  /// {
+  ///   auto buffer = elle::Buffer(65536, elle::BufferPool::local());
+  ///   buffer.size(socket.read_some(buffer));
+  ///   process(std::move(buffer));
+  /// }
+  ///
+  /// @endcode
+  class ELLE_API BufferPool
+  {
+  /*------.
+  | Types |
+  `------*/
+  public:
+    using Self = BufferPool;
+    using Size = Buffer::Size;
+
+  /*-------------.
+  | Construction |
+  `-------------*/
+  public:
+    /// The pool of the current thread.
+    static
+    BufferPool&
+    local();
+    BufferPool(BufferPool const&) = delete;
+    ~BufferPool();
+  private:
+    BufferPool();
+
+  /*-------------.
+  | Size classes |
+  `-------------*/
+  public:
+    /// Powers of two and their midpoints, from 512 B to 4 MiB.
+    static constexpr int classes = 27;
+    /// Size of the smallest class at least @a size bytes large.
+    ///
+    /// @return The class size, or 0 if @a size is above the largest class.
+    static
+    Size
+    class_size(Size size);
+
+  /*-----------.
+  | Statistics |
+  `-----------*/
+  public:
+    /// Requests served from cached memory.
+    ELLE_ATTRIBUTE_R(std::size_t, hits);
+    /// Requests that had to allocate memory.
+    ELLE_ATTRIBUTE_R(std::size_t, misses);
+    /// Bytes currently cached.
+    ELLE_ATTRIBUTE_R(Size, cached);
+    /// Maximum number of bytes to cache.
+    ELLE_ATTRIBUTE_RW(Size, high_water);
+
+  /*-----------.
+  | Operations |
+  `-----------*/
+  public:
+    /// Free cached memory until at most @a keep bytes remain.
+    void
+    trim(Size keep = 0);
+  private:
+    friend class Buffer;
+    /// Memory for at least @a size bytes, setting @a capacity to its size.
+    Buffer::Byte*
+    _get(Size size, Size& capacity);
+    /// Give back a block of @a capacity bytes to the current thread's pool.
+    static
+    void
+    _put(Buffer::Byte* block, Size capacity);
+    /// Cached blocks, by size class.
+    ELLE_ATTRIBUTE(std::vector<std::vector<Buffer::Byte*>>, free);
+  };
+}
@@ -11,7 +11,7 @@ namespace elle
   `-------------*/
 
   Exception::Exception(std::string const& message, int skip)
-    : Exception(Backtrace::current(1 + skip), message)
+    : Exception(Backtrace::capture(1 + skip), message)
   {}
 
   Exception::Exception(Backtrace bt, std::string const& message)
@@ -24,6 +24,8 @@ namespace elle ELLE_API
 
     /// Construct an Exception.
     ///
+    /// The Backtrace is captured according to Backtrace::policy.
+    ///
     /// @param message An explanatory string.
     /// @param skip The number of stack frames to skip
     Exception(std::string const& message, int skip = 0);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <elle/attribute.hh>
+
+namespace elle
+{
+  /// Worker std::threads running jobs, handed back in submission order.
+  ///
+  /// Jobs must have a `done` flag, set once they ran, and an `error`
+  /// exception pointer, set if running them threw.
+  ///
+  /// \code{.cc}
+  ///
+  /// struct Job { Buffer input; Buffer output; bool done; std::exception_ptr
+  ///              error; };
+  /// auto pool = OrderedPool<Job>(
+  ///   0, [] { return [] (Job& job) { job.output = compress(job.input); }; });
+  /// for (auto& input: inputs)
+  /// {
+  ///   pool.submit(make_job(input));
+  ///   // Keep at most 8 jobs in flight.
+  ///   while (auto job = pool.next(8))
+  ///     write(*job);
+  /// }
+  /// while (auto job = pool.next(0))
+  ///   write(*job);
+  ///
+  /// \endcode
+  template <typename Job>
+  class OrderedPool
+  {
+  public:
+    using Worker = std::function<void (Job&)>;
+    /// Create an OrderedPool.
+    ///
+    /// Threads are started on demand, as jobs are submitted.
+    ///
+    /// @param threads The number of threads, 0 for one per core.
+    /// @param worker  Called once per thread, returns the function running
+    ///                jobs on that thread. If it throws, so do all the jobs
+    ///                run by that thread.
+    OrderedPool(int threads, std::function<Worker ()> worker);
+    /// Stop the threads, abandoning jobs not started yet.
+    ~OrderedPool();
+    /// Queue @a job for running.
+    void
+    submit(std::shared_ptr<Job> job);
+    /// The oldest pending job once done, waiting for it only if more than
+    /// @a limit jobs are pending.
+    ///
+    /// @returns The job, or null if none could be returned.
+    std::shared_ptr<Job>
+    next(std::size_t limit);
+    ELLE_ATTRIBUTE_R(int, threads);
+
+  private:
+    void
+    _run();
+    ELLE_ATTRIBUTE(std::function<Worker ()>, worker);
+    ELLE_ATTRIBUTE(std::mutex, mutex);
+    ELLE_ATTRIBUTE(std::condition_variable, work);
+    ELLE_ATTRIBUTE(std::condition_variable, done);
+    /// Jobs submitted and not handed back yet, in submission order.
+    ELLE_ATTRIBUTE(std::deque<std::shared_ptr<Job>>, pending);
+    /// Jobs not started yet.
+    ELLE_ATTRIBUTE(std::deque<std::shared_ptr<Job>>, queue);
+    ELLE_ATTRIBUTE(bool, stopping);
+    ELLE_ATTRIBUTE(std::vector<std::thread>, workers);
+  };
+}
+
+#include <elle/OrderedPool.hxx>
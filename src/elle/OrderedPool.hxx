@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <exception>
+
+namespace elle
+{
+  template <typename Job>
+  OrderedPool<Job>::OrderedPool(int threads, std::function<Worker ()> worker)
+    : _threads(threads > 0 ?
+               threads :
+               std::max(1, int(std::thread::hardware_concurrency())))
+    , _worker(std::move(worker))
+    , _mutex()
+    , _work()
+    , _done()
+    , _pending()
+    , _queue()
+    , _stopping(false)
+    , _workers()
+  {}
+
+  template <typename Job>
+  OrderedPool<Job>::~OrderedPool()
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->_mutex);
+      this->_queue.clear();
+      this->_stopping = true;
+      this->_work.notify_all();
+    }
+    for (auto& worker: this->_workers)
+      worker.join();
+  }
+
+  template <typename Job>
+  void
+  OrderedPool<Job>::submit(std::shared_ptr<Job> job)
+  {
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    this->_pending.emplace_back(job);
+    this->_queue.emplace_back(std::move(job));
+    if (this->_workers.size() < std::size_t(this->_threads))
+      this->_workers.emplace_back([this] { this->_run(); });
+    this->_work.notify_one();
+  }
+
+  template <typename Job>
+  std::shared_ptr<Job>
+  OrderedPool<Job>::next(std::size_t limit)
+  {
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    if (this->_pending.empty())
+      return nullptr;
+    auto job = this->_pending.front();
+    if (!job->done)
+    {
+      if (this->_pending.size() <= limit)
+        return nullptr;
+      this->_done.wait(lock, [&] { return job->done; });
+    }
+    this->_pending.pop_front();
+    return job;
+  }
+
+  template <typename Job>
+  void
+  OrderedPool<Job>::_run()
+  {
+    auto run = Worker{};
+    auto error = std::exception_ptr{};
+    try
+    {
+      run = this->_worker();
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    while (true)
+    {
+      auto job = std::shared_ptr<Job>{};
+      {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        this->_work.wait(
+          lock, [&] { return this->_stopping || !this->_queue.empty(); });
+        if (this->_queue.empty())
+          return;
+        job = std::move(this->_queue.front());
+        this->_queue.pop_front();
+      }
+      if (error)
+        job->error = error;
+      else
+        try
+        {
+          run(*job);
+        }
+        catch (...)
+        {
+          job->error = std::current_exception();
+        }
+      std::unique_lock<std::mutex> lock(this->_mutex);
+      job->done = true;
+      this->_done.notify_all();
+    }
+  }
+}
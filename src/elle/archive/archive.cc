@@ -1,13 +1,31 @@
 #include <elle/archive/archive.hh>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
 #include <unordered_set>
 
 #include <archive.h>
 #include <archive_entry.h>
+#include <zlib.h>
 
 #include <boost/filesystem.hpp>
 
+#include <elle/Buffer.hh>
 #include <elle/Error.hh>
+#include <elle/Exception.hh>
+#include <elle/OrderedPool.hh>
+#include <elle/err.hh>
+#include <elle/finally.hh>
+#include <elle/format/deflate.hh>
 #include <elle/system/system.hh>
 #include <elle/log.hh>
 #include <elle/printf.hh>
@@ -146,61 +164,27 @@ namespace elle
       ELLE_TRACE("file %s archived into %s", file, (void*)(archive));
     }
 
+    /*------.
+    | Files |
+    `------*/
+
+    /// Call add on every file to archive, along with its name in the archive.
+    static
     void
-    archive(Format format,
-            Paths const& files,
-            fs::path const& path,
-            Renamer const& renamer,
-            Excluder const& excluder,
-            bool ignore_failure)
+    for_each_file(
+      Paths const& files,
+      Renamer const& renamer,
+      Excluder const& excluder,
+      bool ignore_failure,
+      std::function<void (fs::path const&, fs::path const&)> const& add)
     {
-      ELLE_TRACE_SCOPE("archive %s", path);
-      ELLE_DEBUG("files: %s", files);
       auto root_entries = std::unordered_set<std::string>{};
-      ArchivePtr archive(archive_write_new());
-      ELLE_TRACE("archive: %s", (void*)(archive.get()));
-      int (*format_setter)(::archive*) = nullptr;
-      int (*compression_setter)(::archive*) = nullptr;
-      switch (format)
-      {
-        case Format::tar:
-          format_setter = archive_write_set_format_gnutar;
-          break;
-        case Format::tar_bzip2:
-          format_setter = archive_write_set_format_gnutar;
-          compression_setter = archive_write_add_filter_bzip2;
-          break;
-        case Format::tar_gzip:
-          format_setter = archive_write_set_format_gnutar;
-          compression_setter = archive_write_add_filter_gzip;
-          break;
-        case Format::zip:
-          format_setter = archive_write_set_format_zip;
-          break;
-        case Format::zip_uncompressed:
-          format_setter = archive_write_set_format_zip;
-          compression_setter = archive_write_zip_set_compression_store;
-          break;
-        default:
-          elle::unreachable();
-      }
-      check_call(archive.get(), format_setter(archive.get()));
-      if (compression_setter)
-        check_call(archive.get(), compression_setter(archive.get()));
-      check_call(archive.get(),
-#ifdef ELLE_WINDOWS
-        archive_write_open_filename_w(archive.get(), path.native().c_str()));
-#else
-        archive_write_open_filename(archive.get(), path.string().c_str()));
-#endif
-      auto do_archiving = [ignore_failure] (
-        ::archive* archive,
-        fs::path const& absolute,
-        fs::path const& relative)
+      auto do_archiving = [&] (fs::path const& absolute,
+                               fs::path const& relative)
         {
           try
           {
-            _archive_file(archive, absolute, relative);
+            add(absolute, relative);
           }
           catch (elle::Error const& e)
           {
@@ -210,7 +194,6 @@ namespace elle
               throw;
           }
         };
-
       for (auto const& path: files)
       {
         auto root = path.filename();
@@ -245,7 +228,7 @@ namespace elle
                   return res;
                 }();
                 ELLE_DEBUG("archiving from directory %s as %s", absolute, relative);
-                do_archiving(archive.get(), absolute, relative);
+                do_archiving(absolute, relative);
               }
             }
         }
@@ -257,39 +240,823 @@ namespace elle
             continue;
           }
           ELLE_DEBUG("archiving %s as %s", path, root);
-          do_archiving(archive.get(), path, root);
+          do_archiving(path, root);
         }
       }
     }
 
-    void extract(fs::path const& archive,
-                 boost::optional<fs::path> const& output)
+    /*-----------.
+    | libarchive |
+    `-----------*/
+
+#if ARCHIVE_VERSION_NUMBER >= 3003000
+    using ssize = la_ssize_t;
+#else
+    using ssize = ssize_t;
+#endif
+
+    static
+    ArchivePtr
+    writer(Format format)
     {
-      ELLE_TRACE("[Archive] extracting %s", archive.string());
-      ArchiveReadPtr a(archive_read_new());
-      ArchivePtr out(archive_write_disk_new());
-      int r;
+      ArchivePtr archive(archive_write_new());
+      ELLE_TRACE("archive: %s", (void*)(archive.get()));
+      int (*format_setter)(::archive*) = nullptr;
+      int (*compression_setter)(::archive*) = nullptr;
+      switch (format)
+      {
+        case Format::tar:
+          format_setter = archive_write_set_format_gnutar;
+          break;
+        case Format::tar_bzip2:
+          format_setter = archive_write_set_format_gnutar;
+          compression_setter = archive_write_add_filter_bzip2;
+          break;
+        case Format::tar_gzip:
+          format_setter = archive_write_set_format_gnutar;
+          compression_setter = archive_write_add_filter_gzip;
+          break;
+        case Format::zip:
+          format_setter = archive_write_set_format_zip;
+          break;
+        case Format::zip_uncompressed:
+          format_setter = archive_write_set_format_zip;
+          compression_setter = archive_write_zip_set_compression_store;
+          break;
+        default:
+          elle::unreachable();
+      }
+      check_call(archive.get(), format_setter(archive.get()));
+      if (compression_setter)
+        check_call(archive.get(), compression_setter(archive.get()));
+      return archive;
+    }
 
-      archive_read_support_filter_all(a.get());
-      archive_read_support_format_all(a.get());
-      check_call(a.get(), archive_read_open_filename(a.get(),
-                 archive.string().c_str(), 10240));
+    static
+    ssize
+    stream_write(::archive* archive,
+                 void* output,
+                 void const* data,
+                 size_t size)
+    {
+      auto& stream = *static_cast<std::ostream*>(output);
+      try
+      {
+        stream.write(static_cast<char const*>(data), size);
+        if (stream.good())
+          return size;
+        archive_set_error(archive, EIO, "unable to write to output stream");
+      }
+      catch (std::exception const& e)
+      {
+        archive_set_error(archive, EIO, "%s", e.what());
+      }
+      return -1;
+    }
+
+    namespace
+    {
+      struct StreamReader
+      {
+        StreamReader(std::istream& input)
+          : input(input)
+          , buffer(1 << 16)
+          , start(input.tellg())
+        {
+          // tellg fails on streams that cannot seek.
+          input.clear(input.rdstate() & ~std::ios_base::failbit);
+        }
+
+        std::istream& input;
+        elle::Buffer buffer;
+        std::istream::pos_type start;
+      };
+    }
+
+    static
+    ssize
+    stream_read(::archive* archive, void* reader, void const** data)
+    {
+      auto& r = *static_cast<StreamReader*>(reader);
+      try
+      {
+        r.input.read(reinterpret_cast<char*>(r.buffer.mutable_contents()),
+                     r.buffer.size());
+        if (r.input.bad())
+          archive_set_error(archive, EIO, "unable to read input stream");
+        else
+        {
+          *data = r.buffer.contents();
+          return r.input.gcount();
+        }
+      }
+      catch (std::exception const& e)
+      {
+        archive_set_error(archive, EIO, "%s", e.what());
+      }
+      return -1;
+    }
+
+    /// Seek in the input stream, if it supports it.
+    ///
+    /// Zip archives are then read from their central directory, which holds
+    /// the file modes and symbolic links that local headers lack.
+    static
+    std::int64_t
+    stream_seek(::archive* archive, void* reader, std::int64_t offset,
+                int whence)
+    {
+      auto& r = *static_cast<StreamReader*>(reader);
+      if (r.start == std::istream::pos_type(-1))
+        return ARCHIVE_FATAL;
+      try
+      {
+        r.input.clear();
+        if (whence == SEEK_SET)
+          r.input.seekg(r.start + std::istream::off_type(offset));
+        else
+          r.input.seekg(offset,
+                        whence == SEEK_CUR ? std::ios_base::cur :
+                        std::ios_base::end);
+        auto const pos = r.input.tellg();
+        if (!r.input.fail() && pos != std::istream::pos_type(-1))
+          return pos - r.start;
+        r.input.clear();
+      }
+      catch (std::exception const& e)
+      {
+        archive_set_error(archive, EIO, "%s", e.what());
+      }
+      return ARCHIVE_FATAL;
+    }
+
+    /*----.
+    | Zip |
+    `----*/
+
+    // Zip archives are written by hand rather than through libarchive, so
+    // entries can be deflated in parallel. Files are split in blocks, each
+    // deflated with the end of the previous one as a preset dictionary and
+    // ending on a sync flush but the last one: their concatenation is the
+    // entry's DEFLATE stream, as pigz does. Since sizes and CRCs are known
+    // only once written, entries are followed by data descriptors, like
+    // libarchive does.
+
+    namespace
+    {
+      auto constexpr zip_block_size = std::size_t(1) << 17;
+
+      struct ZipEntry
+      {
+        std::string name;
+        std::uint32_t mode;
+        std::time_t mtime;
+        bool deflated;
+        bool zip64;
+        bool complete;
+        std::uint64_t offset;
+        std::uint32_t crc;
+        std::uint64_t size;
+        std::uint64_t compressed;
+      };
+
+      struct ZipBlock
+      {
+        ZipEntry* entry;
+        bool first;
+        bool last;
+        elle::Buffer input;
+        elle::Buffer dictionary;
+        elle::Buffer output;
+        std::uint32_t crc;
+        std::uint64_t size;
+        bool done;
+        std::exception_ptr error;
+      };
+
+      /// Append little-endian integers, as found in zip records.
+      void
+      put(elle::Buffer& output, std::uint64_t value, int bytes)
+      {
+        for (int i = 0; i < bytes; ++i)
+        {
+          auto const byte = static_cast<unsigned char>(value >> (8 * i));
+          output.append(&byte, 1);
+        }
+      }
+
+      std::uint32_t
+      clamp32(std::uint64_t value)
+      {
+        return std::min<std::uint64_t>(value, 0xffffffff);
+      }
+
+      /// MS-DOS time and date.
+      std::pair<std::uint16_t, std::uint16_t>
+      dos_time(std::time_t time)
+      {
+        auto tm = std::tm{};
+#ifdef ELLE_WINDOWS
+        localtime_s(&tm, &time);
+#else
+        localtime_r(&time, &tm);
+#endif
+        if (tm.tm_year < 80)
+          return {0, (1 << 5) | 1};
+        return {
+          (tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2),
+          ((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday,
+        };
+      }
+
+      class ZipWriter
+      {
+      public:
+        ZipWriter(std::ostream& output, Parallel const& parallel)
+          : _output(output)
+          , _offset(0)
+          , _entries()
+          , _finished(false)
+          , _in_flight(std::max<std::size_t>(parallel.memory / zip_block_size,
+                                             2))
+          , _pool(parallel.threads,
+                  []
+                  {
+                    auto deflater =
+                      std::make_shared<format::deflate::Deflater>();
+                    return [deflater] (ZipBlock& block)
+                      {
+                        _deflate(*deflater, block);
+                      };
+                  })
+        {}
+
+        ~ZipWriter()
+        {
+          // Leave a valid archive of the entries written so far.
+          if (!this->_finished)
+            try
+            {
+              this->_central_directory();
+            }
+            catch (...)
+            {
+              ELLE_ERR("unable to finalize zip archive: %s",
+                       elle::exception_string());
+            }
+        }
+
+        void
+        add(fs::path const& file, fs::path const& name)
+        {
+          ELLE_TRACE_SCOPE("add %s as %s", file, name);
+          struct stat st;
+#ifdef ELLE_WINDOWS
+          if (::_wstat(file.native().c_str(), &st) != 0)
+#else
+          if (::lstat(file.string().c_str(), &st) != 0)
+#endif
+            elle::err("unable to stat %s: %s", file, std::strerror(errno));
+          auto input = std::unique_ptr<std::ifstream>{};
+          auto target = std::string{};
+          if (S_ISLNK(st.st_mode))
+            target = fs::read_symlink(file).string();
+          else if (S_ISREG(st.st_mode))
+          {
+            input = std::make_unique<std::ifstream>(file, std::ios::binary);
+            if (!input->good())
+              elle::err("unable to open %s", file);
+          }
+          else
+            elle::err("unsupported file type for %s: %o", file, st.st_mode);
+          this->_entries.emplace_back();
+          auto& entry = this->_entries.back();
+          entry.name = name.generic_string();
+          entry.mode = st.st_mode;
+          entry.mtime = st.st_mtime;
+          entry.deflated = bool(input);
+          // Leave room for deflate to expand incompressible data.
+          entry.zip64 = std::uint64_t(st.st_size) >= 0xf0000000;
+          entry.complete = false;
+          entry.offset = 0;
+          entry.crc = 0;
+          entry.size = 0;
+          entry.compressed = 0;
+          if (!input)
+          {
+            auto block = this->_block(entry, true);
+            block->last = true;
+            block->input = elle::Buffer(target.data(), target.size());
+            this->_submit(std::move(block));
+            return;
+          }
+          auto dictionary = elle::Buffer();
+          for (bool first = true; ; first = false)
+          {
+            auto block = this->_block(entry, first);
+            block->input.size(zip_block_size);
+            input->read(
+              reinterpret_cast<char*>(block->input.mutable_contents()),
+              zip_block_size);
+            if (input->bad())
+            {
+              if (first)
+                elle::err("unable to read %s", file);
+              else
+                // Part of the entry may already be in the archive, which
+                // cannot be undone: fail it whatever ignore_failure says.
+                throw elle::Exception(elle::sprintf(
+                  "unable to read %s while archiving it", file));
+            }
+            block->input.size(input->gcount());
+            block->last = block->input.size() < zip_block_size;
+            block->dictionary = std::move(dictionary);
+            dictionary = elle::Buffer(
+              format::deflate::Deflater::dictionary(block->input));
+            auto const last = block->last;
+            this->_submit(std::move(block));
+            if (last)
+              break;
+          }
+        }
+
+        void
+        finish()
+        {
+          ELLE_TRACE_SCOPE("finalize zip archive");
+          this->_drain(0);
+          this->_central_directory();
+          this->_finished = true;
+          this->_output.flush();
+        }
+
+      private:
+        static
+        void
+        _deflate(format::deflate::Deflater& deflater, ZipBlock& block)
+        {
+          block.size = block.input.size();
+          block.crc = crc32(0, block.input.contents(), block.input.size());
+          if (block.entry->deflated)
+          {
+            block.output = deflater(block.input, block.dictionary, block.last);
+            block.input = elle::Buffer();
+            block.dictionary = elle::Buffer();
+          }
+          else
+            block.output = std::move(block.input);
+        }
+
+        std::shared_ptr<ZipBlock>
+        _block(ZipEntry& entry, bool first)
+        {
+          auto res = std::make_shared<ZipBlock>();
+          res->entry = &entry;
+          res->first = first;
+          res->last = false;
+          res->crc = 0;
+          res->size = 0;
+          res->done = false;
+          return res;
+        }
+
+        void
+        _submit(std::shared_ptr<ZipBlock> block)
+        {
+          this->_pool.submit(std::move(block));
+          this->_drain(this->_in_flight);
+        }
+
+        /// Write deflated blocks in order, until at most limit are pending.
+        void
+        _drain(std::size_t limit)
+        {
+          while (auto block = this->_pool.next(limit))
+            this->_write(*block);
+        }
+
+        void
+        _write(ZipBlock& block)
+        {
+          if (block.error)
+            std::rethrow_exception(block.error);
+          auto& entry = *block.entry;
+          if (block.first)
+          {
+            entry.offset = this->_offset;
+            // Stored entries are a single block, whose size and CRC can go
+            // in the local header.
+            if (!entry.deflated)
+            {
+              entry.crc = block.crc;
+              entry.size = entry.compressed = block.size;
+            }
+            this->_local_header(entry);
+          }
+          this->_send(block.output);
+          if (entry.deflated)
+          {
+            entry.crc = crc32_combine(entry.crc, block.crc, block.size);
+            entry.size += block.size;
+            entry.compressed += block.output.size();
+          }
+          if (block.last)
+          {
+            if (entry.deflated)
+              this->_data_descriptor(entry);
+            entry.complete = true;
+          }
+        }
+
+        void
+        _send(elle::Buffer const& data)
+        {
+          this->_output.write(reinterpret_cast<char const*>(data.contents()),
+                              data.size());
+          if (!this->_output.good())
+            elle::err("unable to write zip archive");
+          this->_offset += data.size();
+        }
+
+        static
+        int
+        _flags(ZipEntry const& entry)
+        {
+          auto const utf8 = std::any_of(
+            entry.name.begin(), entry.name.end(),
+            [] (char c) { return static_cast<unsigned char>(c) >= 0x80; });
+          return (entry.deflated ? 0x8 : 0) | (utf8 ? 0x800 : 0);
+        }
+
+        void
+        _local_header(ZipEntry const& entry)
+        {
+          auto const time = dos_time(entry.mtime);
+          auto header = elle::Buffer();
+          put(header, 0x04034b50, 4);
+          put(header, entry.zip64 ? 45 : 20, 2);
+          put(header, _flags(entry), 2);
+          put(header, entry.deflated ? Z_DEFLATED : 0, 2);
+          put(header, time.first, 2);
+          put(header, time.second, 2);
+          put(header, entry.crc, 4);
+          put(header, entry.zip64 ? 0xffffffff : entry.compressed, 4);
+          put(header, entry.zip64 ? 0xffffffff : entry.size, 4);
+          put(header, entry.name.size(), 2);
+          put(header, 9 + (entry.zip64 ? 20 : 0), 2);
+          header.append(entry.name.data(), entry.name.size());
+          // Extended timestamp.
+          put(header, 0x5455, 2);
+          put(header, 5, 2);
+          put(header, 1, 1);
+          put(header, entry.mtime, 4);
+          if (entry.zip64)
+          {
+            put(header, 0x0001, 2);
+            put(header, 16, 2);
+            put(header, entry.size, 8);
+            put(header, entry.compressed, 8);
+          }
+          this->_send(header);
+        }
+
+        void
+        _data_descriptor(ZipEntry const& entry)
+        {
+          if (!entry.zip64 &&
+              (entry.size >= 0xffffffff || entry.compressed >= 0xffffffff))
+            elle::err("%s grew over 4GiB while being archived", entry.name);
+          auto descriptor = elle::Buffer();
+          put(descriptor, 0x08074b50, 4);
+          put(descriptor, entry.crc, 4);
+          put(descriptor, entry.compressed, entry.zip64 ? 8 : 4);
+          put(descriptor, entry.size, entry.zip64 ? 8 : 4);
+          this->_send(descriptor);
+        }
+
+        void
+        _central_directory()
+        {
+          auto const start = this->_offset;
+          auto count = std::uint64_t(0);
+          for (auto const& entry: this->_entries)
+          {
+            if (!entry.complete)
+              continue;
+            ++count;
+            auto const time = dos_time(entry.mtime);
+            auto zip64 = elle::Buffer();
+            if (entry.size >= 0xffffffff)
+              put(zip64, entry.size, 8);
+            if (entry.compressed >= 0xffffffff)
+              put(zip64, entry.compressed, 8);
+            if (entry.offset >= 0xffffffff)
+              put(zip64, entry.offset, 8);
+            auto const version = entry.zip64 || !zip64.empty() ? 45 : 20;
+            auto header = elle::Buffer();
+            put(header, 0x02014b50, 4);
+            // Made by Unix, so that the mode is honored.
+            put(header, (3 << 8) | version, 2);
+            put(header, version, 2);
+            put(header, _flags(entry), 2);
+            put(header, entry.deflated ? Z_DEFLATED : 0, 2);
+            put(header, time.first, 2);
+            put(header, time.second, 2);
+            put(header, entry.crc, 4);
+            put(header, clamp32(entry.compressed), 4);
+            put(header, clamp32(entry.size), 4);
+            put(header, entry.name.size(), 2);
+            put(header, 9 + (zip64.empty() ? 0 : 4 + zip64.size()), 2);
+            // Comment length, disk number and internal attributes.
+            put(header, 0, 6);
+            put(header, std::uint64_t(entry.mode) << 16, 4);
+            put(header, clamp32(entry.offset), 4);
+            header.append(entry.name.data(), entry.name.size());
+            put(header, 0x5455, 2);
+            put(header, 5, 2);
+            put(header, 1, 1);
+            put(header, entry.mtime, 4);
+            if (!zip64.empty())
+            {
+              put(header, 0x0001, 2);
+              put(header, zip64.size(), 2);
+              header.append(zip64.contents(), zip64.size());
+            }
+            this->_send(header);
+          }
+          auto const size = this->_offset - start;
+          auto end = elle::Buffer();
+          if (count >= 0xffff || size >= 0xffffffff || start >= 0xffffffff)
+          {
+            auto const record = this->_offset;
+            put(end, 0x06064b50, 4);
+            put(end, 44, 8);
+            put(end, (3 << 8) | 45, 2);
+            put(end, 45, 2);
+            put(end, 0, 8);
+            put(end, count, 8);
+            put(end, count, 8);
+            put(end, size, 8);
+            put(end, start, 8);
+            put(end, 0x07064b50, 4);
+            put(end, 0, 4);
+            put(end, record, 8);
+            put(end, 1, 4);
+          }
+          put(end, 0x06054b50, 4);
+          put(end, 0, 4);
+          put(end, std::min<std::uint64_t>(count, 0xffff), 2);
+          put(end, std::min<std::uint64_t>(count, 0xffff), 2);
+          put(end, clamp32(size), 4);
+          put(end, clamp32(start), 4);
+          put(end, 0, 2);
+          this->_send(end);
+        }
+
+        ELLE_ATTRIBUTE(std::ostream&, output);
+        ELLE_ATTRIBUTE(std::uint64_t, offset);
+        // A deque, so blocks can point to entries.
+        ELLE_ATTRIBUTE(std::deque<ZipEntry>, entries);
+        ELLE_ATTRIBUTE(bool, finished);
+        ELLE_ATTRIBUTE(std::size_t, in_flight);
+        // Last, so workers are stopped before entries are destroyed.
+        ELLE_ATTRIBUTE(OrderedPool<ZipBlock>, pool);
+      };
+    }
+
+    /*----------.
+    | Archiving |
+    `----------*/
+
+    void
+    archive(Format format,
+            Paths const& files,
+            fs::path const& path,
+            Renamer const& renamer,
+            Excluder const& excluder,
+            bool ignore_failure)
+    {
+      ELLE_TRACE_SCOPE("archive %s", path);
+      ELLE_DEBUG("files: %s", files);
+      if (format == Format::zip)
+      {
+        std::ofstream output(path, std::ios::binary);
+        if (!output.good())
+          elle::err("unable to open %s", path);
+        return archive(format, files, output, renamer, excluder,
+                       ignore_failure);
+      }
+      auto archive = writer(format);
+      check_call(archive.get(),
+#ifdef ELLE_WINDOWS
+        archive_write_open_filename_w(archive.get(), path.native().c_str()));
+#else
+        archive_write_open_filename(archive.get(), path.string().c_str()));
+#endif
+      for_each_file(files, renamer, excluder, ignore_failure,
+                    [&] (fs::path const& absolute, fs::path const& relative)
+                    {
+                      _archive_file(archive.get(), absolute, relative);
+                    });
+    }
+
+    void
+    archive(Format format,
+            Paths const& files,
+            std::ostream& output,
+            Renamer const& renamer,
+            Excluder const& excluder,
+            bool ignore_failure,
+            Parallel const& parallel)
+    {
+      ELLE_TRACE_SCOPE("archive to stream");
+      ELLE_DEBUG("files: %s", files);
+      if (format == Format::zip)
+      {
+        ZipWriter zip(output, parallel);
+        for_each_file(files, renamer, excluder, ignore_failure,
+                      [&] (fs::path const& absolute, fs::path const& relative)
+                      {
+                        zip.add(absolute, relative);
+                      });
+        zip.finish();
+        return;
+      }
+      auto archive = writer(format);
+      // Do not pad the last block, the output is not a tape.
+      check_call(archive.get(),
+                 archive_write_set_bytes_in_last_block(archive.get(), 1));
+      check_call(archive.get(),
+                 archive_write_open(archive.get(), &output,
+                                    nullptr, &stream_write, nullptr));
+      for_each_file(files, renamer, excluder, ignore_failure,
+                    [&] (fs::path const& absolute, fs::path const& relative)
+                    {
+                      _archive_file(archive.get(), absolute, relative);
+                    });
+    }
+
+    /*-----------.
+    | Extraction |
+    `-----------*/
+
+    namespace
+    {
+      struct Extraction
+      {
+        EntryPtr entry;
+        elle::Buffer data;
+        std::size_t size;
+        bool done;
+        std::exception_ptr error;
+      };
+    }
+
+    /// Write an entry, whose data is all in memory, with a dedicated disk
+    /// writer.
+    static
+    void
+    write_entry(Extraction& extraction)
+    {
+      auto disk = archive_write_disk_new();
+      elle::SafeFinally release([&] { archive_write_free(disk); });
+      auto const& data = extraction.data;
+      check_call(disk, archive_write_header(disk, extraction.entry.get()));
+      if (!data.empty())
+        check_call(disk,
+                   archive_write_data(disk, data.contents(), data.size()),
+                   data.size());
+      check_call(disk, archive_write_finish_entry(disk));
+      check_call(disk, archive_write_close(disk));
+      extraction.data = elle::Buffer();
+    }
+
+    /// Extract entries, writing regular files to disk on worker threads.
+    static
+    void
+    _extract(::archive* a, fs::path const& dest, Parallel const& parallel)
+    {
+      ArchivePtr out(archive_write_disk_new());
+      // Files bigger than that are written as they are decompressed.
+      auto const buffered = std::max<std::size_t>(parallel.memory / 4, 1);
+      auto in_flight = std::size_t(0);
+      auto pool = OrderedPool<Extraction>(
+        parallel.threads,
+        [] { return &write_entry; });
+      // Collect written entries, waiting for them only if more than limit
+      // bytes or any entry if limit is zero are in flight.
+      auto const collect = [&] (std::size_t limit)
+        {
+          while (true)
+          {
+            auto const wait = limit == 0 || in_flight > limit;
+            auto const done =
+              pool.next(wait ? 0 : std::numeric_limits<std::size_t>::max());
+            if (!done)
+              break;
+            in_flight -= done->size;
+            if (done->error)
+              std::rethrow_exception(done->error);
+          }
+        };
       for (;;)
       {
         ::archive_entry* entry;
-        r = archive_read_next_header(a.get(), &entry);
+        auto const r = archive_read_next_header(a, &entry);
         if (r == ARCHIVE_EOF)
           break;
-        check_call(a.get(), r);
+        check_call(a, r);
         const char* cur_file = archive_entry_pathname(entry);
-        auto dest = output ? output.get() : archive.parent_path();
         const std::string fullpath = (dest / cur_file).string();
         ELLE_TRACE("[Archive] extracting %s", fullpath);
         archive_entry_set_pathname(entry, fullpath.c_str());
-        check_call(a.get(), archive_write_header(out.get(), entry));
-        check_call(a.get(), copy_data(a.get(), out.get()));
-        check_call(a.get(), archive_write_finish_entry(out.get()));
+        auto data = elle::Buffer();
+        if (archive_entry_filetype(entry) == AE_IFREG &&
+            !archive_entry_hardlink(entry))
+        {
+          // Sizes may be unknown until decompressed, read up to the limit.
+          auto complete = false;
+          while (!complete && data.size() <= buffered)
+          {
+            auto const offset = data.size();
+            data.size(offset + (1 << 16));
+            auto const read = archive_read_data(
+              a, data.mutable_contents() + offset, 1 << 16);
+            if (read < 0)
+              check_call(a, read);
+            data.size(offset + read);
+            complete = read == 0;
+          }
+          if (complete)
+          {
+            collect(parallel.memory - std::min(parallel.memory, data.size()));
+            auto job = std::make_shared<Extraction>();
+            job->entry.reset(archive_entry_clone(entry));
+            job->size = data.size();
+            job->data = std::move(data);
+            job->done = false;
+            in_flight += job->size;
+            pool.submit(std::move(job));
+            continue;
+          }
+        }
+        else if (archive_entry_hardlink(entry))
+          // Hard links point to entries that must be written first.
+          collect(0);
+        check_call(out.get(), archive_write_header(out.get(), entry));
+        if (data.empty())
+          check_call(a, copy_data(a, out.get()));
+        else
+          // Data was partially read with archive_read_data, whose remainder
+          // archive_read_data_block would skip: keep reading the same way.
+          while (!data.empty())
+          {
+            check_call(
+              out.get(),
+              archive_write_data(out.get(), data.contents(), data.size()),
+              data.size());
+            data.size(1 << 16);
+            auto const read =
+              archive_read_data(a, data.mutable_contents(), data.size());
+            if (read < 0)
+              check_call(a, read);
+            data.size(read);
+          }
+        check_call(out.get(), archive_write_finish_entry(out.get()));
       }
+      collect(0);
+    }
+
+    void
+    extract(fs::path const& archive,
+            boost::optional<fs::path> const& output)
+    {
+      ELLE_TRACE("[Archive] extracting %s", archive.string());
+      ArchiveReadPtr a(archive_read_new());
+      archive_read_support_filter_all(a.get());
+      archive_read_support_format_all(a.get());
+      check_call(a.get(), archive_read_open_filename(a.get(),
+                 archive.string().c_str(), 10240));
+      _extract(a.get(),
+               output ? output.get() : archive.parent_path(),
+               Parallel{});
+    }
+
+    void
+    extract(std::istream& archive,
+            fs::path const& output,
+            Parallel const& parallel)
+    {
+      ELLE_TRACE_SCOPE("extract stream to %s", output);
+      auto reader = StreamReader(archive);
+      ArchiveReadPtr a(archive_read_new());
+      archive_read_support_filter_all(a.get());
+      archive_read_support_format_all(a.get());
+      check_call(a.get(),
+                 archive_read_set_seek_callback(a.get(), &stream_seek));
+      check_call(a.get(), archive_read_open(a.get(), &reader,
+                                            nullptr, &stream_read, nullptr));
+      _extract(a.get(), output, parallel);
     }
   }
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <iosfwd>
 #include <vector>
 
 #include <boost/optional.hpp>
@@ -30,6 +32,16 @@ namespace elle
     /// Return true to exclude the file.
     using Excluder = std::function<auto (fs::path const&) -> bool>;
 
+    /// Settings for parallel archiving and extraction.
+    struct Parallel
+    {
+      /// Number of worker threads, 0 for one per core.
+      int threads = 0;
+      /// Maximum amount of file data read ahead of compression, or of
+      /// extracted data waiting to be written to disk.
+      std::size_t memory = 64 << 20;
+    };
+
     /// Create an archive containing @a list of files.
     ///
     /// @param format         The type of archive.
@@ -38,6 +50,8 @@ namespace elle
     /// @param renamer        A function to rename entries.
     /// @param excluder       A function to exclude files.
     /// @param ignore_failure Ignore failure (like non-existent files, etc.)
+    ///                       Files that fail to be read once their zip entry
+    ///                       was started still fail the archive.
     void
     archive(Format format,
             Paths const& files,
@@ -46,6 +60,30 @@ namespace elle
             Excluder const& excluder = {},
             bool ignore_failure = false);
 
+    /// Create an archive containing @a list of files, written to a stream.
+    ///
+    /// The stream is only written to sequentially, it may for instance be a
+    /// socket. Zip entries are deflated by blocks on worker threads and
+    /// written in order; other formats are compressed on the calling thread.
+    ///
+    /// @param format         The type of archive.
+    /// @param files          The paths of the files to archive.
+    /// @param output         Where to write the resulting archive.
+    /// @param renamer        A function to rename entries.
+    /// @param excluder       A function to exclude files.
+    /// @param ignore_failure Ignore failure (like non-existent files, etc.)
+    ///                       Files that fail to be read once their zip entry
+    ///                       was started still fail the archive.
+    /// @param parallel       Parallel compression settings.
+    void
+    archive(Format format,
+            Paths const& files,
+            std::ostream& output,
+            Renamer const& renamer = {},
+            Excluder const& excluder = {},
+            bool ignore_failure = false,
+            Parallel const& parallel = {});
+
     /// Extract an archive to a given path.
     ///
     /// The extract function supports all formats, no need to specify it.
@@ -57,5 +95,23 @@ namespace elle
     void
     extract(fs::path const& archive,
             boost::optional<fs::path> const& output = {});
+
+    /// Extract an archive read from a stream to a given path.
+    ///
+    /// The stream is only read sequentially, it may for instance be a
+    /// socket. Files are written to disk on worker threads while the next
+    /// entries are decompressed.
+    ///
+    /// Zip archives only record file modes and symbolic links in their
+    /// trailing central directory: they are restored only if the stream is
+    /// seekable, like a file or string stream.
+    ///
+    /// @param archive  The archive stream.
+    /// @param output   Where to extract the archive.
+    /// @param parallel Parallel extraction settings.
+    void
+    extract(std::istream& archive,
+            fs::path const& output,
+            Parallel const& parallel = {});
   }
 }
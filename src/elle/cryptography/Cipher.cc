@@ -63,6 +63,8 @@ namespace elle
         return stream << "cfb";
       case Mode::ofb:
         return stream << "ofb";
+      case Mode::gcm:
+        return stream << "gcm";
       }
       elle::unreachable();
     }
@@ -240,6 +242,8 @@ namespace elle
               return ::EVP_aes_128_cfb();
             case Mode::ofb:
               return ::EVP_aes_128_ofb();
+            case Mode::gcm:
+              return ::EVP_aes_128_gcm();
             default:
               break;
             }
@@ -258,6 +262,8 @@ namespace elle
               return ::EVP_aes_192_cfb();
             case Mode::ofb:
               return ::EVP_aes_192_ofb();
+            case Mode::gcm:
+              return ::EVP_aes_192_gcm();
             default:
               break;
             }
@@ -276,6 +282,8 @@ namespace elle
               return ::EVP_aes_256_cfb();
             case Mode::ofb:
               return ::EVP_aes_256_ofb();
+            case Mode::gcm:
+              return ::EVP_aes_256_gcm();
             default:
               break;
             }
@@ -342,16 +350,19 @@ namespace elle
             { ::EVP_aes_128_ecb(), {Cipher::aes128, Mode::ecb} },
             { ::EVP_aes_128_cfb(), {Cipher::aes128, Mode::cfb} },
             { ::EVP_aes_128_ofb(), {Cipher::aes128, Mode::ofb} },
+            { ::EVP_aes_128_gcm(), {Cipher::aes128, Mode::gcm} },
             // aes192
             { ::EVP_aes_192_cbc(), {Cipher::aes192, Mode::cbc} },
             { ::EVP_aes_192_ecb(), {Cipher::aes192, Mode::ecb} },
             { ::EVP_aes_192_cfb(), {Cipher::aes192, Mode::cfb} },
             { ::EVP_aes_192_ofb(), {Cipher::aes192, Mode::ofb} },
+            { ::EVP_aes_192_gcm(), {Cipher::aes192, Mode::gcm} },
             // aes256
             { ::EVP_aes_256_cbc(), {Cipher::aes256, Mode::cbc} },
             { ::EVP_aes_256_ecb(), {Cipher::aes256, Mode::ecb} },
             { ::EVP_aes_256_cfb(), {Cipher::aes256, Mode::cfb} },
-            { ::EVP_aes_256_ofb(), {Cipher::aes256, Mode::ofb} }
+            { ::EVP_aes_256_ofb(), {Cipher::aes256, Mode::ofb} },
+            { ::EVP_aes_256_gcm(), {Cipher::aes256, Mode::gcm} }
           };
 
         auto it = functions.find(function);
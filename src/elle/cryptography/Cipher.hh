@@ -35,7 +35,9 @@ namespace elle
       cbc,
       ecb,
       cfb,
-      ofb
+      ofb,
+      /// Authenticated encryption, see SecretKey.
+      gcm
     };
 
     /*----------.
@@ -1,12 +1,53 @@
+#include <cstring>
+
+#include <openssl/err.h>
+#include <openssl/rand.h>
+
 #include <elle/cryptography/SecretKey.hh>
 #include <elle/cryptography/random.hh>
 #include <elle/cryptography/Cipher.hh>
+#include <elle/cryptography/Error.hh>
 #include <elle/cryptography/cryptography.hh>
+#include <elle/cryptography/finally.hh>
 #include <elle/cryptography/raw.hh>
 
 #include <elle/serialization/Serializer.hh>
 #include <elle/log.hh>
 
+namespace
+{
+  /// Magic of the authenticated format, followed by its version.
+  char const aead_magic[] = "elleAEAD";
+  unsigned char const aead_version = 1;
+  /// Size of the magic and version, authenticated as associated data.
+  auto const aead_header = sizeof (aead_magic);
+  auto const aead_nonce = std::size_t(12);
+  auto const aead_tag = std::size_t(16);
+  auto const aead_overhead = aead_header + aead_nonce + aead_tag;
+  /// Label the derived keys are bound to.
+  auto const aead_label = elle::ConstWeakBuffer("elle.cryptography.aead.1");
+
+  elle::Buffer
+  read_all(std::istream& input)
+  {
+    auto res = elle::Buffer();
+    auto block = std::size_t(64 * 1024);
+    while (input.good())
+    {
+      auto const size = res.size();
+      res.size(size + block);
+      input.read(reinterpret_cast<char*>(res.mutable_contents() + size),
+                 block);
+      if (input.bad())
+        throw elle::cryptography::Error(
+          elle::sprintf("unable to read the input stream: %s",
+                        input.rdstate()));
+      res.size(size + input.gcount());
+    }
+    return res;
+  }
+}
+
 //
 // ---------- Class -----------------------------------------------------------
 //
@@ -42,6 +83,7 @@ namespace elle
 
     SecretKey::SecretKey(SecretKey&& other)
       : _password(std::move(other._password))
+      , _contexts(std::move(other._contexts))
     {
       // Make sure the cryptographic system is set up.
       cryptography::require();
@@ -57,8 +99,13 @@ namespace elle
                         Mode const mode,
                         Oneway const oneway) const
     {
-      auto in = elle::IOStream(plain.istreambuf());
       auto res = elle::Buffer();
+      if (mode == Mode::gcm)
+      {
+        this->_seal(plain.contents(), plain.size(), res, cipher, oneway);
+        return res;
+      }
+      auto in = elle::IOStream(plain.istreambuf());
       res.capacity(plain.size() + 1024);
       {
         auto out = elle::IOStream(res.ostreambuf());
@@ -67,22 +114,70 @@ namespace elle
       return res;
     }
 
+    elle::Buffer
+    SecretKey::_encipher(elle::Buffer&& plain,
+                         Cipher const cipher,
+                         Mode const mode,
+                         Oneway const oneway) const
+    {
+      if (mode != Mode::gcm)
+        return this->encipher(elle::ConstWeakBuffer(plain),
+                              cipher, mode, oneway);
+      // Make room for the header and nonce, encipher in place.
+      auto const size = plain.size();
+      plain.size(size + aead_overhead);
+      auto const data = plain.mutable_contents() + aead_header + aead_nonce;
+      std::memmove(data, plain.contents(), size);
+      this->_seal(data, size, plain, cipher, oneway);
+      return std::move(plain);
+    }
+
     elle::Buffer
     SecretKey::decipher(elle::ConstWeakBuffer const& code,
                         Cipher const cipher,
                         Mode const mode,
                         Oneway const oneway) const
     {
-      auto in = elle::IOStream(code.istreambuf());
       auto res = elle::Buffer();
+      if (_sealed(code))
+      {
+        res.size(code.size() - aead_overhead);
+        this->_open(code, res.mutable_contents(), cipher, oneway);
+        return res;
+      }
+      auto in = elle::IOStream(code.istreambuf());
       res.capacity(code.size());
       {
         auto out = elle::IOStream(res.ostreambuf());
-        this->decipher(in, out, cipher, mode, oneway);
+        raw::symmetric::decipher(
+          this->_password,
+          cipher::resolve(cipher,
+                          mode == Mode::gcm ? defaults::mode : mode),
+          oneway::resolve(oneway),
+          in,
+          out);
       }
       return res;
     }
 
+    elle::Buffer
+    SecretKey::_decipher(elle::Buffer&& code,
+                         Cipher const cipher,
+                         Mode const mode,
+                         Oneway const oneway) const
+    {
+      if (!_sealed(code))
+        return this->decipher(elle::ConstWeakBuffer(code),
+                              cipher, mode, oneway);
+      // Decipher in place, then drop the header and nonce.
+      auto const data = code.mutable_contents() + aead_header + aead_nonce;
+      this->_open(code, data, cipher, oneway);
+      auto const size = code.size() - aead_overhead;
+      std::memmove(code.mutable_contents(), data, size);
+      code.size(size);
+      return std::move(code);
+    }
+
     void
     SecretKey::encipher(std::istream& plain,
                         std::ostream& code,
@@ -90,6 +185,16 @@ namespace elle
                         Mode const mode,
                         Oneway const oneway) const
     {
+      if (mode == Mode::gcm)
+      {
+        auto const res = this->encipher(read_all(plain), cipher, mode, oneway);
+        code.write(reinterpret_cast<char const*>(res.contents()), res.size());
+        if (!code.good())
+          throw Error(
+            elle::sprintf("unable to write the code's output stream: %s",
+                          code.rdstate()));
+        return;
+      }
       raw::symmetric::encipher(this->_password,
                                cipher::resolve(cipher, mode),
                                oneway::resolve(oneway),
@@ -104,6 +209,16 @@ namespace elle
                         Mode const mode,
                         Oneway const oneway) const
     {
+      if (mode == Mode::gcm)
+      {
+        auto const res = this->decipher(read_all(code), cipher, mode, oneway);
+        plain.write(reinterpret_cast<char const*>(res.contents()), res.size());
+        if (!plain.good())
+          throw Error(
+            elle::sprintf("unable to write the plain's output stream: %s",
+                          plain.rdstate()));
+        return;
+      }
       raw::symmetric::decipher(this->_password,
                                cipher::resolve(cipher, mode),
                                oneway::resolve(oneway),
@@ -133,6 +248,121 @@ namespace elle
       return this->_password == other._password;
     }
 
+    SecretKey&
+    SecretKey::operator =(SecretKey&& other)
+    {
+      std::lock_guard<std::mutex> lock(this->_contexts_mutex);
+      this->_password = std::move(other._password);
+      this->_contexts = std::move(other._contexts);
+      return *this;
+    }
+
+    /*-----.
+    | AEAD |
+    `-----*/
+
+    bool
+    SecretKey::_sealed(elle::ConstWeakBuffer const& code)
+    {
+      return code.size() >= aead_overhead &&
+        std::memcmp(code.contents(), aead_magic, aead_header - 1) == 0 &&
+        code.contents()[aead_header - 1] == aead_version;
+    }
+
+    std::shared_ptr<::EVP_CIPHER_CTX>
+    SecretKey::_context(Cipher const cipher,
+                        Oneway const oneway) const
+    {
+      std::lock_guard<std::mutex> lock(this->_contexts_mutex);
+      auto& res = this->_contexts[std::make_pair(cipher, oneway)];
+      if (!res)
+      {
+        auto const function = cipher::resolve(cipher, Mode::gcm);
+        auto const key = raw::aead::derive(this->_password,
+                                           oneway::resolve(oneway),
+                                           aead_label,
+                                           ::EVP_CIPHER_key_length(function));
+        auto context = std::shared_ptr<::EVP_CIPHER_CTX>(
+          ::EVP_CIPHER_CTX_new(), &::EVP_CIPHER_CTX_free);
+        if (!context)
+          throw Error("unable to allocate the cipher context");
+        // Expand the key schedule once, nonces are set per message.
+        if (::EVP_EncryptInit_ex(context.get(),
+                                 function,
+                                 nullptr,
+                                 key.contents(),
+                                 nullptr) <= 0)
+          throw Error(
+            elle::sprintf("unable to initialize the encryption process: %s",
+                          ::ERR_error_string(ERR_get_error(), nullptr)));
+        res = std::move(context);
+      }
+      return res;
+    }
+
+    void
+    SecretKey::_seal(unsigned char const* plain,
+                     std::size_t size,
+                     elle::Buffer& code,
+                     Cipher const cipher,
+                     Oneway const oneway) const
+    {
+      auto const keyed = this->_context(cipher, oneway);
+      code.size(size + aead_overhead);
+      auto const header = code.mutable_contents();
+      std::memcpy(header, aead_magic, aead_header - 1);
+      header[aead_header - 1] = aead_version;
+      auto const nonce = header + aead_header;
+      if (::RAND_bytes(nonce, aead_nonce) <= 0)
+        throw Error(
+          elle::sprintf("unable to generate a nonce: %s",
+                        ::ERR_error_string(ERR_get_error(), nullptr)));
+      // Work on a copy so the key schedule can be shared between threads.
+      ::EVP_CIPHER_CTX context;
+      ::EVP_CIPHER_CTX_init(&context);
+      ELLE_CRYPTOGRAPHY_FINALLY_ACTION_CLEANUP_CIPHER_CONTEXT(context);
+      if (::EVP_CIPHER_CTX_copy(&context, keyed.get()) <= 0)
+        throw Error(
+          elle::sprintf("unable to copy the cipher context: %s",
+                        ::ERR_error_string(ERR_get_error(), nullptr)));
+      auto const data = nonce + aead_nonce;
+      raw::aead::seal(&context,
+                      elle::ConstWeakBuffer(nonce, aead_nonce),
+                      elle::ConstWeakBuffer(header, aead_header),
+                      plain,
+                      size,
+                      data,
+                      elle::WeakBuffer(data + size, aead_tag));
+    }
+
+    void
+    SecretKey::_open(elle::ConstWeakBuffer const& code,
+                     unsigned char* plain,
+                     Cipher const cipher,
+                     Oneway const oneway) const
+    {
+      auto const keyed = this->_context(cipher, oneway);
+      auto const size = code.size() - aead_overhead;
+      auto const header = code.contents();
+      auto const nonce = header + aead_header;
+      auto const data = nonce + aead_nonce;
+      ::EVP_CIPHER_CTX context;
+      ::EVP_CIPHER_CTX_init(&context);
+      ELLE_CRYPTOGRAPHY_FINALLY_ACTION_CLEANUP_CIPHER_CONTEXT(context);
+      if (::EVP_CIPHER_CTX_copy(&context, keyed.get()) <= 0)
+        throw Error(
+          elle::sprintf("unable to copy the cipher context: %s",
+                        ::ERR_error_string(ERR_get_error(), nullptr)));
+      if (!raw::aead::open(&context,
+                           elle::ConstWeakBuffer(nonce, aead_nonce),
+                           elle::ConstWeakBuffer(header, aead_header),
+                           data,
+                           size,
+                           plain,
+                           elle::ConstWeakBuffer(data + size, aead_tag)))
+        throw Error("the code failed authentication");
+    }
+
     /*----------.
     | Printable |
     `----------*/
@@ -158,6 +388,11 @@ namespace elle
     SecretKey::serialize(elle::serialization::Serializer& serializer)
     {
       serializer.serialize("password", this->_password);
+      if (serializer.in())
+      {
+        std::lock_guard<std::mutex> lock(this->_contexts_mutex);
+        this->_contexts.clear();
+      }
     }
   }
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
 #include <utility>
 
 #include <boost/operators.hpp>
@@ -22,6 +26,13 @@ namespace elle
   namespace cryptography
   {
     /// Represent a secret key for symmetric cryptosystem operations.
+    ///
+    /// With Mode::gcm, only available with AES ciphers, code is produced in
+    /// a versioned authenticated format: a key is derived from the password
+    /// once per cipher and oneway and its schedule cached in the SecretKey,
+    /// every message is enciphered and authenticated in a single pass with a
+    /// random nonce. Deciphering recognizes the format: code produced with
+    /// `defaults::mode` can still be deciphered when passing Mode::gcm.
     class SecretKey
       : public elle::Printable
       , private boost::totally_ordered<SecretKey>
@@ -61,12 +72,28 @@ namespace elle
                Cipher const cipher = defaults::cipher,
                Mode const mode = defaults::mode,
                Oneway const oneway = defaults::oneway) const;
+      /// Encipher a given plain text, in place with Mode::gcm.
+      template <typename B,
+                typename = std::enable_if_t<std::is_same<B, elle::Buffer>{}>>
+      elle::Buffer
+      encipher(B&& plain,
+               Cipher const cipher = defaults::cipher,
+               Mode const mode = defaults::mode,
+               Oneway const oneway = defaults::oneway) const;
       /// Decipher a given code and return the original plain text.
       elle::Buffer
       decipher(elle::ConstWeakBuffer const& code,
                Cipher const cipher = defaults::cipher,
                Mode const mode = defaults::mode,
                Oneway const oneway = defaults::oneway) const;
+      /// Decipher a given code, in place if authenticated.
+      template <typename B,
+                typename = std::enable_if_t<std::is_same<B, elle::Buffer>{}>>
+      elle::Buffer
+      decipher(B&& code,
+               Cipher const cipher = defaults::cipher,
+               Mode const mode = defaults::mode,
+               Oneway const oneway = defaults::oneway) const;
       /// Encipher an input stream and put the cipher text in the
       /// output stream.
       virtual
@@ -100,7 +127,7 @@ namespace elle
       SecretKey&
       operator =(SecretKey const&) = delete;
       SecretKey&
-      operator =(SecretKey&&) = default;
+      operator =(SecretKey&& other);
 
       /*----------.
       | Printable |
@@ -123,6 +150,49 @@ namespace elle
       `-----------*/
     private:
       ELLE_ATTRIBUTE_R(elle::Buffer, password);
+
+      /*-----.
+      | AEAD |
+      `-----*/
+    private:
+      elle::Buffer
+      _encipher(elle::Buffer&& plain,
+                Cipher const cipher,
+                Mode const mode,
+                Oneway const oneway) const;
+      elle::Buffer
+      _decipher(elle::Buffer&& code,
+                Cipher const cipher,
+                Mode const mode,
+                Oneway const oneway) const;
+      /// The authenticated code of @a size bytes from @a plain, written to
+      /// @a code.
+      void
+      _seal(unsigned char const* plain,
+            std::size_t size,
+            elle::Buffer& code,
+            Cipher const cipher,
+            Oneway const oneway) const;
+      /// Decipher the authenticated @a code to @a plain.
+      ///
+      /// @throw Error if @a code was altered.
+      void
+      _open(elle::ConstWeakBuffer const& code,
+            unsigned char* plain,
+            Cipher const cipher,
+            Oneway const oneway) const;
+      /// Whether @a code is in the authenticated format.
+      static
+      bool
+      _sealed(elle::ConstWeakBuffer const& code);
+      /// A context initialized with the derived key.
+      std::shared_ptr<::EVP_CIPHER_CTX>
+      _context(Cipher const cipher,
+               Oneway const oneway) const;
+      using Contexts =
+        std::map<std::pair<Cipher, Oneway>, std::shared_ptr<::EVP_CIPHER_CTX>>;
+      ELLE_ATTRIBUTE(Contexts, contexts, mutable);
+      ELLE_ATTRIBUTE(std::mutex, contexts_mutex, mutable);
     };
   }
 }
@@ -147,3 +217,5 @@ namespace elle
     }
   }
 }
+
+#include <elle/cryptography/SecretKey.hxx>
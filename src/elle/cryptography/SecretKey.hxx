@@ -0,0 +1,29 @@
+namespace elle
+{
+  namespace cryptography
+  {
+    /*--------.
+    | Methods |
+    `--------*/
+
+    template <typename B, typename>
+    elle::Buffer
+    SecretKey::encipher(B&& plain,
+                        Cipher const cipher,
+                        Mode const mode,
+                        Oneway const oneway) const
+    {
+      return this->_encipher(std::move(plain), cipher, mode, oneway);
+    }
+
+    template <typename B, typename>
+    elle::Buffer
+    SecretKey::decipher(B&& code,
+                        Cipher const cipher,
+                        Mode const mode,
+                        Oneway const oneway) const
+    {
+      return this->_decipher(std::move(code), cipher, mode, oneway);
+    }
+  }
+}
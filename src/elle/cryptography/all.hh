@@ -5,6 +5,7 @@
 #include <elle/cryptography/Error.hh>
 #include <elle/cryptography/Oneway.hh>
 #include <elle/cryptography/SecretKey.hh>
+#include <elle/cryptography/batch.hh>
 #include <elle/cryptography/bn.hh>
 #include <elle/cryptography/cryptography.hh>
 #include <elle/cryptography/raw.hh>
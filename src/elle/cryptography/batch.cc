@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <openssl/err.h>
+
+#include <elle/cryptography/batch.hh>
+#include <elle/cryptography/cryptography.hh>
+#include <elle/log.hh>
+#include <elle/printf.hh>
+
+ELLE_LOG_COMPONENT("elle.cryptography.batch");
+
+namespace elle
+{
+  namespace cryptography
+  {
+    namespace batch
+    {
+      /*-----------.
+      | Statistics |
+      `-----------*/
+
+      Statistics::Statistics()
+        : _items(0)
+        , _failures(0)
+        , _workers(0)
+        , _elapsed(0)
+      {}
+
+      double
+      Statistics::per_second() const
+      {
+        if (this->_elapsed.count() <= 0)
+          return 0;
+        return this->_items / this->_elapsed.count();
+      }
+
+      void
+      Statistics::print(std::ostream& stream) const
+      {
+        elle::fprintf(stream, "%s items (%s failed) on %s workers in %.3fs: "
+                      "%.0f/s",
+                      this->_items, this->_failures, this->_workers,
+                      this->_elapsed.count(), this->per_second());
+      }
+
+      /*----.
+      | Run |
+      `----*/
+
+      Statistics
+      run(std::size_t count,
+          int workers,
+          std::function<std::function<void (std::size_t)> ()> const& worker)
+      {
+        // Make sure the cryptographic system, including its locking
+        // callbacks, is set up before spawning threads.
+        cryptography::require();
+        if (workers <= 0)
+          workers = std::max(1u, std::thread::hardware_concurrency());
+        // No point in having workers without a chunk to process.
+        workers = static_cast<int>(
+          std::min<std::size_t>(workers, (count + chunk - 1) / chunk));
+        workers = std::max(workers, 1);
+        ELLE_TRACE_SCOPE("process %s items on %s workers", count, workers);
+        auto const start = std::chrono::steady_clock::now();
+        auto next = std::atomic<std::size_t>(0);
+        auto error = std::exception_ptr{};
+        auto error_mutex = std::mutex{};
+        auto const work = [&]
+          {
+            try
+            {
+              auto process = worker();
+              while (true)
+              {
+                auto const begin = next.fetch_add(chunk);
+                if (begin >= count)
+                  break;
+                auto const end = std::min(begin + chunk, count);
+                for (auto i = begin; i < end; ++i)
+                  process(i);
+              }
+            }
+            catch (...)
+            {
+              std::lock_guard<std::mutex> lock(error_mutex);
+              if (!error)
+                error = std::current_exception();
+              // Stop the other workers.
+              next = count;
+            }
+          };
+        {
+          // The calling thread is one of the workers.
+          auto threads = std::vector<std::thread>{};
+          for (int i = 1; i < workers; ++i)
+            threads.emplace_back(
+              [&]
+              {
+                work();
+                // Release this thread's OpenSSL error queue.
+                ::ERR_remove_state(0);
+              });
+          work();
+          for (auto& t: threads)
+            t.join();
+        }
+        if (error)
+          std::rethrow_exception(error);
+        auto res = Statistics{};
+        res.items(count);
+        res.workers(workers);
+        res.elapsed(std::chrono::steady_clock::now() - start);
+        ELLE_DEBUG("%s", res);
+        return res;
+      }
+    }
+  }
+}
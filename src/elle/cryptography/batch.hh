@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <elle/Printable.hh>
+#include <elle/attribute.hh>
+
+namespace elle
+{
+  namespace cryptography
+  {
+    /// Run a cryptographic operation over many items on several threads.
+    ///
+    /// Items are handed out to the workers in chunks. Every worker builds its
+    /// own state once, typically an initialized OpenSSL context, and reuses it
+    /// for all the items it processes. The call blocks until every item is
+    /// processed: from a reactor thread, run it through reactor::background
+    /// so the scheduler is not stalled.
+    namespace batch
+    {
+      /// Number of items a worker takes at once.
+      static std::size_t const chunk = 64;
+
+      /// The outcome of one item: either a value or the reason it could not
+      /// be computed.
+      template <typename T>
+      struct Result
+      {
+        boost::optional<T> value;
+        std::string error;
+
+        explicit
+        operator bool() const
+        {
+          return bool(this->value);
+        }
+      };
+
+      /// Throughput of a batch.
+      class Statistics
+        : public elle::Printable
+      {
+      public:
+        Statistics();
+        /// Items processed per second.
+        double
+        per_second() const;
+        void
+        print(std::ostream& stream) const override;
+        ELLE_ATTRIBUTE_RW(std::size_t, items);
+        ELLE_ATTRIBUTE_RW(std::size_t, failures);
+        ELLE_ATTRIBUTE_RW(int, workers);
+        ELLE_ATTRIBUTE_RW(std::chrono::duration<double>, elapsed);
+      };
+
+      /// The results of a batch, in the order of the items.
+      template <typename T>
+      struct Outcome
+      {
+        std::vector<Result<T>> results;
+        Statistics statistics;
+      };
+
+      /// Process the @a count items on @a workers threads, all the hardware
+      /// threads if zero.
+      ///
+      /// @a worker is called once on each thread and returns the function
+      /// computing an item from its index. Errors thrown by the latter are
+      /// reported in the item's result.
+      template <typename T>
+      Outcome<T>
+      run(std::size_t count,
+          int workers,
+          std::function<std::function<T (std::size_t)> ()> const& worker);
+
+      /// Process the @a count items on @a workers threads, @a worker being
+      /// called once per thread and returning the function processing an
+      /// item.
+      Statistics
+      run(std::size_t count,
+          int workers,
+          std::function<std::function<void (std::size_t)> ()> const& worker);
+    }
+  }
+}
+
+#include <elle/cryptography/batch.hxx>
@@ -0,0 +1,46 @@
+#include <elle/Exception.hh>
+
+namespace elle
+{
+  namespace cryptography
+  {
+    namespace batch
+    {
+      template <typename T>
+      Outcome<T>
+      run(std::size_t count,
+          int workers,
+          std::function<std::function<T (std::size_t)> ()> const& worker)
+      {
+        auto res = Outcome<T>{};
+        res.results.resize(count);
+        auto& results = res.results;
+        res.statistics = run(
+          count,
+          workers,
+          std::function<std::function<void (std::size_t)> ()>(
+            [&]
+            {
+              return
+                [&results, process = worker()] (std::size_t i)
+                {
+                  try
+                  {
+                    results[i].value = process(i);
+                  }
+                  catch (...)
+                  {
+                    results[i].error = elle::exception_string();
+                  }
+                };
+            }));
+        auto failures = std::size_t(0);
+        for (auto const& r: results)
+          if (!r)
+            ++failures;
+        res.statistics.failures(failures);
+        return res;
+      }
+    }
+  }
+}
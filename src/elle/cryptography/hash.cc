@@ -1,9 +1,14 @@
 # include <openssl/evp.h>
 
+#include <openssl/err.h>
+
+#include <elle/cryptography/Error.hh>
+#include <elle/cryptography/cryptography.hh>
 #include <elle/cryptography/hash.hh>
 #include <elle/cryptography/raw.hh>
 
 #include <elle/Buffer.hh>
+#include <elle/finally.hh>
 #include <elle/log.hh>
 
 namespace elle
@@ -18,9 +23,17 @@ namespace elle
     hash(elle::ConstWeakBuffer const& plain,
          Oneway const oneway)
     {
-      elle::IOStream _plain(plain.istreambuf());
+      // Digest the buffer in place rather than through a stream, which would
+      // copy it block by block.
+      auto done = false;
+      auto next_block = [&] () -> elle::ConstWeakBuffer {
+        if (done)
+          return elle::ConstWeakBuffer();
+        done = true;
+        return plain;
+      };
 
-      return (hash(_plain, oneway));
+      return (hash(next_block, oneway));
     }
 
     elle::Buffer
@@ -41,5 +54,61 @@ namespace elle
 
       return (raw::hash(function, plain));
     }
+
+    std::vector<elle::Buffer>
+    hash(elle::ConstWeakBuffer const& plain,
+         std::vector<Oneway> const& oneways)
+    {
+      // Make sure the cryptographic system is set up.
+      cryptography::require();
+      // Small enough for a block to stay in cache across functions.
+      static auto const block_size = std::size_t(64 * 1024);
+      auto contexts = std::vector< ::EVP_MD_CTX>(oneways.size());
+      for (auto& context: contexts)
+        ::EVP_MD_CTX_init(&context);
+      elle::SafeFinally cleanup(
+        [&]
+        {
+          for (auto& context: contexts)
+            ::EVP_MD_CTX_cleanup(&context);
+        });
+      for (auto i = 0u; i < oneways.size(); ++i)
+        if (::EVP_DigestInit_ex(&contexts[i],
+                                oneway::resolve(oneways[i]),
+                                nullptr) <= 0)
+          throw Error(
+            elle::sprintf("unable to initialize the digest process: %s",
+                          ::ERR_error_string(ERR_get_error(), nullptr)));
+      for (auto offset = std::size_t(0);
+           offset < plain.size();
+           offset += block_size)
+      {
+        auto const size = std::min(block_size, plain.size() - offset);
+        for (auto& context: contexts)
+          if (::EVP_DigestUpdate(&context,
+                                 plain.contents() + offset,
+                                 size) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the digest function: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+      }
+      auto digests = std::vector<elle::Buffer>{};
+      digests.reserve(contexts.size());
+      for (auto& context: contexts)
+      {
+        elle::Buffer digest(EVP_MD_size(::EVP_MD_CTX_md(&context)));
+        unsigned int size(0);
+        if (::EVP_DigestFinal_ex(&context,
+                                 digest.mutable_contents(),
+                                 &size) <= 0)
+          throw Error(
+            elle::sprintf("unable to finalize the digest process: %s",
+                          ::ERR_error_string(ERR_get_error(), nullptr)));
+        digest.size(size);
+        digests.emplace_back(std::move(digest));
+      }
+
+      return (digests);
+    }
   }
 }
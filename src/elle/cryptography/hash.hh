@@ -5,6 +5,7 @@
 # include <elle/cryptography/Oneway.hh>
 
 # include <iosfwd>
+# include <vector>
 
 namespace elle
 {
@@ -25,6 +26,13 @@ namespace elle
     elle::Buffer
     hash(std::istream& plain,
          Oneway const oneway);
+    /// Hash a plain text with several functions in a single pass.
+    ///
+    /// Each block of the text goes through every function while it is still
+    /// in cache. Digests are returned in the order of @a oneways.
+    std::vector<elle::Buffer>
+    hash(elle::ConstWeakBuffer const& plain,
+         std::vector<Oneway> const& oneways);
   }
 }
 
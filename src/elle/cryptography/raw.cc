@@ -20,7 +20,7 @@
 #include <openssl/rand.h>
 #include <openssl/evp.h>
 
-
+#include <algorithm>
 #include <thread>
 
 #if defined(ELLE_CRYPTOGRAPHY_ROTATION)
@@ -513,6 +513,123 @@ namespace elle
           return (buffer);
         }
 #endif
+
+        /*-------.
+        | Signer |
+        `-------*/
+
+        Signer::Signer(::EVP_PKEY* key,
+                       ::EVP_MD const* oneway,
+                       Operation operation,
+                       std::function<void (::EVP_MD_CTX*,
+                                           ::EVP_PKEY_CTX*)> prolog)
+          : _key(key)
+          , _operation(operation)
+          , _initial(::EVP_MD_CTX_create())
+          , _context(::EVP_MD_CTX_create())
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          ELLE_ASSERT(key);
+
+          if (!this->_initial || !this->_context)
+          {
+            ::EVP_MD_CTX_destroy(this->_initial);
+            ::EVP_MD_CTX_destroy(this->_context);
+            throw Error(
+              elle::sprintf("unable to allocate the signature contexts: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          }
+
+          ::EVP_PKEY_CTX* ctx = nullptr;
+          auto const res = operation == Operation::sign
+            ? ::EVP_DigestSignInit(this->_initial, &ctx, oneway, NULL, key)
+            : ::EVP_DigestVerifyInit(this->_initial, &ctx, oneway, NULL, key);
+          if (res <= 0)
+          {
+            ::EVP_MD_CTX_destroy(this->_initial);
+            ::EVP_MD_CTX_destroy(this->_context);
+            throw Error(
+              elle::sprintf("unable to initialize the context for %s: %s",
+                            operation == Operation::sign
+                            ? "signature" : "verify",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          }
+
+          ELLE_ASSERT(ctx != nullptr);
+          if (prolog)
+            prolog(this->_initial, ctx);
+        }
+
+        Signer::~Signer()
+        {
+          ::EVP_MD_CTX_destroy(this->_context);
+          ::EVP_MD_CTX_destroy(this->_initial);
+        }
+
+        void
+        Signer::_reset()
+        {
+          // Duplicate both the digest and the key context, the latter
+          // holding the padding set by the prolog.
+          if (::EVP_MD_CTX_copy_ex(this->_context, this->_initial) <= 0)
+            throw Error(
+              elle::sprintf("unable to duplicate the signature context: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+        }
+
+        elle::Buffer
+        Signer::sign(elle::ConstWeakBuffer const& plain)
+        {
+          ELLE_ASSERT_EQ(this->_operation, Operation::sign);
+          this->_reset();
+          if (::EVP_DigestSignUpdate(this->_context,
+                                     plain.contents(),
+                                     plain.size()) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the signature function: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          auto size = static_cast<size_t>(::EVP_PKEY_size(this->_key));
+          elle::Buffer signature(size);
+          if (::EVP_DigestSignFinal(this->_context,
+                                    signature.mutable_contents(),
+                                    &size) <= 0)
+            throw Error(
+              elle::sprintf("unable to finalize the signature process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          signature.size(size);
+          return signature;
+        }
+
+        bool
+        Signer::verify(elle::ConstWeakBuffer const& signature,
+                       elle::ConstWeakBuffer const& plain)
+        {
+          ELLE_ASSERT_EQ(this->_operation, Operation::verify);
+          this->_reset();
+          if (::EVP_DigestVerifyUpdate(this->_context,
+                                       plain.contents(),
+                                       plain.size()) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the verify function: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          switch (::EVP_DigestVerifyFinal(this->_context,
+                                          signature.contents(),
+                                          signature.size()))
+          {
+            case 1:
+              return true;
+            case 0:
+              // A plain mismatch leaves an error in the thread's queue.
+              ::ERR_clear_error();
+              return false;
+            default:
+              throw Error(
+                elle::sprintf("unable to verify the signature: %s",
+                              ::ERR_error_string(ERR_get_error(), nullptr)));
+          }
+        }
       }
     }
   }
@@ -831,6 +948,145 @@ namespace elle
   }
 }
 
+//
+// ---------- AEAD ------------------------------------------------------------
+//
+
+namespace elle
+{
+  namespace cryptography
+  {
+    namespace raw
+    {
+      namespace aead
+      {
+        elle::Buffer
+        derive(elle::ConstWeakBuffer const& secret,
+               ::EVP_MD const* oneway,
+               elle::ConstWeakBuffer const& label,
+               int length)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          auto res = elle::Buffer();
+          auto block = elle::Buffer();
+          for (unsigned char i = 1; res.size() < unsigned(length); ++i)
+          {
+            if (i == 0)
+              throw Error(elle::sprintf("unable to derive a key of %s bytes",
+                                        length));
+            block.append(label.contents(), label.size());
+            block.append(&i, 1);
+            unsigned char digest[EVP_MAX_MD_SIZE];
+            unsigned int size(0);
+            if (::HMAC(oneway,
+                       secret.contents(), secret.size(),
+                       block.contents(), block.size(),
+                       digest, &size) == nullptr)
+              throw Error(
+                elle::sprintf("unable to derive the key: %s",
+                              ::ERR_error_string(ERR_get_error(), nullptr)));
+            res.append(digest, std::min<std::size_t>(size, length - res.size()));
+            block = elle::Buffer(digest, size);
+          }
+          return res;
+        }
+
+        void
+        seal(::EVP_CIPHER_CTX* context,
+             elle::ConstWeakBuffer const& nonce,
+             elle::ConstWeakBuffer const& aad,
+             unsigned char const* input,
+             int size,
+             unsigned char* output,
+             elle::WeakBuffer tag)
+        {
+          // Set the nonce, keeping the key schedule.
+          if (::EVP_EncryptInit_ex(context,
+                                   nullptr,
+                                   nullptr,
+                                   nullptr,
+                                   nonce.contents()) <= 0)
+            throw Error(
+              elle::sprintf("unable to initialize the encryption process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          int length(0);
+          if (::EVP_EncryptUpdate(context,
+                                  nullptr,
+                                  &length,
+                                  aad.contents(),
+                                  aad.size()) <= 0)
+            throw Error(
+              elle::sprintf("unable to authenticate the associated data: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          // Encrypt and authenticate in a single pass.
+          if (size > 0 &&
+              ::EVP_EncryptUpdate(context, output, &length, input, size) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the encryption function: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          if (::EVP_EncryptFinal_ex(context, output + size, &length) <= 0)
+            throw Error(
+              elle::sprintf("unable to finalize the encryption process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          ELLE_ASSERT_EQ(length, 0);
+          if (::EVP_CIPHER_CTX_ctrl(context,
+                                    EVP_CTRL_GCM_GET_TAG,
+                                    tag.size(),
+                                    tag.mutable_contents()) <= 0)
+            throw Error(
+              elle::sprintf("unable to retrieve the authentication tag: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+        }
+
+        bool
+        open(::EVP_CIPHER_CTX* context,
+             elle::ConstWeakBuffer const& nonce,
+             elle::ConstWeakBuffer const& aad,
+             unsigned char const* input,
+             int size,
+             unsigned char* output,
+             elle::ConstWeakBuffer const& tag)
+        {
+          if (::EVP_DecryptInit_ex(context,
+                                   nullptr,
+                                   nullptr,
+                                   nullptr,
+                                   nonce.contents()) <= 0)
+            throw Error(
+              elle::sprintf("unable to initialize the decryption process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          int length(0);
+          if (::EVP_DecryptUpdate(context,
+                                  nullptr,
+                                  &length,
+                                  aad.contents(),
+                                  aad.size()) <= 0)
+            throw Error(
+              elle::sprintf("unable to authenticate the associated data: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          if (size > 0 &&
+              ::EVP_DecryptUpdate(context, output, &length, input, size) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the decryption function: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          if (::EVP_CIPHER_CTX_ctrl(
+                context,
+                EVP_CTRL_GCM_SET_TAG,
+                tag.size(),
+                const_cast<unsigned char*>(tag.contents())) <= 0)
+            throw Error(
+              elle::sprintf("unable to set the authentication tag: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          // Verify the tag.
+          return ::EVP_DecryptFinal_ex(context, output + size, &length) > 0;
+        }
+      }
+    }
+  }
+}
+
 //
 // ---------- Hash ------------------------------------------------------------
 //
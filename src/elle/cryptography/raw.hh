@@ -5,6 +5,7 @@
 # include <elle/cryptography/Cipher.hh>
 # include <elle/cryptography/Oneway.hh>
 
+# include <elle/attribute.hh>
 # include <elle/fwd.hh>
 
 # include <memory>
@@ -82,6 +83,49 @@ namespace elle
                  std::function<void (::EVP_PKEY_CTX*)> prolog = nullptr,
                  std::function<void (::EVP_PKEY_CTX*)> epilog = nullptr);
 # endif
+
+        /*--------.
+        | Classes |
+        `--------*/
+
+        /// A signature context initialized once for a key and reused for
+        /// many messages.
+        ///
+        /// The initialized context is duplicated for every message instead
+        /// of going through EVP_DigestSignInit()/EVP_DigestVerifyInit() and
+        /// the prolog again. A Signer is not thread-safe: batches use one per
+        /// worker.
+        class Signer
+        {
+        public:
+          enum class Operation
+          {
+            sign,
+            verify,
+          };
+          Signer(::EVP_PKEY* key,
+                 ::EVP_MD const* oneway,
+                 Operation operation,
+                 std::function<void (::EVP_MD_CTX*,
+                                     ::EVP_PKEY_CTX*)> prolog = nullptr);
+          Signer(Signer const&) = delete;
+          ~Signer();
+          /// Sign the given plain text.
+          elle::Buffer
+          sign(elle::ConstWeakBuffer const& plain);
+          /// Return true if the signature is valid according to the plain.
+          bool
+          verify(elle::ConstWeakBuffer const& signature,
+                 elle::ConstWeakBuffer const& plain);
+        private:
+          /// Reset the working context to the initialized one.
+          void
+          _reset();
+          ELLE_ATTRIBUTE(::EVP_PKEY*, key);
+          ELLE_ATTRIBUTE(Operation, operation);
+          ELLE_ATTRIBUTE(::EVP_MD_CTX*, initial);
+          ELLE_ATTRIBUTE(::EVP_MD_CTX*, context);
+        };
       }
     }
   }
@@ -120,6 +164,49 @@ namespace elle
                  std::function<void (::EVP_CIPHER_CTX*)> prolog = nullptr,
                  std::function<void (::EVP_CIPHER_CTX*)> epilog = nullptr);
       }
+
+      /// Contain the operations related to authenticated encryption.
+      ///
+      /// Unlike the symmetric functions, these operate on memory, in place,
+      /// with a context already initialized with the cipher and key so the
+      /// key schedule can be reused from one message to the next.
+      namespace aead
+      {
+        /// Derive a key of @a length bytes from the given secret.
+        ///
+        /// The key is expanded as in HKDF: T(i) = HMAC(secret, T(i - 1) |
+        /// label | i), @a label binding the key to its usage.
+        elle::Buffer
+        derive(elle::ConstWeakBuffer const& secret,
+               ::EVP_MD const* oneway,
+               elle::ConstWeakBuffer const& label,
+               int length);
+        /// Encrypt @a size bytes from @a input to @a output, authenticating
+        /// them along with @a aad, and write the tag to @a tag.
+        ///
+        /// @a input and @a output may be equal to encrypt in place, but not
+        /// otherwise overlap.
+        void
+        seal(::EVP_CIPHER_CTX* context,
+             elle::ConstWeakBuffer const& nonce,
+             elle::ConstWeakBuffer const& aad,
+             unsigned char const* input,
+             int size,
+             unsigned char* output,
+             elle::WeakBuffer tag);
+        /// Decrypt @a size bytes from @a input to @a output.
+        ///
+        /// @return Whether the data and @a aad match the tag. The content of
+        ///         @a output is undefined if they do not.
+        bool
+        open(::EVP_CIPHER_CTX* context,
+             elle::ConstWeakBuffer const& nonce,
+             elle::ConstWeakBuffer const& aad,
+             unsigned char const* input,
+             int size,
+             unsigned char* output,
+             elle::ConstWeakBuffer const& tag);
+      }
     }
   }
 }
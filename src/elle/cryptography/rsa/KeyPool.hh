@@ -14,6 +14,11 @@ namespace elle
   {
     namespace rsa
     {
+      /// A pool of key pairs generated ahead of time by system threads.
+      ///
+      /// get() blocks the calling system thread until a key is ready: from
+      /// reactor code, use an elle::reactor::ProducerPool<KeyPair> producing
+      /// keypair::generate(), which only blocks the calling reactor Thread.
       class KeyPool
         : public elle::ProducerPool<KeyPair>
       {
@@ -9,6 +9,7 @@
 #include <elle/log.hh>
 
 #include <elle/cryptography/Error.hh>
+#include <elle/cryptography/batch.hh>
 #include <elle/cryptography/bn.hh>
 #include <elle/cryptography/cryptography.hh>
 #include <elle/cryptography/envelope.hh>
@@ -27,6 +28,8 @@
 # include <dopenssl/rsa.hh>
 #endif
 
+ELLE_LOG_COMPONENT("elle.cryptography.rsa.PrivateKey");
+
 namespace elle
 {
   namespace cryptography
@@ -252,6 +255,34 @@ namespace elle
                   prolog);
       }
 
+      batch::Outcome<elle::Buffer>
+      PrivateKey::sign_many(std::vector<elle::ConstWeakBuffer> const& plains,
+                            Padding const padding,
+                            Oneway const oneway,
+                            int workers) const
+      {
+        ELLE_TRACE_SCOPE("%s: sign %s plain texts", this, plains.size());
+        auto const worker =
+          [&] () -> std::function<elle::Buffer (std::size_t)>
+          {
+            auto signer = std::make_shared<raw::asymmetric::Signer>(
+              this->_key.get(),
+              oneway::resolve(oneway),
+              raw::asymmetric::Signer::Operation::sign,
+              [padding] (::EVP_MD_CTX*, ::EVP_PKEY_CTX* ctx)
+              {
+                padding::pad(ctx, padding);
+              });
+            return [signer, &plains] (std::size_t i)
+              {
+                return signer->sign(plains[i]);
+              };
+          };
+        auto res = batch::run<elle::Buffer>(plains.size(), workers, worker);
+        ELLE_DEBUG("%s", res.statistics);
+        return res;
+      }
+
       uint32_t
       PrivateKey::size() const
       {
@@ -2,11 +2,13 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <boost/operators.hpp>
 
 #include <elle/serialization.hh>
 
+#include <elle/cryptography/batch.hh>
 #include <elle/cryptography/fwd.hh>
 #include <elle/cryptography/types.hh>
 #include <elle/cryptography/Oneway.hh>
@@ -111,6 +113,16 @@ namespace elle
         sign(std::istream& plain,
              Padding const padding = defaults::signature_padding,
              Oneway const oneway = defaults::oneway) const;
+        /// Sign many plain texts on @a workers threads, all the hardware
+        /// threads if zero, each reusing its own initialized context.
+        ///
+        /// The signatures are in the order of @a plains, an item whose
+        /// signature failed carrying the error rather than throwing.
+        batch::Outcome<elle::Buffer>
+        sign_many(std::vector<elle::ConstWeakBuffer> const& plains,
+                  Padding const padding = defaults::signature_padding,
+                  Oneway const oneway = defaults::oneway,
+                  int workers = 0) const;
         /// Return the private key's size in bytes.
         uint32_t
         size() const;
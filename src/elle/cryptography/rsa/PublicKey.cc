@@ -23,6 +23,7 @@
 #include <elle/cryptography/rsa/der.hh>
 #include <elle/cryptography/Error.hh>
 #include <elle/cryptography/cryptography.hh>
+#include <elle/cryptography/batch.hh>
 #include <elle/cryptography/bn.hh>
 #include <elle/cryptography/raw.hh>
 #include <elle/cryptography/envelope.hh>
@@ -249,6 +250,34 @@ namespace elle
                   prolog));
       }
 
+      batch::Outcome<bool>
+      PublicKey::verify_many(std::vector<Signed> const& items,
+                             Padding const padding,
+                             Oneway const oneway,
+                             int workers) const
+      {
+        ELLE_TRACE_SCOPE("%s: verify %s signatures", this, items.size());
+        auto const worker =
+          [&] () -> std::function<bool (std::size_t)>
+          {
+            auto signer = std::make_shared<raw::asymmetric::Signer>(
+              this->_key.get(),
+              oneway::resolve(oneway),
+              raw::asymmetric::Signer::Operation::verify,
+              [padding] (::EVP_MD_CTX*, ::EVP_PKEY_CTX* ctx)
+              {
+                padding::pad(ctx, padding);
+              });
+            return [signer, &items] (std::size_t i)
+              {
+                return signer->verify(items[i].first, items[i].second);
+              };
+          };
+        auto res = batch::run<bool>(items.size(), workers, worker);
+        ELLE_DEBUG("%s", res.statistics);
+        return res;
+      }
+
       uint32_t
       PublicKey::size() const
       {
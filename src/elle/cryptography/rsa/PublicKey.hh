@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <boost/operators.hpp>
 
@@ -9,6 +10,7 @@
 #include <elle/operator.hh>
 #include <elle/serialization.hh>
 
+#include <elle/cryptography/batch.hh>
 #include <elle/cryptography/fwd.hh>
 #include <elle/cryptography/types.hh>
 #include <elle/cryptography/Oneway.hh>
@@ -111,6 +113,19 @@ namespace elle
                std::istream& plain,
                Padding const padding = defaults::signature_padding,
                Oneway const oneway = defaults::oneway) const;
+        /// A signature and the plain text it is supposed to sign.
+        using Signed =
+          std::pair<elle::ConstWeakBuffer, elle::ConstWeakBuffer>;
+        /// Verify many signatures on @a workers threads, all the hardware
+        /// threads if zero, each reusing its own initialized context.
+        ///
+        /// The results are in the order of @a items, an item whose
+        /// verification failed carrying the error rather than throwing.
+        batch::Outcome<bool>
+        verify_many(std::vector<Signed> const& items,
+                    Padding const padding = defaults::signature_padding,
+                    Oneway const oneway = defaults::oneway,
+                    int workers = 0) const;
         /// Return the public key's size in bytes.
         uint32_t
         size() const;
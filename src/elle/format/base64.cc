@@ -1,11 +1,8 @@
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/ostream_iterator.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-
 #include <elle/Exception.hh>
 #include <elle/assert.hh>
+#include <elle/err.hh>
 #include <elle/format/base64.hh>
+#include <elle/format/kernels.hh>
 #include <elle/log.hh>
 
 ELLE_LOG_COMPONENT("elle.format.base64")
@@ -16,8 +13,6 @@ namespace elle
   {
     namespace base64
     {
-      using namespace boost::archive::iterators;
-
       size_t
       encoded_size(ConstWeakBuffer input)
       {
@@ -28,14 +23,10 @@ namespace elle
       encode(ConstWeakBuffer input)
       {
         ELLE_TRACE_SCOPE("encode %s", input);
-        size_t size = encoded_size(input);
-        ELLE_DEBUG("previsional size: %s", size);
-        Buffer res;
-        res.capacity(size);
-        IOStream stream(res.ostreambuf());
-        Stream base64_stream(stream);
-        base64_stream.write(reinterpret_cast<char const*>(input.contents()),
-                            input.size());
+        Buffer res(encoded_size(input));
+        _details::base64_encode(
+          input.contents(), input.size(),
+          reinterpret_cast<char*>(res.mutable_contents()), false);
         return res;
       }
 
@@ -55,42 +46,16 @@ namespace elle
       decode(ConstWeakBuffer input)
       {
         ELLE_TRACE_SCOPE("decode %s", input);
-        size_t size = decoded_size(input);
-        ELLE_DEBUG("previsional size: %s", size);
-        Buffer res(size);
-        IOStream stream(input.istreambuf());
-        Stream base64_stream(stream);
-        base64_stream.read(reinterpret_cast<char*>(res.mutable_contents()),
-                           size);
-        ELLE_ASSERT_EQ(base64_stream.gcount(), signed(size));
-        ELLE_ASSERT(
-          (base64_stream.read(reinterpret_cast<char*>(
-                                res.mutable_contents()), 1),
-           base64_stream.gcount() == 0));
-
+        Buffer res((input.size() + 3) / 4 * 3);
+        auto const size = _details::base64_decode(
+          reinterpret_cast<char const*>(input.contents()), input.size(),
+          res.mutable_contents(), false);
+        if (size < 0)
+          elle::err("invalid base64: %s", input);
+        res.size(size);
         return res;
       }
 
-      using encoder = base64_from_binary<transform_width<const char *, 6, 8>>;
-      template <typename SourceIterator, typename DestinationIterator>
-      void
-      _stream_encode(SourceIterator begin,
-                     SourceIterator end,
-                     DestinationIterator output)
-      {
-        std::copy(encoder(begin), encoder(end), output);
-      }
-
-      using decoder = transform_width<binary_from_base64<char const *>, 8, 6>;
-      template <typename SourceIterator, typename DestinationIterator>
-      void
-      _stream_decode(SourceIterator begin,
-                     SourceIterator end,
-                     DestinationIterator output)
-      {
-        std::copy(decoder(begin), decoder(end), output);
-      }
-
       /*-------------.
       | Construction |
       `-------------*/
@@ -123,32 +88,16 @@ namespace elle
         }
         this->_remaining_read = read % 4;
         read = read - this->_remaining_read;
-        size_t decoded_size = read / 4 * 3;
+        auto decoded_size = std::ptrdiff_t(0);
         if (read > 0)
         {
           ELLE_DEBUG_SCOPE("%s: decode %s bytes", *this, read);
-          bool end = buffer[read - 1] == '=';
-          if (end)
-          {
-            read -= 4;
-            decoded_size -= 3;
-          }
-          _stream_decode(buffer, buffer + read, this->_buffer_read);
-          if (end)
-          {
-            ELLE_DEBUG_SCOPE("%s: decode last 4 bytes with padding", *this);
-            ELLE_DUMP("%s: remaining bytes: \"%s\"", *this,
-                      std::string(buffer + read, 4));
-            auto source = decoder(buffer + read);
-            auto destination = this->_buffer_read + (read / 4 * 3);
-            if (buffer[read + 2] != '=')
-            {
-              *(destination++) = *(source++);
-              ++decoded_size;
-            }
-            *(destination++) = *(source++);
-            ++decoded_size;
-          }
+          decoded_size = _details::base64_decode(
+            buffer, read,
+            reinterpret_cast<std::uint8_t*>(this->_buffer_read), false);
+          if (decoded_size < 0)
+            elle::err("%s: invalid base64: %s",
+                      *this, elle::ConstWeakBuffer(buffer, read));
           if (decoded_size > 0)
             ELLE_DUMP("%s: decoded data: %s", *this,
                       elle::WeakBuffer(this->_buffer_read, decoded_size));
@@ -179,9 +128,11 @@ namespace elle
         {
           ELLE_DEBUG_SCOPE("%s: encode %s bytes to the backend",
                            *this, size);
-          _stream_encode(this->_buffer_write,
-                         this->_buffer_write + size,
-                         std::ostreambuf_iterator<char>(_stream));
+          char encoded[sizeof(this->_buffer_write) / 3 * 4];
+          _details::base64_encode(
+            reinterpret_cast<std::uint8_t const*>(this->_buffer_write), size,
+            encoded, false);
+          this->_stream.write(encoded, size / 3 * 4);
         }
         if (size && this->_remaining_write > 0)
         {
@@ -201,21 +152,11 @@ namespace elle
           ELLE_DEBUG_SCOPE("%s: encode last %s remaining bytes",
                            *this, this->_remaining_write);
           ELLE_ASSERT_LT(this->_remaining_write, 3);
-          _stream_encode(
-            this->_buffer_write,
-            this->_buffer_write + this->_remaining_write,
-            std::ostreambuf_iterator<char>(this->_stream));
-          switch (this->_remaining_write)
-          {
-            case 1:
-              this->_stream << "==";
-              break;
-            case 2:
-              this->_stream << "=";
-              break;
-            default:
-              elle::unreachable();
-          }
+          char encoded[4];
+          _details::base64_encode(
+            reinterpret_cast<std::uint8_t const*>(this->_buffer_write),
+            this->_remaining_write, encoded, false);
+          this->_stream.write(encoded, 4);
         }
       }
 
@@ -1,5 +1,7 @@
+#include <elle/err.hh>
 #include <elle/format/base64.hh>
 #include <elle/format/base64url.hh>
+#include <elle/format/kernels.hh>
 #include <elle/log.hh>
 
 ELLE_LOG_COMPONENT("elle.format.base64url")
@@ -52,6 +54,31 @@ namespace elle
         ELLE_ATTRIBUTE(std::iostream&, backend);
       };
 
+      namespace _details
+      {
+        void
+        encode(ConstWeakBuffer input, char* output)
+        {
+          ELLE_TRACE_SCOPE("encode %s", input);
+          format::_details::base64_encode(
+            input.contents(), input.size(), output, true);
+        }
+
+        Buffer
+        decode(ConstWeakBuffer input)
+        {
+          ELLE_TRACE_SCOPE("decode %s", input);
+          Buffer res((input.size() + 3) / 4 * 3);
+          auto const size = format::_details::base64_decode(
+            reinterpret_cast<char const*>(input.contents()), input.size(),
+            res.mutable_contents(), true);
+          if (size < 0)
+            elle::err("invalid base64url: %s", input);
+          res.size(size);
+          return res;
+        }
+      }
+
       Stream::Stream(std::iostream& underlying):
         IOStream(this->_buffer = new base64::StreamBuffer(this->_rewritter)),
         _rewritter(this->_rewrite_buffer = new RewriteStreamBuffer(underlying))
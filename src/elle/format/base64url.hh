@@ -26,6 +26,19 @@ namespace elle
         ELLE_ATTRIBUTE(elle::IOStream, rewritter);
       };
 
+      namespace _details
+      {
+        /// Encode input to base64url, output having room for
+        /// base64::encoded_size(input) characters.
+        ELLE_API
+        void
+        encode(ConstWeakBuffer input, char* output);
+        /// Decode base64url, padded or not.
+        ELLE_API
+        Buffer
+        decode(ConstWeakBuffer input);
+      }
+
       /// Encode to base64url.
       template <typename T = Buffer>
       T
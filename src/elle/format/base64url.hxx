@@ -1,8 +1,6 @@
 #ifndef ELLE_FORMAT_BASE64URL_HXX
 # define ELLE_FORMAT_BASE64URL_HXX
 
-# include <elle/log.hh>
-
 namespace elle
 {
   namespace format
@@ -13,16 +11,9 @@ namespace elle
       T
       encode(ConstWeakBuffer input)
       {
-        ELLE_LOG_COMPONENT("elle.format.base64url")
-        ELLE_TRACE_SCOPE("encode %s", input);
-        size_t size = base64::encoded_size(input);
-        ELLE_DEBUG("previsional size: %s", size);
         T res;
-        res.capacity(size);
-        IOStream stream(res.ostreambuf());
-        Stream base64_stream(stream);
-        base64_stream.write(reinterpret_cast<char const*>(input.contents()),
-                            input.size());
+        res.size(base64::encoded_size(input));
+        _details::encode(input, reinterpret_cast<char*>(res.mutable_contents()));
         return res;
       }
 
@@ -31,40 +22,16 @@ namespace elle
       std::string
       encode(ConstWeakBuffer input)
       {
-        ELLE_LOG_COMPONENT("elle.format.base64url")
-        ELLE_TRACE_SCOPE("encode %s", input);
-        std::stringstream stream;
-        {
-          Stream base64_stream(stream);
-          base64_stream.write(reinterpret_cast<char const*>(input.contents()),
-                              input.size());
-        }
-        return stream.str();
+        std::string res(base64::encoded_size(input), '\0');
+        _details::encode(input, &res[0]);
+        return res;
       }
 
       template <typename T>
       Buffer
       decode(T input)
       {
-        ELLE_LOG_COMPONENT("elle.format.base64url")
-        ELLE_TRACE_SCOPE("decode %s", input);
-        size_t size = base64::decoded_size(input);
-        ELLE_DEBUG("previsional size: %s", size);
-        Buffer res(size);
-        IOStream stream(input.istreambuf());
-        Stream base64_stream(stream);
-        base64_stream.read(reinterpret_cast<char*>(res.mutable_contents()),
-                           size);
-        return res;
-      }
-
-      template <>
-      inline
-      Buffer
-      decode(std::string const& input)
-      {
-        ConstWeakBuffer buffer(input.c_str(), input.size());
-        return decode(buffer);
+        return _details::decode(ConstWeakBuffer(input));
       }
     }
   }
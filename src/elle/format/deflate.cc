@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <new>
+
+#include <zlib.h>
+
+#include <elle/assert.hh>
+#include <elle/err.hh>
+#include <elle/format/deflate.hh>
+
+namespace elle
+{
+  namespace format
+  {
+    namespace deflate
+    {
+      class Deflater::Impl
+      {
+      public:
+        Impl(int level)
+          : stream()
+        {
+          this->check(deflateInit2(&this->stream, level, Z_DEFLATED,
+                                   // Raw deflate, framed by the caller.
+                                   -15, 8, Z_DEFAULT_STRATEGY));
+        }
+
+        ~Impl()
+        {
+          deflateEnd(&this->stream);
+        }
+
+        void
+        check(int err)
+        {
+          ELLE_ASSERT_NEQ(err, Z_STREAM_ERROR);
+          if (err == Z_MEM_ERROR)
+            throw std::bad_alloc();
+          else if (err != Z_STREAM_END && err != Z_OK)
+            elle::err("ZLIB error: {}: {}", zError(err), this->stream.msg);
+        }
+
+        z_stream stream;
+      };
+
+      Deflater::Deflater(int level)
+        : _impl(std::make_unique<Impl>(level))
+      {}
+
+      Deflater::~Deflater() = default;
+
+      Buffer
+      Deflater::operator ()(ConstWeakBuffer input,
+                            ConstWeakBuffer dictionary,
+                            bool last)
+      {
+        auto& impl = *this->_impl;
+        auto& s = impl.stream;
+        impl.check(deflateReset(&s));
+        if (!dictionary.empty())
+          impl.check(deflateSetDictionary(&s,
+                                          dictionary.contents(),
+                                          dictionary.size()));
+        s.next_in = const_cast<Bytef*>(input.contents());
+        s.avail_in = input.size();
+        // Room for incompressible data and the sync flush marker, so that one
+        // pass is enough.
+        auto res = Buffer(deflateBound(&s, input.size()) + 16);
+        auto produced = std::size_t(0);
+        do
+        {
+          if (produced == res.size())
+            res.size(res.size() * 2);
+          s.next_out = res.mutable_contents() + produced;
+          s.avail_out = res.size() - produced;
+          impl.check(::deflate(&s, last ? Z_FINISH : Z_SYNC_FLUSH));
+          produced = res.size() - s.avail_out;
+        }
+        while (s.avail_out == 0);
+        res.size(produced);
+        return res;
+      }
+
+      ConstWeakBuffer
+      Deflater::dictionary(ConstWeakBuffer block)
+      {
+        // Deflate windows are 32KiB, no use priming with more.
+        auto const size = std::min<std::size_t>(block.size(), 1 << 15);
+        return ConstWeakBuffer(block.contents() + block.size() - size, size);
+      }
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+#include <elle/compiler.hh>
+
+namespace elle
+{
+  namespace format
+  {
+    namespace deflate
+    {
+      /// Compress blocks to raw DEFLATE data whose concatenation is a single
+      /// DEFLATE stream, as pigz does.
+      ///
+      /// Every block is primed with the end of the previous one as a preset
+      /// dictionary and ends on a byte boundary thanks to a sync flush, except
+      /// the last one which is finished. Blocks are thus independent and can
+      /// be compressed concurrently, with one Deflater per thread.
+      class ELLE_API Deflater
+      {
+      public:
+        /// Create a Deflater.
+        ///
+        /// @param level Compression level, from 1 (fastest) to 9 (best), or
+        ///              -1 for ZLIB's default.
+        Deflater(int level = -1);
+        ~Deflater();
+        Deflater(Deflater const&) = delete;
+        /// Compress a block.
+        ///
+        /// @param input      The block.
+        /// @param dictionary The dictionary() of the previous block, if any.
+        /// @param last       Whether this block ends the stream.
+        /// @returns The compressed block.
+        Buffer
+        operator ()(ConstWeakBuffer input,
+                    ConstWeakBuffer dictionary,
+                    bool last);
+        /// The end of @a block, priming the next one.
+        static
+        ConstWeakBuffer
+        dictionary(ConstWeakBuffer block);
+
+      private:
+        class Impl;
+        ELLE_ATTRIBUTE(std::unique_ptr<Impl>, impl);
+      };
+    }
+  }
+}
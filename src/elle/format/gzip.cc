@@ -1,6 +1,15 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+
 #include <zlib.h>
 
+#include <elle/Exception.hh>
+#include <elle/OrderedPool.hh>
 #include <elle/finally.hh>
+#include <elle/format/deflate.hh>
 #include <elle/format/gzip.hh>
 #include <elle/log.hh>
 
@@ -101,7 +110,7 @@ namespace elle
             this->_deflate_stream.avail_out = output.capacity();
             this->_deflate_stream.next_out = output.contents();
             auto ret = z_call(&this->_deflate_stream,
-                              deflate(&this->_deflate_stream, flush));
+                              ::deflate(&this->_deflate_stream, flush));
             ELLE_ASSERT_NEQ(ret, Z_STREAM_ERROR);
             ELLE_ASSERT_NEQ(ret, Z_BUF_ERROR);
             output.size(output.capacity() - this->_deflate_stream.avail_out);
@@ -197,7 +206,7 @@ namespace elle
         }
 
       private:
-        ELLE_ATTRIBUTE(std::iostream&, underlying);
+        ELLE_ATTRIBUTE_R(std::iostream&, underlying);
         ELLE_ATTRIBUTE(bool, honor_flush);
         ELLE_ATTRIBUTE(Buffer::Size, buffer_size);
         ELLE_ATTRIBUTE(z_stream, deflate_stream);
@@ -210,11 +219,214 @@ namespace elle
         ELLE_ATTRIBUTE(bool, inflate_init);
       };
 
+      /*---------.
+      | Parallel |
+      `---------*/
+
+      /// Compress blocks on worker threads, pigz-style.
+      ///
+      /// Blocks are compressed by deflate::Deflater into a single DEFLATE
+      /// stream, framed by a GZIP header and a trailer whose CRC is combined
+      /// from the blocks ones.
+      ///
+      /// Decompression is inherited from the sequential StreamBuffer.
+      class ParallelStreamBuffer
+        : public StreamBuffer
+      {
+      public:
+        ParallelStreamBuffer(std::iostream& underlying,
+                             Parallel const& parallel)
+          : StreamBuffer(underlying, false, parallel.block_size)
+          , _threads(parallel.threads > 0 ?
+                     parallel.threads :
+                     std::max(1u, std::thread::hardware_concurrency()))
+          , _in_flight(parallel.in_flight > 0 ?
+                       parallel.in_flight : 2 * this->_threads)
+          , _level(parallel.level)
+          , _block_size(parallel.block_size)
+          , _block()
+          , _filled(0)
+          , _dictionary()
+          , _started(false)
+          , _crc(crc32(0, Z_NULL, 0))
+          , _size(0)
+          , _pool(this->_threads,
+                  [level = this->_level]
+                  {
+                    auto deflater =
+                      std::make_shared<deflate::Deflater>(level);
+                    return [deflater] (Job& job) { _compress(*deflater, job); };
+                  })
+        {
+          if (this->_level < -1 || this->_level > 9)
+            elle::err("invalid GZIP compression level: %s", this->_level);
+          if (this->_block_size == 0)
+            elle::err("invalid GZIP block size: 0");
+        }
+
+        ~ParallelStreamBuffer()
+        {
+          try
+          {
+            if (this->_started)
+              this->_finish();
+          }
+          catch (...)
+          {
+            ELLE_ERR("%s: unable to finalize output: %s",
+                       this, elle::exception_string());
+          }
+        }
+
+        WeakBuffer
+        write_buffer() override
+        {
+          if (!this->_started)
+          {
+            ELLE_TRACE_SCOPE(
+              "%s: start compressing blocks of %s bytes on %s threads",
+              this, this->_block_size, this->_threads);
+            this->_started = true;
+            this->_header();
+            this->_block = Buffer(this->_block_size);
+          }
+          return WeakBuffer(this->_block.mutable_contents() + this->_filled,
+                            this->_block_size - this->_filled);
+        }
+
+        void
+        flush(Size size) override
+        {
+          this->_filled += size;
+          ELLE_ASSERT_LTE(this->_filled, this->_block_size);
+          if (this->_filled == this->_block_size)
+          {
+            this->_submit(false);
+            this->_block = Buffer(this->_block_size);
+            this->_filled = 0;
+            this->_write(this->_in_flight);
+          }
+        }
+
+      private:
+        struct Job
+        {
+          Buffer input;
+          Buffer::Size size;
+          Buffer dictionary;
+          bool last;
+          Buffer output;
+          uLong crc;
+          bool done;
+          std::exception_ptr error;
+        };
+
+        void
+        _header()
+        {
+          // Extra flags announce the slowest and the fastest levels, like
+          // ZLIB does. The operating system is always Unix.
+          unsigned char const header[] = {
+            0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0,
+            static_cast<unsigned char>(
+              this->_level == 9 ? 2 : this->_level == 1 ? 4 : 0),
+            3,
+          };
+          this->underlying().write(
+            reinterpret_cast<char const*>(header), sizeof(header));
+        }
+
+        void
+        _finish()
+        {
+          ELLE_TRACE_SCOPE("%s: finalize output", this);
+          this->_block.size(this->_filled);
+          this->_submit(true);
+          this->_write(0);
+          unsigned char trailer[8];
+          for (int i = 0; i < 4; ++i)
+          {
+            trailer[i] = (this->_crc >> (8 * i)) & 0xff;
+            trailer[4 + i] = (this->_size >> (8 * i)) & 0xff;
+          }
+          this->underlying().write(
+            reinterpret_cast<char const*>(trailer), sizeof(trailer));
+          this->underlying().flush();
+        }
+
+        /// Queue the current block for compression.
+        void
+        _submit(bool last)
+        {
+          auto job = std::make_shared<Job>();
+          job->input = std::move(this->_block);
+          job->input.size(this->_filled);
+          job->size = this->_filled;
+          job->dictionary = std::move(this->_dictionary);
+          job->last = last;
+          job->crc = 0;
+          job->done = false;
+          this->_dictionary =
+            Buffer(deflate::Deflater::dictionary(job->input));
+          ELLE_DEBUG("%s: submit %s bytes block", this, job->input.size());
+          this->_pool.submit(std::move(job));
+        }
+
+        /// Write compressed blocks in order, waiting until at most limit are
+        /// left in flight.
+        void
+        _write(std::size_t limit)
+        {
+          while (auto job = this->_pool.next(limit))
+          {
+            if (job->error)
+              std::rethrow_exception(job->error);
+            ELLE_DEBUG("%s: send %s compressed bytes to underlying stream",
+                       this, job->output.size());
+            this->underlying().write(
+              reinterpret_cast<char const*>(job->output.contents()),
+              job->output.size());
+            this->_crc =
+              crc32_combine(this->_crc, job->crc, job->size);
+            this->_size += job->size;
+          }
+        }
+
+        static
+        void
+        _compress(deflate::Deflater& deflater, Job& job)
+        {
+          job.crc = crc32(0, job.input.contents(), job.input.size());
+          job.output = deflater(job.input, job.dictionary, job.last);
+          // Only the output is needed from now on, release memory early.
+          job.input = Buffer();
+          job.dictionary = Buffer();
+        }
+
+        ELLE_ATTRIBUTE(int, threads);
+        ELLE_ATTRIBUTE(std::size_t, in_flight);
+        ELLE_ATTRIBUTE(int, level);
+        ELLE_ATTRIBUTE(Buffer::Size, block_size);
+        ELLE_ATTRIBUTE(Buffer, block);
+        ELLE_ATTRIBUTE(Buffer::Size, filled);
+        ELLE_ATTRIBUTE(Buffer, dictionary);
+        ELLE_ATTRIBUTE(bool, started);
+        ELLE_ATTRIBUTE(uLong, crc);
+        ELLE_ATTRIBUTE(std::uint64_t, size);
+        // Last, so workers are stopped before anything else is destroyed.
+        ELLE_ATTRIBUTE(OrderedPool<Job>, pool);
+      };
+
       Stream::Stream(std::iostream& underlying,
                      bool honor_flush,
                      Buffer::Size buffer_size):
         IOStream(new StreamBuffer(underlying, honor_flush, buffer_size))
       {}
+
+      Stream::Stream(std::iostream& underlying,
+                     Parallel const& parallel):
+        IOStream(new ParallelStreamBuffer(underlying, parallel))
+      {}
     }
   }
 }
@@ -11,6 +11,22 @@ namespace elle
   {
     namespace gzip
     {
+      /// Settings for parallel compression.
+      struct Parallel
+      {
+        /// Number of compressing threads, 0 for one per core.
+        int threads = 0;
+        /// Size of the blocks compressed concurrently.
+        Buffer::Size block_size = 1 << 17;
+        /// Maximum number of blocks being compressed or waiting to be written,
+        /// 0 for twice the number of threads. Memory usage is about twice that
+        /// many blocks.
+        int in_flight = 0;
+        /// Compression level, from 1 (fastest) to 9 (best), or -1 for ZLIB's
+        /// default.
+        int level = -1;
+      };
+
       /// Stream wrapper that compresses to GZIP.
       ///
       /// Data written to the stream are compressed on the fly and written back
@@ -38,6 +54,18 @@ namespace elle
         Stream(std::iostream& underlying,
                bool honor_flush,
                Buffer::Size buffer_size = 1 << 16);
+        /// Construct a Stream that compresses blocks in parallel.
+        ///
+        /// Written data are split in blocks, deflated concurrently by worker
+        /// threads, each primed with the end of the previous block, and written
+        /// back in order as a single standard GZIP member. Writing only blocks
+        /// when the in-flight limit is reached. Flushing does not force output:
+        /// the last block is compressed on destruction.
+        ///
+        /// \param underlying The wrapped stream to write compressed data to.
+        /// \param parallel   Parallel compression settings.
+        Stream(std::iostream& underlying,
+               Parallel const& parallel);
       };
     }
   }
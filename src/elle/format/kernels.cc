@@ -0,0 +1,888 @@
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include <elle/format/kernels.hh>
+
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+# define ELLE_FORMAT_X86
+# include <immintrin.h>
+# define ELLE_FORMAT_TARGET(Target) __attribute__((target(Target)))
+#elif defined __aarch64__
+# define ELLE_FORMAT_NEON
+# include <arm_neon.h>
+#endif
+
+namespace elle
+{
+  namespace format
+  {
+    namespace _details
+    {
+      namespace
+      {
+        /*---------.
+        | Alphabet |
+        `---------*/
+
+        char const base64_alphabet[] =
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        char const base64url_alphabet[] =
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        char const hexadecimal_alphabet[] = "0123456789abcdef";
+
+        auto constexpr invalid = std::uint8_t(0xff);
+
+        /// Character to value tables.
+        struct Tables
+        {
+          Tables()
+          {
+            std::memset(this->base64, invalid, sizeof(this->base64));
+            std::memset(this->base64url, invalid, sizeof(this->base64url));
+            std::memset(this->hexadecimal, invalid, sizeof(this->hexadecimal));
+            for (int i = 0; i < 64; ++i)
+            {
+              this->base64[std::uint8_t(base64_alphabet[i])] = i;
+              // base64url decoding historically accepts both alphabets.
+              this->base64url[std::uint8_t(base64_alphabet[i])] = i;
+              this->base64url[std::uint8_t(base64url_alphabet[i])] = i;
+            }
+            for (int i = 0; i < 16; ++i)
+              this->hexadecimal[std::uint8_t(hexadecimal_alphabet[i])] = i;
+          }
+
+          std::uint8_t base64[256];
+          std::uint8_t base64url[256];
+          std::uint8_t hexadecimal[256];
+        };
+
+        Tables const&
+        tables()
+        {
+          static auto const res = Tables();
+          return res;
+        }
+
+        /*-------.
+        | Scalar |
+        `-------*/
+
+        // Every kernel processes what it can of the input in blocks and
+        // returns how much it consumed, the scalar code handles the rest.
+        // Decoding kernels also stop at the first invalid block, leaving the
+        // scalar code to report it.
+
+        std::size_t
+        scalar_base64_encode(std::uint8_t const*, std::size_t,
+                             char*, bool)
+        {
+          return 0;
+        }
+
+        std::size_t
+        scalar_base64_decode(char const*, std::size_t,
+                             std::uint8_t*, bool)
+        {
+          return 0;
+        }
+
+        std::size_t
+        scalar_hexadecimal_encode(std::uint8_t const*, std::size_t, char*)
+        {
+          return 0;
+        }
+
+        std::size_t
+        scalar_hexadecimal_decode(char const*, std::size_t, std::uint8_t*)
+        {
+          return 0;
+        }
+
+#ifdef ELLE_FORMAT_X86
+
+        /*-------.
+        | SSE4.1 |
+        `-------*/
+
+        // Base64 algorithms from Wojciech Muła and Daniel Lemire, "Faster
+        // Base64 Encoding and Decoding Using AVX2 Instructions".
+
+        /// Translate 6-bit values to characters.
+        ELLE_FORMAT_TARGET("sse4.1")
+        __m128i
+        sse_base64_translate(__m128i values, bool url)
+        {
+          auto const lut = url ?
+            _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+                          -4, -4, -4, -4, -17, 32, 0, 0) :
+            _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+                          -4, -4, -4, -4, -19, -16, 0, 0);
+          auto indices = _mm_subs_epu8(values, _mm_set1_epi8(51));
+          auto const letters = _mm_cmpgt_epi8(values, _mm_set1_epi8(25));
+          indices = _mm_sub_epi8(indices, letters);
+          return _mm_add_epi8(values, _mm_shuffle_epi8(lut, indices));
+        }
+
+        /// Split 12 bytes, shuffled in 32-bit groups, into 16 6-bit values.
+        ELLE_FORMAT_TARGET("sse4.1")
+        __m128i
+        sse_base64_split(__m128i in)
+        {
+          auto const t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+          auto const t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+          auto const t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+          auto const t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+          return _mm_or_si128(t1, t3);
+        }
+
+        ELLE_FORMAT_TARGET("sse4.1")
+        std::size_t
+        sse_base64_encode_loop(std::uint8_t const* input, std::size_t size,
+                               char* output, std::size_t i, bool url)
+        {
+          auto const shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                             7, 6, 8, 7, 10, 9, 11, 10);
+          // Blocks of 12 bytes, loaded 16 at a time.
+          for (; size - i >= 16; i += 12)
+          {
+            auto in = _mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(input + i));
+            in = _mm_shuffle_epi8(in, shuffle);
+            auto const out = sse_base64_translate(sse_base64_split(in), url);
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i*>(output + i / 3 * 4), out);
+          }
+          return i;
+        }
+
+        ELLE_FORMAT_TARGET("sse4.1")
+        std::size_t
+        sse_base64_encode(std::uint8_t const* input, std::size_t size,
+                          char* output, bool url)
+        {
+          return sse_base64_encode_loop(input, size, output, 0, url);
+        }
+
+        /// Map the URL alphabet onto the standard one.
+        ELLE_FORMAT_TARGET("sse4.1")
+        __m128i
+        sse_base64_unurl(__m128i in)
+        {
+          auto const dash = _mm_cmpeq_epi8(in, _mm_set1_epi8('-'));
+          auto const underscore = _mm_cmpeq_epi8(in, _mm_set1_epi8('_'));
+          return _mm_add_epi8(
+            in,
+            _mm_or_si128(
+              _mm_and_si128(dash, _mm_set1_epi8('+' - '-')),
+              _mm_and_si128(underscore, _mm_set1_epi8('/' - '_'))));
+        }
+
+        /// Translate 16 characters to 6-bit values.
+        ///
+        /// @returns Whether all characters are valid.
+        ELLE_FORMAT_TARGET("sse4.1")
+        bool
+        sse_base64_values(__m128i& in)
+        {
+          auto const lut_lo = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+          auto const lut_hi = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+          auto const lut_roll = _mm_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+          auto const mask_2f = _mm_set1_epi8(0x2f);
+          auto const hi_nibbles =
+            _mm_and_si128(_mm_srli_epi32(in, 4), mask_2f);
+          auto const lo_nibbles = _mm_and_si128(in, mask_2f);
+          auto const hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+          auto const lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+          if (!_mm_testz_si128(lo, hi))
+            return false;
+          auto const eq_2f = _mm_cmpeq_epi8(in, mask_2f);
+          auto const roll =
+            _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+          in = _mm_add_epi8(in, roll);
+          return true;
+        }
+
+        /// Pack 16 6-bit values into 12 bytes, followed by 4 zeros.
+        ELLE_FORMAT_TARGET("sse4.1")
+        __m128i
+        sse_base64_pack(__m128i values)
+        {
+          auto const merged =
+            _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+          auto const out = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+          return _mm_shuffle_epi8(
+            out,
+            _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                          -1, -1, -1, -1));
+        }
+
+        ELLE_FORMAT_TARGET("sse4.1")
+        std::size_t
+        sse_base64_decode_loop(char const* input, std::size_t size,
+                               std::uint8_t* output, std::size_t i, bool url)
+        {
+          // Blocks of 16 characters, stored as 16 bytes of which 12 are
+          // decoded: keep room for the 4 extra bytes.
+          for (; size - i >= 24; i += 16)
+          {
+            auto in = _mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(input + i));
+            if (url)
+              in = sse_base64_unurl(in);
+            if (!sse_base64_values(in))
+              break;
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i*>(output + i / 4 * 3),
+              sse_base64_pack(in));
+          }
+          return i;
+        }
+
+        ELLE_FORMAT_TARGET("sse4.1")
+        std::size_t
+        sse_base64_decode(char const* input, std::size_t size,
+                          std::uint8_t* output, bool url)
+        {
+          return sse_base64_decode_loop(input, size, output, 0, url);
+        }
+
+        ELLE_FORMAT_TARGET("sse4.1")
+        std::size_t
+        sse_hexadecimal_encode(std::uint8_t const* input, std::size_t size,
+                               char* output)
+        {
+          auto const lut = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(hexadecimal_alphabet));
+          auto const mask = _mm_set1_epi8(0x0f);
+          auto i = std::size_t(0);
+          for (; size - i >= 16; i += 16)
+          {
+            auto const in = _mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(input + i));
+            auto const hi =
+              _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(in, 4), mask));
+            auto const lo = _mm_shuffle_epi8(lut, _mm_and_si128(in, mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * i),
+                             _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * i + 16),
+                             _mm_unpackhi_epi8(hi, lo));
+          }
+          return i;
+        }
+
+        /// Translate 16 lowercase hexadecimal digits to values.
+        ///
+        /// @returns Whether all characters are valid.
+        ELLE_FORMAT_TARGET("sse4.1")
+        bool
+        sse_hexadecimal_values(__m128i& in)
+        {
+          auto const digit = _mm_sub_epi8(in, _mm_set1_epi8('0'));
+          auto const letter = _mm_sub_epi8(in, _mm_set1_epi8('a'));
+          auto const is_digit =
+            _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+          auto const is_letter =
+            _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+          if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff)
+            return false;
+          in = _mm_or_si128(
+            _mm_and_si128(is_digit, digit),
+            _mm_and_si128(is_letter,
+                          _mm_add_epi8(letter, _mm_set1_epi8(10))));
+          return true;
+        }
+
+        ELLE_FORMAT_TARGET("sse4.1")
+        std::size_t
+        sse_hexadecimal_decode(char const* input, std::size_t size,
+                               std::uint8_t* output)
+        {
+          auto const weights = _mm_set1_epi16(0x0110);
+          auto i = std::size_t(0);
+          for (; size - i >= 32; i += 32)
+          {
+            auto a = _mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(input + i));
+            auto b = _mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(input + i + 16));
+            if (!sse_hexadecimal_values(a) || !sse_hexadecimal_values(b))
+              break;
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i*>(output + i / 2),
+              _mm_packus_epi16(_mm_maddubs_epi16(a, weights),
+                               _mm_maddubs_epi16(b, weights)));
+          }
+          return i;
+        }
+
+        /*-----.
+        | AVX2 |
+        `-----*/
+
+        ELLE_FORMAT_TARGET("avx2")
+        __m256i
+        avx2_base64_translate(__m256i values, bool url)
+        {
+          auto const lut = url ?
+            _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+                             -4, -4, -4, -4, -17, 32, 0, 0,
+                             65, 71, -4, -4, -4, -4, -4, -4,
+                             -4, -4, -4, -4, -17, 32, 0, 0) :
+            _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+                             -4, -4, -4, -4, -19, -16, 0, 0,
+                             65, 71, -4, -4, -4, -4, -4, -4,
+                             -4, -4, -4, -4, -19, -16, 0, 0);
+          auto indices = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+          auto const letters = _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25));
+          indices = _mm256_sub_epi8(indices, letters);
+          return _mm256_add_epi8(values, _mm256_shuffle_epi8(lut, indices));
+        }
+
+        ELLE_FORMAT_TARGET("avx2")
+        __m256i
+        avx2_base64_split(__m256i in)
+        {
+          auto const t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+          auto const t1 =
+            _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+          auto const t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+          auto const t3 =
+            _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+          return _mm256_or_si256(t1, t3);
+        }
+
+        ELLE_FORMAT_TARGET("avx2")
+        std::size_t
+        avx2_base64_encode(std::uint8_t const* input, std::size_t size,
+                           char* output, bool url)
+        {
+          // Blocks of 24 bytes, loaded 32 at a time from 4 bytes before the
+          // block, so each lane holds 12 of them. The first block is encoded
+          // with SSE so that those 4 bytes exist.
+          if (size < 16)
+            return 0;
+          auto i = sse_base64_encode_loop(input, 16, output, 0, url);
+          auto const shuffle = _mm256_setr_epi8(
+            5, 4, 6, 5, 8, 7, 9, 8, 11, 10, 12, 11, 14, 13, 15, 14,
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+          for (; size - i >= 28; i += 24)
+          {
+            auto in = _mm256_loadu_si256(
+              reinterpret_cast<__m256i const*>(input + i - 4));
+            in = _mm256_shuffle_epi8(in, shuffle);
+            _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(output + i / 3 * 4),
+              avx2_base64_translate(avx2_base64_split(in), url));
+          }
+          return sse_base64_encode_loop(input, size, output, i, url);
+        }
+
+        ELLE_FORMAT_TARGET("avx2")
+        std::size_t
+        avx2_base64_decode(char const* input, std::size_t size,
+                           std::uint8_t* output, bool url)
+        {
+          auto const lut_lo = _mm256_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+          auto const lut_hi = _mm256_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+          auto const lut_roll = _mm256_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+          auto const mask_2f = _mm256_set1_epi8(0x2f);
+          auto const shuffle = _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+          auto const compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+          auto i = std::size_t(0);
+          // Blocks of 32 characters, stored as 32 bytes of which 24 are
+          // decoded: keep room for the 8 extra bytes.
+          for (; size - i >= 44; i += 32)
+          {
+            auto in = _mm256_loadu_si256(
+              reinterpret_cast<__m256i const*>(input + i));
+            if (url)
+            {
+              auto const dash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('-'));
+              auto const underscore =
+                _mm256_cmpeq_epi8(in, _mm256_set1_epi8('_'));
+              in = _mm256_add_epi8(
+                in,
+                _mm256_or_si256(
+                  _mm256_and_si256(dash, _mm256_set1_epi8('+' - '-')),
+                  _mm256_and_si256(underscore, _mm256_set1_epi8('/' - '_'))));
+            }
+            auto const hi_nibbles =
+              _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+            auto const lo_nibbles = _mm256_and_si256(in, mask_2f);
+            auto const hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+            auto const lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+            if (!_mm256_testz_si256(lo, hi))
+              break;
+            auto const eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+            auto const roll = _mm256_shuffle_epi8(
+              lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+            in = _mm256_add_epi8(in, roll);
+            auto const merged =
+              _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+            auto out =
+              _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+            out = _mm256_shuffle_epi8(out, shuffle);
+            out = _mm256_permutevar8x32_epi32(out, compact);
+            _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(output + i / 4 * 3), out);
+          }
+          return sse_base64_decode_loop(input, size, output, i, url);
+        }
+
+        ELLE_FORMAT_TARGET("avx2")
+        std::size_t
+        avx2_hexadecimal_encode(std::uint8_t const* input, std::size_t size,
+                                char* output)
+        {
+          auto const lut = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(hexadecimal_alphabet)));
+          auto const mask = _mm256_set1_epi8(0x0f);
+          auto i = std::size_t(0);
+          for (; size - i >= 32; i += 32)
+          {
+            auto const in = _mm256_loadu_si256(
+              reinterpret_cast<__m256i const*>(input + i));
+            auto const hi = _mm256_shuffle_epi8(
+              lut, _mm256_and_si256(_mm256_srli_epi16(in, 4), mask));
+            auto const lo =
+              _mm256_shuffle_epi8(lut, _mm256_and_si256(in, mask));
+            // Unpacking interleaves within lanes: reorder the lanes.
+            auto const a = _mm256_unpacklo_epi8(hi, lo);
+            auto const b = _mm256_unpackhi_epi8(hi, lo);
+            _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(output + 2 * i),
+              _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(output + 2 * i + 32),
+              _mm256_permute2x128_si256(a, b, 0x31));
+          }
+          return i;
+        }
+
+        ELLE_FORMAT_TARGET("avx2")
+        bool
+        avx2_hexadecimal_values(__m256i& in)
+        {
+          auto const digit = _mm256_sub_epi8(in, _mm256_set1_epi8('0'));
+          auto const letter = _mm256_sub_epi8(in, _mm256_set1_epi8('a'));
+          auto const is_digit = _mm256_cmpeq_epi8(
+            _mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+          auto const is_letter = _mm256_cmpeq_epi8(
+            _mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+          if (_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) != -1)
+            return false;
+          in = _mm256_or_si256(
+            _mm256_and_si256(is_digit, digit),
+            _mm256_and_si256(is_letter,
+                             _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+          return true;
+        }
+
+        ELLE_FORMAT_TARGET("avx2")
+        std::size_t
+        avx2_hexadecimal_decode(char const* input, std::size_t size,
+                                std::uint8_t* output)
+        {
+          auto const weights = _mm256_set1_epi16(0x0110);
+          auto i = std::size_t(0);
+          for (; size - i >= 64; i += 64)
+          {
+            auto a = _mm256_loadu_si256(
+              reinterpret_cast<__m256i const*>(input + i));
+            auto b = _mm256_loadu_si256(
+              reinterpret_cast<__m256i const*>(input + i + 32));
+            if (!avx2_hexadecimal_values(a) || !avx2_hexadecimal_values(b))
+              break;
+            // Packing interleaves lanes: reorder the quadwords.
+            auto const packed = _mm256_packus_epi16(
+              _mm256_maddubs_epi16(a, weights),
+              _mm256_maddubs_epi16(b, weights));
+            _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(output + i / 2),
+              _mm256_permute4x64_epi64(packed, 0xd8));
+          }
+          return i;
+        }
+
+#endif
+
+#ifdef ELLE_FORMAT_NEON
+
+        /*-----.
+        | NEON |
+        `-----*/
+
+        uint8x16x4_t
+        neon_table(char const* alphabet)
+        {
+          auto const bytes = reinterpret_cast<std::uint8_t const*>(alphabet);
+          return uint8x16x4_t{{vld1q_u8(bytes), vld1q_u8(bytes + 16),
+                               vld1q_u8(bytes + 32), vld1q_u8(bytes + 48)}};
+        }
+
+        std::size_t
+        neon_base64_encode(std::uint8_t const* input, std::size_t size,
+                           char* output, bool url)
+        {
+          auto const table =
+            neon_table(url ? base64url_alphabet : base64_alphabet);
+          auto const mask = vdupq_n_u8(0x3f);
+          auto i = std::size_t(0);
+          // Blocks of 48 bytes, deinterleaved in 3 registers.
+          for (; size - i >= 48; i += 48)
+          {
+            auto const in = vld3q_u8(input + i);
+            auto const a = vshrq_n_u8(in.val[0], 2);
+            auto const b = vandq_u8(
+              vorrq_u8(vshrq_n_u8(in.val[1], 4), vshlq_n_u8(in.val[0], 4)),
+              mask);
+            auto const c = vandq_u8(
+              vorrq_u8(vshrq_n_u8(in.val[2], 6), vshlq_n_u8(in.val[1], 2)),
+              mask);
+            auto const d = vandq_u8(in.val[2], mask);
+            auto const out = uint8x16x4_t{{
+              vqtbl4q_u8(table, a), vqtbl4q_u8(table, b),
+              vqtbl4q_u8(table, c), vqtbl4q_u8(table, d)}};
+            vst4q_u8(reinterpret_cast<std::uint8_t*>(output + i / 3 * 4), out);
+          }
+          return i;
+        }
+
+        std::size_t
+        neon_base64_decode(char const* input, std::size_t size,
+                           std::uint8_t* output, bool url)
+        {
+          auto const& t = url ? tables().base64url : tables().base64;
+          auto const lo = uint8x16x4_t{{
+            vld1q_u8(t), vld1q_u8(t + 16), vld1q_u8(t + 32), vld1q_u8(t + 48)}};
+          auto const hi = uint8x16x4_t{{
+            vld1q_u8(t + 64), vld1q_u8(t + 80),
+            vld1q_u8(t + 96), vld1q_u8(t + 112)}};
+          auto const offset = vdupq_n_u8(64);
+          auto const values = [&] (uint8x16_t c, uint8x16_t& error)
+            {
+              auto const res =
+                vqtbx4q_u8(vqtbl4q_u8(lo, c), hi, vsubq_u8(c, offset));
+              // Lookups of characters above 127 yield 0: flag them.
+              error = vorrq_u8(error, vorrq_u8(res, vcgeq_u8(c, vdupq_n_u8(128))));
+              return res;
+            };
+          auto i = std::size_t(0);
+          // Blocks of 64 characters, deinterleaved in 4 registers.
+          for (; size - i >= 64; i += 64)
+          {
+            auto const in =
+              vld4q_u8(reinterpret_cast<std::uint8_t const*>(input + i));
+            auto error = vdupq_n_u8(0);
+            auto const a = values(in.val[0], error);
+            auto const b = values(in.val[1], error);
+            auto const c = values(in.val[2], error);
+            auto const d = values(in.val[3], error);
+            if (vmaxvq_u8(error) > 63)
+              break;
+            auto const out = uint8x16x3_t{{
+              vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4)),
+              vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2)),
+              vorrq_u8(vshlq_n_u8(c, 6), d)}};
+            vst3q_u8(output + i / 4 * 3, out);
+          }
+          return i;
+        }
+
+        std::size_t
+        neon_hexadecimal_encode(std::uint8_t const* input, std::size_t size,
+                                char* output)
+        {
+          auto const lut = vld1q_u8(
+            reinterpret_cast<std::uint8_t const*>(hexadecimal_alphabet));
+          auto i = std::size_t(0);
+          for (; size - i >= 16; i += 16)
+          {
+            auto const in = vld1q_u8(input + i);
+            auto const out = uint8x16x2_t{{
+              vqtbl1q_u8(lut, vshrq_n_u8(in, 4)),
+              vqtbl1q_u8(lut, vandq_u8(in, vdupq_n_u8(0x0f)))}};
+            vst2q_u8(reinterpret_cast<std::uint8_t*>(output + 2 * i), out);
+          }
+          return i;
+        }
+
+        std::size_t
+        neon_hexadecimal_decode(char const* input, std::size_t size,
+                                std::uint8_t* output)
+        {
+          auto const values = [] (uint8x16_t c, uint8x16_t& valid)
+            {
+              auto const digit = vsubq_u8(c, vdupq_n_u8('0'));
+              auto const letter = vsubq_u8(c, vdupq_n_u8('a'));
+              auto const is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+              auto const is_letter = vcleq_u8(letter, vdupq_n_u8(5));
+              valid = vandq_u8(valid, vorrq_u8(is_digit, is_letter));
+              return vbslq_u8(is_digit, digit,
+                              vaddq_u8(letter, vdupq_n_u8(10)));
+            };
+          auto i = std::size_t(0);
+          for (; size - i >= 32; i += 32)
+          {
+            auto const in =
+              vld2q_u8(reinterpret_cast<std::uint8_t const*>(input + i));
+            auto valid = vdupq_n_u8(0xff);
+            auto const hi = values(in.val[0], valid);
+            auto const lo = values(in.val[1], valid);
+            if (vminvq_u8(valid) == 0)
+              break;
+            vst1q_u8(output + i / 2, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+          }
+          return i;
+        }
+
+#endif
+
+        /*---------.
+        | Dispatch |
+        `---------*/
+
+        struct Kernels
+        {
+          char const* name;
+          std::size_t (*base64_encode)(
+            std::uint8_t const*, std::size_t, char*, bool);
+          std::size_t (*base64_decode)(
+            char const*, std::size_t, std::uint8_t*, bool);
+          std::size_t (*hexadecimal_encode)(
+            std::uint8_t const*, std::size_t, char*);
+          std::size_t (*hexadecimal_decode)(
+            char const*, std::size_t, std::uint8_t*);
+        };
+
+        Kernels const scalar = {
+          "scalar",
+          &scalar_base64_encode,
+          &scalar_base64_decode,
+          &scalar_hexadecimal_encode,
+          &scalar_hexadecimal_decode,
+        };
+
+#ifdef ELLE_FORMAT_X86
+        Kernels const sse = {
+          "sse4.1",
+          &sse_base64_encode,
+          &sse_base64_decode,
+          &sse_hexadecimal_encode,
+          &sse_hexadecimal_decode,
+        };
+
+        Kernels const avx2 = {
+          "avx2",
+          &avx2_base64_encode,
+          &avx2_base64_decode,
+          &avx2_hexadecimal_encode,
+          &avx2_hexadecimal_decode,
+        };
+#endif
+
+#ifdef ELLE_FORMAT_NEON
+        Kernels const neon = {
+          "neon",
+          &neon_base64_encode,
+          &neon_base64_decode,
+          &neon_hexadecimal_encode,
+          &neon_hexadecimal_decode,
+        };
+#endif
+
+        /// The kernels supported by this CPU, best first.
+        std::vector<Kernels const*>
+        supported()
+        {
+          auto res = std::vector<Kernels const*>{};
+#ifdef ELLE_FORMAT_X86
+          __builtin_cpu_init();
+          if (__builtin_cpu_supports("avx2"))
+            res.emplace_back(&avx2);
+          if (__builtin_cpu_supports("sse4.1"))
+            res.emplace_back(&sse);
+#endif
+#ifdef ELLE_FORMAT_NEON
+          res.emplace_back(&neon);
+#endif
+          res.emplace_back(&scalar);
+          return res;
+        }
+
+        std::atomic<Kernels const*>&
+        current()
+        {
+          static std::atomic<Kernels const*> res(supported().front());
+          return res;
+        }
+
+        Kernels const&
+        selected()
+        {
+          // Build the tables along with the selection, not on every call.
+          static auto const& t = tables();
+          (void)t;
+          return *current().load(std::memory_order_relaxed);
+        }
+      }
+
+      char const*
+      kernels()
+      {
+        return selected().name;
+      }
+
+      bool
+      kernels(std::string const& name)
+      {
+        for (auto k: supported())
+          if (k->name == name)
+          {
+            selected();
+            current().store(k);
+            return true;
+          }
+        return false;
+      }
+
+      /*--------.
+      | Base 64 |
+      `--------*/
+
+      void
+      base64_encode(std::uint8_t const* input, std::size_t size,
+                    char* output, bool url)
+      {
+        auto const alphabet = url ? base64url_alphabet : base64_alphabet;
+        auto i = selected().base64_encode(input, size, output, url);
+        output += i / 3 * 4;
+        for (; size - i >= 3; i += 3)
+        {
+          auto const v =
+            input[i] << 16 | input[i + 1] << 8 | input[i + 2];
+          *output++ = alphabet[v >> 18];
+          *output++ = alphabet[(v >> 12) & 0x3f];
+          *output++ = alphabet[(v >> 6) & 0x3f];
+          *output++ = alphabet[v & 0x3f];
+        }
+        if (size - i == 1)
+        {
+          auto const v = input[i] << 16;
+          *output++ = alphabet[v >> 18];
+          *output++ = alphabet[(v >> 12) & 0x3f];
+          *output++ = '=';
+          *output++ = '=';
+        }
+        else if (size - i == 2)
+        {
+          auto const v = input[i] << 16 | input[i + 1] << 8;
+          *output++ = alphabet[v >> 18];
+          *output++ = alphabet[(v >> 12) & 0x3f];
+          *output++ = alphabet[(v >> 6) & 0x3f];
+          *output++ = '=';
+        }
+      }
+
+      std::ptrdiff_t
+      base64_decode(char const* input, std::size_t size,
+                    std::uint8_t* output, bool url)
+      {
+        auto const rest = size % 4;
+        if (rest == 1 || (rest && !url))
+          return -1;
+        // Full quads, then the 2 or 3 meaningful characters of a padded or
+        // short last quad.
+        auto body = size - rest;
+        auto tail = rest;
+        if (!rest && size && input[size - 1] == '=')
+        {
+          body = size - 4;
+          tail = input[size - 2] == '=' ? 2 : 3;
+        }
+        auto const& table = url ? tables().base64url : tables().base64;
+        auto const value = [&] (std::size_t i)
+          {
+            return table[static_cast<std::uint8_t>(input[i])];
+          };
+        auto i = selected().base64_decode(input, body, output, url);
+        auto o = i / 4 * 3;
+        for (; i < body; i += 4)
+        {
+          auto const a = value(i);
+          auto const b = value(i + 1);
+          auto const c = value(i + 2);
+          auto const d = value(i + 3);
+          if ((a | b | c | d) == invalid)
+            return -1;
+          output[o++] = (a << 2) | (b >> 4);
+          output[o++] = (b << 4) | (c >> 2);
+          output[o++] = (c << 6) | d;
+        }
+        if (tail)
+        {
+          auto const a = value(body);
+          auto const b = value(body + 1);
+          auto const c = tail == 3 ? value(body + 2) : 0;
+          if ((a | b | c) == invalid)
+            return -1;
+          output[o++] = (a << 2) | (b >> 4);
+          if (tail == 3)
+            output[o++] = (b << 4) | (c >> 2);
+        }
+        return o;
+      }
+
+      /*------------.
+      | Hexadecimal |
+      `------------*/
+
+      void
+      hexadecimal_encode(std::uint8_t const* input, std::size_t size,
+                         char* output)
+      {
+        auto i = selected().hexadecimal_encode(input, size, output);
+        for (; i < size; ++i)
+        {
+          output[2 * i] = hexadecimal_alphabet[input[i] >> 4];
+          output[2 * i + 1] = hexadecimal_alphabet[input[i] & 0xf];
+        }
+      }
+
+      bool
+      hexadecimal_decode(char const* input, std::size_t size,
+                         std::uint8_t* output)
+      {
+        auto const& table = tables().hexadecimal;
+        auto i = selected().hexadecimal_decode(input, size, output);
+        for (; i < size; i += 2)
+        {
+          auto const hi = table[static_cast<std::uint8_t>(input[i])];
+          auto const lo = table[static_cast<std::uint8_t>(input[i + 1])];
+          if ((hi | lo) == invalid)
+            return false;
+          output[i / 2] = (hi << 4) | lo;
+        }
+        return true;
+      }
+    }
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <elle/compiler.hh>
+
+namespace elle
+{
+  namespace format
+  {
+    /// Vectorized base64 and hexadecimal kernels, shared by the one-shot and
+    /// streaming codecs.
+    ///
+    /// The best implementation for the running CPU (AVX2, SSE4.1, NEON or
+    /// plain C++) is selected once, on first use.
+    namespace _details
+    {
+      /// The name of the selected implementation.
+      ELLE_API
+      char const*
+      kernels();
+      /// Select an implementation by name, for testing and benchmarking.
+      ///
+      /// @returns Whether it is supported by this CPU.
+      ELLE_API
+      bool
+      kernels(std::string const& name);
+
+      /// Encode size bytes to base64 with padding.
+      ///
+      /// @param output Room for (size + 2) / 3 * 4 characters.
+      /// @param url Whether to use the URL-safe alphabet.
+      ELLE_API
+      void
+      base64_encode(std::uint8_t const* input, std::size_t size,
+                    char* output, bool url);
+
+      /// Decode base64.
+      ///
+      /// Padding is required, unless url is set, in which case both alphabets
+      /// are accepted.
+      ///
+      /// @param output Room for (size + 3) / 4 * 3 bytes.
+      /// @returns The number of decoded bytes, or -1 if the input is invalid.
+      ELLE_API
+      std::ptrdiff_t
+      base64_decode(char const* input, std::size_t size,
+                    std::uint8_t* output, bool url);
+
+      /// Encode size bytes to lowercase hexadecimal.
+      ///
+      /// @param output Room for 2 * size characters.
+      ELLE_API
+      void
+      hexadecimal_encode(std::uint8_t const* input, std::size_t size,
+                         char* output);
+
+      /// Decode size lowercase hexadecimal digits, size being even.
+      ///
+      /// @param output Room for size / 2 bytes.
+      /// @returns Whether the input is valid.
+      ELLE_API
+      bool
+      hexadecimal_decode(char const* input, std::size_t size,
+                         std::uint8_t* output);
+    }
+  }
+}
@@ -23,6 +23,14 @@ namespace elle
   std::ostream&
   print(std::ostream& o, std::string const& fmt, Args&& ... args);
 
+  /// Print a formatted string to a given stream.
+  ///
+  /// Same as above, the parsed format being cached by address: meant for
+  /// literals, as in log messages.
+  template <typename ... Args>
+  std::ostream&
+  print(std::ostream& o, char const* fmt, Args&& ... args);
+
   /// A formatted string.
   ///
   /// @param fmt The un-formatted string specifying how to format and interpret
@@ -33,6 +41,14 @@ namespace elle
   std::string
   print(std::string const& fmt, Args&& ... args);
 
+  /// A formatted string.
+  ///
+  /// Same as above, the parsed format being cached by address: meant for
+  /// literals, as in log messages.
+  template <typename ... Args>
+  std::string
+  print(char const* fmt, Args&& ... args);
+
   /// Whether a stream is set for debugging output.
   ///
   /// Armed with `%r` in print's format.
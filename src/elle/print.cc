@@ -1,4 +1,7 @@
 #include <memory>
+#include <sstream>
+#include <streambuf>
+#include <unordered_map>
 
 #include <boost/bind.hpp>
 #include <boost/config/warning_disable.hpp>
@@ -404,6 +407,150 @@ namespace elle
       ELLE_ASSERT(res);
       return res;
     }
+
+    /*--------.
+    | Caches  |
+    `--------*/
+
+    /// A stream buffer appending to a string whose capacity is kept from one
+    /// use to the next.
+    class StringBuffer
+      : public std::streambuf
+    {
+    public:
+      std::string text;
+
+    protected:
+      int_type
+      overflow(int_type c) override
+      {
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+          this->text.push_back(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+      }
+
+      std::streamsize
+      xsputn(char const* s, std::streamsize n) override
+      {
+        this->text.append(s, n);
+        return n;
+      }
+    };
+
+    // Set once the state of this thread is destroyed, so printing during
+    // thread exit falls back to parsing and allocating every time.
+    thread_local bool destroyed = false;
+
+    /// Per-thread formatting state, so lookups need no locking.
+    ///
+    /// Parsed formats are cached both by address, for literals, and by text.
+    /// Caches are flushed when full: formats are nearly always literals, so
+    /// the working set is small and stable.
+    struct State
+    {
+      /// Maximum number of formats in each cache.
+      static std::size_t const capacity = 1024;
+
+      ~State()
+      {
+        destroyed = true;
+      }
+
+      std::shared_ptr<Expression>
+      get(std::string const& fmt)
+      {
+        auto it = this->by_text.find(fmt);
+        if (it == this->by_text.end())
+        {
+          auto ast = parse(fmt);
+          if (this->by_text.size() >= capacity)
+            this->by_text.clear();
+          it = this->by_text.emplace(fmt, std::move(ast)).first;
+        }
+        return it->second;
+      }
+
+      std::shared_ptr<Expression>
+      get(char const* fmt)
+      {
+        // The text is checked too, the address of a non-literal format may
+        // be reused for a different one.
+        auto it = this->by_address.find(fmt);
+        if (it != this->by_address.end() && it->second.first == fmt)
+          return it->second.second;
+        auto text = std::string(fmt);
+        auto ast = this->get(text);
+        if (this->by_address.size() >= capacity)
+          this->by_address.clear();
+        this->by_address[fmt] = std::make_pair(std::move(text), ast);
+        return ast;
+      }
+
+      std::unordered_map<std::string, std::shared_ptr<Expression>> by_text;
+      std::unordered_map<
+        char const*,
+        std::pair<std::string, std::shared_ptr<Expression>>> by_address;
+      /// A stream printing to a reusable string.
+      struct Stream
+      {
+        StringBuffer buffer;
+        std::ostream stream{&this->buffer};
+      };
+      /// Streams to print to strings, one per nesting level since printing
+      /// an argument may print to a string in turn.
+      std::vector<std::unique_ptr<Stream>> streams;
+      std::size_t depth = 0;
+    };
+
+    State*
+    state()
+    {
+      static thread_local State state;
+      return destroyed ? nullptr : &state;
+    }
+
+    template <typename F>
+    std::shared_ptr<Expression>
+    lookup(F const& fmt)
+    {
+      if (auto* s = state())
+        return s->get(fmt);
+      else
+        return parse(fmt);
+    }
+
+    /// Print to a string using a stream of this thread.
+    template <typename F>
+    std::string
+    format_string(F const& fmt,
+                 std::vector<Argument> const& args,
+                 NamedArguments const& named)
+    {
+      auto* s = state();
+      if (!s)
+      {
+        std::stringstream output;
+        print(output, fmt, args, named);
+        return output.str();
+      }
+      if (s->depth == s->streams.size())
+        s->streams.emplace_back(std::make_unique<State::Stream>());
+      auto& p = *s->streams[s->depth];
+      ++s->depth;
+      BOOST_SCOPE_EXIT_TPL(s) {
+        --s->depth;
+      } BOOST_SCOPE_EXIT_END
+      auto& stream = p.stream;
+      p.buffer.text.clear();
+      stream.clear();
+      stream.flags(std::ios_base::dec | std::ios_base::skipws);
+      stream.precision(6);
+      stream.width(0);
+      stream.fill(' ');
+      repr(stream, false);
+      print(stream, fmt, args, named);
+      return p.buffer.text;
+    }
     }
 
     /*------.
@@ -445,12 +592,20 @@ namespace elle
                id == &typeid(Next))
       {
         auto& var = ast.as<Variable>();
-        // FIXME: we need a saver that also deals with `repr`.
-        auto const saver = boost::io::ios_all_saver(s);
+        // Only save what formatting alters, ios_all_saver also copies the
+        // locale.
+        auto const flags = s.flags();
+        auto const precision = s.precision();
+        auto const width = s.width();
+        auto const fill = s.fill();
         auto const old_repr = repr(s);
         // Don't use SafeFinally, which uses a log, which uses print, hence
         // infinite recursion.
-        BOOST_SCOPE_EXIT(&s, old_repr) {
+        BOOST_SCOPE_EXIT(&s, flags, precision, width, fill, old_repr) {
+            s.flags(flags);
+            s.precision(precision);
+            s.width(width);
+            s.fill(fill);
             repr(s, old_repr);
         } BOOST_SCOPE_EXIT_END
         var.apply_fmt(s);
@@ -522,13 +677,15 @@ namespace elle
       }
     }
 
+    template <typename F>
+    static
     void
-    print(std::ostream& s,
-          std::string const& fmt,
-          std::vector<Argument> const& args,
-          NamedArguments const& named)
+    print_format(std::ostream& s,
+                 F const& fmt,
+                 std::vector<Argument> const& args,
+                 NamedArguments const& named)
     {
-      auto const ast = _details::parse(fmt);
+      auto const ast = _details::lookup(fmt);
       int count = 0;
       bool full_positional = true;
       _details::print(s, *ast, args, count, true, named, full_positional);
@@ -536,6 +693,40 @@ namespace elle
         elle::err("too many arguments (%s > %s) for format: %s",
                   args.size(), count, fmt);
     }
+
+    void
+    print(std::ostream& s,
+          std::string const& fmt,
+          std::vector<Argument> const& args,
+          NamedArguments const& named)
+    {
+      print_format(s, fmt, args, named);
+    }
+
+    void
+    print(std::ostream& s,
+          char const* fmt,
+          std::vector<Argument> const& args,
+          NamedArguments const& named)
+    {
+      print_format(s, fmt, args, named);
+    }
+
+    std::string
+    print_string(std::string const& fmt,
+                 std::vector<Argument> const& args,
+                 NamedArguments const& named)
+    {
+      return format_string(fmt, args, named);
+    }
+
+    std::string
+    print_string(char const* fmt,
+                 std::vector<Argument> const& args,
+                 NamedArguments const& named)
+    {
+      return format_string(fmt, args, named);
+    }
   }
 
 
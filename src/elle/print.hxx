@@ -126,12 +126,34 @@ namespace elle
       }
     };
 
+    /// Print with a format looked up by text in the cache of parsed
+    /// formats.
     void
     print(std::ostream& s,
           std::string const& fmt,
           std::vector<Argument> const& args,
           NamedArguments const& named);
 
+    /// Print with a format looked up by address in the cache of parsed
+    /// formats, which suits literals: no string is built nor hashed.
+    void
+    print(std::ostream& s,
+          char const* fmt,
+          std::vector<Argument> const& args,
+          NamedArguments const& named);
+
+    /// Print to a string through a reused, per-thread stream.
+    std::string
+    print_string(std::string const& fmt,
+                 std::vector<Argument> const& args,
+                 NamedArguments const& named);
+
+    /// Print to a string through a reused, per-thread stream.
+    std::string
+    print_string(char const* fmt,
+                 std::vector<Argument> const& args,
+                 NamedArguments const& named);
+
     template <typename ... Args>
     std::vector <Argument>
     erasure(Args const& ... args)
@@ -155,14 +177,28 @@ namespace elle
     return o;
   }
 
+  template <typename ... Args>
+  std::ostream&
+  print(std::ostream& o, char const* fmt, Args&& ... args)
+  {
+    _details::print(o, fmt, _details::erasure(args...), {});
+    return o;
+  }
+
   template <typename ... Args>
   ELLE_COMPILER_ATTRIBUTE_WARN_UNUSED_RESULT
   std::string
   print(std::string const& fmt, Args&& ... args)
   {
-    std::stringstream output;
-    print(output, fmt, std::forward<Args>(args)...);
-    return output.str();
+    return _details::print_string(fmt, _details::erasure(args...), {});
+  }
+
+  template <typename ... Args>
+  ELLE_COMPILER_ATTRIBUTE_WARN_UNUSED_RESULT
+  std::string
+  print(char const* fmt, Args&& ... args)
+  {
+    return _details::print_string(fmt, _details::erasure(args...), {});
   }
 
   /*------.
@@ -179,14 +215,30 @@ namespace elle
     return o;
   }
 
+  inline
+  std::ostream&
+  print(std::ostream& o,
+        char const* fmt,
+        _details::NamedArguments const& args)
+  {
+    _details::print(o, fmt, {}, args);
+    return o;
+  }
+
   inline
   std::string
   print(std::string const& fmt,
         _details::NamedArguments const& args)
   {
-    std::stringstream output;
-    print(output, fmt, args);
-    return output.str();
+    return _details::print_string(fmt, {}, args);
+  }
+
+  inline
+  std::string
+  print(char const* fmt,
+        _details::NamedArguments const& args)
+  {
+    return _details::print_string(fmt, {}, args);
   }
 
   /*----------.
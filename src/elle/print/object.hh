@@ -4,6 +4,8 @@
 #include <ostream>
 #include <memory>
 
+#include <elle/print-fwd.hh>
+
 namespace elle
 {
   namespace _details
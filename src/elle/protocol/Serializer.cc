@@ -5,6 +5,7 @@
 #endif
 
 #include <elle/Buffer.hh>
+#include <elle/BufferPool.hh>
 #include <elle/log.hh>
 
 #include <elle/cryptography/hash.hh>
@@ -69,7 +70,7 @@ namespace elle
       if (!size)
         size = Serializer::Super::uint32_get(stream, version);
       ELLE_DUMP("expected size: %s", *size);
-      elle::Buffer content(*size);
+      auto content = elle::Buffer(*size, elle::BufferPool::local());
       read(stream, content, *size);
       return content;
     }
@@ -238,7 +239,7 @@ namespace elle
               uint32_t total_size =
                 Serializer::Super::uint32_get(this->_stream, this->version());
               ELLE_DEBUG("packet size: %s", total_size);
-              elle::Buffer packet(static_cast<std::size_t>(total_size));
+              auto packet = elle::Buffer(total_size, elle::BufferPool::local());
               elle::Buffer::Size offset = 0;
               while (true)
               {
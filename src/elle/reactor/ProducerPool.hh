@@ -0,0 +1,131 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <elle/Duration.hh>
+#include <elle/Printable.hh>
+#include <elle/attribute.hh>
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Channel.hh>
+#include <elle/reactor/Thread.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    /// A pool of values produced ahead of time on the background pool.
+    ///
+    /// Unlike elle::ProducerPool, getting a value only blocks the calling
+    /// Thread, never the scheduler: producers are reactor Threads running the
+    /// production function through reactor::background. Production starts
+    /// once the pool drops below its low watermark and goes on until it is
+    /// full, so values are generated in bursts ahead of the demand.
+    ///
+    /// @code{.cc}
+    ///
+    /// reactor::ProducerPool<rsa::KeyPair> keys(
+    ///   [] { return rsa::keypair::generate(2048); }, 16, 2);
+    /// // Stop generating while the machine is loaded.
+    /// keys.throttle([] { double l; return ::getloadavg(&l, 1) == 1 && l > 4; });
+    /// auto k = keys.get();
+    ///
+    /// @endcode
+    template <typename T>
+    class ProducerPool
+      : public elle::Printable
+    {
+    /*------.
+    | Types |
+    `------*/
+    public:
+      using Produce = std::function<T ()>;
+      /// Whether production should pause.
+      using Throttle = std::function<bool ()>;
+
+    /*-------------.
+    | Construction |
+    `-------------*/
+    public:
+      /// Create a ProducerPool and start filling it.
+      ///
+      /// @param produce The production function, run in a system thread.
+      /// @param max_size The maximum number of values the pool holds.
+      /// @param producers The number of values produced in parallel.
+      /// @param low_watermark The size under which the pool is refilled, half
+      ///                      of @a max_size if negative.
+      ProducerPool(Produce produce,
+                   int max_size,
+                   int producers = 1,
+                   int low_watermark = -1);
+      /// Stop the producers, dropping the values being produced.
+      ~ProducerPool();
+
+    /*--------.
+    | Content |
+    `--------*/
+    public:
+      /// Get a value, waiting for one to be produced if the pool is empty.
+      T
+      get();
+      /// Refill the pool up to its maximum size, regardless of the low
+      /// watermark.
+      void
+      prefetch();
+      /// Number of values ready.
+      int
+      size() const;
+    private:
+      /// Whether a production may start.
+      bool
+      _room() const;
+      /// Body of the producer Threads.
+      void
+      _production();
+      ELLE_ATTRIBUTE(Produce, produce);
+      ELLE_ATTRIBUTE_R(int, max_size);
+      ELLE_ATTRIBUTE_R(int, low_watermark);
+      ELLE_ATTRIBUTE(Channel<T>, pool);
+      /// Values being produced.
+      ELLE_ATTRIBUTE_R(int, producing);
+      /// Open while the pool is refilling.
+      ELLE_ATTRIBUTE(Barrier, refill);
+      ELLE_ATTRIBUTE(std::vector<Thread::unique_ptr>, producers);
+
+    /*-----------.
+    | Throttling |
+    `-----------*/
+    public:
+      /// Checked before every production, which is delayed by
+      /// throttle_delay while it returns true.
+      ELLE_ATTRIBUTE_RW(Throttle, throttle);
+      ELLE_ATTRIBUTE_RW(Duration, throttle_delay);
+
+    /*-----------.
+    | Statistics |
+    `-----------*/
+    public:
+      /// Number of latency buckets.
+      static int const buckets = 16;
+      /// Production latencies: bucket i counts the productions that took
+      /// less than 2^i milliseconds, the last one all the slower ones.
+      ELLE_ATTRIBUTE_R(std::vector<std::size_t>, latency);
+      /// Number of values produced.
+      ELLE_ATTRIBUTE_R(std::size_t, produced);
+      /// Number of get() calls that had to wait for a value.
+      ELLE_ATTRIBUTE_R(std::size_t, misses);
+    private:
+      void
+      _record(Duration latency);
+
+    /*----------.
+    | Printable |
+    `----------*/
+    public:
+      void
+      print(std::ostream& stream) const override;
+    };
+  }
+}
+
+#include <elle/reactor/ProducerPool.hxx>
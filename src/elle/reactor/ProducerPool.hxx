@@ -0,0 +1,166 @@
+#include <elle/Error.hh>
+#include <elle/finally.hh>
+#include <elle/log.hh>
+#include <elle/printf.hh>
+
+#include <elle/reactor/BackgroundFuture.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    /*-------------.
+    | Construction |
+    `-------------*/
+
+    template <typename T>
+    ProducerPool<T>::ProducerPool(Produce produce,
+                                  int max_size,
+                                  int producers,
+                                  int low_watermark)
+      : _produce(std::move(produce))
+      , _max_size(max_size)
+      , _low_watermark(low_watermark < 0 ? max_size / 2 : low_watermark)
+      , _pool()
+      , _producing(0)
+      , _refill("producer pool refill")
+      , _producers()
+      , _throttle()
+      , _throttle_delay(std::chrono::milliseconds(100))
+      , _latency(buckets, 0)
+      , _produced(0)
+      , _misses(0)
+    {
+      ELLE_ASSERT_GT(max_size, 0);
+      ELLE_ASSERT_GT(producers, 0);
+      this->_refill.open();
+      for (int i = 0; i < producers; ++i)
+        this->_producers.emplace_back(
+          new Thread(elle::sprintf("%s producer %s", this, i),
+                     [this] { this->_production(); }));
+    }
+
+    template <typename T>
+    ProducerPool<T>::~ProducerPool()
+    {
+      this->_producers.clear();
+    }
+
+    /*--------.
+    | Content |
+    `--------*/
+
+    template <typename T>
+    T
+    ProducerPool<T>::get()
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.ProducerPool");
+      ELLE_TRACE_SCOPE("%s: get", this);
+      if (this->size() == 0)
+      {
+        ELLE_DEBUG("pool is empty, wait for production");
+        ++this->_misses;
+        this->_refill.open();
+      }
+      auto res = this->_pool.get();
+      if (this->size() + this->_producing < this->_low_watermark &&
+          !this->_refill.opened())
+      {
+        ELLE_DEBUG("%s: below low watermark, refill", this);
+        this->_refill.open();
+      }
+      return res;
+    }
+
+    template <typename T>
+    void
+    ProducerPool<T>::prefetch()
+    {
+      this->_refill.open();
+    }
+
+    template <typename T>
+    int
+    ProducerPool<T>::size() const
+    {
+      return this->_pool.size();
+    }
+
+    template <typename T>
+    bool
+    ProducerPool<T>::_room() const
+    {
+      return this->size() + this->_producing < this->_max_size;
+    }
+
+    template <typename T>
+    void
+    ProducerPool<T>::_production()
+    {
+      ELLE_LOG_COMPONENT("elle.reactor.ProducerPool");
+      while (true)
+      {
+        reactor::wait(this->_refill);
+        while (this->_throttle && this->_throttle())
+        {
+          ELLE_DEBUG("%s: throttled", this);
+          reactor::sleep(this->_throttle_delay);
+        }
+        if (!this->_room())
+        {
+          ELLE_DEBUG("%s: full", this);
+          this->_refill.close();
+          continue;
+        }
+        try
+        {
+          auto const start = std::chrono::steady_clock::now();
+          auto value = [&]
+            {
+              ++this->_producing;
+              elle::SafeFinally produced([this] { --this->_producing; });
+              return std::move(BackgroundFuture<T>(this->_produce).value());
+            }();
+          this->_record(std::chrono::duration_cast<Duration>(
+                          std::chrono::steady_clock::now() - start));
+          this->_pool.put(std::move(value));
+        }
+        catch (elle::Error const& e)
+        {
+          ELLE_WARN("%s: production failed: %s", this, e);
+          reactor::sleep(this->_throttle_delay);
+        }
+      }
+    }
+
+    /*-----------.
+    | Statistics |
+    `-----------*/
+
+    template <typename T>
+    void
+    ProducerPool<T>::_record(Duration latency)
+    {
+      auto const ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(latency).count();
+      auto bucket = 0;
+      while (bucket < buckets - 1 && (1ll << bucket) <= ms)
+        ++bucket;
+      ++this->_latency[bucket];
+      ++this->_produced;
+    }
+
+    /*----------.
+    | Printable |
+    `----------*/
+
+    template <typename T>
+    void
+    ProducerPool<T>::print(std::ostream& stream) const
+    {
+      elle::fprintf(stream, "ProducerPool(%s/%s, %s producing)",
+                    this->size(), this->_max_size, this->_producing);
+    }
+  }
+}
@@ -1,3 +1,5 @@
+#include <boost/range/iterator_range.hpp>
+
 #include <elle/finally.hh>
 #include <elle/log.hh>
 #include <elle/optional.hh>
@@ -32,6 +34,9 @@ namespace elle
       , _injection()
       , _exception()
       , _waited()
+      , _waiter_slots(nullptr)
+      , _waiter_slots_used(0)
+      , _waiter_spilled(false)
       , _timeout(false)
       , _timeout_timer(scheduler.io_service())
       , _thread(scheduler._manager->make_thread(
@@ -83,6 +88,9 @@ namespace elle
                          this, this->state());
             this->terminate_now(false);
           };
+      for (auto& slot: this->_storage)
+        if (slot.value)
+          slot.destroy(slot.value);
       this->_destructed();
     }
 
@@ -306,21 +314,43 @@ namespace elle
     bool
     Thread::wait(Waitable& s, DurationOpt timeout)
     {
-      auto waitables = Waitables{&s};
-      return wait(waitables, timeout);
+      auto const waitable = &s;
+      return this->_wait(&waitable, &waitable + 1, timeout);
     }
 
     bool
     Thread::wait(Waitables const& waitables, DurationOpt timeout)
     {
+      return this->_wait(waitables.data(),
+                         waitables.data() + waitables.size(),
+                         timeout);
+    }
+
+    bool
+    Thread::_wait(Waitable* const* begin,
+                  Waitable* const* end,
+                  DurationOpt timeout)
+    {
 #ifndef ELLE_IOS
-      ELLE_TRACE_SCOPE("%s: wait %s%s", *this, waitables,
+      ELLE_TRACE_SCOPE("%s: wait %s%s", *this, Waitables(begin, end),
                        timeout ? elle::sprintf(" for %s", timeout) : "");
 #endif
       ELLE_ASSERT_EQ(_state, State::running);
       ELLE_ASSERT(_waited.empty());
+      // Waiters registered by this wait live here. They unlink themselves
+      // when destroyed, whatever happened to the waited Waitables.
+      Waiter slots[waiter_slots];
+      this->_waiter_slots = slots;
+      this->_waiter_slots_used = 0;
+      this->_waiter_spilled = false;
+      elle::SafeFinally reset_slots([this]
+        {
+          this->_waiter_slots = nullptr;
+          this->_waiter_slots_used = 0;
+          this->_waiter_spilled = false;
+        });
       bool freeze = false;
-      for (auto s: waitables)
+      for (auto s: boost::make_iterator_range(begin, end))
         if (s->_wait(this, Waker()))
         {
           freeze = true;
@@ -351,7 +381,7 @@ namespace elle
         {
           this->_timeout_timer.expires_from_now(*timeout);
           this->_timeout = false;
-          auto repr = elle::sprintf("%s", waitables);
+          auto repr = elle::sprintf("%s", Waitables(begin, end));
           this->_timeout_timer.async_wait(
             [this, repr]
             (boost::system::error_code const& e)
@@ -404,7 +434,7 @@ namespace elle
 
     static
     std::ostream&
-    operator <<(std::ostream& output, std::set<Waitable*> waitables)
+    operator <<(std::ostream& output, Thread::Waited const& waitables)
     {
       if (waitables.size() == 1)
         output << **waitables.begin();
@@ -480,8 +510,12 @@ namespace elle
         if (this->_waited.empty())
         {
           ELLE_TRACE("%s: nothing to wait on, waking up", *this);
+          // Only describe the wake to those who listen.
           this->_scheduler._unfreeze(
-            *this, elle::sprintf("wait for %s ended", *waitable));
+            *this,
+            this->_unfrozen.empty()
+            ? std::string()
+            : elle::sprintf("wait for %s ended", *waitable));
           this->_state = State::running;
         }
         else
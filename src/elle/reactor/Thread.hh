@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
+#include <boost/container/flat_set.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/signals2.hpp>
 #include <boost/system/error_code.hpp>
 
@@ -186,6 +191,23 @@ namespace elle
       // signal invoked when Thread is released by the Scheduler.
       ELLE_ATTRIBUTE_X(Tracker, released);
 
+    /*--------.
+    | Storage |
+    `--------*/
+    private:
+      template <typename T>
+      friend class LocalStorage;
+      /// The value of a LocalStorage for this Thread.
+      struct StorageSlot
+      {
+        void* value = nullptr;
+        void (*destroy)(void*) = nullptr;
+        /// Generation of the owning LocalStorage, zero if unused.
+        std::uint64_t generation = 0;
+      };
+      /// LocalStorage values, indexed by storage slot.
+      ELLE_ATTRIBUTE(std::vector<StorageSlot>, storage);
+
     /*-------.
     | Status |
     `-------*/
@@ -284,6 +306,12 @@ namespace elle
       bool
       wait(Waitable& s,
            DurationOpt timeout = {});
+      /// The Waitables a Thread is waiting for.
+      using Waited = boost::container::flat_set<
+        Waitable*, std::less<Waitable*>,
+        boost::container::small_vector<Waitable*, 4>>;
+      /// Number of Waiters kept on the stack of a wait.
+      static constexpr int waiter_slots = 4;
       /// Terminate execution of the thread by injecting a terminate exception.
       void
       terminate();
@@ -300,6 +328,10 @@ namespace elle
       friend class Scope;
       friend class TimeoutGuard;
       friend class Waitable;
+      bool
+      _wait(Waitable* const* begin,
+            Waitable* const* end,
+            DurationOpt timeout);
       void
       _wait_timeout(boost::system::error_code const& e,
                     std::string const& waited);
@@ -309,7 +341,12 @@ namespace elle
       _freeze();
       void
       _wake(Waitable* waitable);
-      ELLE_ATTRIBUTE_R(std::set<Waitable*>, waited);
+      ELLE_ATTRIBUTE_R(Waited, waited);
+      /// Waiters on the stack of the current wait, if any.
+      ELLE_ATTRIBUTE(Waiter*, waiter_slots);
+      ELLE_ATTRIBUTE(int, waiter_slots_used);
+      /// Whether the current wait had to allocate Waiters.
+      ELLE_ATTRIBUTE(bool, waiter_spilled);
       ELLE_ATTRIBUTE(bool, timeout);
       ELLE_ATTRIBUTE(AsioTimer, timeout_timer);
 
@@ -24,13 +24,18 @@ namespace elle
       : _name(std::move(name))
       , _waiters()
       , _exception()
+      , _on_signaled()
     {}
 
     Waitable::Waitable(Waitable&& source)
       : _name(source._name)
       , _waiters(std::move(source._waiters))
       , _exception(source._exception)
-    {}
+      , _on_signaled(std::move(source._on_signaled))
+    {
+      for (auto& waiter: this->_waiters)
+        waiter.waitable = this;
+    }
 
     Waitable::~Waitable()
     {
@@ -44,7 +49,7 @@ namespace elle
       {
         auto threads =
           make_vector(this->_waiters,
-                      [](auto& t){ return elle::sprintf("%s", *t.first); });
+                      [](auto& w){ return elle::sprintf("%s", *w.thread); });
         ELLE_ABORT("%s destroyed while waited by %s at %s",
                    *this,
                    boost::algorithm::join(threads, ", "),
@@ -69,21 +74,23 @@ namespace elle
     int
     Waitable::_signal()
     {
-      if (_waiters.empty())
+      // Only wake the current waiters, not the ones the wakers may add.
+      auto waiters = Waiters{};
+      waiters.swap(this->_waiters);
+      int res = 0;
+      while (!waiters.empty())
       {
-        _exception = std::exception_ptr{}; // An empty one.
-        this->on_signaled()();
-        return false;
-      }
-      for (auto& thread: this->_waiters)
-        if (thread.second)
-          thread.second(thread.first);
+        auto& waiter = waiters.front();
+        waiters.pop_front();
+        if (waiter.waker)
+          waiter.waker(waiter.thread);
         else
-          thread.first->_wake(this);
-      int res = _waiters.size();
-      _waiters.clear();
-      _exception = std::exception_ptr{}; // An empty one.
-      this->on_signaled()();
+          waiter.thread->_wake(this);
+        this->_release(waiter);
+        ++res;
+      }
+      this->_exception = std::exception_ptr{}; // An empty one.
+      this->_signaled();
       return res;
     }
 
@@ -93,42 +100,53 @@ namespace elle
       if (this->_waiters.empty())
       {
         this->_exception = std::exception_ptr{}; // An empty one.
-        this->on_signaled()();
+        this->_signaled();
         return nullptr;
       }
-      auto thread = *this->_waiters.begin();
-      this->_signal_one(thread);
-      return thread.first;
+      auto& waiter = this->_waiters.front();
+      auto const thread = waiter.thread;
+      this->_signal_one(waiter);
+      return thread;
     }
 
     void
     Waitable::_signal_one(Thread* t)
     {
-      auto thread = this->_waiters.get<1>().find(t);
-      if (thread != this->_waiters.get<1>().end())
-        return _signal_one(*thread);
+      if (auto waiter = this->_find(t))
+        this->_signal_one(*waiter);
     }
 
     void
-    Waitable::_signal_one(Handler const& thread)
+    Waitable::_signal_one(Waiter& waiter)
     {
-      if (thread.second)
-        thread.second(thread.first);
+      if (waiter.waker)
+        waiter.waker(waiter.thread);
       else
-        thread.first->_wake(this);
-      this->_waiters.get<1>().erase(thread.first);
+        waiter.thread->_wake(this);
+      this->_release(waiter);
       this->_exception = std::exception_ptr{}; // An empty one.
       if (this->_waiters.empty())
-        this->on_signaled()();
+        this->_signaled();
     }
 
     bool
     Waitable::_wait(Thread* t, Waker const& waker)
     {
       ELLE_TRACE("%s: wait %s", t, this);
-      ELLE_ASSERT_EQ(this->_waiters.get<1>().find(t),
-                     this->_waiters.get<1>().end());
-      this->_waiters.emplace_back(t, waker);
+      ELLE_ASSERT(!this->_find(t));
+      auto waiter = [t]
+        {
+          if (t->_waiter_slots && t->_waiter_slots_used < Thread::waiter_slots)
+            return &t->_waiter_slots[t->_waiter_slots_used++];
+          auto res = new Waiter;
+          res->owned = true;
+          t->_waiter_spilled = true;
+          return res;
+        }();
+      waiter->thread = t;
+      waiter->waker = waker;
+      waiter->waitable = this;
+      this->_waiters.push_back(*waiter);
       return true;
     }
 
@@ -136,9 +154,40 @@ namespace elle
     Waitable::_unwait(Thread* t)
     {
       ELLE_TRACE("%s: unwait %s", t, this);
-      ELLE_ASSERT_NEQ(this->_waiters.get<1>().find(t),
-                      this->_waiters.get<1>().end());
-      this->_waiters.get<1>().erase(t);
+      auto waiter = this->_find(t);
+      ELLE_ASSERT(waiter);
+      this->_release(*waiter);
+    }
+
+    auto
+    Waitable::_find(Thread* t)
+      -> Waiter*
+    {
+      // Look on the stack of the waiting thread first, which does not depend
+      // on the number of waiters.
+      if (t->_waiter_slots)
+        for (int i = 0; i < t->_waiter_slots_used; ++i)
+        {
+          auto& waiter = t->_waiter_slots[i];
+          if (waiter.waitable == this && waiter.is_linked())
+            return &waiter;
+        }
+      if (!t->_waiter_slots || t->_waiter_spilled)
+        for (auto& waiter: this->_waiters)
+          if (waiter.thread == t)
+            return &waiter;
+      return nullptr;
+    }
+
+    void
+    Waitable::_release(Waiter& waiter)
+    {
+      waiter.unlink();
+      if (waiter.owned)
+        delete &waiter;
+      else
+        // Release the callback state early.
+        waiter.waker = nullptr;
     }
 
     void
@@ -147,6 +196,26 @@ namespace elle
       this->_exception = e;
     }
 
+    /*-------.
+    | Events |
+    `-------*/
+
+    boost::signals2::signal<void ()>&
+    Waitable::on_signaled()
+    {
+      if (!this->_on_signaled)
+        this->_on_signaled =
+          std::make_unique<boost::signals2::signal<void ()>>();
+      return *this->_on_signaled;
+    }
+
+    void
+    Waitable::_signaled()
+    {
+      if (this->_on_signaled)
+        (*this->_on_signaled)();
+    }
+
     /*----------.
     | Printable |
     `----------*/
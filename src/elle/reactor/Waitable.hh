@@ -1,12 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <set>
 
 #include <boost/function.hpp>
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/sequenced_index.hpp>
-#include <boost/multi_index/hashed_index.hpp>
+#include <boost/intrusive/list.hpp>
 #include <boost/noncopyable.hpp>
 
 #include <elle/Exception.hh>
@@ -66,16 +64,28 @@ namespace elle
       using Self = Waitable;
       /// Wake callback.
       using Waker = std::function<void (Thread*)>;
-      /// Waited thread and its wake callback.
-      using Handler = std::pair<Thread*, Waker>;
-      /// Collection of threads waiting this
-      using Waiters = boost::multi_index_container<
-        Handler,
-        boost::multi_index::indexed_by<
-          boost::multi_index::sequenced<>,
-          boost::multi_index::hashed_unique<
-            boost::multi_index::member<Handler, Thread*, &Handler::first>>>
-        >;
+      /// A Thread waiting for a Waitable, with its wake callback.
+      ///
+      /// Waiters are intrusive nodes: they usually live on the stack of the
+      /// waiting Thread, in Thread::wait, and unlink themselves when
+      /// destroyed. Waiters created outside of Thread::wait, or beyond its
+      /// inline capacity, are allocated and owned by the Waitable.
+      struct Waiter
+        : public boost::intrusive::list_base_hook<
+            boost::intrusive::link_mode<boost::intrusive::auto_unlink>>
+      {
+        /// The waiting Thread.
+        Thread* thread = nullptr;
+        /// The wake callback, Thread::_wake if empty.
+        Waker waker;
+        /// The Waitable waited for.
+        Waitable* waitable = nullptr;
+        /// Whether the Waitable deletes this once unlinked.
+        bool owned = false;
+      };
+      /// Collection of threads waiting this, in waiting order.
+      using Waiters = boost::intrusive::list<
+        Waiter, boost::intrusive::constant_time_size<false>>;
 
     /*-------------.
     | Construction |
@@ -168,14 +178,14 @@ namespace elle
       /// \param thread The Thread to wake up.
       void
       _signal_one(Thread* thread);
-      /// Signal a specific Handler.
+      /// Signal a specific Waiter.
       ///
-      /// Same as _signal_one(Thread). If the Handler has a Waker function, use
+      /// Same as _signal_one(Thread). If the Waiter has a Waker function, use
       /// it.
       ///
-      /// \param thread The Handler to signal.
+      /// \param waiter The Waiter to signal.
       void
-      _signal_one(Handler const& thread);
+      _signal_one(Waiter& waiter);
       ///  Register an exception waiting thread should throw when woken.
       ///
       /// \tparam Exception The type of the exception to raise.
@@ -194,6 +204,12 @@ namespace elle
       /// Let friends register/unregister themselves.
       friend class Thread;
       friend class OrWaitable;
+      /// The Waiter of \a thread, if any.
+      Waiter*
+      _find(Thread* thread);
+      /// Unlink \a waiter, deleting it if we own it.
+      void
+      _release(Waiter& waiter);
       /// Exception woken thread must throw.
       ELLE_ATTRIBUTE_R(std::exception_ptr, exception);
 
@@ -202,7 +218,17 @@ namespace elle
     `-------*/
     public:
       /// Signal triggered when the waitable wakes its waiting threads.
-      ELLE_ATTRIBUTE_RX(boost::signals2::signal<void ()>, on_signaled);
+      ///
+      /// Created on first access, so that Waitables nobody listens to do not
+      /// pay for firing it.
+      boost::signals2::signal<void ()>&
+      on_signaled();
+    private:
+      /// Fire on_signaled, if anybody ever connected to it.
+      void
+      _signaled();
+      ELLE_ATTRIBUTE(std::unique_ptr<boost::signals2::signal<void ()>>,
+                     on_signaled);
 
     /*----------.
     | Printable |
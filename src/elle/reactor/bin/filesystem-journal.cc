@@ -0,0 +1,90 @@
+#include <iostream>
+
+#include <elle/Exception.hh>
+
+#include <elle/reactor/filesystem_journal.hh>
+#include <elle/reactor/scheduler.hh>
+
+namespace journal = elle::reactor::filesystem::journal;
+
+static
+void
+usage()
+{
+  std::cerr
+    << "Usage: filesystem-journal inspect JOURNAL\n"
+    << "       filesystem-journal replay JOURNAL DIRECTORY" << std::endl;
+}
+
+/// Dump the records of a journal.
+static
+void
+inspect(std::string const& path)
+{
+  journal::Reader reader(path);
+  auto record = journal::Record{};
+  auto requests = std::size_t(0);
+  auto failures = std::size_t(0);
+  while (reader.next(record))
+  {
+    std::cout << record << std::endl;
+    if (!record.reply)
+      ++requests;
+    else if (record.code)
+      ++failures;
+  }
+  std::cerr << requests << " requests, " << failures << " failed";
+  if (reader.truncated())
+    std::cerr << ", incomplete last record at offset " << reader.offset();
+  std::cerr << std::endl;
+}
+
+/// Run the requests of a journal against a directory.
+static
+void
+replay(std::string const& path, std::string const& directory)
+{
+  elle::reactor::filesystem::BindOperations operations(directory);
+  std::cerr << journal::replay(path, operations) << std::endl;
+}
+
+static
+int
+run(int argc, char** argv)
+{
+  auto const command = argc > 1 ? std::string(argv[1]) : std::string();
+  if (command == "inspect" && argc == 3)
+    inspect(argv[2]);
+  else if (command == "replay" && argc == 4)
+    replay(argv[2], argv[3]);
+  else
+  {
+    usage();
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(int argc, char** argv)
+{
+  auto res = 0;
+  elle::reactor::Scheduler sched;
+  elle::reactor::Thread t(
+    sched, "main",
+    [&]
+    {
+      try
+      {
+        res = run(argc, argv);
+      }
+      catch (...)
+      {
+        std::cerr << "filesystem-journal: " << elle::exception_string()
+                  << std::endl;
+        res = 1;
+      }
+    });
+  sched.run();
+  return res;
+}
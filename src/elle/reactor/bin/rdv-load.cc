@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <elle/print.hh>
+
+#include <elle/reactor/network/rdv.hh>
+#include <elle/reactor/network/resolve.hh>
+#include <elle/reactor/network/udp-socket.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/sleep.hh>
+
+ELLE_LOG_COMPONENT("rdv.load");
+
+using namespace elle::reactor::network;
+
+namespace
+{
+  struct Statistics
+  {
+    std::size_t sent = 0;
+    std::size_t pongs = 0;
+    std::size_t connects = 0;
+    std::size_t found = 0;
+    std::size_t requested = 0;
+    std::size_t errors = 0;
+  };
+}
+
+static
+void
+usage()
+{
+  std::cerr
+    << "Usage: rdv-load HOST PORT [PEERS [SOCKETS [SECONDS [json|binary]]]]"
+    << std::endl;
+}
+
+/// Simulate peers, spread over sockets, pinging the server and asking it to
+/// connect them to one another.
+static
+void
+run(int argc, char** argv)
+{
+  auto const server = resolve_udp(argv[1], argv[2])[0];
+  auto const peers = argc > 3 ? std::stoi(argv[3]) : 10000;
+  auto const sockets = std::min(argc > 4 ? std::stoi(argv[4]) : 64, peers);
+  auto const duration =
+    std::chrono::seconds(argc > 5 ? std::stoi(argv[5]) : 10);
+  auto const encoding = argc > 6 && std::string(argv[6]) == "binary" ?
+    rdv::Encoding::binary : rdv::Encoding::json;
+  auto stats = Statistics{};
+  auto threads = std::vector<elle::reactor::Thread::unique_ptr>{};
+  auto udp = std::vector<std::unique_ptr<UDPSocket>>{};
+  for (int s = 0; s < sockets; ++s)
+  {
+    udp.emplace_back(std::make_unique<UDPSocket>());
+    udp.back()->close();
+    udp.back()->bind(rdv::Endpoint(boost::asio::ip::udp::v4(), 0));
+    threads.emplace_back(new elle::reactor::Thread(
+      elle::print("receive {}", s),
+      [&, s]
+      {
+        auto& socket = *udp[s];
+        elle::Buffer buf;
+        while (true)
+        {
+          buf.size(5000);
+          rdv::Endpoint source;
+          auto const sz = socket.receive_from(elle::WeakBuffer(buf), source);
+          try
+          {
+            auto const msg =
+              rdv::unpack(elle::ConstWeakBuffer(buf.contents(), sz));
+            switch (msg.command)
+            {
+            case rdv::Command::pong:
+              ++stats.pongs;
+              break;
+            case rdv::Command::connect:
+              ++stats.connects;
+              if (msg.target_endpoint)
+                ++stats.found;
+              break;
+            case rdv::Command::connect_requested:
+              ++stats.requested;
+              break;
+            default:
+              ++stats.errors;
+            }
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_WARN("invalid reply from %s: %s", source, e);
+            ++stats.errors;
+          }
+        }
+      }));
+    threads.emplace_back(new elle::reactor::Thread(
+      elle::print("send {}", s),
+      [&, s]
+      {
+        auto& socket = *udp[s];
+        auto random = std::minstd_rand(s);
+        auto pick = std::uniform_int_distribution<int>(0, peers - 1);
+        auto msg = rdv::Message{};
+        while (true)
+          // Peers of this socket are s, s + sockets, s + 2 * sockets, ...
+          for (int p = s; p < peers; p += sockets)
+          {
+            msg.id = elle::print("peer-{}", p);
+            msg.command = rdv::Command::ping;
+            msg.target_address.reset();
+            auto data = rdv::pack(msg, encoding);
+            socket.send_to(elle::ConstWeakBuffer(data), server);
+            ++stats.sent;
+            // One peer out of four also asks for another one.
+            if (p % 4 == 0)
+            {
+              msg.command = rdv::Command::connect;
+              msg.target_address = elle::print("peer-{}", pick(random));
+              data = rdv::pack(msg, encoding);
+              socket.send_to(elle::ConstWeakBuffer(data), server);
+              ++stats.sent;
+            }
+            elle::reactor::yield();
+          }
+      }));
+  }
+  elle::reactor::sleep(duration);
+  for (auto& t: threads)
+    t->terminate_now();
+  auto const seconds = double(duration.count());
+  std::cout
+    << peers << " peers over " << sockets << " sockets, "
+    << (encoding == rdv::Encoding::binary ? "binary" : "json") << ":\n"
+    << "  sent:      " << stats.sent / seconds << " msg/s\n"
+    << "  pongs:     " << stats.pongs / seconds << " msg/s\n"
+    << "  connects:  " << stats.connects / seconds << " msg/s, "
+    << stats.found << " peers found\n"
+    << "  requested: " << stats.requested / seconds << " msg/s\n"
+    << "  errors:    " << stats.errors << std::endl;
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc < 3 || argc > 7)
+  {
+    usage();
+    return 1;
+  }
+  elle::reactor::Scheduler sched;
+  elle::reactor::Thread t(sched, "main", [&]
+                          {
+                            run(argc, argv);
+                          });
+  sched.run();
+}
@@ -1,93 +1,183 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <boost/optional.hpp>
 
-#include <elle/serialization/json.hh>
+#include <elle/err.hh>
 
 #include <elle/reactor/network/rdv.hh>
 #include <elle/reactor/network/udp-socket.hh>
 #include <elle/reactor/scheduler.hh>
-
+#include <elle/reactor/sleep.hh>
 
 ELLE_LOG_COMPONENT("rdv.server");
 
 using namespace elle::reactor::network;
+using namespace std::literals;
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Peer
+  {
+    rdv::Endpoint endpoint;
+    rdv::Encoding encoding;
+    Clock::time_point seen;
+  };
+
+  /// Known peers, forgotten when not heard of for ttl.
+  ///
+  /// Peers are sharded by id, so workers serving different sockets seldom
+  /// contend for the same lock.
+  class Peers
+  {
+  public:
+    Peers(int shards, Clock::duration ttl)
+      : _ttl(ttl)
+      , _shards()
+    {
+      for (int i = 0; i < shards; ++i)
+        this->_shards.emplace_back(std::make_unique<Shard>());
+    }
+
+    void
+    seen(std::string const& id, rdv::Endpoint const& ep, rdv::Encoding e)
+    {
+      auto& shard = this->_shard(id);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.peers[id] = Peer{ep, e, Clock::now()};
+    }
+
+    boost::optional<Peer>
+    find(std::string const& id)
+    {
+      auto& shard = this->_shard(id);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.peers.find(id);
+      if (it == shard.peers.end() || this->_expired(it->second, Clock::now()))
+        return boost::none;
+      return it->second;
+    }
+
+    /// Forget expired peers.
+    ///
+    /// @returns The number of remaining and expired peers.
+    std::pair<std::size_t, std::size_t>
+    sweep()
+    {
+      auto remaining = std::size_t(0);
+      auto expired = std::size_t(0);
+      for (auto& shard: this->_shards)
+      {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        auto const now = Clock::now();
+        for (auto it = shard->peers.begin(); it != shard->peers.end();)
+          if (this->_expired(it->second, now))
+          {
+            it = shard->peers.erase(it);
+            ++expired;
+          }
+          else
+            ++it;
+        remaining += shard->peers.size();
+      }
+      return {remaining, expired};
+    }
 
-std::unordered_map<std::string, rdv::Endpoint> peers;
-elle::reactor::network::UDPSocket* server = nullptr;
+    ELLE_ATTRIBUTE_R(Clock::duration, ttl);
+
+  private:
+    struct Shard
+    {
+      std::mutex mutex;
+      std::unordered_map<std::string, Peer> peers;
+    };
+
+    Shard&
+    _shard(std::string const& id)
+    {
+      return *this->_shards[
+        std::hash<std::string>()(id) % this->_shards.size()];
+    }
 
-static void send_with_magik(elle::Buffer const& b, rdv::Endpoint peer)
+    bool
+    _expired(Peer const& peer, Clock::time_point now) const
+    {
+      return now - peer.seen > this->_ttl;
+    }
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+  };
+}
+
+static
+void
+send(UDPSocket& socket, rdv::Message const& message,
+     rdv::Encoding encoding, rdv::Endpoint const& peer)
 {
-  elle::Buffer data(elle::reactor::network::rdv::rdv_magic, 8);
-  data.append(b.contents(), b.size());
-  server->send_to(elle::ConstWeakBuffer(data), peer);
+  auto const data = rdv::pack(message, encoding);
+  socket.send_to(elle::ConstWeakBuffer(data), peer);
 }
 
-static void run(int argc, char** argv)
+static
+void
+serve(UDPSocket& socket, Peers& peers)
 {
-  int port = 7890;
-  if (argc >1)
-    port = std::stoi(argv[1]);
-  elle::reactor::network::UDPSocket srv;
-  server = &srv;
-  srv.close();
-  srv.bind(
-    boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), port));
   elle::Buffer buf;
   while (true)
   {
     buf.size(5000);
     rdv::Endpoint source;
-    int sz = srv.receive_from(elle::WeakBuffer(buf), source);
-    buf.size(sz);
-    if (memcmp(buf.contents(), rdv::rdv_magic, 8) == 0)
-    {
-      memmove(buf.mutable_contents(), buf.contents()+8, buf.size()-8);
-      buf.size(sz - 8);
-    }
+    int sz = socket.receive_from(elle::WeakBuffer(buf), source);
+    auto encoding = rdv::Encoding::json;
     rdv::Message req;
     try
     {
-      req = elle::serialization::json::deserialize<rdv::Message>(buf, false);
-
-      peers[req.id] = source;
+      req = rdv::unpack(elle::ConstWeakBuffer(buf.contents(), sz), &encoding);
+      peers.seen(req.id, source, encoding);
       rdv::Message reply;
       reply.id = req.id;
       reply.source_endpoint = source;
       ELLE_TRACE("Got %s packet from %s", (int)req.command, source);
-      switch(req.command)
+      switch (req.command)
       {
       case rdv::Command::ping:
         reply.command = rdv::Command::pong;
         break;
       case rdv::Command::pong:
-        break;
+        continue;
       case rdv::Command::connect:
         {
           reply.command = rdv::Command::connect;
-          ELLE_ASSERT(req.target_address);
+          if (!req.target_address)
+            elle::err("connect request without target address");
           reply.target_address = req.target_address;
-          auto peer = peers.find(*req.target_address);
-          if (peer != peers.end())
+          if (auto peer = peers.find(*req.target_address))
           {
-            ELLE_TRACE("Found peer at %s", peer->second);
-            reply.target_endpoint = peer->second;
+            ELLE_TRACE("Found peer at %s", peer->endpoint);
+            reply.target_endpoint = peer->endpoint;
             rdv::Message other;
             other.command = rdv::Command::connect_requested;
             other.id = *req.target_address;
-            other.source_endpoint = peer->second;
+            other.source_endpoint = peer->endpoint;
             other.target_address = req.id;
             other.target_endpoint = source;
-            elle::Buffer b = elle::serialization::json::serialize(other, false);
-            send_with_magik(b, peer->second);
+            send(socket, other, peer->encoding, peer->endpoint);
           }
         }
         break;
       case rdv::Command::connect_requested:
       case rdv::Command::error:
         ELLE_LOG("unexpected connect_requested");
-        break;
+        continue;
       }
-      elle::Buffer b = elle::serialization::json::serialize(reply, false);
-      send_with_magik(b, source);
+      send(socket, reply, encoding, source);
     }
     catch (elle::Error const& e)
     {
@@ -96,18 +186,69 @@ static void run(int argc, char** argv)
       reply.id = req.id;
       reply.command = rdv::Command::error;
       reply.target_address = e.what();
-      elle::Buffer b = elle::serialization::json::serialize(reply, false);
-      send_with_magik(b, source);
+      send(socket, reply, encoding, source);
     }
   }
 }
 
-int main(int argc, char** argv)
+static
+void
+sweep(Peers& peers)
+{
+  auto const period = std::max<Clock::duration>(peers.ttl() / 4, 1s);
+  while (true)
+  {
+    elle::reactor::sleep(
+      std::chrono::duration_cast<elle::reactor::Duration>(period));
+    auto const res = peers.sweep();
+    if (res.second)
+      ELLE_LOG("forgot %s expired peers, %s remaining",
+               res.second, res.first);
+  }
+}
+
+/// Serve one socket with its own scheduler.
+static
+void
+worker(int port, bool reuse_port, Peers& peers, bool sweeper)
 {
   elle::reactor::Scheduler sched;
   elle::reactor::Thread t(sched, "main", [&]
     {
-      run(argc, argv);
+      UDPSocket srv;
+      srv.close();
+      srv.bind(
+        boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), port),
+        reuse_port);
+      auto sweeping = std::unique_ptr<elle::reactor::Thread>(
+        sweeper ?
+        new elle::reactor::Thread("sweep", [&] { sweep(peers); }) :
+        nullptr);
+      serve(srv, peers);
     });
   sched.run();
 }
+
+int main(int argc, char** argv)
+{
+  if (argc > 4)
+  {
+    std::cerr << "Usage: rdv-server [PORT [SOCKETS [TTL_SECONDS]]]"
+              << std::endl;
+    return 1;
+  }
+  int port = 7890;
+  if (argc > 1)
+    port = std::stoi(argv[1]);
+  // With more than one socket, the system spreads datagrams among sockets
+  // bound to the same port, each served on its own core.
+  auto const sockets = argc > 2 ? std::max(std::stoi(argv[2]), 1) : 1;
+  auto const ttl = std::chrono::seconds(argc > 3 ? std::stoi(argv[3]) : 120);
+  Peers peers(sockets * 8, ttl);
+  std::vector<std::thread> workers;
+  for (int i = 1; i < sockets; ++i)
+    workers.emplace_back([&] { worker(port, true, peers, false); });
+  worker(port, sockets > 1, peers, true);
+  for (auto& w: workers)
+    w.join();
+}
@@ -18,12 +18,14 @@ namespace elle
     {}
 
     Timeout::Timeout(reactor::Duration const& delay)
-      : Super(elle::sprintf("timeout %s", delay))
+      : Super(elle::Backtrace::capture(typeid(Timeout), 1),
+              elle::sprintf("timeout %s", delay))
       , _delay(delay)
     {}
 
     Terminate::Terminate(const std::string& message)
-      : Super(elle::sprintf("thread termination: %s", message))
+      : Super(elle::Backtrace::capture(typeid(Terminate), 1),
+              elle::sprintf("thread termination: %s", message))
     {}
   }
 }
@@ -7,6 +7,7 @@
 
 #include <elle/assert.hh>
 #include <elle/log.hh>
+#include <elle/os/environ.hh>
 #include <elle/reactor/filesystem.hh>
 
 ELLE_LOG_COMPONENT("elle.reactor.filesystem");
@@ -44,17 +45,160 @@ namespace elle
           return false;
       }
 
+      /*----------.
+      | PathCache |
+      `----------*/
+
+      namespace
+      {
+        /// Estimated memory of an entry besides its path: index nodes and a
+        /// typical Path object.
+        std::size_t const entry_overhead = 256;
+
+        std::size_t
+        cost(std::string const& path)
+        {
+          return entry_overhead + path.size();
+        }
+      }
+
+      PathCache::PathCache()
+        : _budget(elle::os::getenv("INFINIT_FILESYSTEM_CACHE_SIZE",
+                                   64 * 1024 * 1024))
+        , _negative_ttl(std::chrono::seconds(1))
+        , _size(0)
+        , _hits(0)
+        , _misses(0)
+        , _evictions(0)
+      {}
+
+      PathCache::Entry const*
+      PathCache::_find(std::string const& path)
+      {
+        auto& by_path = this->_entries.get<1>();
+        auto it = by_path.find(path);
+        if (it == by_path.end())
+          return nullptr;
+        auto recent = this->_entries.project<0>(it);
+        this->_entries.relocate(this->_entries.begin(), recent);
+        return &*recent;
+      }
+
+      std::shared_ptr<Path>
+      PathCache::get(std::string const& path)
+      {
+        auto entry = this->_find(path);
+        if (entry && entry->content)
+        {
+          ++this->_hits;
+          return entry->content;
+        }
+        ++this->_misses;
+        return nullptr;
+      }
+
+      bool
+      PathCache::missing(std::string const& path)
+      {
+        auto entry = this->_find(path);
+        if (!entry || entry->content)
+          return false;
+        if (entry->expiration < Clock::now())
+        {
+          this->_erase(this->_entries.begin());
+          return false;
+        }
+        ++this->_hits;
+        return true;
+      }
+
+      void
+      PathCache::set(std::string const& path, std::shared_ptr<Path> content)
+      {
+        this->_insert(Entry{path, std::move(content), Time()});
+      }
+
+      void
+      PathCache::set_missing(std::string const& path)
+      {
+        this->_insert(Entry{path, nullptr, Clock::now() + this->_negative_ttl});
+      }
+
+      std::shared_ptr<Path>
+      PathCache::extract(std::string const& path)
+      {
+        auto& by_path = this->_entries.get<1>();
+        auto it = by_path.find(path);
+        if (it == by_path.end())
+          return nullptr;
+        auto res = it->content;
+        this->_erase(this->_entries.project<0>(it));
+        return res;
+      }
+
+      void
+      PathCache::invalidate(std::string const& path)
+      {
+        this->extract(path);
+        auto const prefix = path == "/" ? path : path + "/";
+        auto& by_order = this->_entries.get<2>();
+        auto it = by_order.lower_bound(prefix);
+        while (it != by_order.end() &&
+               it->path.compare(0, prefix.size(), prefix) == 0)
+          this->_erase(this->_entries.project<0>(it++));
+      }
+
+      void
+      PathCache::clear()
+      {
+        this->_entries.clear();
+        this->_size = 0;
+      }
+
+      void
+      PathCache::_insert(Entry entry)
+      {
+        this->extract(entry.path);
+        this->_size += cost(entry.path);
+        this->_entries.push_front(std::move(entry));
+        // Evict the least recently used entries, keeping at least the new one.
+        while (this->_size > this->_budget && this->_entries.size() > 1)
+        {
+          ++this->_evictions;
+          this->_erase(std::prev(this->_entries.end()));
+        }
+      }
+
+      void
+      PathCache::_erase(Entries::iterator it)
+      {
+        this->_size -= cost(it->path);
+        this->_entries.erase(it);
+      }
+
+      /*-----------.
+      | FileSystem |
+      `-----------*/
+
+      void
+      FileSystem::_cached(std::string const& path, std::shared_ptr<Path> p)
+      {
+        if (p->allow_cache())
+          this->_cache.set(path, std::move(p));
+        else
+          // Drop any negative entry.
+          this->_cache.extract(path);
+      }
+
       std::shared_ptr<Path>
       FileSystem::fetch_recurse(std::string path)
       {
         path = normalize(path);
         ELLE_DEBUG_SCOPE("%s: fetch_recurse \"%s\"", *this, path);
-        ELLE_DUMP("from %s", _cache);
-        auto it = _cache.find(path);
-        if (it != _cache.end())
+        if (auto res = this->_cache.get(path))
         {
-          ELLE_DEBUG("%s: hit on '%s': %s", *this, path, it->second.get());
-          return it->second;
+          ELLE_DEBUG("%s: hit on '%s': %s", *this, path, res.get());
+          return res;
         }
         else
         {
@@ -63,15 +207,16 @@ namespace elle
           {
             ELLE_DEBUG("%s: root fetch", *this);
             auto p = _operations->path("/");
-            if (p->allow_cache())
-              _cache[path] = p;
+            this->_cached(path, p);
             return p;
           }
           auto bpath = bfs::path(path);
-          auto parent = this->fetch_recurse(bpath.parent_path().string());
+          auto const parent_path = bpath.parent_path().string();
+          if (this->_cache.missing(parent_path))
+            throw Error(ENOENT, "No such file or directory");
+          auto parent = this->fetch_recurse(parent_path);
           auto p = parent->child(bpath.filename().string());
-          if (p->allow_cache())
-            _cache[path] = p;
+          this->_cached(path, p);
           return p;
         }
       }
@@ -82,23 +227,27 @@ namespace elle
         ELLE_DEBUG_SCOPE("%s: fetch \"%s\"", *this, opath);
         auto spath = normalize(opath);
         ELLE_ASSERT(_impl);
-        if (this->_full_tree)
-        {
-          auto res = this->fetch_recurse(spath);
-          return res->unwrap();
-        }
-        else
+        try
         {
-          auto it = this->_cache.find(spath);
-          if (it == this->_cache.end())
+          if (this->_full_tree)
+          {
+            auto res = this->fetch_recurse(spath);
+            return res->unwrap();
+          }
+          else
           {
+            if (auto res = this->_cache.get(spath))
+              return res;
             auto res = this->_operations->path(spath);
-            if (res->allow_cache())
-              this->_cache[spath] = res;
+            this->_cached(spath, res);
             return res;
           }
-          else
-            return it->second;
+        }
+        catch (Error const& e)
+        {
+          if (e.error_code() == ENOENT)
+            this->_cache.set_missing(spath);
+          throw;
         }
       }
 
@@ -106,11 +255,9 @@ namespace elle
       FileSystem::extract(std::string const& path_)
       {
         auto path = normalize(path_);
-        auto it = this->_cache.find(path);
-        if (it == this->_cache.end())
+        auto res = this->_cache.extract(path);
+        if (!res)
           return {};
-        auto res = it->second;
-        this->_cache.erase(path);
         return res->unwrap();
       }
 
@@ -120,20 +267,32 @@ namespace elle
       {
         auto path = normalize(path_);
         std::shared_ptr<Path> res = extract(path);
-        this->_cache[path] =
-          this->_operations->wrap(path, new_content);
+        this->_cache.set(path, this->_operations->wrap(path, new_content));
         return res;
       }
 
       std::shared_ptr<Path>
       FileSystem::get(std::string const& path_)
       {
-        auto path = normalize(path_);
-        auto it = this->_cache.find(path);
-        if (it == this->_cache.end())
-          return nullptr;
-        else
-          return it->second;
+        return this->_cache.get(normalize(path_));
+      }
+
+      void
+      FileSystem::invalidate(std::string const& path)
+      {
+        this->_cache.invalidate(normalize(path));
+      }
+
+      void
+      FileSystem::missing(std::string const& path)
+      {
+        this->_cache.set_missing(normalize(path));
+      }
+
+      bool
+      FileSystem::is_missing(std::string const& path)
+      {
+        return this->_cache.missing(normalize(path));
       }
 
       std::unique_ptr<Handle>
@@ -8,8 +8,14 @@
 #include <unordered_map>
 
 #include <boost/filesystem.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
 
 #include <elle/Buffer.hh>
+#include <elle/Duration.hh>
 #include <elle/Exception.hh>
 #include <elle/filesystem.hh>
 #include <elle/reactor/Waitable.hh>
@@ -217,6 +223,87 @@ namespace elle
         ELLE_ATTRIBUTE_R(FileSystem*, filesystem, protected);
       };
 
+      /// Bounded LRU cache of resolved Paths, by normalized full path.
+      ///
+      /// Once the estimated memory of the entries exceeds `budget` bytes, the
+      /// least recently used ones are evicted. Negative entries remember a
+      /// path does not exist for `negative_ttl`.
+      class PathCache
+      {
+      public:
+        PathCache();
+
+        /// The Path cached for @a path, null on a miss or a negative entry.
+        std::shared_ptr<Path>
+        get(std::string const& path);
+
+        /// Whether @a path has an unexpired negative entry.
+        bool
+        missing(std::string const& path);
+
+        /// Cache @a content for @a path, replacing any previous entry.
+        void
+        set(std::string const& path, std::shared_ptr<Path> content);
+
+        /// Add a negative entry for @a path.
+        void
+        set_missing(std::string const& path);
+
+        /// Remove the entry for @a path.
+        ///
+        /// @return The Path it held, if any.
+        std::shared_ptr<Path>
+        extract(std::string const& path);
+
+        /// Remove the entries for @a path and everything below it.
+        void
+        invalidate(std::string const& path);
+
+        /// Remove every entry.
+        void
+        clear();
+
+        /// Estimated memory, in bytes, to keep entries under.
+        ELLE_ATTRIBUTE_RW(std::size_t, budget);
+        /// How long negative entries stay valid.
+        ELLE_ATTRIBUTE_RW(Duration, negative_ttl);
+        /// Estimated memory of the entries, in bytes.
+        ELLE_ATTRIBUTE_R(std::size_t, size);
+        /// Lookups answered from the cache, negative ones included.
+        ELLE_ATTRIBUTE_R(std::size_t, hits);
+        ELLE_ATTRIBUTE_R(std::size_t, misses);
+        /// Entries dropped to stay within the budget.
+        ELLE_ATTRIBUTE_R(std::size_t, evictions);
+
+      private:
+        struct Entry
+        {
+          std::string path;
+          /// Null for negative entries.
+          std::shared_ptr<Path> content;
+          /// Expiration of negative entries.
+          Time expiration;
+        };
+        /// Entries by recency, most recent first, by path and by path order
+        /// to find subtrees.
+        using Entries = boost::multi_index::multi_index_container<
+          Entry,
+          boost::multi_index::indexed_by<
+            boost::multi_index::sequenced<>,
+            boost::multi_index::hashed_unique<
+              boost::multi_index::member<Entry, std::string, &Entry::path>>,
+            boost::multi_index::ordered_unique<
+              boost::multi_index::member<Entry, std::string, &Entry::path>>>>;
+        /// The entry for @a path, made most recent, or null.
+        Entry const*
+        _find(std::string const& path);
+        void
+        _insert(Entry entry);
+        void
+        _erase(Entries::iterator it);
+        ELLE_ATTRIBUTE(Entries, entries);
+      };
+
       class FileSystemImpl;
       class FileSystem
         : public reactor::Waitable
@@ -261,6 +348,24 @@ namespace elle
         std::shared_ptr<Path>
         get(std::string const& path);
 
+        /// Remove @a path and everything below it, e.g. once renamed.
+        void
+        invalidate(std::string const& path);
+
+        /// Remember @a path does not exist.
+        ///
+        /// Until the negative entry expires, `missing` reports it and
+        /// resolving a path below it fails with ENOENT. Resolving @a path
+        /// itself, e.g. to create it, removes the negative entry.
+        void
+        missing(std::string const& path);
+
+        /// Whether @a path is known not to exist.
+        bool
+        is_missing(std::string const& path);
+
+        ELLE_ATTRIBUTE_RX(PathCache, cache);
+
       /*---------.
       | Waitable |
       `---------*/
@@ -276,11 +381,13 @@ namespace elle
         ELLE_ATTRIBUTE_R(FileSystemImpl*, impl);
         std::shared_ptr<Path>
         fetch_recurse(std::string path);
+        /// Cache @a p as @a path if it allows it.
+        void
+        _cached(std::string const& path, std::shared_ptr<Path> p);
         ELLE_ATTRIBUTE_RX(std::unique_ptr<Operations>, operations);
         ELLE_ATTRIBUTE_R(std::vector<std::string>, mount_options);
         ELLE_ATTRIBUTE_RW(bool, full_tree);
         std::string _where;
-        std::unordered_map<std::string, std::shared_ptr<Path>> _cache;
       };
 
 
@@ -381,6 +488,11 @@ namespace elle
         ELLE_ATTRIBUTE_R(BindOperations&, ops);
       };
 
+      /// Journal the operations of @a backend to the file at @a path.
+      ///
+      /// The flush policy is read from INFINIT_FILESYSTEM_JOURNAL_SYNC:
+      /// "never" (the default), "commit", or a number of milliseconds
+      /// between flushes. See journal::Writer.
       std::unique_ptr<Operations> install_journal(std::unique_ptr<Operations> backend,
                                                   std::string const& path);
     }
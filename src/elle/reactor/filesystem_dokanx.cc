@@ -305,6 +305,7 @@ namespace elle
                 p->rmdir();
               else
                 p->unlink();
+              fs->invalidate(path);
             }
             Handle* handle = (Handle*)context->Context;
             if (handle)
@@ -713,6 +714,8 @@ namespace elle
               {}
             }
             p->rename(target);
+            fs->invalidate(path);
+            fs->invalidate(target);
           }
           catch (Error const& e)
           {
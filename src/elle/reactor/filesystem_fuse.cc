@@ -4,12 +4,17 @@
 #include <cerrno>
 #include <sys/types.h>
 
+#include <chrono>
+#include <deque>
 #include <unordered_map>
+#include <vector>
 
 #include <fuse/fuse.h>
+#include <fuse/fuse_lowlevel.h>
 
 #include <boost/filesystem.hpp>
 
+#include <elle/BufferPool.hh>
 #include <elle/bench.hh>
 #include <elle/os/environ.hh>
 #include <elle/reactor/filesystem.hh>
@@ -45,15 +50,19 @@ namespace elle
         BENCH("getattr");
         ELLE_ASSERT(path);
         ELLE_TRACE_SCOPE("fusop_getattr %s", path);
+        auto* fs = (FileSystem*)fuse_get_context()->private_data;
+        if (fs->is_missing(path))
+          return -ENOENT;
         try
         {
-          auto* fs = (FileSystem*)fuse_get_context()->private_data;
           PathPtr p = fs->path(path);
           p->stat(stbuf);
         }
         catch (Error const& e)
         {
           ELLE_TRACE("filesystem error statting %s: %s", path, e.what());
+          if (e.error_code() == ENOENT)
+            fs->missing(path);
           return -e.error_code();
         }
         return 0;
@@ -145,6 +154,7 @@ namespace elle
           auto* fs = (FileSystem*)fuse_get_context()->private_data;
           PathPtr p = fs->path(path);
           p->unlink();
+          fs->invalidate(path);
         }
         catch (Error const& e)
         {
@@ -187,6 +197,7 @@ namespace elle
           auto* fs = (FileSystem*)fuse_get_context()->private_data;
           PathPtr p = fs->path(path);
           p->rmdir();
+          fs->invalidate(path);
         }
         catch (Error const& e)
         {
@@ -209,6 +220,8 @@ namespace elle
           auto* fs = (FileSystem*)fuse_get_context()->private_data;
           PathPtr p = fs->path(path);
           p->rename(to);
+          fs->invalidate(path);
+          fs->invalidate(to);
         }
         catch (Error const& e)
         {
@@ -387,6 +400,7 @@ namespace elle
           auto* fs = (FileSystem*)fuse_get_context()->private_data;
           PathPtr p = fs->path(path);
           p->link(to);
+          fs->invalidate(to);
         }
         catch (Error const& e)
         {
@@ -660,8 +674,1016 @@ namespace elle
         return 0;
       }
 
+      /*--------------.
+      | Low-level API |
+      `--------------*/
+
+      /// How long the kernel may cache entries and attributes, in seconds,
+      /// like the high-level API does by default.
+      static double const ll_timeout = 1.0;
+
+      /// Inode number reported for directory entries, like the high-level API
+      /// does when not using inode numbers.
+      static ino_t const ll_unknown_ino = 0xffffffff;
+
+      using Clock = std::chrono::steady_clock;
+
+      /// A node known to the kernel.
+      struct Node
+      {
+        /// Full path in the filesystem.
+        std::string name;
+        /// Resolved Path, null until used or after it moved.
+        PathPtr path;
+        /// Lookups the kernel did not forget yet.
+        uint64_t lookups;
+      };
+
+      /// Directory listing, fetched on opendir and served by readdir.
+      struct Directory
+      {
+        std::vector<std::pair<std::string, struct stat>> entries;
+      };
+
       class FileSystemImpl: public FuseContext
-      {};
+      {
+      public:
+        /// Forget every node but the root.
+        void
+        reset()
+        {
+          this->_nodes.clear();
+          this->_ids.clear();
+          this->_listed.clear();
+          this->_expiries.clear();
+          this->_nodes[FUSE_ROOT_ID] = Node{"/", nullptr, 1};
+          this->_ids["/"] = FUSE_ROOT_ID;
+          this->_next = FUSE_ROOT_ID + 1;
+        }
+
+        /// Full path of @a ino.
+        std::string
+        name(fuse_ino_t ino)
+        {
+          return this->_node(ino).name;
+        }
+
+        /// Full path of @a name in directory @a parent.
+        std::string
+        child(fuse_ino_t parent, char const* name)
+        {
+          auto res = this->name(parent);
+          if (res != "/")
+            res += "/";
+          return res + name;
+        }
+
+        /// The Path of @a ino, resolved once and kept until it moves.
+        PathPtr
+        path(FileSystem& fs, fuse_ino_t ino)
+        {
+          auto& node = this->_node(ino);
+          if (node.path)
+            return node.path;
+          auto const name = node.name;
+          auto res = fs.path(name);
+          // The node may have been forgotten or moved while resolving.
+          auto it = this->_nodes.find(ino);
+          if (it != this->_nodes.end() && it->second.name == name &&
+              res->allow_cache())
+            it->second.path = res;
+          return res;
+        }
+
+        /// Resolve and stat @a name, counting one more lookup of its node.
+        fuse_entry_param
+        entry(FileSystem& fs, std::string const& name)
+        {
+          fuse_entry_param res;
+          memset(&res, 0, sizeof(res));
+          auto path = fs.path(name);
+          this->stat(name, *path, &res.attr);
+          auto it = this->_ids.find(name);
+          if (it == this->_ids.end())
+          {
+            it = this->_ids.emplace(name, this->_next++).first;
+            this->_nodes[it->second] = Node{name, nullptr, 0};
+          }
+          auto& node = this->_nodes.at(it->second);
+          if (path->allow_cache())
+            node.path = path;
+          ++node.lookups;
+          res.ino = it->second;
+          res.attr.st_ino = res.ino;
+          res.attr_timeout = ll_timeout;
+          res.entry_timeout = ll_timeout;
+          return res;
+        }
+
+        /// Stat @a path, using attributes from a recent listing if any.
+        void
+        stat(std::string const& name, Path& path, struct stat* st)
+        {
+          auto it = this->_listed.find(name);
+          if (it != this->_listed.end())
+          {
+            auto const fresh = this->_fresh(it->second.second);
+            if (fresh)
+              *st = it->second.first;
+            this->_listed.erase(it);
+            if (fresh)
+              return;
+          }
+          path.stat(st);
+        }
+
+        /// Keep attributes of @a name from a directory listing for the
+        /// lookup that usually follows.
+        void
+        listed(std::string const& name, struct stat const& st)
+        {
+          // Listings are timestamped in order: expired ones are at the
+          // front. Skip those listed again since, or dropped already.
+          while (!this->_expiries.empty() &&
+                 !this->_fresh(this->_expiries.front().second))
+          {
+            auto const& expired = this->_expiries.front();
+            auto it = this->_listed.find(expired.first);
+            if (it != this->_listed.end() &&
+                it->second.second == expired.second)
+              this->_listed.erase(it);
+            this->_expiries.pop_front();
+          }
+          auto const now = Clock::now();
+          this->_listed[name] = std::make_pair(st, now);
+          this->_expiries.emplace_back(name, now);
+        }
+
+        /// Drop listed attributes of @a ino, which are changing.
+        void
+        changed(fuse_ino_t ino)
+        {
+          this->_listed.erase(this->name(ino));
+        }
+
+        void
+        forget(fuse_ino_t ino, uint64_t count)
+        {
+          auto it = this->_nodes.find(ino);
+          if (ino == FUSE_ROOT_ID || it == this->_nodes.end())
+            return;
+          auto& node = it->second;
+          node.lookups -= std::min(count, node.lookups);
+          if (node.lookups == 0)
+          {
+            auto id = this->_ids.find(node.name);
+            if (id != this->_ids.end() && id->second == ino)
+              this->_ids.erase(id);
+            this->_nodes.erase(it);
+          }
+        }
+
+        /// @a name was removed: a new file there gets a new node, while
+        /// open handles keep the old one until the kernel forgets it.
+        void
+        removed(std::string const& name)
+        {
+          this->_ids.erase(name);
+          this->_listed.erase(name);
+        }
+
+        /// @a from and its children moved to @a to.
+        void
+        moved(std::string const& from, std::string const& to)
+        {
+          this->removed(to);
+          this->_listed.erase(from);
+          auto const prefix = from + "/";
+          auto moved = std::vector<std::pair<std::string, fuse_ino_t>>{};
+          for (auto it = this->_ids.begin(); it != this->_ids.end();)
+            if (it->first == from ||
+                it->first.compare(0, prefix.size(), prefix) == 0)
+            {
+              moved.emplace_back(to + it->first.substr(from.size()),
+                                 it->second);
+              it = this->_ids.erase(it);
+            }
+            else
+              ++it;
+          for (auto& m: moved)
+          {
+            auto& node = this->_nodes.at(m.second);
+            node.name = m.first;
+            node.path = nullptr;
+            this->_ids[m.first] = m.second;
+          }
+        }
+
+      private:
+        Node&
+        _node(fuse_ino_t ino)
+        {
+          auto it = this->_nodes.find(ino);
+          if (it == this->_nodes.end())
+            throw Error(ESTALE, elle::sprintf("unknown node %s", ino));
+          return it->second;
+        }
+
+        static
+        bool
+        _fresh(Clock::time_point time)
+        {
+          return Clock::now() - time <
+            std::chrono::duration<double>(ll_timeout);
+        }
+
+        std::unordered_map<fuse_ino_t, Node> _nodes;
+        std::unordered_map<std::string, fuse_ino_t> _ids;
+        std::unordered_map<std::string,
+                           std::pair<struct stat, Clock::time_point>> _listed;
+        /// Listed names by listing time, to expire them.
+        std::deque<std::pair<std::string, Clock::time_point>> _expiries;
+        fuse_ino_t _next = FUSE_ROOT_ID + 1;
+      };
+
+      static
+      FileSystem&
+      ll_fs(fuse_req_t req)
+      {
+        return *static_cast<FileSystem*>(fuse_req_userdata(req));
+      }
+
+      static
+      void
+      ll_reply_entry(fuse_req_t req, std::string const& name)
+      {
+        auto& fs = ll_fs(req);
+        auto e = fs.impl()->entry(fs, name);
+        if (fuse_reply_entry(req, &e) == -ENOENT)
+          fs.impl()->forget(e.ino, 1);
+      }
+
+      static
+      void
+      ll_reply_attr(fuse_req_t req, fuse_ino_t ino, PathPtr const& p)
+      {
+        struct stat st;
+        p->stat(&st);
+        st.st_ino = ino;
+        fuse_reply_attr(req, &st, ll_timeout);
+      }
+
+      static
+      void
+      fusell_init(void*, struct fuse_conn_info* conn)
+      {
+#ifdef FUSE_CAP_BIG_WRITES
+        conn->want |= conn->capable & FUSE_CAP_BIG_WRITES;
+#endif
+      }
+
+      static
+      void
+      fusell_lookup(fuse_req_t req, fuse_ino_t parent, const char* name)
+      {
+        BENCH("lookup");
+        ELLE_TRACE_SCOPE("fusell_lookup %s %s", parent, name);
+        auto& fs = ll_fs(req);
+        std::string path;
+        try
+        {
+          path = fs.impl()->child(parent, name);
+          if (fs.is_missing(path))
+            fuse_reply_err(req, ENOENT);
+          else
+            ll_reply_entry(req, path);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error looking up %s: %s", name, e.what());
+          if (e.error_code() == ENOENT && !path.empty())
+            fs.missing(path);
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_forget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup)
+      {
+        ELLE_TRACE_SCOPE("fusell_forget %s %s", ino, nlookup);
+        ll_fs(req).impl()->forget(ino, nlookup);
+        fuse_reply_none(req);
+      }
+
+#if FUSE_VERSION >= 29
+      static
+      void
+      fusell_forget_multi(fuse_req_t req,
+                          size_t count,
+                          struct fuse_forget_data* forgets)
+      {
+        ELLE_TRACE_SCOPE("fusell_forget_multi %s", count);
+        auto& impl = *ll_fs(req).impl();
+        for (size_t i = 0; i < count; ++i)
+          impl.forget(forgets[i].ino, forgets[i].nlookup);
+        fuse_reply_none(req);
+      }
+#endif
+
+      static
+      void
+      fusell_getattr(fuse_req_t req, fuse_ino_t ino, fuse_file_info*)
+      {
+        BENCH("getattr");
+        ELLE_TRACE_SCOPE("fusell_getattr %s", ino);
+        try
+        {
+          auto& fs = ll_fs(req);
+          ll_reply_attr(req, ino, fs.impl()->path(fs, ino));
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error statting %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      struct timespec
+      ll_time(int to_set, int set, int now, struct timespec const& time)
+      {
+        struct timespec res = time;
+        if (to_set & now)
+          res.tv_nsec = UTIME_NOW;
+        else if (!(to_set & set))
+          res.tv_nsec = UTIME_OMIT;
+        return res;
+      }
+
+      static
+      void
+      fusell_setattr(fuse_req_t req,
+                     fuse_ino_t ino,
+                     struct stat* attr,
+                     int to_set,
+                     fuse_file_info* fi)
+      {
+        BENCH("setattr");
+        ELLE_TRACE_SCOPE("fusell_setattr %s %s", ino, to_set);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto p = fs.impl()->path(fs, ino);
+          fs.impl()->changed(ino);
+          if (to_set & FUSE_SET_ATTR_MODE)
+            p->chmod(attr->st_mode);
+          if (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID))
+            p->chown(to_set & FUSE_SET_ATTR_UID ? attr->st_uid : -1,
+                     to_set & FUSE_SET_ATTR_GID ? attr->st_gid : -1);
+          if (to_set & FUSE_SET_ATTR_SIZE)
+          {
+            if (fi && fi->fh)
+              ((Handle*)fi->fh)->ftruncate(attr->st_size);
+            else
+              p->truncate(attr->st_size);
+          }
+          if (to_set & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME))
+          {
+#ifdef FUSE_SET_ATTR_ATIME_NOW
+            auto const atime_now = FUSE_SET_ATTR_ATIME_NOW;
+            auto const mtime_now = FUSE_SET_ATTR_MTIME_NOW;
+#else
+            auto const atime_now = 0;
+            auto const mtime_now = 0;
+#endif
+#ifdef ELLE_MACOS
+            auto const& atime = attr->st_atimespec;
+            auto const& mtime = attr->st_mtimespec;
+#else
+            auto const& atime = attr->st_atim;
+            auto const& mtime = attr->st_mtim;
+#endif
+            struct timespec const tv[2] = {
+              ll_time(to_set, FUSE_SET_ATTR_ATIME, atime_now, atime),
+              ll_time(to_set, FUSE_SET_ATTR_MTIME, mtime_now, mtime),
+            };
+            p->utimens(tv);
+          }
+          ll_reply_attr(req, ino, p);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error on setattr %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_readlink(fuse_req_t req, fuse_ino_t ino)
+      {
+        BENCH("readlink");
+        ELLE_TRACE_SCOPE("fusell_readlink %s", ino);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto target = fs.impl()->path(fs, ino)->readlink().string();
+          fuse_reply_readlink(req, target.c_str());
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error on readlink %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_mkdir(fuse_req_t req,
+                   fuse_ino_t parent,
+                   const char* name,
+                   mode_t mode)
+      {
+        BENCH("mkdir");
+        ELLE_TRACE_SCOPE("fusell_mkdir %s %s", parent, name);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto path = fs.impl()->child(parent, name);
+          fs.path(path)->mkdir(mode);
+          ll_reply_entry(req, path);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error mkdiring %s: %s", name, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_unlink(fuse_req_t req, fuse_ino_t parent, const char* name)
+      {
+        BENCH("unlink");
+        ELLE_TRACE_SCOPE("fusell_unlink %s %s", parent, name);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto path = fs.impl()->child(parent, name);
+          fs.path(path)->unlink();
+          fs.invalidate(path);
+          fs.impl()->removed(path);
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error unlinking %s: %s", name, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_rmdir(fuse_req_t req, fuse_ino_t parent, const char* name)
+      {
+        BENCH("rmdir");
+        ELLE_TRACE_SCOPE("fusell_rmdir %s %s", parent, name);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto path = fs.impl()->child(parent, name);
+          fs.path(path)->rmdir();
+          fs.invalidate(path);
+          fs.impl()->removed(path);
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error rmdiring %s: %s", name, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_symlink(fuse_req_t req,
+                     const char* target,
+                     fuse_ino_t parent,
+                     const char* name)
+      {
+        BENCH("symlink");
+        ELLE_TRACE_SCOPE("fusell_symlink %s %s %s", target, parent, name);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto path = fs.impl()->child(parent, name);
+          fs.path(path)->symlink(target);
+          ll_reply_entry(req, path);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error on symlink %s: %s", name, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_rename(fuse_req_t req,
+                    fuse_ino_t parent,
+                    const char* name,
+                    fuse_ino_t newparent,
+                    const char* newname)
+      {
+        BENCH("rename");
+        ELLE_TRACE_SCOPE("fusell_rename %s %s %s %s",
+                         parent, name, newparent, newname);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto from = fs.impl()->child(parent, name);
+          auto to = fs.impl()->child(newparent, newname);
+          fs.path(from)->rename(to);
+          fs.invalidate(from);
+          fs.invalidate(to);
+          fs.impl()->moved(from, to);
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error renaming %s: %s", name, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_link(fuse_req_t req,
+                  fuse_ino_t ino,
+                  fuse_ino_t newparent,
+                  const char* newname)
+      {
+        BENCH("link");
+        ELLE_TRACE_SCOPE("fusell_link %s %s %s", ino, newparent, newname);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto to = fs.impl()->child(newparent, newname);
+          fs.impl()->path(fs, ino)->link(to);
+          fs.invalidate(to);
+          ll_reply_entry(req, to);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error on link %s: %s", newname, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_open(fuse_req_t req, fuse_ino_t ino, fuse_file_info* fi)
+      {
+        BENCH("open");
+        ELLE_TRACE_SCOPE("fusell_open %s %s", ino, fi->flags);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto handle = fs.impl()->path(fs, ino)->open(fi->flags, 0);
+          fi->fh = (decltype(fi->fh)) handle.release();
+          ELLE_TRACE("handle: %s", fi->fh);
+          if (fuse_reply_open(req, fi) == -ENOENT)
+            std::unique_ptr<Handle>((Handle*)fi->fh)->close();
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error opening %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_create(fuse_req_t req,
+                    fuse_ino_t parent,
+                    const char* name,
+                    mode_t mode,
+                    fuse_file_info* fi)
+      {
+        BENCH("create");
+        ELLE_TRACE_SCOPE("fusell_create %s %s %s %s",
+                         parent, name, mode, fi->flags);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto path = fs.impl()->child(parent, name);
+          auto handle = fs.path(path)->create(fi->flags, mode);
+          fuse_entry_param e;
+          try
+          {
+            e = fs.impl()->entry(fs, path);
+          }
+          catch (Error const&)
+          {
+            handle->close();
+            throw;
+          }
+          fi->fh = (decltype(fi->fh)) handle.release();
+          if (fuse_reply_create(req, &e, fi) == -ENOENT)
+          {
+            std::unique_ptr<Handle>((Handle*)fi->fh)->close();
+            fs.impl()->forget(e.ino, 1);
+          }
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error creating %s: %s", name, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_read(fuse_req_t req,
+                  fuse_ino_t ino,
+                  size_t size,
+                  off_t offset,
+                  fuse_file_info* fi)
+      {
+        BENCH("read");
+        ELLE_TRACE_SCOPE("fusell_read %s sz=%s, offset=%s", ino, size, offset);
+        try
+        {
+          auto* handle = (Handle*)fi->fh;
+          auto buffer = elle::Buffer(size, elle::BufferPool::local());
+          int res = handle->read(elle::WeakBuffer(buffer), size, offset);
+          if (res < 0)
+            fuse_reply_err(req, -res);
+          else
+          {
+#if FUSE_VERSION >= 29
+            // Reply straight from the buffer, without copying it in a
+            // reply message.
+            fuse_bufvec data = FUSE_BUFVEC_INIT(size_t(res));
+            data.buf[0].mem = buffer.mutable_contents();
+            fuse_reply_data(req, &data, FUSE_BUF_SPLICE_MOVE);
+#else
+            fuse_reply_buf(req, (const char*)buffer.contents(), res);
+#endif
+          }
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error reading %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      ll_reply_write(fuse_req_t req, int res)
+      {
+        if (res < 0)
+          fuse_reply_err(req, -res);
+        else
+          fuse_reply_write(req, res);
+      }
+
+      static
+      void
+      fusell_write(fuse_req_t req,
+                   fuse_ino_t ino,
+                   const char* buf,
+                   size_t size,
+                   off_t offset,
+                   fuse_file_info* fi)
+      {
+        BENCH("write");
+        ELLE_TRACE_SCOPE("fusell_write %s(%s) sz=%s, offset=%s",
+                         ino, fi->fh, size, offset);
+        try
+        {
+          auto* handle = (Handle*)fi->fh;
+          ll_fs(req).impl()->changed(ino);
+          ll_reply_write(
+            req, handle->write(elle::ConstWeakBuffer(buf, size), size, offset));
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error writing %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+#if FUSE_VERSION >= 29
+      static
+      void
+      fusell_write_buf(fuse_req_t req,
+                       fuse_ino_t ino,
+                       fuse_bufvec* data,
+                       off_t offset,
+                       fuse_file_info* fi)
+      {
+        BENCH("write");
+        auto const size = fuse_buf_size(data);
+        ELLE_TRACE_SCOPE("fusell_write_buf %s(%s) sz=%s, offset=%s",
+                         ino, fi->fh, size, offset);
+        try
+        {
+          auto* handle = (Handle*)fi->fh;
+          ll_fs(req).impl()->changed(ino);
+          if (data->count == 1 && data->idx == 0 && data->off == 0 &&
+              !(data->buf[0].flags & FUSE_BUF_IS_FD))
+            // Write straight from the request buffer.
+            ll_reply_write(
+              req,
+              handle->write(
+                elle::ConstWeakBuffer(data->buf[0].mem, size), size, offset));
+          else
+          {
+            auto buffer = elle::Buffer(size, elle::BufferPool::local());
+            fuse_bufvec copy = FUSE_BUFVEC_INIT(size);
+            copy.buf[0].mem = buffer.mutable_contents();
+            auto copied = fuse_buf_copy(&copy, data, fuse_buf_copy_flags(0));
+            if (copied < 0)
+              fuse_reply_err(req, -copied);
+            else
+              ll_reply_write(
+                req,
+                handle->write(elle::ConstWeakBuffer(buffer.contents(), copied),
+                              copied, offset));
+          }
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error writing %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+#endif
+
+      static
+      void
+      fusell_flush(fuse_req_t req, fuse_ino_t ino, fuse_file_info* fi)
+      {
+        BENCH("flush");
+        ELLE_TRACE_SCOPE("fusell_flush %s(%s)", ino, fi->fh);
+        try
+        {
+          if (auto* handle = (Handle*)fi->fh)
+            handle->close();
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error flushing %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_release(fuse_req_t req, fuse_ino_t ino, fuse_file_info* fi)
+      {
+        BENCH("release");
+        ELLE_TRACE_SCOPE("fusell_release %s", ino);
+        try
+        {
+          std::unique_ptr<Handle> handle((Handle*)fi->fh);
+          if (handle)
+            handle->close();
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error releasing %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_fsync(fuse_req_t req,
+                   fuse_ino_t ino,
+                   int datasync,
+                   fuse_file_info* fi)
+      {
+        BENCH("fsync");
+        ELLE_TRACE_SCOPE("fusell_fsync %s %s", ino, datasync);
+        try
+        {
+          ((Handle*)fi->fh)->fsync(datasync);
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error on fsync %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_opendir(fuse_req_t req, fuse_ino_t ino, fuse_file_info* fi)
+      {
+        BENCH("opendir");
+        ELLE_TRACE_SCOPE("fusell_opendir %s", ino);
+        try
+        {
+          auto& fs = ll_fs(req);
+          auto& impl = *fs.impl();
+          auto const name = impl.name(ino);
+          auto dir = std::make_unique<Directory>();
+          impl.path(fs, ino)->list_directory(
+            [&] (std::string const& filename, struct stat* stbuf)
+            {
+              struct stat st;
+              if (stbuf)
+                st = *stbuf;
+              else
+                memset(&st, 0, sizeof(st));
+              // Without readdirplus in this FUSE version, keep complete
+              // attributes for the lookups of a `ls -l`.
+              if (stbuf && stbuf->st_mode)
+                impl.listed(
+                  (name == "/" ? name : name + "/") + filename, *stbuf);
+              st.st_ino = ll_unknown_ino;
+              dir->entries.emplace_back(filename, st);
+            });
+          fi->fh = (decltype(fi->fh)) dir.release();
+          if (fuse_reply_open(req, fi) == -ENOENT)
+            delete (Directory*)fi->fh;
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error reading dir %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_readdir(fuse_req_t req,
+                     fuse_ino_t ino,
+                     size_t size,
+                     off_t offset,
+                     fuse_file_info* fi)
+      {
+        BENCH("readdir");
+        ELLE_TRACE_SCOPE("fusell_readdir %s %s %s", ino, size, offset);
+        auto const& entries = ((Directory*)fi->fh)->entries;
+        auto buffer = elle::Buffer(size, elle::BufferPool::local());
+        auto data = (char*)buffer.mutable_contents();
+        auto used = size_t(0);
+        for (auto i = size_t(offset); i < entries.size(); ++i)
+        {
+          auto const len = fuse_add_direntry(
+            req, data + used, size - used,
+            entries[i].first.c_str(), &entries[i].second, i + 1);
+          if (len > size - used)
+            break;
+          used += len;
+        }
+        fuse_reply_buf(req, data, used);
+      }
+
+      static
+      void
+      fusell_releasedir(fuse_req_t req, fuse_ino_t, fuse_file_info* fi)
+      {
+        delete (Directory*)fi->fh;
+        fuse_reply_err(req, 0);
+      }
+
+      static
+      void
+      fusell_statfs(fuse_req_t req, fuse_ino_t ino)
+      {
+        BENCH("statfs");
+        ELLE_TRACE_SCOPE("fusell_statfs %s", ino);
+        try
+        {
+          auto& fs = ll_fs(req);
+          struct ::statvfs svfs;
+          fs.impl()->path(fs, ino)->statfs(&svfs);
+          fuse_reply_statfs(req, &svfs);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error on statfs %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_setxattr(fuse_req_t req,
+                      fuse_ino_t ino,
+                      const char* key,
+                      const char* val,
+                      size_t valsize,
+                      int flags
+  #ifdef ELLE_MACOS
+                      , uint32_t position
+  #endif
+        )
+      {
+        BENCH("setxattr");
+        ELLE_TRACE_SCOPE("fusell_setxattr %s %s", ino, key);
+        try
+        {
+          auto& fs = ll_fs(req);
+          fs.impl()->path(fs, ino)->setxattr(
+            key, std::string(val, valsize), flags);
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("error: %s", e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      /// Reply @a value to an xattr request of @a size bytes.
+      static
+      void
+      ll_reply_xattr(fuse_req_t req, std::string const& value, size_t size)
+      {
+        if (size == 0)
+          fuse_reply_xattr(req, value.size());
+        else if (size < value.size())
+          fuse_reply_err(req, ERANGE);
+        else
+          fuse_reply_buf(req, value.data(), value.size());
+      }
+
+      static
+      void
+      fusell_getxattr(fuse_req_t req,
+                      fuse_ino_t ino,
+                      const char* key,
+                      size_t size
+  #ifdef ELLE_MACOS
+                      , uint32_t position
+  #endif
+        )
+      {
+        BENCH("getxattr");
+        ELLE_TRACE_SCOPE("fusell_getxattr %s %s buf %s", ino, key, size);
+        try
+        {
+          auto& fs = ll_fs(req);
+          ll_reply_xattr(req, fs.impl()->path(fs, ino)->getxattr(key), size);
+        }
+        catch (Error const& e)
+        {
+          if (e.error_code() != ENODATA)
+            ELLE_TRACE("error: %s", e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_listxattr(fuse_req_t req, fuse_ino_t ino, size_t size)
+      {
+        BENCH("listxattr");
+        ELLE_TRACE_SCOPE("fusell_listxattr %s", ino);
+        try
+        {
+          auto& fs = ll_fs(req);
+          std::string packed;
+          for (auto const& s: fs.impl()->path(fs, ino)->listxattr())
+            packed += s + (char)0;
+          ll_reply_xattr(req, packed, size);
+        }
+        catch (Error const& e)
+        {
+          ELLE_TRACE("filesystem error on listxattr %s: %s", ino, e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
+
+      static
+      void
+      fusell_removexattr(fuse_req_t req, fuse_ino_t ino, const char* key)
+      {
+        BENCH("removexattr");
+        ELLE_TRACE_SCOPE("fusell_removexattr %s %s", ino, key);
+        try
+        {
+          auto& fs = ll_fs(req);
+          fs.impl()->path(fs, ino)->removexattr(key);
+          fuse_reply_err(req, 0);
+        }
+        catch (Error const& e)
+        {
+          if (e.error_code() != ENODATA)
+            ELLE_TRACE("error: %s", e.what());
+          fuse_reply_err(req, e.error_code());
+        }
+      }
 
       FileSystem::FileSystem(std::unique_ptr<Operations> op, bool full_tree)
         : _impl(new FileSystemImpl())
@@ -689,39 +1711,81 @@ namespace elle
                         std::vector<std::string> const& options)
       {
         _where = where.string();
-        fuse_operations ops;
-        memset(&ops, 0, sizeof(ops));
-        ops.getattr = fusop_getattr;
-        ops.readdir = fusop_readdir;
-        ops.open = fusop_open;
-        ops.read = fusop_read;
-        ops.write = fusop_write;
-        ops.release = fusop_release;
-        ops.create = fusop_create;
-        ops.unlink = fusop_unlink;
-        ops.mkdir = fusop_mkdir;
-        ops.rmdir = fusop_rmdir;
-        ops.rename = fusop_rename;
-        ops.readlink = fusop_readlink;
-        ops.symlink = fusop_symlink;
-        ops.link = fusop_link;
-        ops.chmod = fusop_chmod;
-        ops.chown = fusop_chown;
-        ops.statfs = fusop_statfs;
-        ops.utimens = fusop_utimens;
-        ops.truncate = fusop_truncate;
-        ops.ftruncate = fusop_ftruncate;
-        ops.flush = fusop_flush;
-        ops.setxattr = fusop_setxattr;
-        ops.getxattr = fusop_getxattr;
-        ops.listxattr = fusop_listxattr;
-        ops.removexattr = fusop_removexattr;
-        ops.fsync = fusop_fsync;
-        ops.fsyncdir = fusop_fsyncdir;
+        if (elle::os::getenv("INFINIT_FUSE_LOWLEVEL", false))
+        {
+          ELLE_TRACE("Low-level API");
+          fuse_lowlevel_ops ops;
+          memset(&ops, 0, sizeof(ops));
+          ops.init = fusell_init;
+          ops.lookup = fusell_lookup;
+          ops.forget = fusell_forget;
+          ops.getattr = fusell_getattr;
+          ops.setattr = fusell_setattr;
+          ops.readlink = fusell_readlink;
+          ops.mkdir = fusell_mkdir;
+          ops.unlink = fusell_unlink;
+          ops.rmdir = fusell_rmdir;
+          ops.symlink = fusell_symlink;
+          ops.rename = fusell_rename;
+          ops.link = fusell_link;
+          ops.open = fusell_open;
+          ops.read = fusell_read;
+          ops.write = fusell_write;
+          ops.flush = fusell_flush;
+          ops.release = fusell_release;
+          ops.fsync = fusell_fsync;
+          ops.opendir = fusell_opendir;
+          ops.readdir = fusell_readdir;
+          ops.releasedir = fusell_releasedir;
+          ops.statfs = fusell_statfs;
+          ops.setxattr = fusell_setxattr;
+          ops.getxattr = fusell_getxattr;
+          ops.listxattr = fusell_listxattr;
+          ops.removexattr = fusell_removexattr;
+          ops.create = fusell_create;
   #if FUSE_VERSION >= 29
-        ops.flag_nullpath_ok = true;
+          ops.write_buf = fusell_write_buf;
+          ops.forget_multi = fusell_forget_multi;
   #endif
-        _impl->create(where.string(), options, &ops, sizeof(ops), this);
+          _impl->reset();
+          _impl->create(where.string(), options, &ops, sizeof(ops), this);
+        }
+        else
+        {
+          fuse_operations ops;
+          memset(&ops, 0, sizeof(ops));
+          ops.getattr = fusop_getattr;
+          ops.readdir = fusop_readdir;
+          ops.open = fusop_open;
+          ops.read = fusop_read;
+          ops.write = fusop_write;
+          ops.release = fusop_release;
+          ops.create = fusop_create;
+          ops.unlink = fusop_unlink;
+          ops.mkdir = fusop_mkdir;
+          ops.rmdir = fusop_rmdir;
+          ops.rename = fusop_rename;
+          ops.readlink = fusop_readlink;
+          ops.symlink = fusop_symlink;
+          ops.link = fusop_link;
+          ops.chmod = fusop_chmod;
+          ops.chown = fusop_chown;
+          ops.statfs = fusop_statfs;
+          ops.utimens = fusop_utimens;
+          ops.truncate = fusop_truncate;
+          ops.ftruncate = fusop_ftruncate;
+          ops.flush = fusop_flush;
+          ops.setxattr = fusop_setxattr;
+          ops.getxattr = fusop_getxattr;
+          ops.listxattr = fusop_listxattr;
+          ops.removexattr = fusop_removexattr;
+          ops.fsync = fusop_fsync;
+          ops.fsyncdir = fusop_fsyncdir;
+  #if FUSE_VERSION >= 29
+          ops.flag_nullpath_ok = true;
+  #endif
+          _impl->create(where.string(), options, &ops, sizeof(ops), this);
+        }
         _impl->on_loop_exited([this]
           {
             this->unmount();
@@ -2,12 +2,27 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
-#include <fstream>
+#ifdef ELLE_WINDOWS
+# include <io.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <unordered_map>
 #include <utility>
 
-#include <elle/reactor/filesystem.hh>
-#include <elle/serialization/json.hh>
+#include <boost/crc.hpp>
+
+#include <elle/With.hh>
+#include <elle/log.hh>
+#include <elle/os/environ.hh>
+#include <elle/printf.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/filesystem_journal.hh>
+#include <elle/reactor/scheduler.hh>
 
 ELLE_LOG_COMPONENT("elle.reactor.filesystem.journal");
 
@@ -17,116 +32,930 @@ namespace elle
   {
     namespace filesystem
     {
-      static bool True = true;
+      namespace journal
+      {
+        namespace
+        {
+          char const magic[8] = {'E', 'L', 'L', 'E', 'J', 'N', 'L', '1'};
+          /// Payload size and CRC-32.
+          std::size_t const frame_size = 8;
+          std::uint32_t const max_payload = 1u << 30;
 
-#define REACTOR_FILESYSTEM_ERROR(name)                                  \
-      catch (Error const& e)                                            \
-      {                                                                 \
-        _owner.push_fail(_full_path, name, e.error_code(), e.what());   \
-        throw;                                                          \
-      }                                                                 \
+          /*---------.
+          | Encoding |
+          `---------*/
 
-#define REACTOR_FILESYSTEM_HERROR(name)                                 \
-      catch(Error const& e)                                             \
-      {                                                                 \
-        bool fail = false;                                              \
-        int erc = e.error_code();                                       \
-        std::string message = e.what();                                 \
-        _owner.push_out(PushSerializer(this, name)("success", fail)     \
-                        ("code", erc)("message", message)());           \
-        throw;                                                          \
-      }                                                                 \
+          void
+          put_varint(elle::Buffer& buffer, std::uint64_t value)
+          {
+            std::uint8_t bytes[10];
+            auto size = 0;
+            for (; value >= 0x80; value >>= 7)
+              bytes[size++] = std::uint8_t(value) | 0x80;
+            bytes[size++] = std::uint8_t(value);
+            buffer.append(bytes, size);
+          }
 
-      class PushSerializer
-      {
-      public:
-        PushSerializer(std::string const& path, std::string const& op)
-        : ios(b.ostreambuf())
-        , _serializer(new elle::serialization::json::SerializerOut(ios))
+          void
+          put_integer(elle::Buffer& buffer, std::int64_t value)
+          {
+            // Zigzag, so small negative values stay short.
+            put_varint(buffer,
+                       (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63));
+          }
+
+          void
+          put_bytes(elle::Buffer& buffer, void const* data, std::size_t size)
+          {
+            put_varint(buffer, size);
+            buffer.append(data, size);
+          }
+
+          void
+          put_le32(elle::Buffer::Byte* where, std::uint32_t value)
+          {
+            for (int i = 0; i < 4; ++i)
+              where[i] = std::uint8_t(value >> (8 * i));
+          }
+
+          std::uint32_t
+          get_le32(elle::Buffer::Byte const* where)
+          {
+            auto res = std::uint32_t(0);
+            for (int i = 0; i < 4; ++i)
+              res |= std::uint32_t(where[i]) << (8 * i);
+            return res;
+          }
+
+          std::uint32_t
+          crc32(elle::Buffer::Byte const* data, std::size_t size)
+          {
+            auto crc = boost::crc_32_type{};
+            crc.process_bytes(data, size);
+            return crc.checksum();
+          }
+
+          void
+          encode(elle::Buffer& buffer,
+                 Record const& record,
+                 elle::ConstWeakBuffer data)
+          {
+            auto const start = buffer.size();
+            elle::Buffer::Byte frame[frame_size] = {};
+            buffer.append(frame, frame_size);
+            put_varint(buffer, record.sequence);
+            std::uint8_t const header[2] = {
+              std::uint8_t(record.reply),
+              std::uint8_t(record.operation),
+            };
+            buffer.append(header, sizeof header);
+            put_bytes(buffer, record.path.data(), record.path.size());
+            put_varint(buffer, record.handle);
+            put_integer(buffer, record.code);
+            put_bytes(buffer, record.message.data(), record.message.size());
+            put_varint(buffer, record.integers.size());
+            for (auto i: record.integers)
+              put_integer(buffer, i);
+            put_varint(buffer, record.strings.size());
+            for (auto const& s: record.strings)
+              put_bytes(buffer, s.data(), s.size());
+            if (data.empty())
+              data = record.data;
+            put_bytes(buffer, data.contents(), data.size());
+            auto const payload = buffer.mutable_contents() + start + frame_size;
+            auto const size = buffer.size() - start - frame_size;
+            put_le32(buffer.mutable_contents() + start, size);
+            put_le32(buffer.mutable_contents() + start + 4,
+                     crc32(payload, size));
+          }
+
+          /*---------.
+          | Decoding |
+          `---------*/
+
+          class Decoder
+          {
+          public:
+            Decoder(elle::ConstWeakBuffer payload)
+              : _data(payload.contents())
+              , _end(payload.contents() + payload.size())
+            {}
+
+            std::uint8_t
+            byte()
+            {
+              this->_need(1);
+              return *this->_data++;
+            }
+
+            std::uint64_t
+            varint()
+            {
+              auto res = std::uint64_t(0);
+              for (int shift = 0; shift < 64; shift += 7)
+              {
+                auto const b = this->byte();
+                res |= std::uint64_t(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                  return res;
+              }
+              throw elle::Error("invalid varint in journal record");
+            }
+
+            std::int64_t
+            integer()
+            {
+              auto const v = this->varint();
+              return std::int64_t(v >> 1) ^ -std::int64_t(v & 1);
+            }
+
+            elle::ConstWeakBuffer
+            bytes()
+            {
+              auto const size = this->varint();
+              this->_need(size);
+              auto res = elle::ConstWeakBuffer(this->_data, size);
+              this->_data += size;
+              return res;
+            }
+
+            std::string
+            string()
+            {
+              return this->bytes().string();
+            }
+
+          private:
+            void
+            _need(std::uint64_t size)
+            {
+              if (std::uint64_t(this->_end - this->_data) < size)
+                throw elle::Error("truncated journal record");
+            }
+
+            elle::Buffer::Byte const* _data;
+            elle::Buffer::Byte const* _end;
+          };
+
+          void
+          decode(elle::ConstWeakBuffer payload, Record& record)
+          {
+            auto d = Decoder(payload);
+            record.sequence = d.varint();
+            record.reply = d.byte();
+            auto const operation = d.byte();
+            if (operation > std::uint8_t(Operation::dispose))
+              throw elle::Error(
+                elle::sprintf("unknown journal operation %s", int(operation)));
+            record.operation = Operation(operation);
+            record.path = d.string();
+            record.handle = d.varint();
+            record.code = d.integer();
+            record.message = d.string();
+            record.integers.resize(d.varint());
+            for (auto& i: record.integers)
+              i = d.integer();
+            record.strings.resize(d.varint());
+            for (auto& s: record.strings)
+              s = d.string();
+            record.data = elle::Buffer(d.bytes());
+          }
+
+          void
+          write_all(int fd, elle::Buffer const& buffer)
+          {
+            auto data = buffer.contents();
+            auto size = buffer.size();
+            while (size)
+            {
+              auto const written = ::write(fd, data, size);
+              if (written < 0)
+              {
+                if (errno == EINTR)
+                  continue;
+                throw elle::Error(
+                  elle::sprintf("unable to write: %s", std::strerror(errno)));
+              }
+              data += written;
+              size -= written;
+            }
+          }
+
+          void
+          sync_fd(int fd)
+          {
+#ifdef ELLE_WINDOWS
+            auto const res = ::_commit(fd);
+#else
+            auto const res = ::fsync(fd);
+#endif
+            if (res)
+              throw elle::Error(
+                elle::sprintf("unable to sync: %s", std::strerror(errno)));
+          }
+        }
+
+        /*------.
+        | Types |
+        `------*/
+
+        std::ostream&
+        operator <<(std::ostream& output, Operation operation)
         {
-          _serializer->serialize("path", path);
-          _serializer->serialize("operation", op);
+          static char const* const names[] = {
+            "stat", "list_directory", "open", "create", "unlink", "mkdir",
+            "rmdir", "rename", "readlink", "symlink", "link", "chmod", "chown",
+            "statfs", "utimens", "truncate", "setxattr", "getxattr",
+            "listxattr", "removexattr", "read", "write", "ftruncate", "fsync",
+            "fsyncdir", "close", "dispose",
+          };
+          return output << names[int(operation)];
         }
-        PushSerializer(void* handle, std::string const& op)
-        : ios(b.ostreambuf())
-        , _serializer(new elle::serialization::json::SerializerOut(ios))
+
+        std::ostream&
+        operator <<(std::ostream& output, Record const& record)
         {
-          std::string shandle = std::to_string((uint64_t)handle);
-          _serializer->serialize("handle", shandle);
-          _serializer->serialize("operation", op);
+          output << (record.reply ? "reply " : "request ") << record.sequence
+                 << ": " << record.operation;
+          if (!record.path.empty())
+            output << " \"" << record.path << "\"";
+          if (record.handle)
+            output << " handle " << record.handle;
+          for (auto i: record.integers)
+            output << " " << i;
+          for (auto const& s: record.strings)
+            output << " \"" << s << "\"";
+          if (!record.data.empty())
+            output << " (" << record.data.size() << " bytes)";
+          if (record.code)
+            output << " failed with " << record.code << ": " << record.message;
+          return output;
         }
-        PushSerializer(PushSerializer const& b) = delete;
-        PushSerializer(PushSerializer&& b) = default;
-        template<typename T>
-        PushSerializer& operator()(std::string const& k, T& v)
+
+        /*-------.
+        | Writer |
+        `-------*/
+
+        Writer::Writer(std::string const& path,
+                       Sync sync,
+                       Duration sync_interval,
+                       Duration latency,
+                       std::size_t batch)
+          : _path(path)
+          , _sync(sync)
+          , _sync_interval(sync_interval)
+          , _latency(latency)
+          , _batch(batch)
+          , _fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600))
+          , _queued(0)
+          , _written(0)
+          , _commits(0)
+          , _syncs(0)
+          , _flush_requested(0)
+          , _flushed(0)
+          , _stop(false)
         {
-          _serializer->serialize(k, v);
-          return *this;
+          if (this->_fd < 0)
+            throw elle::Error(elle::sprintf("unable to open journal %s: %s",
+                                            path, std::strerror(errno)));
+          this->_pending.append(magic, sizeof magic);
+          this->_thread = std::thread([this] { this->_run(); });
         }
-        elle::Buffer
-        operator()()
+
+        Writer::~Writer()
         {
-          _serializer.reset();
-          ios.flush();
-          return std::move(b);
+          {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_stop = true;
+          }
+          this->_wake.notify_one();
+          this->_thread.join();
+          ::close(this->_fd);
         }
-        elle::Buffer b;
-        elle::IOStream ios;
-        std::unique_ptr<elle::serialization::json::SerializerOut> _serializer;
-      };
 
-      class JournalOperations: public Operations
+        void
+        Writer::append(Record const& record, elle::ConstWeakBuffer data)
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          this->_check();
+          if (this->_pending.size() >= 16 * this->_batch)
+          {
+            this->_wake.notify_one();
+            this->_wait(lock, [this] {
+                return this->_pending.size() < 16 * this->_batch ||
+                  !this->_error.empty();
+              });
+            this->_check();
+          }
+          auto const idle = this->_pending.empty();
+          encode(this->_pending, record, data);
+          ++this->_queued;
+          // An idle writer waits for records without a timeout.
+          if (idle || this->_pending.size() >= this->_batch)
+            this->_wake.notify_one();
+        }
+
+        void
+        Writer::flush()
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          // Wait for a write started after this request: one in progress may
+          // have swapped the queue before our records were appended.
+          auto const target = ++this->_flush_requested;
+          this->_wake.notify_one();
+          this->_wait(lock, [this, target] {
+              return this->_flushed >= target || !this->_error.empty();
+            });
+          this->_check();
+        }
+
+        std::size_t
+        Writer::records() const
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          return this->_written;
+        }
+
+        std::size_t
+        Writer::commits() const
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          return this->_commits;
+        }
+
+        std::size_t
+        Writer::syncs() const
+        {
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          return this->_syncs;
+        }
+
+        void
+        Writer::_check()
+        {
+          if (!this->_error.empty())
+            throw elle::Error(
+              elle::sprintf("journal %s: %s", this->_path, this->_error));
+        }
+
+        void
+        Writer::_wait(std::unique_lock<std::mutex>& lock,
+                      std::function<bool ()> const& ready)
+        {
+          if (!reactor::Scheduler::scheduler())
+          {
+            this->_done.wait(lock, ready);
+            return;
+          }
+          // Wait from a system thread, so the scheduler keeps running. Not
+          // interruptible since the wait refers to this writer.
+          lock.unlock();
+          elle::With<reactor::Thread::NonInterruptible>() << [&]
+          {
+            reactor::background([&]
+              {
+                std::unique_lock<std::mutex> lock(this->_mutex);
+                this->_done.wait(lock, ready);
+              });
+          };
+          lock.lock();
+        }
+
+        void
+        Writer::_run()
+        {
+          auto last_sync = Clock::now();
+          // Whether records were written since the last sync, with
+          // Sync::interval.
+          auto unsynced = false;
+          auto buffer = elle::Buffer();
+          std::unique_lock<std::mutex> lock(this->_mutex);
+          while (true)
+          {
+            auto const ready = [this] {
+              return this->_stop ||
+                this->_flushed < this->_flush_requested ||
+                this->_pending.size() >= this->_batch;
+            };
+            // Queued records are written after the latency at most, and
+            // written ones synced at the interval even if nothing follows.
+            if (!this->_pending.empty())
+              this->_wake.wait_until(
+                lock,
+                unsynced ?
+                std::min(Clock::now() + this->_latency,
+                         last_sync + this->_sync_interval) :
+                Clock::now() + this->_latency,
+                ready);
+            else if (unsynced)
+              this->_wake.wait_until(
+                lock, last_sync + this->_sync_interval, ready);
+            else
+            {
+              this->_wake.wait(lock, [&] {
+                  return ready() || !this->_pending.empty();
+                });
+              // Give the first records the latency to gather more.
+              if (!ready())
+                continue;
+            }
+            auto const requested = this->_flush_requested;
+            auto const flushing = this->_flushed < requested;
+            auto const stop = this->_stop;
+            auto const sync_due =
+              unsynced && Clock::now() - last_sync >= this->_sync_interval;
+            if (this->_pending.empty() && !flushing && !stop && !sync_due)
+              continue;
+            // Write everything queued so far while appends go on.
+            std::swap(buffer, this->_pending);
+            auto const queued = this->_queued;
+            lock.unlock();
+            auto synced = false;
+            auto error = std::string();
+            try
+            {
+              if (!buffer.empty())
+                write_all(this->_fd, buffer);
+              auto const now = Clock::now();
+              auto const sync = [&]
+              {
+                switch (this->_sync)
+                {
+                  case Sync::never:
+                    return false;
+                  case Sync::commit:
+                    return !buffer.empty() || flushing || stop;
+                  case Sync::interval:
+                    return flushing || stop ||
+                      ((unsynced || !buffer.empty()) &&
+                       now - last_sync >= this->_sync_interval);
+                }
+                return false;
+              }();
+              if (sync)
+              {
+                sync_fd(this->_fd);
+                last_sync = now;
+                synced = true;
+                unsynced = false;
+              }
+              else if (!buffer.empty() && this->_sync == Sync::interval)
+                unsynced = true;
+            }
+            catch (elle::Error const& e)
+            {
+              error = e.what();
+            }
+            auto const committed = !buffer.empty();
+            buffer.reset();
+            lock.lock();
+            if (!error.empty() && this->_error.empty())
+              this->_error = error;
+            this->_written = queued;
+            if (committed)
+              ++this->_commits;
+            if (synced)
+              ++this->_syncs;
+            if (flushing)
+              this->_flushed = requested;
+            this->_done.notify_all();
+            if (stop && this->_pending.empty())
+              break;
+          }
+        }
+
+        /*-------.
+        | Reader |
+        `-------*/
+
+        Reader::Reader(std::string const& path)
+          : _path(path)
+          , _truncated(false)
+          , _offset(sizeof magic)
+          , _input(path, std::ios::binary)
+          , _sequence(0)
+        {
+          if (!this->_input)
+            throw elle::Error(
+              elle::sprintf("unable to open journal %s", path));
+          char header[sizeof magic];
+          if (!this->_input.read(header, sizeof header) ||
+              std::memcmp(header, magic, sizeof magic))
+            throw elle::Error(
+              elle::sprintf("%s is not a file system journal", path));
+        }
+
+        bool
+        Reader::next(Record& record)
+        {
+          elle::Buffer::Byte frame[frame_size];
+          this->_input.read(reinterpret_cast<char*>(frame), frame_size);
+          auto const read = std::size_t(this->_input.gcount());
+          if (read == 0)
+            return false;
+          if (read < frame_size)
+          {
+            this->_truncated = true;
+            return false;
+          }
+          auto const size = get_le32(frame);
+          if (size > max_payload)
+            throw elle::Error(
+              elle::sprintf("%s: invalid record size %s at offset %s",
+                            this->_path, size, this->_offset));
+          this->_payload.size(size);
+          this->_input.read(
+            reinterpret_cast<char*>(this->_payload.mutable_contents()), size);
+          if (std::size_t(this->_input.gcount()) < size)
+          {
+            this->_truncated = true;
+            return false;
+          }
+          if (crc32(this->_payload.contents(), size) != get_le32(frame + 4))
+            throw elle::Error(
+              elle::sprintf("%s: checksum mismatch at offset %s",
+                            this->_path, this->_offset));
+          decode(this->_payload, record);
+          if (!record.reply)
+          {
+            if (record.sequence != this->_sequence + 1)
+              throw elle::Error(
+                elle::sprintf("%s: request %s follows request %s",
+                              this->_path, record.sequence, this->_sequence));
+            this->_sequence = record.sequence;
+          }
+          else if (record.sequence == 0 || record.sequence > this->_sequence)
+            throw elle::Error(
+              elle::sprintf("%s: reply to unknown request %s",
+                            this->_path, record.sequence));
+          this->_offset += frame_size + size;
+          return true;
+        }
+
+        /*-------.
+        | Replay |
+        `-------*/
+
+        std::ostream&
+        operator <<(std::ostream& output, Statistics const& statistics)
+        {
+          auto const seconds =
+            std::chrono::duration<double>(statistics.elapsed).count();
+          return output
+            << statistics.requests << " requests in " << seconds << "s ("
+            << (seconds > 0 ? statistics.requests / seconds : 0) << "/s), "
+            << statistics.failures << " failed, "
+            << statistics.mismatches << " differing from the journal";
+        }
+
+        namespace
+        {
+          std::int64_t
+          integer(Record const& record, std::size_t i)
+          {
+            if (i >= record.integers.size())
+              throw Error(EINVAL,
+                          elle::sprintf("missing argument to %s", record));
+            return record.integers[i];
+          }
+
+          std::string const&
+          string(Record const& record, std::size_t i)
+          {
+            if (i >= record.strings.size())
+              throw Error(EINVAL,
+                          elle::sprintf("missing argument to %s", record));
+            return record.strings[i];
+          }
+        }
+
+        Statistics
+        replay(std::string const& path,
+               Operations& operations,
+               bool full_tree)
+        {
+          ELLE_TRACE_SCOPE("replay %s", path);
+          auto res = Statistics{};
+          Reader reader(path);
+          // Journal handle identifiers to replayed handles.
+          auto handles =
+            std::unordered_map<std::uint64_t, std::unique_ptr<Handle>>{};
+          // Replayed errno of requests awaiting their journaled reply.
+          auto results = std::unordered_map<std::uint64_t, int>{};
+          auto buffer = elle::Buffer();
+          auto const resolve = [&] (std::string const& p)
+          {
+            if (!full_tree)
+              return operations.path(p);
+            auto res = operations.path("/");
+            for (auto const& c: bfs::path(p))
+              if (c != "/" && c != "." && !c.empty())
+                res = res->child(c.string());
+            return res;
+          };
+          auto const handle = [&] (std::uint64_t id) -> Handle&
+          {
+            auto it = handles.find(id);
+            if (it == handles.end())
+              throw Error(EBADF, elle::sprintf("unknown handle %s", id));
+            return *it->second;
+          };
+          auto const start = Clock::now();
+          auto record = Record{};
+          while (reader.next(record))
+          {
+            if (record.reply)
+            {
+              auto it = results.find(record.sequence);
+              if (it != results.end())
+              {
+                if (it->second != record.code)
+                {
+                  ELLE_TRACE("%s: replay returned %s", record, it->second);
+                  ++res.mismatches;
+                }
+                results.erase(it);
+              }
+              continue;
+            }
+            ELLE_DEBUG("%s", record);
+            ++res.requests;
+            auto code = 0;
+            try
+            {
+              switch (record.operation)
+              {
+                case Operation::stat:
+                {
+                  struct stat st;
+                  resolve(record.path)->stat(&st);
+                  break;
+                }
+                case Operation::list_directory:
+                  resolve(record.path)->list_directory(
+                    [] (std::string const&, struct stat*) {});
+                  break;
+                case Operation::open:
+                  handles[record.handle] = resolve(record.path)->open(
+                    integer(record, 0), integer(record, 1));
+                  break;
+                case Operation::create:
+                  handles[record.handle] = resolve(record.path)->create(
+                    integer(record, 0), integer(record, 1));
+                  break;
+                case Operation::unlink:
+                  resolve(record.path)->unlink();
+                  break;
+                case Operation::mkdir:
+                  resolve(record.path)->mkdir(integer(record, 0));
+                  break;
+                case Operation::rmdir:
+                  resolve(record.path)->rmdir();
+                  break;
+                case Operation::rename:
+                  resolve(record.path)->rename(string(record, 0));
+                  break;
+                case Operation::readlink:
+                  resolve(record.path)->readlink();
+                  break;
+                case Operation::symlink:
+                  resolve(record.path)->symlink(string(record, 0));
+                  break;
+                case Operation::link:
+                  resolve(record.path)->link(string(record, 0));
+                  break;
+                case Operation::chmod:
+                  resolve(record.path)->chmod(integer(record, 0));
+                  break;
+                case Operation::chown:
+                  resolve(record.path)->chown(integer(record, 0),
+                                              integer(record, 1));
+                  break;
+                case Operation::statfs:
+                {
+                  struct statvfs st;
+                  resolve(record.path)->statfs(&st);
+                  break;
+                }
+                case Operation::utimens:
+                {
+                  struct timespec tv[2];
+                  tv[0].tv_sec = integer(record, 0);
+                  tv[0].tv_nsec = integer(record, 1);
+                  tv[1].tv_sec = integer(record, 2);
+                  tv[1].tv_nsec = integer(record, 3);
+                  resolve(record.path)->utimens(tv);
+                  break;
+                }
+                case Operation::truncate:
+                  resolve(record.path)->truncate(integer(record, 0));
+                  break;
+                case Operation::setxattr:
+                  resolve(record.path)->setxattr(
+                    string(record, 0), string(record, 1), integer(record, 0));
+                  break;
+                case Operation::getxattr:
+                  resolve(record.path)->getxattr(string(record, 0));
+                  break;
+                case Operation::listxattr:
+                  resolve(record.path)->listxattr();
+                  break;
+                case Operation::removexattr:
+                  resolve(record.path)->removexattr(string(record, 0));
+                  break;
+                case Operation::read:
+                {
+                  auto const size = integer(record, 0);
+                  buffer.size(size);
+                  handle(record.handle).read(
+                    elle::WeakBuffer(buffer), size, integer(record, 1));
+                  break;
+                }
+                case Operation::write:
+                  handle(record.handle).write(
+                    record.data, record.data.size(), integer(record, 1));
+                  break;
+                case Operation::ftruncate:
+                  handle(record.handle).ftruncate(integer(record, 0));
+                  break;
+                case Operation::fsync:
+                  handle(record.handle).fsync(integer(record, 0));
+                  break;
+                case Operation::fsyncdir:
+                  handle(record.handle).fsyncdir(integer(record, 0));
+                  break;
+                case Operation::close:
+                  handle(record.handle).close();
+                  break;
+                case Operation::dispose:
+                  handles.erase(record.handle);
+                  break;
+              }
+            }
+            catch (Error const& e)
+            {
+              ELLE_DEBUG("%s: %s", record, e.what());
+              code = e.error_code();
+              ++res.failures;
+            }
+            results[record.sequence] = code;
+          }
+          res.elapsed = Clock::now() - start;
+          if (reader.truncated())
+          {
+            ELLE_WARN("%s: journal ends with an incomplete record", path);
+          }
+          return res;
+        }
+      }
+
+      using journal::Operation;
+      using journal::Record;
+
+      /*------------------.
+      | JournalOperations |
+      `------------------*/
+
+#define REACTOR_FILESYSTEM_ERROR(reply)                                 \
+      catch (Error const& e)                                            \
+      {                                                                 \
+        this->_owner.fail(reply, e.error_code(), e.what());             \
+        throw;                                                          \
+      }                                                                 \
+
+      namespace
       {
-      public:
-        JournalOperations(std::unique_ptr<Operations> backend, std::string const& path)
-        : _backend(std::move(backend))
-        , _in_op(0)
+        journal::Sync
+        sync_policy()
         {
-          _in.reset(new std::ofstream(path + "in"));
-          _out.reset(new std::ofstream(path + "out"));
+          auto const sync = elle::os::getenv(
+            "INFINIT_FILESYSTEM_JOURNAL_SYNC", std::string("never"));
+          if (sync == "never")
+            return journal::Sync::never;
+          else if (sync == "commit")
+            return journal::Sync::commit;
+          else
+            return journal::Sync::interval;
         }
+
+        Duration
+        sync_interval()
+        {
+          auto const sync = elle::os::getenv(
+            "INFINIT_FILESYSTEM_JOURNAL_SYNC", std::string("never"));
+          if (sync == "never" || sync == "commit")
+            return std::chrono::seconds(1);
+          // Otherwise, a positive number of milliseconds.
+          auto end = std::size_t(0);
+          auto milliseconds = 0l;
+          try
+          {
+            milliseconds = std::stol(sync, &end);
+          }
+          catch (std::logic_error const&)
+          {}
+          if (end == 0 || end != sync.size() || milliseconds <= 0)
+            throw elle::Error(elle::sprintf(
+              "invalid INFINIT_FILESYSTEM_JOURNAL_SYNC: \"%s\", expected "
+              "never, commit or a sync interval in milliseconds", sync));
+          return std::chrono::milliseconds(milliseconds);
+        }
+      }
+
+      class JournalOperations: public Operations
+      {
+      public:
+        JournalOperations(std::unique_ptr<Operations> backend,
+                          std::string const& path)
+          : _backend(std::move(backend))
+          , _writer(path,
+                    sync_policy(),
+                    sync_interval(),
+                    std::chrono::milliseconds(10),
+                    elle::os::getenv("INFINIT_FILESYSTEM_JOURNAL_BATCH",
+                                     1024 * 1024))
+          , _sequence(0)
+          , _handles(0)
+          , _failed(false)
+          , _in_op(0)
+        {}
+
         void
         filesystem(FileSystem* fs) override
         {
           _filesystem = fs;
           _backend->filesystem(fs);
         }
+
         std::shared_ptr<Path>
         path(std::string const& path) override;
+
         std::shared_ptr<Path>
         wrap(std::string const& path, std::shared_ptr<Path> in) override;
-        void push_op(std::string const& path, std::string const& op)
+
+        /// Journal @a request and return its reply, to fill and journal
+        /// once the operation completes.
+        Record
+        request(Record request, elle::ConstWeakBuffer data = {})
         {
-          push_in(PushSerializer(path, op)());
+          request.sequence = ++this->_sequence;
+          this->_append(request, data);
+          auto reply = Record{};
+          reply.sequence = request.sequence;
+          reply.reply = true;
+          reply.operation = request.operation;
+          reply.handle = request.handle;
+          return reply;
         }
-        void push_ok(std::string const& path, std::string const& op)
+
+        void
+        reply(Record const& reply)
         {
-          push_out(PushSerializer(path, op)("success", True)());
+          this->_append(reply);
         }
-        void push_fail(std::string const& path, std::string const& op,
-                       int erc, std::string const& msg)
+
+        void
+        fail(Record& reply, int code, std::string message)
         {
-          bool False = false;
-          push_out(PushSerializer(path, op)("success", False)("code", erc)
-            ("message", msg)());
+          reply.code = code;
+          reply.message = std::move(message);
+          this->_append(reply);
         }
-        void push_out(elle::Buffer buf)
+
+        /// A new handle identifier.
+        std::uint64_t
+        handle()
         {
-          _out->write((const char*)buf.contents(), buf.size());
-          _out->flush();
+          return ++this->_handles;
         }
-        void push_in(elle::Buffer buf)
+
+      private:
+        void
+        _append(Record const& record, elle::ConstWeakBuffer data = {})
         {
-          _in->write((const char*)buf.contents(), buf.size());
-          _in->flush();
+          if (this->_failed)
+            return;
+          try
+          {
+            this->_writer.append(record, data);
+          }
+          catch (elle::Error const& e)
+          {
+            // Journaling must not fail file system operations.
+            ELLE_ERR("%s: stop journaling: %s", this, e.what());
+            this->_failed = true;
+          }
         }
-      private:
+
         std::unique_ptr<Operations> _backend;
-        std::shared_ptr<std::ostream> _in;
-        std::shared_ptr<std::ostream> _out;
+        journal::Writer _writer;
+        std::uint64_t _sequence;
+        std::uint64_t _handles;
+        bool _failed;
         ELLE_ATTRIBUTE_R(int, in_op);
         friend class InOp;
       };
+
       class InOp
       {
       public:
@@ -141,113 +970,144 @@ namespace elle
         }
         JournalOperations& _j;
       };
-      std::unique_ptr<Operations> install_journal(std::unique_ptr<Operations> backend,
-                                                  std::string const& path)
+
+      std::unique_ptr<Operations>
+      install_journal(std::unique_ptr<Operations> backend,
+                      std::string const& path)
       {
         return std::make_unique<JournalOperations>(std::move(backend), path);
       }
 
+      /*---------------.
+      | JournalHandle |
+      `---------------*/
+
       class JournalHandle: public Handle
       {
       public:
-        JournalHandle(JournalOperations& owner, std::unique_ptr<Handle> backend)
-        : _owner(owner)
-        , _backend(std::move(backend))
-        {
-        }
+        JournalHandle(JournalOperations& owner,
+                      std::unique_ptr<Handle> backend,
+                      std::uint64_t id)
+          : _owner(owner)
+          , _backend(std::move(backend))
+          , _id(id)
+        {}
+
       private:
         JournalOperations& _owner;
         std::unique_ptr<Handle> _backend;
+        std::uint64_t _id;
+
+        Record
+        _request(Operation operation,
+                 std::vector<std::int64_t> integers = {},
+                 elle::ConstWeakBuffer data = {})
+        {
+          auto request = Record{};
+          request.operation = operation;
+          request.handle = this->_id;
+          request.integers = std::move(integers);
+          return this->_owner.request(std::move(request), data);
+        }
+
       public:
         ~JournalHandle() override
         {
-          _owner.push_in(
-            PushSerializer(this, "dispose")()
-          );
-          _owner.push_out(PushSerializer(this, "dispose")("success", True)());
+          try
+          {
+            this->_owner.reply(this->_request(Operation::dispose));
+          }
+          catch (...)
+          {
+            ELLE_WARN("unable to journal handle disposal: %s",
+                      elle::exception_string());
+          }
         }
-        void close() override
+
+        void
+        close() override
         {
-          _owner.push_in(
-            PushSerializer(this, "close")()
-          );
+          auto reply = this->_request(Operation::close);
           try
           {
-            _backend->close();
-            _owner.push_out(PushSerializer(this, "close")("success", True)());
+            this->_backend->close();
           }
-          REACTOR_FILESYSTEM_HERROR("close")
+          REACTOR_FILESYSTEM_ERROR(reply)
+          this->_owner.reply(reply);
         }
-        void fsyncdir(int datasync) override
+
+        void
+        fsyncdir(int datasync) override
         {
-          _owner.push_in(
-            PushSerializer(this, "fsyncdir")("datasync", datasync)()
-          );
+          auto reply = this->_request(Operation::fsyncdir, {datasync});
           try
           {
-            _backend->fsyncdir(datasync);
-            _owner.push_out(PushSerializer(this, "fsyncdir")("success", True)());
+            this->_backend->fsyncdir(datasync);
           }
-          REACTOR_FILESYSTEM_HERROR("fsyncdir")
+          REACTOR_FILESYSTEM_ERROR(reply)
+          this->_owner.reply(reply);
         }
-        void fsync(int datasync) override
+
+        void
+        fsync(int datasync) override
         {
-          _owner.push_in(
-            PushSerializer(this, "fsync")("datasync", datasync)()
-          );
+          auto reply = this->_request(Operation::fsync, {datasync});
           try
           {
-            _backend->fsyncdir(datasync);
-            _owner.push_out(PushSerializer(this, "fsync")("success", True)());
+            this->_backend->fsync(datasync);
           }
-          REACTOR_FILESYSTEM_HERROR("fsync")
+          REACTOR_FILESYSTEM_ERROR(reply)
+          this->_owner.reply(reply);
         }
-        void ftruncate(off_t offset) override
+
+        void
+        ftruncate(off_t offset) override
         {
-          _owner.push_in(
-            PushSerializer(this, "ftruncate")("size", offset)()
-          );
+          auto reply = this->_request(Operation::ftruncate, {offset});
           try
           {
-            _backend->ftruncate(offset);
-            _owner.push_out(PushSerializer(this, "ftruncate")("success", True)());
+            this->_backend->ftruncate(offset);
           }
-          REACTOR_FILESYSTEM_HERROR("ftruncate")
+          REACTOR_FILESYSTEM_ERROR(reply)
+          this->_owner.reply(reply);
         }
-        int read(elle::WeakBuffer buffer, size_t size, off_t offset) override
+
+        int
+        read(elle::WeakBuffer buffer, size_t size, off_t offset) override
         {
-          auto size_ = uint64_t(size);
-          _owner.push_in(
-            PushSerializer(this, "read")("size", size_)("offset", offset)()
-          );
+          auto reply = this->_request(
+            Operation::read, {std::int64_t(size), offset});
           try
           {
-            int res = _backend->read(buffer, size, offset);
-            elle::Buffer buf(buffer.contents(), res);
-            _owner.push_out(PushSerializer(this, "read")("content", buf)("success", True)());
+            auto const res = this->_backend->read(buffer, size, offset);
+            // Record the size read, not the content.
+            reply.integers.push_back(res);
+            this->_owner.reply(reply);
             return res;
           }
-          REACTOR_FILESYSTEM_HERROR("read")
+          REACTOR_FILESYSTEM_ERROR(reply)
         }
 
         int
         write(elle::ConstWeakBuffer buffer, size_t size, off_t offset) override
         {
-          elle::Buffer buf(buffer.contents(), buffer.size());
-          auto size_ = uint64_t(size);
-          _owner.push_in(
-            PushSerializer(this, "write")("size", size_)("offset", offset)("content", buf)()
-          );
+          auto reply = this->_request(
+            Operation::write, {std::int64_t(size), offset}, buffer);
           try
           {
-            int res = _backend->write(buffer, size, offset);
-            _owner.push_out(PushSerializer(this, "write")("success", True)());
+            auto const res = this->_backend->write(buffer, size, offset);
+            reply.integers.push_back(res);
+            this->_owner.reply(reply);
             return res;
           }
-          REACTOR_FILESYSTEM_HERROR("write")
+          REACTOR_FILESYSTEM_ERROR(reply)
         }
       };
 
+      /*------------.
+      | JournalPath |
+      `------------*/
+
       class JournalPath: public Path
       {
       public:
@@ -257,342 +1117,332 @@ namespace elle
         , _full_path(std::move(full_path))
         , _backend(std::move(backend))
         {}
+
       private:
         JournalOperations& _owner;
         std::string _full_path;
         std::shared_ptr<Path> _backend;
-      public:
-        std::shared_ptr<Path> child(std::string const& name) override
+
+        Record
+        _request(Operation operation,
+                 std::vector<std::int64_t> integers = {},
+                 std::vector<std::string> strings = {},
+                 std::uint64_t handle = 0)
         {
-          ELLE_DEBUG("journal_child %s", name);
-          InOp inop(_owner);
-          auto res = _backend->child(name);
-          return std::make_shared<JournalPath>(_owner, res,
-            _full_path + (_full_path == "/" ? "" : "/") + name);
+          auto request = Record{};
+          request.operation = operation;
+          request.path = this->_full_path;
+          request.handle = handle;
+          request.integers = std::move(integers);
+          request.strings = std::move(strings);
+          return this->_owner.request(std::move(request));
         }
-        std::unique_ptr<Handle> create(int flags, mode_t mode) override
+
+        template <typename Open>
+        std::unique_ptr<Handle>
+        _open(Operation operation, int flags, mode_t mode, Open const& open)
         {
           InOp inop(_owner);
-          void* h = nullptr;
-          elle::SafeFinally pushin([&] {
-              std::string shandle = std::to_string((uint64_t)h);
-              _owner.push_in(
-                PushSerializer(_full_path, "create")("mode", mode)("flags", flags)
-                ("handle", shandle)
-                ()
-            );
-          });
+          auto const id = this->_owner.handle();
+          auto reply = this->_request(operation, {flags, mode}, {}, id);
           try
           {
-            auto bh = _backend->create(flags, mode);
-            auto handle = std::make_unique<JournalHandle>(_owner, std::move(bh));
-            h = handle.get();
-            _owner.push_ok(_full_path, "create");
+            auto handle =
+              std::make_unique<JournalHandle>(this->_owner, open(), id);
+            this->_owner.reply(reply);
             return std::move(handle);
           }
-          REACTOR_FILESYSTEM_ERROR("create")
+          REACTOR_FILESYSTEM_ERROR(reply)
         }
-        std::unique_ptr<Handle> open(int flags, mode_t mode) override
+
+      public:
+        std::shared_ptr<Path>
+        child(std::string const& name) override
         {
+          ELLE_DEBUG("journal_child %s", name);
           InOp inop(_owner);
-          void* h = nullptr;
-          elle::SafeFinally pushin([&] {
-              std::string shandle = std::to_string((uint64_t)h);
-              _owner.push_in(
-                PushSerializer(_full_path, "open")("mode", mode)("flags", flags)
-                ("handle", shandle)
-                ()
-            );
-          });
-          try
-          {
-            auto bh = _backend->open(flags, mode);
-            auto handle = std::make_unique<JournalHandle>(_owner, std::move(bh));
-            h = handle.get();
-            _owner.push_ok(_full_path, "open");
-            return std::move(handle);
-          }
-          REACTOR_FILESYSTEM_ERROR("open")
+          auto res = _backend->child(name);
+          return std::make_shared<JournalPath>(_owner, res,
+            _full_path + (_full_path == "/" ? "" : "/") + name);
+        }
+
+        std::unique_ptr<Handle>
+        create(int flags, mode_t mode) override
+        {
+          return this->_open(Operation::create, flags, mode,
+                             [&] { return this->_backend->create(flags, mode); });
         }
-        void stat(struct stat* s) override
+
+        std::unique_ptr<Handle>
+        open(int flags, mode_t mode) override
+        {
+          return this->_open(Operation::open, flags, mode,
+                             [&] { return this->_backend->open(flags, mode); });
+        }
+
+        void
+        stat(struct stat* s) override
         {
           ELLE_DEBUG("journal_stat %s", _full_path);
           InOp inop(_owner);
-          _owner.push_op(_full_path, "stat");
+          auto reply = this->_request(Operation::stat);
           try
           {
             _backend->stat(s);
-            elle::Buffer buf;
-            {
-              elle::IOStream ios(buf.ostreambuf());
-              elle::serialization::json::SerializerOut response(ios);
-              response.serialize("success", true);
-              response.serialize("operation", "stat");
-              response.serialize("path"      , this->_full_path);
-              response.serialize("st_dev"    , s->st_dev    );
-              response.serialize("st_ino"    , s->st_ino    );
-              response.serialize("st_mode"   , s->st_mode   );
-              response.serialize("st_nlink"  , s->st_nlink  );
-              response.serialize("st_uid"    , s->st_uid    );
-              response.serialize("st_gid"    , s->st_gid    );
-              response.serialize("st_rdev"   , s->st_rdev   );
-              response.serialize("st_size"   , int64_t(s->st_size));
-#ifndef ELLE_WINDOWS
-              response.serialize("st_blksize", int64_t(s->st_blksize));
-              response.serialize("st_blocks" , s->st_blocks );
-#endif
-              response.serialize("st_atime"  , uint64_t(s->st_atime));
-              response.serialize("st_mtime"  , uint64_t(s->st_mtime));
-              response.serialize("st_ctime"  , uint64_t(s->st_ctime));
-            }
-            _owner.push_out(buf);
+            reply.integers = {
+              std::int64_t(s->st_ino), s->st_mode, std::int64_t(s->st_nlink),
+              s->st_uid, s->st_gid, s->st_size,
+              s->st_atime, s->st_mtime, s->st_ctime,
+            };
           }
-          REACTOR_FILESYSTEM_ERROR("stat");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void mkdir(mode_t mode) override
+
+        void
+        mkdir(mode_t mode) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "mkdir")("mode", mode)()
-          );
+          auto reply = this->_request(Operation::mkdir, {mode});
           try
           {
             _backend->mkdir(mode);
-            _owner.push_ok(_full_path, "mkdir");
           }
-          REACTOR_FILESYSTEM_ERROR("mkdir");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void rmdir() override
+
+        void
+        rmdir() override
         {
-          _owner.push_op(_full_path, "rmdir");
+          InOp inop(_owner);
+          auto reply = this->_request(Operation::rmdir);
           try
           {
             _backend->rmdir();
-            _owner.push_ok(_full_path, "rmdir");
           }
-          REACTOR_FILESYSTEM_ERROR("rmdir");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void list_directory(OnDirectoryEntry cb) override
+
+        void
+        list_directory(OnDirectoryEntry cb) override
         {
           InOp inop(_owner);
-          _owner.push_op(_full_path, "list_directory");
+          auto reply = this->_request(Operation::list_directory);
           try
           {
-            std::vector<std::string> content;
-            _backend->list_directory([&](std::string const& name, struct stat* st) {
+            _backend->list_directory(
+              [&] (std::string const& name, struct stat* st)
+              {
                 cb(name, st);
-                content.push_back(name);
-            });
-            _owner.push_out(PushSerializer(_full_path, "list_directory")
-              ("success", True)
-              ("entries", content)());
+                reply.strings.push_back(name);
+              });
           }
-          REACTOR_FILESYSTEM_ERROR("list_directory");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void unlink() override
+
+        void
+        unlink() override
         {
           InOp inop(_owner);
-          _owner.push_op(_full_path, "unlink");
+          auto reply = this->_request(Operation::unlink);
           try
           {
             _backend->unlink();
-            _owner.push_ok(_full_path, "unlink");
           }
-          REACTOR_FILESYSTEM_ERROR("unlink");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void rename(bfs::path const& where) override
+
+        void
+        rename(bfs::path const& where) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "rename")("target", where.string())()
-          );
+          auto reply = this->_request(Operation::rename, {}, {where.string()});
           try
           {
             _backend->rename(where);
-            _owner.push_ok(_full_path, "rename");
           }
-          REACTOR_FILESYSTEM_ERROR("rename");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        bfs::path readlink() override
+
+        bfs::path
+        readlink() override
         {
           InOp inop(_owner);
-          _owner.push_op(_full_path, "readlink");
+          auto reply = this->_request(Operation::readlink);
           try
           {
             auto res = _backend->readlink();
-            _owner.push_out(PushSerializer(_full_path, "readlink")
-              ("success", True)
-              ("target", res.string())());
+            reply.strings.push_back(res.string());
+            this->_owner.reply(reply);
             return res;
           }
-          REACTOR_FILESYSTEM_ERROR("readlink");
+          REACTOR_FILESYSTEM_ERROR(reply);
         }
-        void symlink(bfs::path const& where) override
+
+        void
+        symlink(bfs::path const& where) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "symlink")("target", where.string())()
-          );
+          auto reply = this->_request(Operation::symlink, {}, {where.string()});
           try
           {
             _backend->symlink(where);
-            _owner.push_ok(_full_path, "symlink");
           }
-          REACTOR_FILESYSTEM_ERROR("symlink");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void link(bfs::path const& where) override
+
+        void
+        link(bfs::path const& where) override
         {
           ELLE_DEBUG("journal_link");
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "link")("target", where.string())()
-          );
+          auto reply = this->_request(Operation::link, {}, {where.string()});
           try
           {
             _backend->link(where);
-            _owner.push_ok(_full_path, "link");
           }
-          REACTOR_FILESYSTEM_ERROR("link");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void chmod(mode_t mode) override
+
+        void
+        chmod(mode_t mode) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "chmod")("mode", mode)()
-          );
+          auto reply = this->_request(Operation::chmod, {mode});
           try
           {
             _backend->chmod(mode);
-            _owner.push_ok(_full_path, "chmod");
           }
-          REACTOR_FILESYSTEM_ERROR("chmod");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void chown(int uid, int gid) override
+
+        void
+        chown(int uid, int gid) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "chown")("uid", uid)("gid", gid)()
-          );
+          auto reply = this->_request(Operation::chown, {uid, gid});
           try
           {
             _backend->chown(uid, gid);
-            _owner.push_ok(_full_path, "chown");
           }
-          REACTOR_FILESYSTEM_ERROR("chown");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void statfs(struct statvfs* st) override
+
+        void
+        statfs(struct statvfs* st) override
         {
           InOp inop(_owner);
-          _owner.push_op(_full_path, "statfs");
+          auto reply = this->_request(Operation::statfs);
           try
           {
             _backend->statfs(st);
-            elle::Buffer buf;
-            {
-              elle::IOStream ios(buf.ostreambuf());
-              elle::serialization::json::SerializerOut response(ios);
-              response.serialize("success", true);
-              response.serialize("f_bsize",   uint64_t(st->f_bsize));
-              response.serialize("f_frsize",  uint64_t(st->f_frsize));
-              response.serialize("f_blocks",  uint64_t(st->f_blocks));
-              response.serialize("f_bfree",   uint64_t(st->f_bfree));
-              response.serialize("f_bavail",  uint64_t(st->f_bavail));
-              response.serialize("f_files",   uint64_t(st->f_files));
-              response.serialize("f_ffree",   uint64_t(st->f_ffree));
-              response.serialize("f_favail",  uint64_t(st->f_favail));
-              response.serialize("f_fsid",    uint64_t(st->f_fsid));
-              response.serialize("f_flag",    uint64_t(st->f_flag));
-              response.serialize("f_namemax", uint64_t(st->f_namemax));
-            }
-            _owner.push_out(buf);
+            reply.integers = {
+              std::int64_t(st->f_bsize), std::int64_t(st->f_blocks),
+              std::int64_t(st->f_bfree), std::int64_t(st->f_bavail),
+              std::int64_t(st->f_files), std::int64_t(st->f_ffree),
+            };
           }
-          REACTOR_FILESYSTEM_ERROR("statfs");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void utimens(const struct timespec tv[2]) override
+
+        void
+        utimens(const struct timespec tv[2]) override
         {
           InOp inop(_owner);
-          uint64_t ta = tv[0].tv_sec * 1000000000ULL + tv[0].tv_nsec;
-          uint64_t tc = tv[1].tv_sec * 1000000000ULL + tv[1].tv_nsec;
-          _owner.push_in(
-            PushSerializer(_full_path, "utimens")("access", ta)("change", tc)()
-          );
+          auto reply = this->_request(
+            Operation::utimens,
+            {tv[0].tv_sec, tv[0].tv_nsec, tv[1].tv_sec, tv[1].tv_nsec});
           try
           {
             _backend->utimens(tv);
-            _owner.push_ok(_full_path, "utimens");
           }
-          REACTOR_FILESYSTEM_ERROR("utimens");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void truncate(off_t new_size) override
+
+        void
+        truncate(off_t new_size) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "truncate")("size", new_size)()
-          );
+          auto reply = this->_request(Operation::truncate, {new_size});
           try
           {
             _backend->truncate(new_size);
-            _owner.push_ok(_full_path, "truncate");
           }
-          REACTOR_FILESYSTEM_ERROR("truncate");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        void setxattr(std::string const& name, std::string const& value,
-                              int flags) override
+
+        void
+        setxattr(std::string const& name, std::string const& value,
+                 int flags) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "setxattr")("name", name)("value", value)()
-          );
+          auto reply = this->_request(Operation::setxattr, {flags},
+                                      {name, value});
           try
           {
             _backend->setxattr(name, value, flags);
-            _owner.push_ok(_full_path, "setxattr");
           }
-          REACTOR_FILESYSTEM_ERROR("setxattr");
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
         }
-        std::string getxattr(std::string const& name) override
+
+        std::string
+        getxattr(std::string const& name) override
         {
           InOp inop(_owner);
-          _owner.push_in(
-            PushSerializer(_full_path, "getxattr")("name", name)()
-          );
+          auto reply = this->_request(Operation::getxattr, {}, {name});
           try
           {
             auto res = _backend->getxattr(name);
-            _owner.push_out(PushSerializer(_full_path, "getxattr")
-              ("success", True)
-              ("value", res)());
+            reply.strings.push_back(res);
+            this->_owner.reply(reply);
             return res;
           }
-          REACTOR_FILESYSTEM_ERROR("getxattr")
+          REACTOR_FILESYSTEM_ERROR(reply)
         }
-        std::vector<std::string> listxattr() override
+
+        std::vector<std::string>
+        listxattr() override
         {
           InOp inop(_owner);
-          _owner.push_op(_full_path, "listxattr");
+          auto reply = this->_request(Operation::listxattr);
           try
           {
             auto res = _backend->listxattr();
-            _owner.push_out(PushSerializer(_full_path, "listxattr")
-              ("entries", res)("success", True)());
+            reply.strings = res;
+            this->_owner.reply(reply);
             return res;
           }
-          REACTOR_FILESYSTEM_ERROR("listxattr");
+          REACTOR_FILESYSTEM_ERROR(reply);
         }
-        void removexattr(std::string const& name) override
+
+        void
+        removexattr(std::string const& name) override
         {
           InOp inop(_owner);
-           _owner.push_in(
-             PushSerializer(_full_path, "removexattr")("name", name)()
-           );
-           try
-           {
-             _backend->removexattr(name);
-             _owner.push_ok(_full_path, "removexattr");
-           }
-           REACTOR_FILESYSTEM_ERROR("removexattr");
-        }
-        std::shared_ptr<Path> unwrap() override
+          auto reply = this->_request(Operation::removexattr, {}, {name});
+          try
+          {
+            _backend->removexattr(name);
+          }
+          REACTOR_FILESYSTEM_ERROR(reply);
+          this->_owner.reply(reply);
+        }
+
+        std::shared_ptr<Path>
+        unwrap() override
         {
           ELLE_DEBUG("unwrap: %s", _owner.in_op());
           if (_owner.in_op())
@@ -608,6 +1458,7 @@ namespace elle
         auto res = _backend->path(p);
         return std::make_shared<JournalPath>(*this, res, p);
       }
+
       std::shared_ptr<Path>
       JournalOperations::wrap(std::string const& path, std::shared_ptr<Path> in)
       {
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <elle/Buffer.hh>
+#include <elle/Duration.hh>
+#include <elle/attribute.hh>
+#include <elle/reactor/filesystem.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace filesystem
+    {
+      /// Binary journal of file system operations.
+      ///
+      /// A journal starts with an 8 bytes magic and holds a sequence of
+      /// records, each framed by its little endian 32 bits payload size and
+      /// CRC-32. Every request gets the next sequence number, its reply,
+      /// written once the operation completes, repeats it.
+      ///
+      /// Records are appended to memory and written by a background thread,
+      /// several at a time (group commit), so journaling does not block the
+      /// file system on disk I/O.
+      namespace journal
+      {
+        /*------.
+        | Types |
+        `------*/
+
+        /// Journaled operations.
+        enum class Operation
+          : std::uint8_t
+        {
+          stat,
+          list_directory,
+          open,
+          create,
+          unlink,
+          mkdir,
+          rmdir,
+          rename,
+          readlink,
+          symlink,
+          link,
+          chmod,
+          chown,
+          statfs,
+          utimens,
+          truncate,
+          setxattr,
+          getxattr,
+          listxattr,
+          removexattr,
+          read,
+          write,
+          ftruncate,
+          fsync,
+          fsyncdir,
+          close,
+          dispose,
+        };
+
+        std::ostream&
+        operator <<(std::ostream& output, Operation operation);
+
+        /// A journaled request or reply.
+        ///
+        /// Operation specific arguments and results go in `integers`,
+        /// `strings` and `data`, e.g. the flags and mode of `open`, the
+        /// target of `rename` or the content of `write`.
+        struct Record
+        {
+          std::uint64_t sequence = 0;
+          bool reply = false;
+          Operation operation = Operation::stat;
+          /// Full path of path operations.
+          std::string path;
+          /// Journal identifier of the handle of open, create and handle
+          /// operations.
+          std::uint64_t handle = 0;
+          /// The errno of failed replies, 0 otherwise.
+          int code = 0;
+          std::string message;
+          std::vector<std::int64_t> integers;
+          std::vector<std::string> strings;
+          elle::Buffer data;
+        };
+
+        std::ostream&
+        operator <<(std::ostream& output, Record const& record);
+
+        /// When to flush written records to stable storage.
+        enum class Sync
+        {
+          /// Let the system write back.
+          never,
+          /// After every group of records.
+          commit,
+          /// At most once per `sync_interval`.
+          interval,
+        };
+
+        /*-------.
+        | Writer |
+        `-------*/
+
+        /// Append records to a journal file from a background thread.
+        class Writer
+        {
+        public:
+          /// Create or truncate the journal at @a path.
+          ///
+          /// @param sync When to flush to stable storage.
+          /// @param sync_interval Minimum delay between flushes with
+          ///                      Sync::interval.
+          /// @param latency Maximum delay before queued records are written.
+          /// @param batch Queued bytes triggering a write before `latency`.
+          Writer(std::string const& path,
+                 Sync sync = Sync::never,
+                 Duration sync_interval = std::chrono::seconds(1),
+                 Duration latency = std::chrono::milliseconds(10),
+                 std::size_t batch = 1024 * 1024);
+          /// Write queued records and stop the background thread.
+          ~Writer();
+          Writer(Writer const&) = delete;
+
+          /// Queue @a record.
+          ///
+          /// Only waits, for backpressure, if the writer fell 16 batches
+          /// behind. Throws if a previous write failed.
+          ///
+          /// @param data If not empty, written as the record data instead of
+          ///             `record.data`, sparing a copy of write payloads.
+          void
+          append(Record const& record, elle::ConstWeakBuffer data = {});
+          /// Wait until queued records are written, and synced unless the
+          /// policy is Sync::never.
+          ///
+          /// In a scheduler, waits from a background thread and only blocks
+          /// the calling reactor thread.
+          void
+          flush();
+
+          ELLE_ATTRIBUTE_R(std::string, path);
+          ELLE_ATTRIBUTE_R(Sync, sync);
+          ELLE_ATTRIBUTE_R(Duration, sync_interval);
+          ELLE_ATTRIBUTE_R(Duration, latency);
+          ELLE_ATTRIBUTE_R(std::size_t, batch);
+
+        /*-----------.
+        | Statistics |
+        `-----------*/
+        public:
+          /// Records written.
+          std::size_t
+          records() const;
+          /// Group writes.
+          std::size_t
+          commits() const;
+          /// Flushes to stable storage.
+          std::size_t
+          syncs() const;
+
+        /*--------.
+        | Details |
+        `--------*/
+        private:
+          void
+          _run();
+          void
+          _check();
+          /// Wait until @a ready, from a system thread in a scheduler.
+          void
+          _wait(std::unique_lock<std::mutex>& lock,
+                std::function<bool ()> const& ready);
+          ELLE_ATTRIBUTE(int, fd);
+          ELLE_ATTRIBUTE(std::mutex, mutex, mutable);
+          /// Signaled when records are queued or a flush is requested.
+          ELLE_ATTRIBUTE(std::condition_variable, wake);
+          /// Signaled when records are written.
+          ELLE_ATTRIBUTE(std::condition_variable, done);
+          /// Encoded records waiting to be written.
+          ELLE_ATTRIBUTE(elle::Buffer, pending);
+          ELLE_ATTRIBUTE(std::size_t, queued);
+          ELLE_ATTRIBUTE(std::size_t, written);
+          ELLE_ATTRIBUTE(std::size_t, commits);
+          ELLE_ATTRIBUTE(std::size_t, syncs);
+          /// Flush requests so far.
+          ELLE_ATTRIBUTE(std::size_t, flush_requested);
+          /// Flush requests served by a completed write.
+          ELLE_ATTRIBUTE(std::size_t, flushed);
+          ELLE_ATTRIBUTE(bool, stop);
+          ELLE_ATTRIBUTE(std::string, error);
+          ELLE_ATTRIBUTE(std::thread, thread);
+        };
+
+        /*-------.
+        | Reader |
+        `-------*/
+
+        /// Read records back from a journal file.
+        class Reader
+        {
+        public:
+          /// Open the journal at @a path, checking its magic.
+          Reader(std::string const& path);
+
+          /// Read the next record into @a record.
+          ///
+          /// Throws on checksum mismatches and sequence gaps. An incomplete
+          /// last record, as left by a crash, ends the journal and sets
+          /// `truncated`.
+          ///
+          /// @return Whether a record was read.
+          bool
+          next(Record& record);
+
+          ELLE_ATTRIBUTE_R(std::string, path);
+          ELLE_ATTRIBUTE_R(bool, truncated);
+          /// Offset of the next record.
+          ELLE_ATTRIBUTE_R(std::uint64_t, offset);
+
+        private:
+          ELLE_ATTRIBUTE(std::ifstream, input);
+          /// Sequence of the last request.
+          ELLE_ATTRIBUTE(std::uint64_t, sequence);
+          ELLE_ATTRIBUTE(elle::Buffer, payload);
+        };
+
+        /*-------.
+        | Replay |
+        `-------*/
+
+        /// Outcome of a replay.
+        struct Statistics
+        {
+          /// Requests run.
+          std::size_t requests = 0;
+          /// Requests that failed.
+          std::size_t failures = 0;
+          /// Requests whose success or errno differs from the journal.
+          std::size_t mismatches = 0;
+          Duration elapsed = Duration::zero();
+        };
+
+        std::ostream&
+        operator <<(std::ostream& output, Statistics const& statistics);
+
+        /// Run the requests of the journal at @a path against @a operations.
+        ///
+        /// Requests run one at a time, in sequence order, with their recorded
+        /// arguments, e.g. to benchmark a backend on a captured workload or
+        /// reproduce a bug.
+        ///
+        /// @param full_tree Whether to resolve paths from the root with
+        ///                  Path::child, as FileSystem does.
+        Statistics
+        replay(std::string const& path,
+               Operations& operations,
+               bool full_tree = false);
+      }
+    }
+  }
+}
@@ -15,6 +15,7 @@
 #include <elle/reactor/asio.hh>
 
 #include <elle/Buffer.hh>
+#include <elle/BufferPool.hh>
 #include <elle/log.hh>
 #include <elle/system/Process.hh>
 #include <elle/finally.hh>
@@ -31,7 +32,10 @@ namespace elle
   namespace reactor
   {
     FuseContext::FuseContext()
-      : _mt_barrier(elle::sprintf("%s barrier", this))
+      : _fuse(nullptr)
+      , _session(nullptr)
+      , _chan(nullptr)
+      , _mt_barrier(elle::sprintf("%s barrier", this))
     {}
 
     void
@@ -63,11 +67,11 @@ namespace elle
     void
     FuseContext::_loop_one_thread(reactor::Scheduler& sched)
     {
-      fuse_session* s = fuse_get_session(this->_fuse);
-      fuse_chan* ch = fuse_session_next_chan(s, nullptr);
+      fuse_session* s = this->_session;
+      fuse_chan* ch = this->_chan;
       size_t buffer_size = fuse_chan_bufsize(ch);
       void* buffer_data = malloc(buffer_size);
-      while (!fuse_exited(this->_fuse))
+      while (!fuse_session_exited(this->_session))
       {
         ELLE_DUMP("Processing command");
         int res = -EINTR;
@@ -102,33 +106,54 @@ namespace elle
     void
     FuseContext::_loop_single()
     {
-      fuse_session* s = fuse_get_session(this->_fuse);
-      fuse_chan* ch = fuse_session_next_chan(s, nullptr);
+      fuse_session* s = this->_session;
+      fuse_chan* ch = this->_chan;
       int fd = fuse_chan_fd(ch);
       ELLE_TRACE("got fuse fd %s", fd);
       auto socket = boost::asio::posix::stream_descriptor(scheduler().io_service());
       socket.assign(fd);
       auto lock = this->_mt_barrier.lock();
-      while (!fuse_exited(this->_fuse))
+      while (!fuse_session_exited(this->_session))
       {
         this->_socket_barrier.close();
         socket.async_read_some(boost::asio::null_buffers(),
           [&] (boost::system::error_code const&, std::size_t)
           {
-            if (!this->_fuse)
+            if (!this->_session)
               return;
             this->_socket_barrier.open();
           });
         ELLE_DUMP("waiting for socket");
         wait(this->_socket_barrier);
-        if (fuse_exited(this->_fuse))
+        if (fuse_session_exited(this->_session))
           break;
         ELLE_DUMP("Processing command");
-        //highlevel api
-        if (auto cmd = fuse_read_cmd(this->_fuse))
-          fuse_process_cmd(this->_fuse, cmd);
+        if (this->_fuse)
+        {
+          //highlevel api
+          if (auto cmd = fuse_read_cmd(this->_fuse))
+            fuse_process_cmd(this->_fuse, cmd);
+          else
+            break;
+        }
         else
-          break;
+        {
+          auto buf = elle::Buffer(fuse_chan_bufsize(ch),
+                                  elle::BufferPool::local());
+          int res = -EINTR;
+          while (res == -EINTR)
+            res = fuse_chan_recv(
+              &ch, (char*)buf.mutable_contents(), buf.size());
+          if (res == -EAGAIN)
+            continue;
+          if (res <= 0)
+          {
+            if (res < 0)
+              ELLE_LOG("%s: %s", res, strerror(-res));
+            break;
+          }
+          fuse_session_process(s, (const char*)buf.contents(), res, ch);
+        }
       }
       socket.release();
       if (this->on_loop_exited())
@@ -182,8 +207,8 @@ namespace elle
       reactor::Semaphore sem;
       bool stop = false;
       auto requests = std::list<elle::Buffer>{};
-      fuse_session* s = fuse_get_session(this->_fuse);
-      fuse_chan* ch = fuse_session_next_chan(s, nullptr);
+      fuse_session* s = this->_session;
+      fuse_chan* ch = this->_chan;
       size_t buffer_size = fuse_chan_bufsize(ch);
       auto lock = this->_mt_barrier.lock();
       auto worker = [&] {
@@ -221,7 +246,7 @@ namespace elle
       auto socket = boost::asio::posix::stream_descriptor(scheduler().io_service());
       socket.assign(fd);
 #endif
-      while (!fuse_exited(this->_fuse))
+      while (!fuse_session_exited(this->_session))
       {
 #ifndef ELLE_MACOS
         this->_socket_barrier.close();
@@ -236,11 +261,10 @@ namespace elle
         ELLE_DUMP("waiting for socket");
         wait(this->_socket_barrier);
 #endif
-        if (fuse_exited(this->_fuse))
+        if (fuse_session_exited(this->_session))
           break;
         ELLE_DUMP("Processing command");
-        elle::Buffer buf;
-        buf.size(buffer_size);
+        auto buf = elle::Buffer(buffer_size, elle::BufferPool::local());
         int res = -EINTR;
         while(res == -EINTR)
           res = fuse_chan_recv(&ch, (char*)buf.mutable_contents(), buf.size());
@@ -278,8 +302,8 @@ namespace elle
     void
     FuseContext::_loop_mt(Scheduler& sched)
     {
-      fuse_session* s = fuse_get_session(this->_fuse);
-      fuse_chan* ch = fuse_session_next_chan(s, nullptr);
+      fuse_session* s = this->_session;
+      fuse_chan* ch = this->_chan;
       size_t buffer_size = fuse_chan_bufsize(ch);
 #ifndef ELLE_MACOS
       int fd = fuse_chan_fd(ch);
@@ -289,7 +313,7 @@ namespace elle
 #endif
       auto lock = this->_mt_barrier.lock();
       void* buffer_data = malloc(buffer_size);
-      while (!fuse_exited(this->_fuse))
+      while (!fuse_session_exited(this->_session))
       {
 #ifndef ELLE_MACOS
         this->_socket_barrier.close();
@@ -303,7 +327,7 @@ namespace elle
         ELLE_DUMP("waiting for socket");
         wait(this->_socket_barrier);
 #endif
-        if (fuse_exited(this->_fuse))
+        if (fuse_session_exited(this->_session))
           break;
         ELLE_DUMP("Processing command");
         int res = -EINTR;
@@ -355,6 +379,44 @@ namespace elle
                         const struct fuse_operations* op,
                         size_t op_size,
                         void* user_data)
+    {
+      this->_create(
+        mountpoint, arguments,
+        [&] (fuse_chan* chan, fuse_args* args)
+        {
+          this->_fuse = ::fuse_new(chan, args, op, op_size, user_data);
+          if (!this->_fuse)
+            throw filesystem::Error(EPERM, "fuse_new failed");
+          this->_session = ::fuse_get_session(this->_fuse);
+        });
+    }
+
+    void
+    FuseContext::create(std::string const& mountpoint,
+                        std::vector<std::string> const& arguments,
+                        const struct fuse_lowlevel_ops* op,
+                        size_t op_size,
+                        void* user_data)
+    {
+      this->_create(
+        mountpoint, arguments,
+        [&] (fuse_chan* chan, fuse_args* args)
+        {
+          this->_session = ::fuse_lowlevel_new(args, op, op_size, user_data);
+          if (!this->_session)
+          {
+            ::fuse_unmount(mountpoint.c_str(), chan);
+            throw filesystem::Error(EPERM, "fuse_lowlevel_new failed");
+          }
+          ::fuse_session_add_chan(this->_session, chan);
+        });
+    }
+
+    void
+    FuseContext::_create(
+      std::string const& mountpoint,
+      std::vector<std::string> const& arguments,
+      std::function<void (fuse_chan*, fuse_args*)> const& create)
     {
       this->_mountpoint = mountpoint;
       fuse_args args;
@@ -369,9 +431,8 @@ namespace elle
       auto chan = ::fuse_mount(mountpoint.c_str(), &args);
       if (!chan)
         throw filesystem::Error(EPERM, "fuse_mount failed");
-      this->_fuse = ::fuse_new(chan, &args, op, op_size, user_data);
-      if (!this->_fuse)
-        throw filesystem::Error(EPERM, "fuse_new failed");
+      create(chan, &args);
+      this->_chan = chan;
     }
 
 #ifdef ELLE_MACOS
@@ -387,9 +448,9 @@ namespace elle
     FuseContext::destroy(DurationOpt grace_time)
     {
       ELLE_TRACE("fuse_destroy");
-      if (this->_fuse)
+      if (this->_session)
       {
-        ::fuse_exit(this->_fuse);
+        ::fuse_session_exit(this->_session);
       }
       else
       {
@@ -434,18 +495,20 @@ namespace elle
         this->_loop_thread->join();
       }
       ELLE_TRACE("done");
-      if (!this->_fuse)
+      if (!this->_session)
         return;
 #ifndef ELLE_MACOS
-      fuse_session* s = ::fuse_get_session(this->_fuse);
-      ELLE_TRACE("session");
-      fuse_chan* ch = ::fuse_session_next_chan(s, NULL);
-      ELLE_TRACE("chan %s", (void*)(ch));
-      ::fuse_unmount(this->_mountpoint.c_str(), ch);
+      ELLE_TRACE("chan %s", (void*)(this->_chan));
+      ::fuse_unmount(this->_mountpoint.c_str(), this->_chan);
 #endif
       ELLE_TRACE("unmounted");
-      ::fuse_destroy(this->_fuse);
+      if (this->_fuse)
+        ::fuse_destroy(this->_fuse);
+      else
+        ::fuse_session_destroy(this->_session);
       this->_fuse = nullptr;
+      this->_session = nullptr;
+      this->_chan = nullptr;
       ELLE_TRACE("destroyed");
 #ifdef ELLE_MACOS
       this->_loop->terminate_now();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <thread>
@@ -9,7 +10,11 @@
 #include <elle/reactor/MultiLockBarrier.hh>
 
 struct fuse;
+struct fuse_args;
+struct fuse_chan;
+struct fuse_lowlevel_ops;
 struct fuse_operations;
+struct fuse_session;
 
 namespace elle
 {
@@ -22,12 +27,25 @@ namespace elle
     `-------------*/
     public:
       FuseContext();
+      /// Mount using the high-level, path based API.
       void
       create(std::string const& mountpoint,
              std::vector<std::string> const& arguments,
              const struct fuse_operations* op,
              size_t op_size,
              void* user_data);
+      /// Mount using the low-level, nodeid based API.
+      void
+      create(std::string const& mountpoint,
+             std::vector<std::string> const& arguments,
+             const struct fuse_lowlevel_ops* op,
+             size_t op_size,
+             void* user_data);
+    private:
+      void
+      _create(std::string const& mountpoint,
+              std::vector<std::string> const& arguments,
+              std::function<void (fuse_chan*, fuse_args*)> const& create);
 
     public:
       void
@@ -57,7 +75,10 @@ namespace elle
       _mac_unmount(DurationOpt grace_time);
 #endif
 
+      /// Only set when using the high-level API.
       fuse* _fuse;
+      fuse_session* _session;
+      fuse_chan* _chan;
       std::string _mountpoint;
       Barrier _socket_barrier;
       reactor::MultiLockBarrier _mt_barrier;
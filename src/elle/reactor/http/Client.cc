@@ -29,12 +29,21 @@ namespace elle
         Impl():
           _curl(boost::asio::use_service<Service>(
                   Scheduler::scheduler()->io_service())),
-          _share(curl_share_init(), &curl_share_cleanup)
+          _share(curl_share_init(), &curl_share_cleanup),
+          _statistics(std::make_shared<Statistics>())
         {
           if (!this->_share)
             throw std::bad_alloc();
-          curl_share_setopt(this->_share.get(),
-                            CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+          // All requests run in the scheduler thread: no locking needed.
+          for (auto data: {
+              CURL_LOCK_DATA_COOKIE,
+              CURL_LOCK_DATA_DNS,
+              CURL_LOCK_DATA_SSL_SESSION,
+#if LIBCURL_VERSION_NUM >= 0x073900
+              CURL_LOCK_DATA_CONNECT,
+#endif
+            })
+            curl_share_setopt(this->_share.get(), CURLSHOPT_SHARE, data);
         }
 
         ~Impl()
@@ -44,6 +53,7 @@ namespace elle
         friend class Client;
         Service& _curl;
         ELLE_ATTRIBUTE(elle::generic_unique_ptr<CURLSH>, share);
+        ELLE_ATTRIBUTE(std::shared_ptr<Statistics>, statistics);
       };
 
       Client::Client()
@@ -81,6 +91,7 @@ namespace elle
                                              curl_easy_strerror(res)));
         }
 
+        request._impl->_statistics = this->_impl->_statistics;
         {
           auto res = curl_easy_setopt(request._impl->_handle,
                                       CURLOPT_USERAGENT,
@@ -109,6 +120,22 @@ namespace elle
           throw elle::Exception("unable to set cookie jar");
         return Request::Impl::cookies(handle.get());
       }
+
+      /*------------.
+      | Connections |
+      `------------*/
+
+      Client::Statistics
+      Client::statistics() const
+      {
+        return *this->_impl->_statistics;
+      }
+
+      void
+      Client::max_host_connections(int count)
+      {
+        this->_impl->_curl.max_host_connections(count);
+      }
     }
   }
 }
@@ -12,7 +12,11 @@ namespace elle
     {
       /// HTTP client to run multiple requests in the same context.
       ///
-      /// For now the context just includes the cookie jar.
+      /// The context includes the cookie jar, the DNS cache and the TLS
+      /// sessions, so that requests issued by the same client skip name
+      /// resolution and full TLS handshakes. Connections themselves are pooled
+      /// by the scheduler-wide HTTP Service and reused across requests
+      /// whenever the server keeps them alive.
       class Client
       {
       public:
@@ -49,6 +53,36 @@ namespace elle
         Request::Configuration::Cookies
         cookies() const;
 
+      /*------------.
+      | Connections |
+      `------------*/
+      public:
+        /// Connection usage of the requests run by a client.
+        struct Statistics
+        {
+          /// Number of completed requests.
+          int requests;
+          /// Number of connections opened.
+          int connections;
+          /// Number of requests served on an already open connection.
+          int reused;
+          /// Number of requests served over HTTP/2.
+          int http2;
+        };
+        /// Connection usage of the requests run by this client so far.
+        Statistics
+        statistics() const;
+        /// Limit the number of simultaneous connections to a single host.
+        ///
+        /// Connections are pooled by the scheduler-wide Service, so is this
+        /// limit. Requests beyond it wait for a connection to be available,
+        /// or are multiplexed on an HTTP/2 one.
+        ///
+        /// @param count The maximum number of connections per host, 0 for
+        ///              no limit.
+        void
+        max_host_connections(int count);
+
       private:
         /// Register a Request to use this client's context.
         void
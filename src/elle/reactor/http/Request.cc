@@ -4,6 +4,7 @@
 #include <boost/algorithm/string/find_iterator.hpp>
 
 #include <elle/Exception.hh>
+#include <elle/finally.hh>
 #include <elle/log.hh>
 #include <elle/print.hh>
 #include <elle/reactor/http/RequestImpl.hh>
@@ -55,6 +56,7 @@ namespace elle
           // XXX: not supported by wsgiref and <=nginx-1.2 ...
         , _chunked_transfers(false)
         , _expected_status()
+        , _receive_buffer_size(256 * 1024)
         , _ssl_verify_host(true)
       {}
 
@@ -87,12 +89,19 @@ namespace elle
         , _headers(nullptr, &curl_slist_free_all)
         , _progress_changed()
         , _input_done(false)
-        , _input()
-        , _input_current()
+        , _input(0)
+        , _input_begin(0)
+        , _input_size(0)
+        , _input_lent(0)
+        , _input_target()
+        , _input_target_size(0)
+        , _input_paused(false)
+        , _input_unbounded(false)
         , _input_available("input available")
         , _output_done(false)
         , _output(0)
         , _output_available(false)
+        , _output_source()
         , _output_offset(0)
         , _curl(boost::asio::use_service<Service>(
                   reactor::scheduler().io_service()))
@@ -101,6 +110,8 @@ namespace elle
         , _query_string()
         , _handle(curl_easy_init())
         , _pause_count(0)
+        , _receive_pause_count(0)
+        , _statistics()
         , _debug(0)
         , _debug2(0)
         , _bt_frozen()
@@ -117,9 +128,26 @@ namespace elle
         memset(&this->_error[0], 0, CURL_ERROR_SIZE);
         setopt(this->_handle, CURLOPT_ERRORBUFFER, this->_error);
         // Set version.
-        auto version = this->_conf.version() == Version::v11
-          ? CURL_HTTP_VERSION_1_1 : CURL_HTTP_VERSION_1_0;
-        setopt(this->_handle, CURLOPT_HTTP_VERSION, version);
+        if (this->_conf.version() == Version::v20)
+        {
+          // Negotiate HTTP/2 through ALPN on TLS connections, and wait for an
+          // existing connection to be multiplexed rather than opening a new
+          // one. Fall back to HTTP/1.1 if curl was built without HTTP/2.
+          if (curl_easy_setopt(this->_handle, CURLOPT_HTTP_VERSION,
+                               CURL_HTTP_VERSION_2TLS) == CURLE_OK)
+            setopt(this->_handle, CURLOPT_PIPEWAIT, 1L);
+          else
+          {
+            ELLE_DEBUG("%s: HTTP/2 not supported, use HTTP/1.1", *this);
+            setopt(this->_handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+          }
+        }
+        else
+        {
+          auto version = this->_conf.version() == Version::v11
+            ? CURL_HTTP_VERSION_1_1 : CURL_HTTP_VERSION_1_0;
+          setopt(this->_handle, CURLOPT_HTTP_VERSION, version);
+        }
         // Set IPv4 only.
         setopt(this->_handle, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
         // Set proxy.
@@ -437,21 +465,24 @@ namespace elle
       elle::ConstWeakBuffer
       Request::Impl::read_buffer()
       {
-        if (!this->_input_available.opened())
+        this->_input_release();
+        while (this->_input_size == 0 && !this->_input_done)
         {
           ELLE_DEBUG_SCOPE("%s: input: wait for more data", *this->_request);
+          this->_input_available.close();
           this->_input_available.wait();
         }
-        if (!this->_input.empty())
+        if (this->_input_size != 0)
         {
-          this->_input_current = std::move(this->_input.front());
-          ELLE_DEBUG_SCOPE("%s: input: fetch data: %f",
-                           *this->_request, this->_input_current);
-          ELLE_DUMP("%s", this->_input_current);
-          this->_input.pop();
-          if (this->_input.empty() && !this->_input_done)
-            this->_input_available.close();
-          return this->_input_current;
+          // Lend the contiguous readable part of the ring to the stream, it is
+          // released on the next call.
+          this->_input_lent = std::min(
+            this->_input_size, this->_input.size() - this->_input_begin);
+          auto res = elle::ConstWeakBuffer(
+            this->_input.contents() + this->_input_begin, this->_input_lent);
+          ELLE_DEBUG_SCOPE("%s: input: fetch data: %f", *this->_request, res);
+          ELLE_DUMP("%s", res);
+          return res;
         }
         else
         {
@@ -460,6 +491,62 @@ namespace elle
         }
       }
 
+      void
+      Request::Impl::_input_release()
+      {
+        if (this->_input_lent)
+        {
+          this->_input_begin =
+            (this->_input_begin + this->_input_lent) % this->_input.size();
+          this->_input_size -= this->_input_lent;
+          this->_input_lent = 0;
+          this->setg(nullptr, nullptr, nullptr);
+          this->_input_resume();
+        }
+      }
+
+      void
+      Request::Impl::_input_grow(std::size_t size)
+      {
+        auto capacity = this->_input.size();
+        while (capacity < size)
+          capacity *= 2;
+        ELLE_DEBUG("%s: input: grow buffer to %s bytes",
+                   *this->_request, capacity);
+        auto grown = elle::Buffer(capacity);
+        auto first =
+          std::min(this->_input_size, this->_input.size() - this->_input_begin);
+        memcpy(grown.mutable_contents(),
+               this->_input.contents() + this->_input_begin, first);
+        memcpy(grown.mutable_contents() + first,
+               this->_input.contents(), this->_input_size - first);
+        // The region lent to the stream now lies at the start of the ring.
+        if (this->_input_lent)
+        {
+          auto base = reinterpret_cast<char*>(grown.mutable_contents());
+          this->setg(base,
+                     base + (this->gptr() - this->eback()),
+                     base + this->_input_lent);
+        }
+        this->_input = std::move(grown);
+        this->_input_begin = 0;
+      }
+
+      void
+      Request::Impl::_input_resume()
+      {
+        // curl delivers chunks of up to CURL_MAX_WRITE_SIZE bytes and hands
+        // back the refused one whole, only resume once it fits.
+        if (this->_input_paused &&
+            (this->_input_unbounded ||
+             this->_input.size() - this->_input_size >= CURL_MAX_WRITE_SIZE))
+        {
+          ELLE_DEBUG("%s: input: resume", *this->_request);
+          this->_input_paused = false;
+          curl_easy_pause(this->_handle, CURLPAUSE_CONT);
+        }
+      }
+
       size_t
       Request::Impl::write_callback(char* ptr,
                                     size_t chunk,
@@ -468,16 +555,53 @@ namespace elle
       {
         auto& self = *reinterpret_cast<Request::Impl*>(userdata);
         auto size = chunk * count;
-        self.enqueue_data(elle::Buffer(ptr, size));
-        return size;
+        if (self.enqueue_data(elle::ConstWeakBuffer(ptr, size)))
+          return size;
+        else
+          return CURL_WRITEFUNC_PAUSE;
       }
 
-      void
-      Request::Impl::enqueue_data(elle::Buffer buffer)
+      bool
+      Request::Impl::enqueue_data(elle::ConstWeakBuffer data)
       {
-        ELLE_DEBUG_SCOPE("%s: input: got data: %f", *this->_request, buffer);
-        this->_input.push(std::move(buffer));
+        ELLE_DEBUG_SCOPE("%s: input: got data: %f", *this->_request, data);
+        if (this->_input.size() == 0)
+          this->_input = elle::Buffer(
+            std::max<std::size_t>(this->_conf.receive_buffer_size(),
+                                  2 * CURL_MAX_WRITE_SIZE));
+        // Hand data straight to a waiting read_into when nothing precedes it.
+        auto direct = std::size_t(0);
+        if (this->_input_size == 0 &&
+            this->_input_target.mutable_contents() &&
+            this->_input_target_size == 0)
+          direct = std::min(data.size(), this->_input_target.size());
+        auto rest = data.size() - direct;
+        if (rest > this->_input.size() - this->_input_size &&
+            this->_input_unbounded)
+          this->_input_grow(this->_input_size + rest);
+        if (rest > this->_input.size() - this->_input_size)
+        {
+          ELLE_DEBUG("%s: input: buffer full, pause", *this->_request);
+          ++this->_receive_pause_count;
+          this->_input_paused = true;
+          return false;
+        }
+        if (direct)
+        {
+          memcpy(this->_input_target.mutable_contents(), data.contents(),
+                 direct);
+          this->_input_target_size = direct;
+        }
+        auto end = (this->_input_begin + this->_input_size) %
+          this->_input.size();
+        auto first = std::min(rest, this->_input.size() - end);
+        memcpy(this->_input.mutable_contents() + end,
+               data.contents() + direct, first);
+        memcpy(this->_input.mutable_contents(),
+               data.contents() + direct + first, rest - first);
+        this->_input_size += rest;
         this->_input_available.open();
+        return true;
       }
 
       void
@@ -507,6 +631,18 @@ namespace elle
         if (this->_conf.chunked_transfers())
         {
           ELLE_ASSERT_GTE(buffer.size(), this->_output.size());
+          if (!this->_output_available && !this->_output_source.empty())
+          {
+            auto effective =
+              std::min(this->_output_source.size(), buffer.size());
+            memcpy(buffer.mutable_contents(),
+                   this->_output_source.contents(), effective);
+            this->_output_source = this->_output_source.range(effective);
+            if (this->_output_source.empty())
+              this->_output_consumed.signal();
+            ELLE_DEBUG("%s: output: get %s bytes", *this->_request, effective);
+            return effective;
+          }
           if (!this->_output_available)
           {
             if (this->_output_done)
@@ -546,6 +682,80 @@ namespace elle
         }
       }
 
+      /*-----------.
+      | Direct I/O |
+      `-----------*/
+
+      std::size_t
+      Request::Impl::read_into(elle::WeakBuffer destination)
+      {
+        // Serve what the stream interface already holds first.
+        if (this->gptr() < this->egptr())
+        {
+          auto effective = std::min<std::size_t>(
+            this->egptr() - this->gptr(), destination.size());
+          memcpy(destination.mutable_contents(), this->gptr(), effective);
+          this->gbump(effective);
+          return effective;
+        }
+        this->_input_release();
+        while (true)
+        {
+          if (this->_input_size != 0)
+          {
+            auto first = std::min(
+              {this->_input_size,
+               this->_input.size() - this->_input_begin,
+               destination.size()});
+            auto second = std::min(this->_input_size - first,
+                                   destination.size() - first);
+            memcpy(destination.mutable_contents(),
+                   this->_input.contents() + this->_input_begin, first);
+            memcpy(destination.mutable_contents() + first,
+                   this->_input.contents(), second);
+            this->_input_lent = first + second;
+            this->_input_release();
+            return first + second;
+          }
+          if (this->_input_done)
+            return 0;
+          this->_input_target = destination;
+          this->_input_target_size = 0;
+          elle::SafeFinally reset([this] {
+              this->_input_target = elle::WeakBuffer();
+            });
+          ELLE_DEBUG_SCOPE("%s: input: wait for data into %s bytes",
+                           *this->_request, destination.size());
+          this->_input_available.close();
+          this->_input_available.wait();
+          if (this->_input_target_size)
+            return this->_input_target_size;
+        }
+      }
+
+      void
+      Request::Impl::write_from(elle::ConstWeakBuffer source)
+      {
+        ELLE_ASSERT(!this->_output_done);
+        if (!this->_conf.chunked_transfers())
+        {
+          ELLE_DEBUG_SCOPE("%s: output: post data: %f",
+                           *this->_request, source);
+          this->_output.append(source.contents(), source.size());
+          return;
+        }
+        while (this->_output_available)
+          this->_output_consumed.wait();
+        ELLE_DEBUG_SCOPE("%s: output: post data: %f", *this->_request, source);
+        this->_output_source = source;
+        elle::SafeFinally reset([this] {
+            this->_output_source = elle::ConstWeakBuffer();
+          });
+        curl_easy_pause(this->_handle, CURLPAUSE_CONT);
+        while (!this->_output_source.empty())
+          this->_output_consumed.wait();
+      }
+
       /*---------.
       | Progress |
       `---------*/
@@ -759,6 +969,23 @@ namespace elle
         }
         else
           ELLE_TRACE_SCOPE("%s: done with status %s", *this, this->_status);
+        if (auto& statistics = this->_impl->_statistics)
+        {
+          long connections = 0;
+          curl_easy_getinfo(this->_impl->_handle,
+                            CURLINFO_NUM_CONNECTS, &connections);
+          ++statistics->requests;
+          statistics->connections += connections;
+          if (connections == 0 && code == CURLE_OK)
+            ++statistics->reused;
+#if LIBCURL_VERSION_NUM >= 0x073200
+          long version = 0;
+          curl_easy_getinfo(this->_impl->_handle,
+                            CURLINFO_HTTP_VERSION, &version);
+          if (version == CURL_HTTP_VERSION_2_0)
+            ++statistics->http2;
+#endif
+        }
         if (!exception && this->_status == static_cast<StatusCode>(0))
         {
           exception = true;
@@ -780,6 +1007,13 @@ namespace elle
       {
         this->_impl->_debug = 1;
         this->finalize();
+        // Whoever waits for completion may not be reading the body, buffer it
+        // entirely instead of stalling the transfer.
+        if (!this->_impl->_input_unbounded)
+        {
+          this->_impl->_input_unbounded = true;
+          this->_impl->_input_resume();
+        }
         if (this->_impl->_input_done)
         {
           if (std::exception_ptr exn = this->exception())
@@ -853,11 +1087,15 @@ namespace elle
       {
         this->finalize();
         elle::Buffer res;
+        while (true)
         {
-          elle::IOStream output(res.ostreambuf());
-          using IIterator = std::istreambuf_iterator<char>;
-          using OIterator = std::ostreambuf_iterator<char>;
-          std::copy(IIterator(*this), IIterator(), OIterator(output));
+          auto const size = res.size();
+          res.size(size + CURL_MAX_WRITE_SIZE);
+          auto read = this->read_into(elle::WeakBuffer(
+            res.mutable_contents() + size, CURL_MAX_WRITE_SIZE));
+          res.size(size + read);
+          if (!read)
+            break;
         }
         // We ran out of data so the request should be finished; this is just
         // for exceptions.
@@ -871,6 +1109,30 @@ namespace elle
         return this->_impl->_pause_count;
       }
 
+      int
+      Request::receive_pause_count() const
+      {
+        return this->_impl->_receive_pause_count;
+      }
+
+      /*-----------.
+      | Direct I/O |
+      `-----------*/
+
+      std::size_t
+      Request::read_into(elle::WeakBuffer destination)
+      {
+        return this->_impl->read_into(destination);
+      }
+
+      void
+      Request::write_from(elle::ConstWeakBuffer source)
+      {
+        // Keep ordering with data already written through the stream.
+        this->flush();
+        this->_impl->write_from(source);
+      }
+
       /*--------.
       | Cookies |
       `--------*/
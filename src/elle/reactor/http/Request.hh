@@ -141,6 +141,13 @@ namespace elle
           /// The HTTP status to expect. Any different status will throw an
           /// exception upon waiting.
           ELLE_ATTRIBUTE_RW(boost::optional<StatusCode>, expected_status);
+          /// Size of the buffer holding the response body until it is read.
+          ///
+          /// When it is full, the transfer is paused until the consumer reads
+          /// data, bounding memory usage whatever the response size. Once the
+          /// request is waited for, it grows as needed instead. It is never
+          /// less than twice the largest chunk curl delivers.
+          ELLE_ATTRIBUTE_RW(std::size_t, receive_buffer_size);
 
         /*----.
         | SSL |
@@ -262,6 +269,34 @@ namespace elle
         ELLE_ATTRIBUTE_r(StatusCode, status);
         /// How many time the request was paused in wait for output data.
         ELLE_attribute_r(int, pause_count);
+        /// How many time the request was paused because the response buffer
+        /// was full.
+        ELLE_attribute_r(int, receive_pause_count);
+
+      /*-----------.
+      | Direct I/O |
+      `-----------*/
+      public:
+        /// Read response body data directly into a buffer.
+        ///
+        /// Data is copied once, from curl to @a destination, without the
+        /// intermediate copies of the stream interface. If no data is
+        /// available, wait for some. Data already buffered by the stream
+        /// interface is returned first, so both can be mixed.
+        ///
+        /// @param destination Where to store data.
+        /// @return The number of bytes read, 0 at the end of the body.
+        std::size_t
+        read_into(elle::WeakBuffer destination);
+        /// Send request body data directly from a buffer.
+        ///
+        /// With chunked transfers, curl reads straight from @a source and this
+        /// waits until it is entirely consumed. Otherwise the data is appended
+        /// to the stored body.
+        ///
+        /// @param source The data to send.
+        void
+        write_from(elle::ConstWeakBuffer source);
 
       /*--------.
       | Headers |
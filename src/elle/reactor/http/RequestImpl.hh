@@ -1,11 +1,11 @@
 #pragma once
 
-#include <queue>
 #include <string>
 
 #include <elle/Buffer.hh>
 #include <elle/memory.hh>
 #include <elle/reactor/Barrier.hh>
+#include <elle/reactor/http/Client.hh>
 #include <elle/reactor/http/Request.hh>
 #include <elle/reactor/http/fwd.hh>
 #include <elle/reactor/signal.hh>
@@ -75,22 +75,60 @@ namespace elle
         static
         size_t
         write_callback(char* ptr, size_t chunk, size_t count, void* userdata);
-        void
-        enqueue_data(elle::Buffer buffer);
+        /// Store received data in the input ring, or directly in the pending
+        /// read_into destination.
+        ///
+        /// @return Whether the data was accepted, false meaning the transfer
+        ///         must be paused until the consumer makes room.
+        bool
+        enqueue_data(elle::ConstWeakBuffer data);
 
       private:
         void
         _complete();
+        /// Release the region last returned by read_buffer.
+        void
+        _input_release();
+        /// Enlarge and linearize the ring to hold at least @a size bytes.
+        void
+        _input_grow(std::size_t size);
+        /// Resume the transfer if it was paused and the ring has room again.
+        void
+        _input_resume();
         bool _input_done;
-        std::queue<elle::Buffer> _input;
-        elle::Buffer _input_current;
+        /// Fixed size ring holding received data.
+        elle::Buffer _input;
+        /// Offset of the first unread byte in the ring.
+        std::size_t _input_begin;
+        /// Number of unread bytes in the ring.
+        std::size_t _input_size;
+        /// Number of bytes lent to the stream interface by read_buffer.
+        std::size_t _input_lent;
+        /// Destination of a pending read_into, filled directly by curl.
+        elle::WeakBuffer _input_target;
+        std::size_t _input_target_size;
+        bool _input_paused;
+        /// Whether to grow the ring rather than pause, once the request is
+        /// waited for.
+        bool _input_unbounded;
         reactor::Barrier _input_available;
         bool _output_done;
         elle::Buffer _output;
         bool _output_available;
+        /// Caller data being sent by a pending write_from.
+        elle::ConstWeakBuffer _output_source;
         reactor::Signal _output_consumed;
         int _output_offset;
 
+      /*-----------.
+      | Direct I/O |
+      `-----------*/
+      public:
+        std::size_t
+        read_into(elle::WeakBuffer destination);
+        void
+        write_from(elle::ConstWeakBuffer source);
+
       /*--------.
       | Cookies |
       `--------*/
@@ -145,6 +183,9 @@ namespace elle
         CURL* _handle;
         char _error[CURL_ERROR_SIZE];
         ELLE_ATTRIBUTE_R(int, pause_count);
+        ELLE_ATTRIBUTE_R(int, receive_pause_count);
+        /// Connection usage of the Client this request is registered with.
+        std::shared_ptr<Client::Statistics> _statistics;
       /*----------.
       | Printable |
       `----------*/
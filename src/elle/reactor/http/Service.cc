@@ -2,6 +2,7 @@
 
 #include <elle/Exception.hh>
 #include <elle/assert.hh>
+#include <elle/err.hh>
 #include <elle/log.hh>
 #include <elle/reactor/duration.hh>
 #include <elle/reactor/http/RequestImpl.hh>
@@ -77,8 +78,9 @@ namespace elle
                           &socket_callback);
         curl_multi_setopt(this->_curl,
                           CURLMOPT_TIMERFUNCTION, &Service::timeout_callback);
-        // Pipelining causes issues with S3, requests end up being stuck.
-        // curl_multi_setopt(this->_curl, CURLMOPT_PIPELINING, 1L);
+        // HTTP/1.1 pipelining causes issues with S3, requests end up being
+        // stuck. Only multiplex requests on HTTP/2 connections.
+        curl_multi_setopt(this->_curl, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
       }
 
       Service::~Service()
@@ -94,6 +96,17 @@ namespace elle
         assert(res == CURLM_OK);
       }
 
+      void
+      Service::max_host_connections(long count)
+      {
+        ELLE_TRACE_SCOPE("%s: limit connections per host to %s", *this, count);
+        auto res = curl_multi_setopt(
+          this->_curl, CURLMOPT_MAX_HOST_CONNECTIONS, count);
+        if (res != CURLM_OK)
+          elle::err("%s: unable to limit connections per host: %s",
+                    *this, curl_multi_strerror(res));
+      }
+
       /*--------.
       | Request |
       `--------*/
@@ -24,6 +24,11 @@ namespace elle
         virtual
         void
         shutdown_service();
+        /// Limit the number of simultaneous connections to a single host.
+        ///
+        /// @param count The maximum number of connections, 0 for no limit.
+        void
+        max_host_connections(long count);
       private:
         friend class Client;
         friend class Request::Impl;
@@ -1,4 +1,5 @@
 #include <elle/assert.hh>
+#include <elle/finally.hh>
 #include <elle/reactor/lockable.hh>
 #include <elle/reactor/scheduler.hh>
 #include <elle/reactor/Thread.hh>
@@ -7,17 +8,53 @@ namespace elle
 {
   namespace reactor
   {
-    Lock::Lock(Lockable& lockable)
-      : _lockable(lockable)
+    /*---------.
+    | Lockable |
+    `---------*/
+
+    bool
+    Lockable::try_lock_for(Duration timeout)
+    {
+      return this->_lock(timeout);
+    }
+
+    void
+    Lockable::_abandon(Thread*)
+    {}
+
+    bool
+    Lockable::_lock(DurationOpt timeout)
     {
       auto sched = reactor::Scheduler::scheduler();
       ELLE_ASSERT(sched);
       auto current = sched->current();
       ELLE_ASSERT(current);
-      while (!_lockable.acquire())
+      auto const deadline = Clock::now() + timeout.value_or(Duration(0));
+      elle::SafeFinally abandon([&] { this->_abandon(current); });
+      while (!this->acquire())
       {
-        current->wait(_lockable);
+        auto remaining = DurationOpt{};
+        if (timeout)
+        {
+          remaining = deadline - Clock::now();
+          if (*remaining <= Duration(0))
+            return false;
+        }
+        if (!current->wait(*this, remaining))
+          return false;
       }
+      abandon.abort();
+      return true;
+    }
+
+    /*-----.
+    | Lock |
+    `-----*/
+
+    Lock::Lock(Lockable& lockable)
+      : _lockable(lockable)
+    {
+      this->_lockable._lock({});
     }
 
     Lock::~Lock()
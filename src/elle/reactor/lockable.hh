@@ -32,6 +32,31 @@ namespace elle
       virtual
       bool
       release() = 0;
+      /// Acquire the lock, waiting at most \a timeout.
+      ///
+      /// \param timeout The maximum delay to wait for the lock.
+      /// \returns Whether the lock was acquired, in which case it must be
+      ///          released.
+      bool
+      try_lock_for(Duration timeout);
+
+    protected:
+      /// Forget about a Thread that gave up acquiring the lock.
+      ///
+      /// Called when waiting for the lock timed out or threw, so that
+      /// Lockables can drop whatever they kept for the Thread. Does
+      /// nothing by default.
+      ///
+      /// \param thread The Thread that gave up.
+      virtual
+      void
+      _abandon(Thread* thread);
+
+    private:
+      friend class Lock;
+      /// Acquire the lock, waiting at most \a timeout if set.
+      bool
+      _lock(DurationOpt timeout);
     };
 
     /// Lock is designed to manage Lockable automatically via RAII.
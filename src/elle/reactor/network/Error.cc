@@ -11,6 +11,10 @@ namespace elle
         Super(message)
       {}
 
+      Error::Error(elle::Backtrace bt, std::string const& message)
+        : Super(std::move(bt), message)
+      {}
+
       SocketClosed::SocketClosed()
         : Super("socket was closed")
       {}
@@ -28,11 +32,13 @@ namespace elle
       {}
 
       ConnectionClosed::ConnectionClosed()
-        : Super("connection closed")
+        : Super(elle::Backtrace::capture(typeid(ConnectionClosed), 1),
+                "connection closed")
       {}
 
       ConnectionClosed::ConnectionClosed(std::string const& message)
-        : Super(elle::sprintf("connection closed: %s", message))
+        : Super(elle::Backtrace::capture(typeid(ConnectionClosed), 1),
+                elle::sprintf("connection closed: %s", message))
       {}
 
       SSLShortRead::SSLShortRead()
@@ -54,7 +60,8 @@ namespace elle
       {}
 
       TimeOut::TimeOut():
-        Super("network operation timed out")
+        Super(elle::Backtrace::capture(typeid(TimeOut), 1),
+              "network operation timed out")
       {}
     }
   }
@@ -16,6 +16,7 @@ namespace elle
       public:
         using Super = elle::Error;
         Error(std::string const& message);
+        Error(elle::Backtrace bt, std::string const& message);
       };
 
       using Exception [[deprecated("use elle::reactor::Error instead")]]
@@ -5,6 +5,7 @@
 #include <elle/os/environ.hh>
 #include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/http-server.hh>
+#include <elle/reactor/network/ssl-server.hh>
 
 ELLE_LOG_COMPONENT("elle.reactor.network.http");
 
@@ -32,6 +33,8 @@ namespace elle
       HttpServer::HttpServer(std::unique_ptr<Server> server)
         : _server(std::move(server))
         , _port(0)
+        , _scheme("http")
+        , _keep_alive(false)
         , _accepter()
       {
         if (!this->_server)
@@ -42,6 +45,12 @@ namespace elle
           this->_server = std::move(server);
           ELLE_TRACE_SCOPE("%s: listen on port %s", *this, this->_port);
         }
+        else if (auto ssl = dynamic_cast<SSLServer*>(this->_server.get()))
+        {
+          this->_port = ssl->port();
+          this->_scheme = "https";
+          ELLE_TRACE_SCOPE("%s: serve HTTPS on port %s", *this, this->_port);
+        }
         this->_accepter.reset(
           new reactor::Thread(*reactor::Scheduler::scheduler(),
                               "accepter",
@@ -49,6 +58,8 @@ namespace elle
       }
 
       HttpServer::HttpServer(int port)
+        : _scheme("http")
+        , _keep_alive(false)
       {
         auto server = std::make_unique<TCPServer>();
         server->listen(port);
@@ -76,7 +87,8 @@ namespace elle
       std::string
       HttpServer::url(std::string const& path)
       {
-        return elle::sprintf("http://127.0.0.1:%s/%s", this->port(), path);
+        return elle::sprintf("%s://127.0.0.1:%s/%s",
+                             this->_scheme, this->port(), path);
       }
 
       HttpServer::CommandLine::CommandLine(elle::Buffer const& buffer)
@@ -184,29 +196,41 @@ namespace elle
 
       void
       HttpServer::_serve(std::unique_ptr<reactor::network::Socket> socket)
+      {
+        // With keep-alive, serve requests until the client hangs up or a
+        // request can't be told apart from the next one.
+        while (this->_serve_request(*socket) && this->_keep_alive)
+          ;
+        ELLE_TRACE("%s: close connection with %s", *this, socket);
+      }
+
+      bool
+      HttpServer::_serve_request(reactor::network::Socket& socket)
       {
         auto headers = this->_headers;
         auto cookies = Cookies{};
+        // Whether the whole request was read, leaving the connection ready
+        // for the next one.
+        auto complete = false;
+        auto request = elle::Buffer();
+        try
+        {
+          request = socket.read_until("\r\n");
+        }
+        catch (reactor::network::ConnectionClosed const&)
+        {
+          // Keep-alive clients hang up between requests, nothing to answer.
+          ELLE_TRACE("%s: connection closed by %s", *this, socket);
+          return false;
+        }
         try
         {
-          CommandLine cmd(socket->read_until("\r\n"));
+          CommandLine cmd(request);
           ELLE_LOG_SCOPE("%s: handle request from %s: %s",
                          *this, socket, cmd);
-          auto route = this->_routes.find(cmd.path());
-          if (route == this->_routes.end())
-          {
-            ELLE_TRACE("%s: not found", *this);
-            throw Exception(cmd.path(), reactor::http::StatusCode::Not_Found);
-          }
-          if (route->second.find(cmd.method()) == route->second.end())
-          {
-            ELLE_TRACE("%s: method not allowed", *this);
-            throw Exception(cmd.path(),
-                            reactor::http::StatusCode::Method_Not_Allowed);
-          }
           while (true)
           {
-            auto buffer = socket->read_until("\r\n");
+            auto buffer = socket.read_until("\r\n");
             if (buffer == "\r\n")
               break;
             buffer.size(buffer.size() - 2);
@@ -258,24 +282,43 @@ namespace elle
 
           ELLE_TRACE("%s: cookies: %s", *this, cookies);
           ELLE_TRACE("%s: parameters: %s", *this, cmd.params());
+          auto const route = this->_routes.find(cmd.path());
+          auto const routed = [&]
+            {
+              if (route == this->_routes.end())
+              {
+                ELLE_TRACE("%s: not found", *this);
+                throw Exception(cmd.path(),
+                                reactor::http::StatusCode::Not_Found);
+              }
+              if (route->second.find(cmd.method()) == route->second.end())
+              {
+                ELLE_TRACE("%s: method not allowed", *this);
+                throw Exception(cmd.path(),
+                                reactor::http::StatusCode::Method_Not_Allowed);
+              }
+            };
+          auto const expect = headers.find("Expect") != headers.end();
+          // Don't ask for a body only to refuse it.
+          if (expect)
+            routed();
           elle::Buffer content;
-          if (cmd.version() == http::Version::v11 &&
-              headers.find("Expect") != headers.end())
+          if (cmd.version() == http::Version::v11 && expect)
           {
             ELLE_TRACE("%s: send Continue header", *this)
             {
               std::string answer(
                 "HTTP/1.1 100 Continue\r\n"
                 "\r\n");
-              socket->write(elle::ConstWeakBuffer(answer));
+              socket.write(elle::ConstWeakBuffer(answer));
             }
           }
           if (headers.find("chunked") != headers.end())
             ELLE_TRACE("%s: read chunked content", *this)
               while (true)
               {
-                socket->read_until("\r\n"); // Ignore the chunked header.
-                auto buffer = socket->read_until("\r\n");
+                socket.read_until("\r\n"); // Ignore the chunked header.
+                auto buffer = socket.read_until("\r\n");
                 if (buffer == "\r\n")
                   break;
                 ELLE_DEBUG("%s: got content chunk from %s: %s",
@@ -287,9 +330,11 @@ namespace elle
             auto content_length =
               boost::lexical_cast<unsigned int>(headers.at("Content-Length"));
             ELLE_TRACE("%s: read sized content", *this)
-              content = this->read_sized_content(*socket, content_length);
+              content = this->read_sized_content(socket, content_length);
           }
+          complete = true;
           ELLE_DUMP("%s: content: %s", *this, content);
+          routed();
           // Check JSON is valid. When getting meta_data on S3, we send a JSON
           // mimetype but an empty body, skip this case (and fix it later
           // cautiously).
@@ -309,7 +354,7 @@ namespace elle
             }
           }
           this->_response(
-            *socket,
+            socket,
             http::StatusCode::OK,
             route->second.at(cmd.method())
               (headers, cookies, cmd.params(), content),
@@ -318,17 +363,17 @@ namespace elle
         catch (Exception const& e)
         {
           ELLE_WARN("%s: http exception: %s", *this, e.what());
-          this->_response(*socket, e.code(),
+          this->_response(socket, e.code(),
                           this->is_json(headers) ? e.body() : e.what(), cookies);
         }
         catch (elle::Exception const& e)
         {
           ELLE_WARN("%s: internal error: %s", *this, e.what());
-          this->_response(*socket,
+          this->_response(socket,
                           reactor::http::StatusCode::Internal_Server_Error,
                           e.what(), cookies);
         }
-        ELLE_TRACE("%s: close connection with %s", *this, socket);
+        return complete;
       }
 
       void
@@ -362,7 +407,7 @@ namespace elle
             "Server: Custom HTTP of doom\r\n",
             (int) code, code);
           headers["Content-Length"] = std::to_string(response.size());
-          headers["Connection"] = "close";
+          headers["Connection"] = this->_keep_alive ? "keep-alive" : "close";
           for (auto const& value: headers)
             answer += elle::sprintf("%s: %s\r\n", value.first, value.second);
           answer += "\r\n" + response;
@@ -91,6 +91,11 @@ namespace elle
         };
 
       public:
+        /// Create an HTTPServer.
+        ///
+        /// \param server The listening server to accept clients from. If it
+        ///               is an SSLServer, HTTPS is served. By default, listen
+        ///               on a random TCP port.
         HttpServer(std::unique_ptr<Server> server = {});
         /// Create an HTTPServer to listen on a specific port.
         ///
@@ -146,6 +151,10 @@ namespace elle
         ELLE_ATTRIBUTE_X(Routes, routes);
         ELLE_ATTRIBUTE(std::unique_ptr<reactor::network::Server>, server);
         ELLE_ATTRIBUTE_R(int, port);
+        /// The URL scheme, "http" or "https".
+        ELLE_ATTRIBUTE_R(std::string, scheme);
+        /// Whether to keep connections open to serve subsequent requests.
+        ELLE_ATTRIBUTE_RW(bool, keep_alive);
         ELLE_ATTRIBUTE(std::unique_ptr<reactor::Thread>, accepter);
         ELLE_ATTRIBUTE_RW(std::function<void (std::string const&)>,
                           check_version);
@@ -182,6 +191,12 @@ namespace elle
         virtual
         void
         _serve(std::unique_ptr<reactor::network::Socket> socket);
+        /// Serve one request.
+        ///
+        /// @returns Whether the request was read entirely, even if it was
+        ///          refused, so the connection may serve another one.
+        bool
+        _serve_request(reactor::network::Socket& socket);
       public:
         /// Register a function to a pair (route / method).
         ///
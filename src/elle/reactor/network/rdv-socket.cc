@@ -18,7 +18,8 @@ namespace elle
       using Endpoint = boost::asio::ip::udp::endpoint;
 
       RDVSocket::RDVSocket()
-        : _server_reached(elle::sprintf("%s: server reached", *this))
+        : _encoding(rdv::Encoding::json)
+        , _server_reached(elle::sprintf("%s: server reached", *this))
         , _breacher("breacher", [this] { this->_loop_breach(); })
         , _keep_alive("keep-alive", [this]  { this->_loop_keep_alive(); })
         , _tasks(elle::sprintf("%s tasks barrier", this))
@@ -56,7 +57,7 @@ namespace elle
         rdv::Message req;
         req.command = rdv::Command::ping;
         req.id = id;
-        elle::Buffer buf = elle::serialization::json::serialize(req, false);
+        auto const buf = rdv::pack(req, this->_encoding);
         auto now = Clock::now();
         while (true)
         {
@@ -101,11 +102,11 @@ namespace elle
             it->second(elle::WeakBuffer(buffer.mutable_contents(), sz),
                        endpoint);
           }
-          else if (magic == rdv::rdv_magic)
+          else if (magic == rdv::rdv_magic || magic == rdv::rdv_binary_magic)
           {
-            rdv::Message repl =
-              elle::serialization::json::deserialize<rdv::Message>(
-                elle::Buffer(buffer.contents() + 8, sz - 8), false);
+            auto encoding = rdv::Encoding::json;
+            rdv::Message repl = rdv::unpack(
+              elle::ConstWeakBuffer(buffer.contents(), sz), &encoding);
             if (set_endpoint && repl.source_endpoint)
             {
               this->_public_endpoint = *repl.source_endpoint;
@@ -121,9 +122,8 @@ namespace elle
                 reply.command = rdv::Command::pong;
                 reply.source_endpoint = endpoint;
                 reply.target_address = repl.target_address;
-                elle::Buffer buf = elle::serialization::json::serialize(reply,
-                                                                        false);
-                this->_send_with_magik(buf, endpoint);
+                auto const buf = rdv::pack(reply, encoding);
+                this->_send_to_failsafe(buf, endpoint);
               }
               break;
             case rdv::Command::pong:
@@ -254,7 +254,7 @@ namespace elle
               req.command = rdv::Command::connect;
               req.id = this->_id;
               req.target_address = id;
-              auto buf = elle::serialization::json::serialize(req, false);
+              auto const buf = rdv::pack(req, this->_encoding);
               this->_send_to_failsafe(buf, _server);
             }
           }
@@ -274,17 +274,6 @@ namespace elle
         }
       }
 
-      void
-      RDVSocket::_send_with_magik(elle::Buffer const& b, Endpoint peer)
-      {
-        elle::Buffer data;
-        data.append(reactor::network::rdv::rdv_magic, 8);
-        data.append(b.contents(), b.size());
-        this->_send_to_failsafe(
-          elle::ConstWeakBuffer(data.contents(), data.size()),
-          peer);
-      }
-
       void
       RDVSocket::_send_ping(Endpoint target, std::string const& tid)
       {
@@ -294,8 +283,8 @@ namespace elle
         ping.id = this->_id;
         ping.source_endpoint = target;
         ping.target_address = tid;
-        elle::Buffer buf = elle::serialization::json::serialize(ping, false);
-        this->_send_with_magik(buf, target);
+        auto const buf = rdv::pack(ping, this->_encoding);
+        this->_send_to_failsafe(buf, target);
       }
 
       void
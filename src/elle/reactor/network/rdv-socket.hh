@@ -1,5 +1,6 @@
 #pragma once
 
+#include <elle/reactor/network/rdv.hh>
 #include <elle/reactor/network/udp-socket.hh>
 #include <elle/reactor/Barrier.hh>
 #include <elle/reactor/MultiLockBarrier.hh>
@@ -87,6 +88,9 @@ namespace elle
         void
         unregister_reader(std::string const& magic);
         ELLE_ATTRIBUTE_R(Endpoint, public_endpoint);
+        /// Encoding of the messages we send. Peers and the RDV server answer
+        /// in the encoding we use.
+        ELLE_ATTRIBUTE_RW(rdv::Encoding, encoding);
 
       private:
         void
@@ -97,8 +101,6 @@ namespace elle
         _loop_breach();
         void
         _loop_keep_alive();
-        void
-        _send_with_magik(elle::Buffer const& buf, Endpoint target);
         ELLE_ATTRIBUTE(std::string, id);
         ELLE_ATTRIBUTE(Endpoint, server);
         ELLE_ATTRIBUTE(Endpoint, self);
@@ -0,0 +1,237 @@
+#include <array>
+#include <cstring>
+
+#include <elle/err.hh>
+#include <elle/reactor/network/rdv.hh>
+
+namespace elle
+{
+  namespace reactor
+  {
+    namespace network
+    {
+      namespace rdv
+      {
+        /*-------.
+        | Binary |
+        `-------*/
+
+        // Layout, integers in network order:
+        //
+        //   magic     8 bytes
+        //   version   1 byte
+        //   command   1 byte
+        //   flags     1 byte, which optional fields follow
+        //   id        2 bytes size, bytes
+        //   source    endpoint, if flags & source_flag
+        //   target    endpoint, if flags & target_flag
+        //   address   2 bytes size, bytes, if flags & address_flag
+        //
+        // Endpoints are a 1 byte address size (4 or 16), the address bytes
+        // and a 2 bytes port.
+
+        namespace
+        {
+          auto constexpr binary_version = 1;
+          auto constexpr source_flag = 0x1;
+          auto constexpr target_flag = 0x2;
+          auto constexpr address_flag = 0x4;
+
+          void
+          put_size(elle::Buffer& output, std::size_t size)
+          {
+            if (size > 0xffff)
+              elle::err("rdv string too long: %s bytes", size);
+            output.append(
+              std::array<unsigned char, 2>{{
+                  static_cast<unsigned char>(size >> 8),
+                  static_cast<unsigned char>(size & 0xff)}}.data(),
+              2);
+          }
+
+          void
+          put_string(elle::Buffer& output, std::string const& s)
+          {
+            put_size(output, s.size());
+            output.append(s.data(), s.size());
+          }
+
+          void
+          put_endpoint(elle::Buffer& output, Endpoint const& ep)
+          {
+            if (ep.address().is_v4())
+            {
+              auto const addr = ep.address().to_v4().to_bytes();
+              output.append(std::array<unsigned char, 1>{{4}}.data(), 1);
+              output.append(addr.data(), addr.size());
+            }
+            else
+            {
+              auto const addr = ep.address().to_v6().to_bytes();
+              output.append(std::array<unsigned char, 1>{{16}}.data(), 1);
+              output.append(addr.data(), addr.size());
+            }
+            put_size(output, ep.port());
+          }
+
+          class Reader
+          {
+          public:
+            Reader(elle::ConstWeakBuffer data)
+              : _data(data)
+              , _offset(0)
+            {}
+
+            unsigned char const*
+            take(std::size_t size)
+            {
+              if (this->_data.size() - this->_offset < size)
+                elle::err("truncated rdv message");
+              auto const res = this->_data.contents() + this->_offset;
+              this->_offset += size;
+              return res;
+            }
+
+            int
+            byte()
+            {
+              return *this->take(1);
+            }
+
+            int
+            size()
+            {
+              auto const b = this->take(2);
+              return (b[0] << 8) | b[1];
+            }
+
+            std::string
+            string()
+            {
+              auto const size = this->size();
+              auto const b = this->take(size);
+              return std::string(b, b + size);
+            }
+
+            Endpoint
+            endpoint()
+            {
+              auto const size = this->byte();
+              if (size == 4)
+              {
+                auto bytes = boost::asio::ip::address_v4::bytes_type{};
+                std::memcpy(bytes.data(), this->take(4), 4);
+                auto const addr = boost::asio::ip::address_v4(bytes);
+                return Endpoint(addr, this->size());
+              }
+              else if (size == 16)
+              {
+                auto bytes = boost::asio::ip::address_v6::bytes_type{};
+                std::memcpy(bytes.data(), this->take(16), 16);
+                auto const addr = boost::asio::ip::address_v6(bytes);
+                return Endpoint(addr, this->size());
+              }
+              else
+                elle::err("invalid rdv endpoint address size: %s", size);
+            }
+
+          private:
+            elle::ConstWeakBuffer _data;
+            std::size_t _offset;
+          };
+        }
+
+        static
+        elle::Buffer
+        pack_binary(Message const& message)
+        {
+          auto res = elle::Buffer{};
+          // Room for a connect_requested with two IPv6 endpoints and
+          // uuid identifiers.
+          res.capacity(128);
+          res.append(rdv_binary_magic, 8);
+          auto const flags =
+            (message.source_endpoint ? source_flag : 0) |
+            (message.target_endpoint ? target_flag : 0) |
+            (message.target_address ? address_flag : 0);
+          res.append(
+            std::array<unsigned char, 3>{{
+                binary_version,
+                static_cast<unsigned char>(message.command),
+                static_cast<unsigned char>(flags)}}.data(),
+            3);
+          put_string(res, message.id);
+          if (message.source_endpoint)
+            put_endpoint(res, *message.source_endpoint);
+          if (message.target_endpoint)
+            put_endpoint(res, *message.target_endpoint);
+          if (message.target_address)
+            put_string(res, *message.target_address);
+          return res;
+        }
+
+        static
+        Message
+        unpack_binary(elle::ConstWeakBuffer data)
+        {
+          auto r = Reader(data);
+          auto const version = r.byte();
+          if (version != binary_version)
+            elle::err("unsupported rdv binary version: %s", version);
+          auto const command = r.byte();
+          if (command > static_cast<int>(Command::error))
+            elle::err("invalid rdv command: %s", command);
+          auto const flags = r.byte();
+          auto res = Message{};
+          res.command = static_cast<Command>(command);
+          res.id = r.string();
+          if (flags & source_flag)
+            res.source_endpoint = r.endpoint();
+          if (flags & target_flag)
+            res.target_endpoint = r.endpoint();
+          if (flags & address_flag)
+            res.target_address = r.string();
+          return res;
+        }
+
+        /*----------.
+        | Interface |
+        `----------*/
+
+        elle::Buffer
+        pack(Message const& message, Encoding encoding)
+        {
+          if (encoding == Encoding::binary)
+            return pack_binary(message);
+          auto res = elle::Buffer(rdv_magic, 8);
+          auto const payload =
+            elle::serialization::json::serialize(message, false);
+          res.append(payload.contents(), payload.size());
+          return res;
+        }
+
+        Message
+        unpack(elle::ConstWeakBuffer data, Encoding* encoding)
+        {
+          auto const magic = [&] (char const* magic)
+            {
+              return data.size() >= 8 &&
+                std::memcmp(data.contents(), magic, 8) == 0;
+            };
+          if (magic(rdv_binary_magic))
+          {
+            if (encoding)
+              *encoding = Encoding::binary;
+            return unpack_binary(data.range(8));
+          }
+          if (encoding)
+            *encoding = Encoding::json;
+          if (magic(rdv_magic))
+            data = data.range(8);
+          return elle::serialization::json::deserialize<Message>(
+            elle::Buffer(data.contents(), data.size()), false);
+        }
+      }
+    }
+  }
+}
@@ -1,4 +1,8 @@
+#pragma once
+
 #include <boost/optional.hpp>
+
+#include <elle/Buffer.hh>
 #include <elle/reactor/asio.hh>
 
 #include <elle/serialization/json.hh>
@@ -14,6 +18,8 @@ namespace elle
         using Endpoint = boost::asio::ip::udp::endpoint;
 
         constexpr char const* rdv_magic = "RDVMAGIK"; // 8 bytes
+        /// Magic of binary encoded messages.
+        constexpr char const* rdv_binary_magic = "RDVBINRY"; // 8 bytes
 
         enum class Command
         {
@@ -47,6 +53,27 @@ namespace elle
           boost::optional<std::string>  target_address;
           using serialization_tag = elle::serialization_tag;
         };
+
+        /// How a Message is encoded on the wire.
+        ///
+        /// Messages are JSON unless they start with rdv_binary_magic. Peers
+        /// are answered in the encoding they used.
+        enum class Encoding
+        {
+          json,
+          binary,
+        };
+
+        /// Encode a Message, prefixed by the magic of the encoding.
+        elle::Buffer
+        pack(Message const& message, Encoding encoding);
+        /// Decode a Message, with or without magic.
+        ///
+        /// \param data The datagram.
+        /// \param encoding If not null, set to the encoding of the datagram.
+        /// \throw elle::Error if the datagram is malformed.
+        Message
+        unpack(elle::ConstWeakBuffer data, Encoding* encoding = nullptr);
       }
     }
   }
@@ -27,6 +27,9 @@ namespace elle
         , _handshake_thread(elle::sprintf("%s handshake", *this),
                             [this] { this->_handshake(); })
         , _shutdown_asynchronous(false)
+        , _background_handshake(false)
+        , _handshakes(0)
+        , _resumed_handshakes(0)
       {}
 
       SSLServer::~SSLServer()
@@ -84,7 +87,11 @@ namespace elle
                 ELLE_TRACE_SCOPE("%s: handshake %s", *this, *socket.value);
                 try
                 {
-                  socket->_server_handshake(this->_handshake_timeout);
+                  socket->_server_handshake(this->_handshake_timeout,
+                                            this->_background_handshake);
+                  ++this->_handshakes;
+                  if (socket->session_reused())
+                    ++this->_resumed_handshakes;
                   this->_sockets.put(socket);
                 }
                 catch (reactor::network::TimeOut const&)
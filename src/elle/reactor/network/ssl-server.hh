@@ -109,6 +109,14 @@ namespace elle
         ELLE_ATTRIBUTE(reactor::Channel<std::unique_ptr<SSLSocket>>, sockets);
         ELLE_ATTRIBUTE(reactor::Thread, handshake_thread);
         ELLE_ATTRIBUTE_RW(bool, shutdown_asynchronous);
+        /// Whether to compute handshakes on the scheduler background pool, so
+        /// their public key operations do not stall the reactor thread. The
+        /// socket I/O remains on the reactor thread.
+        ELLE_ATTRIBUTE_RW(bool, background_handshake);
+        /// Number of successful handshakes.
+        ELLE_ATTRIBUTE_R(int, handshakes);
+        /// Number of successful handshakes that resumed a session.
+        ELLE_ATTRIBUTE_R(int, resumed_handshakes);
       };
     }
   }
@@ -1,3 +1,12 @@
+#include <algorithm>
+#include <chrono>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include <elle/finally.hh>
 #include <elle/log.hh>
 #include <elle/reactor/network/SocketOperation.hh>
 #include <elle/reactor/network/Error.hh>
@@ -17,6 +26,7 @@ namespace elle
     {
       SSLCertificate::SSLCertificate(SSLCertificateMethod meth)
         : _context(meth)
+        , _client_sessions_size(0)
       {
         this->_context.set_options(boost::asio::ssl::verify_none);
       }
@@ -26,6 +36,7 @@ namespace elle
                                      std::vector<char> const& dh,
                                      SSLCertificateMethod meth)
         : _context(meth)
+        , _client_sessions_size(0)
       {
         using boost::asio::const_buffer;
         this->_context.set_options(boost::asio::ssl::verify_none);
@@ -42,6 +53,7 @@ namespace elle
                                      std::string const& dhfile,
                                      SSLCertificateMethod meth)
         : _context(meth)
+        , _client_sessions_size(0)
       {
         this->_context.set_options(boost::asio::ssl::verify_none);
         this->_context.use_certificate_file(certificate,
@@ -51,6 +63,181 @@ namespace elle
         this->_context.use_tmp_dh_file(dhfile);
       }
 
+      /*-------------------.
+      | Session resumption |
+      `-------------------*/
+
+      namespace
+      {
+        /// Number of ticket keys still accepted after a rotation.
+        auto const ticket_keys_history = 2;
+
+        int
+        certificate_index()
+        {
+          static auto const res =
+            SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+          return res;
+        }
+
+        void
+        random_fill(unsigned char* data, int size)
+        {
+          if (RAND_bytes(data, size) != 1)
+            elle::err<SSLHandshakeError>("unable to generate random bytes");
+        }
+      }
+
+      void
+      SSLCertificate::_attach()
+      {
+        SSL_CTX_set_ex_data(
+          this->_context.native_handle(), certificate_index(), this);
+      }
+
+      void
+      SSLCertificate::session_cache(std::size_t size, Duration timeout)
+      {
+        ELLE_TRACE_SCOPE("%s: enable session cache of %s entries for %s",
+                         this, size, timeout);
+        auto ctx = this->_context.native_handle();
+        // The session id context is mandatory for a server to resume
+        // sessions. Scope it to this certificate.
+        SSL_CTX_set_session_id_context(
+          ctx,
+          reinterpret_cast<unsigned char const*>(&ctx),
+          sizeof ctx);
+        SSL_CTX_set_session_cache_mode(
+          ctx, SSL_CTX_get_session_cache_mode(ctx) | SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(ctx, size);
+        SSL_CTX_set_timeout(
+          ctx,
+          std::chrono::duration_cast<std::chrono::seconds>(timeout).count());
+      }
+
+      void
+      SSLCertificate::session_tickets()
+      {
+        ELLE_TRACE_SCOPE("%s: enable session tickets", this);
+        this->_attach();
+        this->rotate_session_ticket_key();
+        auto ctx = this->_context.native_handle();
+        SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+        SSL_CTX_set_tlsext_ticket_key_cb(
+          ctx, &SSLCertificate::_ticket_key_callback);
+      }
+
+      void
+      SSLCertificate::rotate_session_ticket_key()
+      {
+        ELLE_TRACE_SCOPE("%s: rotate session ticket key", this);
+        auto key = TicketKey{};
+        random_fill(key.name, sizeof key.name);
+        random_fill(key.aes, sizeof key.aes);
+        random_fill(key.hmac, sizeof key.hmac);
+        std::lock_guard<std::mutex> lock(this->_ticket_keys_mutex);
+        this->_ticket_keys.emplace_front(key);
+        while (this->_ticket_keys.size() > 1 + ticket_keys_history)
+          this->_ticket_keys.pop_back();
+      }
+
+      int
+      SSLCertificate::_ticket_key_callback(SSL* ssl,
+                                           unsigned char* name,
+                                           unsigned char* iv,
+                                           EVP_CIPHER_CTX* cipher,
+                                           HMAC_CTX* hmac,
+                                           int encrypt)
+      {
+        auto self = static_cast<SSLCertificate*>(
+          SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), certificate_index()));
+        if (!self)
+          return -1;
+        std::lock_guard<std::mutex> lock(self->_ticket_keys_mutex);
+        if (self->_ticket_keys.empty())
+          return -1;
+        if (encrypt)
+        {
+          auto const& key = self->_ticket_keys.front();
+          if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1)
+            return -1;
+          std::memcpy(name, key.name, sizeof key.name);
+          EVP_EncryptInit_ex(cipher, EVP_aes_128_cbc(), nullptr, key.aes, iv);
+          HMAC_Init_ex(hmac, key.hmac, sizeof key.hmac, EVP_sha256(), nullptr);
+          return 1;
+        }
+        auto it = std::find_if(
+          self->_ticket_keys.begin(), self->_ticket_keys.end(),
+          [&] (TicketKey const& key)
+          {
+            return std::memcmp(key.name, name, sizeof key.name) == 0;
+          });
+        // Unknown key: fall back to a full handshake.
+        if (it == self->_ticket_keys.end())
+          return 0;
+        HMAC_Init_ex(hmac, it->hmac, sizeof it->hmac, EVP_sha256(), nullptr);
+        EVP_DecryptInit_ex(cipher, EVP_aes_128_cbc(), nullptr, it->aes, iv);
+        // Ask for a renewed ticket if it was issued under a previous key.
+        return it == self->_ticket_keys.begin() ? 1 : 2;
+      }
+
+      void
+      SSLCertificate::client_session_cache(std::size_t size)
+      {
+        ELLE_TRACE_SCOPE("%s: enable client session cache of %s entries",
+                         this, size);
+        this->_client_sessions_size = size;
+        while (this->_client_sessions.size() > size)
+        {
+          this->_client_sessions_index.erase(
+            this->_client_sessions.back().first);
+          this->_client_sessions.pop_back();
+        }
+        // Keep server side resumption, if enabled on the same context.
+        auto ctx = this->_context.native_handle();
+        SSL_CTX_set_session_cache_mode(
+          ctx, SSL_CTX_get_session_cache_mode(ctx) | SSL_SESS_CACHE_CLIENT);
+      }
+
+      SSL_SESSION*
+      SSLCertificate::_client_session(std::string const& endpoint)
+      {
+        auto it = this->_client_sessions_index.find(endpoint);
+        if (it == this->_client_sessions_index.end())
+          return nullptr;
+        this->_client_sessions.splice(this->_client_sessions.begin(),
+                                      this->_client_sessions,
+                                      it->second);
+        return it->second->second.get();
+      }
+
+      void
+      SSLCertificate::_client_session(std::string const& endpoint,
+                                      SSL_SESSION* session)
+      {
+        if (!this->_client_sessions_size || !session)
+          return;
+        auto owned = std::shared_ptr<SSL_SESSION>(session, &SSL_SESSION_free);
+        auto it = this->_client_sessions_index.find(endpoint);
+        if (it != this->_client_sessions_index.end())
+        {
+          it->second->second = std::move(owned);
+          this->_client_sessions.splice(this->_client_sessions.begin(),
+                                        this->_client_sessions,
+                                        it->second);
+          return;
+        }
+        this->_client_sessions.emplace_front(endpoint, std::move(owned));
+        this->_client_sessions_index.emplace(
+          endpoint, this->_client_sessions.begin());
+        if (this->_client_sessions.size() > this->_client_sessions_size)
+        {
+          this->_client_sessions_index.erase(
+            this->_client_sessions.back().first);
+          this->_client_sessions.pop_back();
+        }
+      }
+
       SSLCertificateOwner::SSLCertificateOwner(
         std::shared_ptr<SSLCertificate> certificate)
         : _certificate(std::move(certificate))
@@ -79,6 +266,29 @@ namespace elle
         this->_client_handshake();
       }
 
+      SSLSocket::SSLSocket(const std::string& hostname,
+                           const std::string& port,
+                           std::shared_ptr<SSLCertificate> certificate,
+                           DurationOpt timeout)
+        : SSLSocket(resolve_tcp(hostname, port)[0],
+                    std::move(certificate),
+                    timeout)
+      {}
+
+      SSLSocket::SSLSocket(boost::asio::ip::tcp::endpoint const& endpoint,
+                           std::shared_ptr<SSLCertificate> certificate,
+                           DurationOpt timeout)
+        : SSLCertificateOwner(std::move(certificate))
+        , Super(std::make_unique<SSLStream>(
+                  reactor::Scheduler::scheduler()->io_service(),
+                  this->certificate()->context()),
+                endpoint, timeout)
+        , _shutdown_asynchronous(false)
+        , _timeout(timeout)
+      {
+        this->_client_handshake();
+      }
+
       SSLSocket::SSLSocket(const std::string& hostname,
                            const std::string& port,
                            SSLCertificate& certificate,
@@ -149,20 +359,43 @@ namespace elle
       | SSL connection |
       `---------------*/
 
+      bool
+      SSLSocket::session_reused() const
+      {
+        return SSL_session_reused(this->_socket->native_handle());
+      }
+
       void
       SSLSocket::_client_handshake()
       {
         ELLE_TRACE_SCOPE("%s: handshake as client", *this);
+        auto& certificate = *this->certificate();
+        auto const resume = certificate.client_sessions_size() > 0;
+        auto const endpoint = elle::sprintf("%s", this->peer());
+        if (resume)
+          if (auto session = certificate._client_session(endpoint))
+          {
+            ELLE_DEBUG("%s: offer previous session", *this);
+            SSL_set_session(this->_socket->native_handle(), session);
+          }
         auto handshaker =
           SSLHandshake<SSLStream>(*this->_socket,
                                   SSLStream::handshake_type::client);
         if (!handshaker.run(this->_timeout))
           throw TimeOut();
+        ELLE_DEBUG("%s: session %s", *this,
+                   this->session_reused() ? "resumed" : "established");
+        if (resume)
+          certificate._client_session(
+            endpoint, SSL_get1_session(this->_socket->native_handle()));
       }
 
       void
-      SSLSocket::_server_handshake(reactor::DurationOpt const& timeout)
+      SSLSocket::_server_handshake(reactor::DurationOpt const& timeout,
+                                   bool background)
       {
+        if (background)
+          return this->_server_handshake_background(timeout);
         ELLE_TRACE_SCOPE("%s: handshake as server", *this);
         auto handshaker =
           SSLHandshake<SSLStream>(*this->_socket,
@@ -171,6 +404,160 @@ namespace elle
           throw TimeOut();
       }
 
+      namespace
+      {
+        /// Move handshake records between the socket and a memory BIO.
+        class HandshakeTransfer
+          : public SocketOperation<boost::asio::ip::tcp::socket>
+        {
+        public:
+          using Super = SocketOperation<boost::asio::ip::tcp::socket>;
+
+          HandshakeTransfer(SSLSocket& socket,
+                            boost::asio::mutable_buffer buffer,
+                            bool write)
+            : Super(socket.socket()->next_layer())
+            , _ssl_socket(socket)
+            , _buffer(buffer)
+            , _write(write)
+            , _transferred(0)
+          {}
+
+          void
+          print(std::ostream& stream) const override
+          {
+            elle::fprintf(stream, "SSL handshake %s %s",
+                          this->_write ? "write to" : "read from",
+                          this->_ssl_socket);
+          }
+
+        protected:
+          void
+          _start() override
+          {
+            auto handler =
+              [this] (boost::system::error_code const& error, std::size_t size)
+              {
+                this->_transferred = size;
+                this->_wakeup(error);
+              };
+            if (this->_write)
+              boost::asio::async_write(
+                this->socket(), boost::asio::buffer(this->_buffer), handler);
+            else
+              this->socket().async_read_some(
+                boost::asio::buffer(this->_buffer), handler);
+          }
+
+          void
+          _handle_error(boost::system::error_code const& error) override
+          {
+            this->_raise<SSLHandshakeError>(error.message());
+          }
+
+          ELLE_ATTRIBUTE(SSLSocket&, ssl_socket);
+          ELLE_ATTRIBUTE(boost::asio::mutable_buffer, buffer);
+          ELLE_ATTRIBUTE(bool, write);
+          ELLE_ATTRIBUTE_R(std::size_t, transferred);
+        };
+      }
+
+      void
+      SSLSocket::_server_handshake_background(
+        reactor::DurationOpt const& timeout)
+      {
+        ELLE_TRACE_SCOPE("%s: handshake as server in background", *this);
+        // Only SSL_do_handshake, where the key exchange and signatures are
+        // computed, runs in the background pool. It works on a memory BIO
+        // pair of its own while the socket I/O stays on the reactor thread,
+        // so a slow peer holds no system thread and the socket is never
+        // touched concurrently.
+        auto ssl = this->_socket->native_handle();
+        auto internal = static_cast<BIO*>(nullptr);
+        auto external = static_cast<BIO*>(nullptr);
+        if (!BIO_new_bio_pair(&internal, 0, &external, 0))
+          elle::err<SSLHandshakeError>("unable to create BIO pair");
+        // Asio's BIO is restored once done, so records that follow the
+        // handshake go through the stream as usual. Hold a reference, since
+        // SSL_set_bio frees the BIO it replaces.
+        auto asio = SSL_get_rbio(ssl);
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+        CRYPTO_add(&asio->references, 1, CRYPTO_LOCK_BIO);
+#else
+        BIO_up_ref(asio);
+#endif
+        SSL_set_bio(ssl, internal, internal);
+        elle::SafeFinally restore([&]
+          {
+            SSL_set_bio(ssl, asio, asio);
+            BIO_free(external);
+          });
+        SSL_set_accept_state(ssl);
+        using Clock = std::chrono::steady_clock;
+        auto const deadline = timeout ?
+          boost::optional<Clock::time_point>(Clock::now() + *timeout) :
+          boost::none;
+        auto transfer = [&] (char* data, std::size_t size, bool write)
+          {
+            auto op = HandshakeTransfer(
+              *this, boost::asio::buffer(data, size), write);
+            auto remaining = DurationOpt{};
+            if (deadline)
+              remaining = std::max(
+                std::chrono::duration_cast<Duration>(*deadline - Clock::now()),
+                Duration::zero());
+            if (!op.run(remaining))
+              throw TimeOut();
+            return op.transferred();
+          };
+        char buffer[16384];
+        while (true)
+        {
+          auto res = 0;
+          auto code = 0;
+          auto error = 0ul;
+          // The step is short: let it finish rather than leave the pool
+          // working on a stream that may be destroyed.
+          elle::With<Thread::NonInterruptible>() << [&]
+          {
+            reactor::background(
+              [&]
+              {
+                ERR_clear_error();
+                res = SSL_do_handshake(ssl);
+                code = SSL_get_error(ssl, res);
+                // The error queue is per system thread.
+                error = ERR_get_error();
+              });
+          };
+          while (auto const pending = BIO_ctrl_pending(external))
+          {
+            auto const size = BIO_read(
+              external, buffer, std::min(pending, sizeof buffer));
+            transfer(buffer, size, true);
+          }
+          if (res == 1)
+            break;
+          else if (code == SSL_ERROR_WANT_READ)
+          {
+            // Read no more than requested so nothing that follows the
+            // handshake is left behind in our BIO.
+            auto const wanted = std::min(
+              BIO_ctrl_get_read_request(external), sizeof buffer);
+            auto const size =
+              transfer(buffer, wanted ? wanted : sizeof buffer, false);
+            BIO_write(external, buffer, size);
+          }
+          else if (code != SSL_ERROR_WANT_WRITE)
+            throw SSLHandshakeError(
+              error ?
+              boost::system::error_code(
+                error, boost::asio::error::get_ssl_category()).message() :
+              "handshake failed");
+        }
+        if (BIO_ctrl_pending(internal))
+          elle::err<SSLHandshakeError>("unexpected data after handshake");
+      }
 
       class SSLShutdown
         : public DataOperation<boost::asio::ip::tcp::socket>
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include <elle/reactor/network/socket.hh>
 #include <elle/reactor/network/resolve.hh>
 #include <elle/reactor/network/TCPSocket.hh>
@@ -56,8 +60,79 @@ namespace elle
                        SSLCertificateMethod meth =
                          boost::asio::ssl::context::tlsv1_server);
 
+      /*-------------------.
+      | Session resumption |
+      `-------------------*/
+      public:
+        /// Enable the server side session cache, so clients presenting a
+        /// known session id skip the full handshake.
+        ///
+        /// @param size The maximum number of cached sessions.
+        /// @param timeout How long a session may be resumed.
+        void
+        session_cache(std::size_t size,
+                      Duration timeout = 5min);
+        /// Enable stateless session tickets, issued and checked with keys
+        /// managed by this certificate.
+        ///
+        /// A first random key is generated, see rotate_session_ticket_key.
+        void
+        session_tickets();
+        /// Generate a new session ticket key.
+        ///
+        /// New tickets are encrypted with the new key, tickets issued under
+        /// the previous keys are still accepted (and renewed) until they are
+        /// pushed out of the key history.
+        void
+        rotate_session_ticket_key();
+        /// Enable the client side session cache, so sockets connecting with
+        /// this certificate resume their previous session with a given
+        /// endpoint.
+        ///
+        /// @param size The maximum number of remembered endpoints.
+        void
+        client_session_cache(std::size_t size);
+
       private:
+        friend class SSLSocket;
+        struct TicketKey
+        {
+          unsigned char name[16];
+          unsigned char aes[16];
+          unsigned char hmac[16];
+        };
+        static
+        int
+        _ticket_key_callback(SSL* ssl,
+                             unsigned char* name,
+                             unsigned char* iv,
+                             EVP_CIPHER_CTX* cipher,
+                             HMAC_CTX* hmac,
+                             int encrypt);
+        /// Bind this certificate to its context so OpenSSL callbacks can find
+        /// it back.
+        void
+        _attach();
+        /// The session to offer when connecting to endpoint, if any.
+        SSL_SESSION*
+        _client_session(std::string const& endpoint);
+        /// Remember the session established with endpoint.
+        void
+        _client_session(std::string const& endpoint, SSL_SESSION* session);
         ELLE_ATTRIBUTE_RX(boost::asio::ssl::context, context);
+        /// Ticket keys, most recent first. Tickets may be checked in
+        /// background handshakes, hence the lock.
+        ELLE_ATTRIBUTE(std::list<TicketKey>, ticket_keys);
+        ELLE_ATTRIBUTE(std::mutex, ticket_keys_mutex);
+        /// Client sessions by endpoint, least recently used last.
+        using ClientSession =
+          std::pair<std::string, std::shared_ptr<SSL_SESSION>>;
+        ELLE_ATTRIBUTE(std::list<ClientSession>, client_sessions);
+        ELLE_ATTRIBUTE(
+          (std::unordered_map<std::string,
+                              std::list<ClientSession>::iterator>),
+          client_sessions_index);
+        ELLE_ATTRIBUTE_R(std::size_t, client_sessions_size);
       };
 
       using SSLStream = boost::asio::ssl::stream<boost::asio::ip::tcp::socket>;
@@ -103,6 +178,29 @@ namespace elle
         ///                times out.
         SSLSocket(SSLEndPoint const& endpoint,
                   DurationOpt timeout = {});
+        /// Construct a client socket sharing a certificate.
+        ///
+        /// If the certificate has a client session cache, the previous
+        /// session with this endpoint is resumed when possible.
+        ///
+        /// @param hostname The name of the host.
+        /// @param port The port the host is listening to.
+        /// @param certificate The shared client SSLCertificate.
+        /// @param timeout The maximum duration before the connection attempt
+        ///                times out.
+        SSLSocket(const std::string& hostname,
+                  const std::string& port,
+                  std::shared_ptr<SSLCertificate> certificate,
+                  DurationOpt timeout = {});
+        /// Construct a client socket sharing a certificate.
+        ///
+        /// @param endpoint The EndPoint of the host.
+        /// @param certificate The shared client SSLCertificate.
+        /// @param timeout The maximum duration before the connection attempt
+        ///                times out.
+        SSLSocket(SSLEndPoint const& endpoint,
+                  std::shared_ptr<SSLCertificate> certificate,
+                  DurationOpt timeout = {});
         /// Construct a server socket.
         ///
         /// @param hostname The name of the host.
@@ -135,6 +233,11 @@ namespace elle
       /*-----------.
       | Connection |
       `-----------*/
+      public:
+        /// Whether the handshake resumed a previous session.
+        bool
+        session_reused() const;
+
       private:
         friend class SSLServer;
         SSLSocket(std::unique_ptr<SSLStream> socket,
@@ -144,8 +247,17 @@ namespace elle
         /// No check of certificate is done by default
         void
         _client_handshake();
+        /// Handshake as a server.
+        ///
+        /// @param timeout The maximum duration of the handshake.
+        /// @param background Whether to run the handshake computations, and
+        ///                   thus its public key operations, on the scheduler
+        ///                   background pool instead of the reactor thread.
+        void
+        _server_handshake(reactor::DurationOpt const& timeout,
+                          bool background = false);
         void
-        _server_handshake(reactor::DurationOpt const& timeout);
+        _server_handshake_background(reactor::DurationOpt const& timeout);
         void
         _shutdown();
 
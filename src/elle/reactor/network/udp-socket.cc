@@ -70,12 +70,22 @@ namespace elle
       `--------------*/
 
       void
-      UDPSocket::bind(EndPoint const& endpoint)
+      UDPSocket::bind(EndPoint const& endpoint, bool reuse_port)
       {
         if (endpoint.address().is_v6())
           socket()->open(boost::asio::ip::udp::v6()); // gives us mapped v4 too
         else
           socket()->open(boost::asio::ip::udp::v4());
+        if (reuse_port)
+        {
+#ifdef SO_REUSEPORT
+          using ReusePort =
+            boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+          socket()->set_option(ReusePort(true));
+#else
+          ELLE_WARN("%s: SO_REUSEPORT is not supported", this);
+#endif
+        }
         socket()->bind(endpoint);
       }
 
@@ -66,8 +66,11 @@ namespace elle
         /// Bind the UDPSocket to the given Endpoint.
         ///
         /// \param endpoint The endpoint to connect to.
+        /// \param reuse_port Whether to let several sockets bind the same
+        ///                   endpoint, the system spreading datagrams among
+        ///                   them (SO_REUSEPORT), where supported.
         void
-        bind(EndPoint const& endpoint);
+        bind(EndPoint const& endpoint, bool reuse_port = false);
 
       /*-----.
       | Read |
@@ -14,6 +14,7 @@
 #include <boost/range/algorithm_ext/erase.hpp>
 
 #include <elle/Buffer.hh>
+#include <elle/BufferPool.hh>
 #include <elle/log.hh>
 #include <elle/os/environ.hh>
 #include <elle/reactor/network/utp-server-impl.hh>
@@ -578,8 +579,9 @@ namespace elle
       UTPServer::Impl::send_to(elle::ConstWeakBuffer buf, EndPoint where,
         std::function<void(boost::system::error_code const&)> on_error)
       {
-        this->_send_buffer.emplace_back(elle::Buffer(buf.contents(), buf.size()),
-                                        where, on_error);
+        auto copy = elle::Buffer(buf.size(), elle::BufferPool::local());
+        memcpy(copy.mutable_contents(), buf.contents(), buf.size());
+        this->_send_buffer.emplace_back(std::move(copy), where, on_error);
         if (this->_sending)
           ELLE_DEBUG("already sending, data queued");
         else
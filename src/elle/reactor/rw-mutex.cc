@@ -1,4 +1,7 @@
+#include <algorithm>
+
 #include <elle/assert.hh>
+#include <elle/finally.hh>
 #include <elle/log.hh>
 #include <elle/reactor/rw-mutex.hh>
 #include <elle/reactor/scheduler.hh>
@@ -10,18 +13,6 @@ namespace elle
 {
   namespace reactor
   {
-
-    /*-------.
-    | Signal |
-    `-------*/
-    Thread*
-    RWMutex::WriteMutex::_signal_one()
-    {
-      Thread* thread = Waitable::_signal_one();
-      this->_locked = thread;
-      return thread;
-    }
-
     /*-----------.
     | WriteMutex |
     `-----------*/
@@ -41,34 +32,7 @@ namespace elle
     bool
     RWMutex::WriteMutex::acquire()
     {
-      auto thread = Scheduler::scheduler()->current();
-      ELLE_TRACE_SCOPE("%s: lock for writing by %s", *this, *thread);
-      if (_locked == thread)
-      {
-        ++_locked_recursive;
-        ELLE_TRACE_SCOPE("%s: already locked for writing by this"
-                         " thread %s times.", *this, _locked_recursive);
-        return true;
-      }
-      const bool reading = _owner._readers > 0;
-      const bool writing = _locked;
-      if (reading || writing)
-      {
-        if (reading)
-          ELLE_TRACE("%s: already locked for reading, waiting.", *this);
-        else
-        {
-          ELLE_TRACE("%s: already locked for writing, waiting.", *this);
-          ELLE_ASSERT(_locked);
-        }
-        return false;
-      }
-      else
-      {
-        ELLE_TRACE("%s: mutex is free, locking", *this);
-        _locked = thread;
-        return true;
-      }
+      return this->_owner._acquire(Mode::write);
     }
 
     bool
@@ -83,74 +47,130 @@ namespace elle
         }
       ELLE_TRACE_SCOPE("%s: release writing lock", *this);
       ELLE_ASSERT(_locked);
-      _signal();
-      _owner._signal();
-      _locked = nullptr;
+      if (this->_owner._upgradable._locked == this->_locked)
+      {
+        ELLE_DEBUG("lock was upgraded, downgrade it");
+        this->_owner.downgrade();
+        return false;
+      }
+      this->_locked = nullptr;
+      this->_owner._wake_after_write();
       return false;
     }
 
     bool
     RWMutex::WriteMutex::_wait(Thread* thread, Waker const& waker)
     {
-      ELLE_TRACE_SCOPE("%s: lock for writing by %s", *this, *thread);
-      if (_locked == thread)
-      {
-        ELLE_TRACE_SCOPE("%s: already locked for writing by this"
-                         " thread %s times.", *this, _locked_recursive);
+      if (this->_locked == thread)
         return false;
-      }
-      const bool reading = _owner._readers > 0;
-      const bool writing = _locked;
-      if (reading || writing)
-      {
-        if (reading)
-          ELLE_TRACE("%s: already locked for reading, waiting.", *this);
-        else
-        {
-          ELLE_TRACE("%s: already locked for writing, waiting.", *this);
-          ELLE_ASSERT(_locked);
-        }
-        bool res = Waitable::_wait(thread, waker);
-        return res;
-      }
-      else
+      auto const woken = this->_owner._forget(thread);
+      if (this->_owner._admissible(thread, Mode::write, woken))
+        return false;
+      return Waitable::_wait(thread, waker);
+    }
+
+    void
+    RWMutex::WriteMutex::_abandon(Thread* thread)
+    {
+      this->_owner._abandon(thread);
+    }
+
+    /*-------------.
+    | UpgradeMutex |
+    `-------------*/
+
+    RWMutex::UpgradeMutex::UpgradeMutex(RWMutex& owner)
+      : _owner(owner)
+      , _locked(nullptr)
+    {}
+
+    bool
+    RWMutex::UpgradeMutex::locked() const
+    {
+      return (this->_locked != nullptr);
+    }
+
+    bool
+    RWMutex::UpgradeMutex::acquire()
+    {
+      return this->_owner._acquire(Mode::upgrade);
+    }
+
+    bool
+    RWMutex::UpgradeMutex::release()
+    {
+      auto& write = this->_owner._write;
+      if (write._locked && write._locked != this->_locked)
       {
-        ELLE_TRACE("%s: mutex is free", *this);
+        ELLE_TRACE("%s: release one of the %s recursive writing lock",
+                   *this, write._locked_recursive);
+        ELLE_ASSERT_GT(write._locked_recursive, 0);
+        --write._locked_recursive;
         return false;
       }
+      ELLE_TRACE_SCOPE("%s: release upgradable lock", *this);
+      ELLE_ASSERT(this->_locked);
+      if (write._locked)
+        this->_owner.downgrade();
+      this->_locked = nullptr;
+      this->_owner._release_read();
+      // Let the next upgradable reader in.
+      this->_owner._rewake();
+      return false;
     }
 
-    /*--------.
-    | RWMutex |
-    `--------*/
+    bool
+    RWMutex::UpgradeMutex::_wait(Thread* thread, Waker const& waker)
+    {
+      if (this->_owner._write._locked == thread)
+        return false;
+      auto const woken = this->_owner._forget(thread);
+      if (this->_owner._admissible(thread, Mode::upgrade, woken))
+        return false;
+      return Waitable::_wait(thread, waker);
+    }
+
+    void
+    RWMutex::UpgradeMutex::_abandon(Thread* thread)
+    {
+      this->_owner._abandon(thread);
+    }
+
+    /*-------------.
+    | Construction |
+    `-------------*/
 
-    RWMutex::RWMutex()
-      : _write(*this)
+    RWMutex::RWMutex(Fairness fairness)
+      : _fairness(fairness)
       , _readers(0)
+      , _write(*this)
+      , _upgradable(*this)
+      , _upgrading(false)
+      , _drained()
+      , _woken_readers()
+      , _woken_writers()
+      , _statistics()
+      , _waiting()
     {}
 
+    /*--------.
+    | Reading |
+    `--------*/
+
     bool
     RWMutex::_wait(Thread* thread, Waker const& waker)
     {
-      ELLE_TRACE_SCOPE("%s: lock for reading by %s", *this, *thread);
-      if (this->_write._locked)
-        {
-          if (_write._locked == thread)
-            {
-              ELLE_TRACE("%s: already locked for writing by this thread"
-                             " %s times", *this, _write._locked_recursive);
-              return false;
-            }
-          else
-            ELLE_TRACE("%s: already locked for writing, waiting", *this)
-              return Waitable::_wait(thread, waker);
-        }
-      else
+      if (this->_write._locked == thread)
       {
-        ELLE_TRACE("%s: mutex is free, locking (readers now: %s)",
-                       *this, _readers);
+        ELLE_TRACE("%s: already locked for writing by this thread"
+                   " %s times", *this, _write._locked_recursive);
         return false;
       }
+      auto const woken = this->_forget(thread);
+      if (this->_admissible(thread, Mode::read, woken))
+        return false;
+      ELLE_TRACE("%s: locked, %s waits", *this, *thread);
+      return Waitable::_wait(thread, waker);
     }
 
     bool
@@ -162,29 +182,7 @@ namespace elle
     bool
     RWMutex::acquire()
     {
-      auto thread = Scheduler::scheduler()->current();
-      ELLE_TRACE_SCOPE("%s: lock for reading by %s", *this, *thread);
-      if (this->_write._locked)
-      {
-        if (_write._locked == thread)
-        {
-          ++_write._locked_recursive;
-          ELLE_TRACE("%s: already locked for writing by this thread"
-            " %s times", *this, _write._locked_recursive);
-          return true;
-        }
-        else
-          ELLE_TRACE("%s: already locked for writing, waiting", *this)
-            return false;
-      }
-      else
-      {
-        ++_readers;
-        ELLE_TRACE("%s: mutex is free, locking (readers now: %s)",
-                       *this, _readers);
-        return true;
-      }
-      elle::unreachable();
+      return this->_acquire(Mode::read);
     }
 
     bool
@@ -198,20 +196,284 @@ namespace elle
           --this->_write._locked_recursive;
           return false;
         }
-
       ELLE_TRACE_SCOPE("%s: release one reading lock (readers now: %s)",
-                           _readers - 1, *this);
-      ELLE_ASSERT_GT(_readers, 0);
-      --_readers;
-      if (!_readers)
-        _write._signal();
+                       *this, _readers - 1);
+      this->_release_read();
       return false;
     }
 
+    void
+    RWMutex::_release_read()
+    {
+      ELLE_ASSERT_GT(this->_readers, 0);
+      --this->_readers;
+      if (this->_upgrading && this->_readers == 1)
+        this->_drained.signal();
+      if (this->_readers == 0)
+        this->_rewake();
+    }
+
     RWMutex::WriteMutex&
     RWMutex::write()
     {
       return _write;
     }
+
+    /*----------.
+    | Upgrading |
+    `----------*/
+
+    RWMutex::UpgradeMutex&
+    RWMutex::upgradable()
+    {
+      return this->_upgradable;
+    }
+
+    void
+    RWMutex::upgrade()
+    {
+      auto const thread = Scheduler::scheduler()->current();
+      ELLE_TRACE_SCOPE("%s: upgrade by %s", *this, *thread);
+      ELLE_ASSERT_EQ(this->_upgradable._locked, thread);
+      ELLE_ASSERT(!this->_write._locked);
+      this->_upgrading = true;
+      {
+        elle::SafeFinally give_up([this]
+                                  {
+                                    this->_upgrading = false;
+                                    this->_rewake();
+                                  });
+        while (this->_readers > 1)
+        {
+          ELLE_DEBUG("wait for %s other readers", this->_readers - 1);
+          reactor::wait(this->_drained);
+        }
+        give_up.abort();
+      }
+      this->_upgrading = false;
+      --this->_readers;
+      this->_write._locked = thread;
+      ++this->_statistics.writes;
+    }
+
+    void
+    RWMutex::downgrade()
+    {
+      auto const thread = Scheduler::scheduler()->current();
+      ELLE_TRACE_SCOPE("%s: downgrade by %s", *this, *thread);
+      ELLE_ASSERT_EQ(this->_write._locked, thread);
+      ELLE_ASSERT_EQ(this->_upgradable._locked, thread);
+      ELLE_ASSERT_EQ(this->_write._locked_recursive, 0);
+      this->_write._locked = nullptr;
+      ++this->_readers;
+      this->_rewake();
+    }
+
+    /*-----------.
+    | Scheduling |
+    `-----------*/
+
+    bool
+    RWMutex::_acquire(Mode mode)
+    {
+      static char const* const names[] = {"reading", "writing", "upgrading"};
+      auto const thread = Scheduler::scheduler()->current();
+      ELLE_TRACE_SCOPE("%s: lock for %s by %s",
+                       *this, names[static_cast<int>(mode)], *thread);
+      if (this->_write._locked == thread)
+      {
+        ++this->_write._locked_recursive;
+        ELLE_TRACE("%s: already locked for writing by this thread %s times",
+                   *this, this->_write._locked_recursive);
+        return true;
+      }
+      auto const woken = this->_forget(thread);
+      if (!this->_admissible(thread, mode, woken))
+      {
+        ELLE_TRACE("%s: locked, waiting", *this);
+        this->_queued(thread);
+        return false;
+      }
+      switch (mode)
+      {
+        case Mode::read:
+          ++this->_readers;
+          ++this->_statistics.reads;
+          break;
+        case Mode::upgrade:
+          ++this->_readers;
+          this->_upgradable._locked = thread;
+          ++this->_statistics.reads;
+          break;
+        case Mode::write:
+          this->_write._locked = thread;
+          ++this->_statistics.writes;
+          break;
+      }
+      ELLE_TRACE("%s: locked (readers now: %s)", *this, this->_readers);
+      this->_dequeued(thread, true);
+      return true;
+    }
+
+    bool
+    RWMutex::_admissible(Thread* thread, Mode mode, bool woken) const
+    {
+      if (this->_write._locked)
+        return false;
+      if (mode == Mode::write)
+        // Unless writers go first, let the woken readers in first.
+        return this->_readers == 0 &&
+          (this->_fairness == Fairness::writers ||
+           this->_woken_readers.empty());
+      if (this->_upgrading)
+        return false;
+      if (mode == Mode::upgrade && this->_upgradable._locked)
+        return false;
+      switch (this->_fairness)
+      {
+        case Fairness::readers:
+          return true;
+        case Fairness::writers:
+          return !this->_writers_pending();
+        case Fairness::phase_fair:
+          // Readers woken when the last writer left belong to this phase.
+          return woken || !this->_writers_pending();
+      }
+      elle::unreachable();
+    }
+
+    bool
+    RWMutex::_writers_pending() const
+    {
+      return !this->_write.waiters().empty() || !this->_woken_writers.empty();
+    }
+
+    void
+    RWMutex::_wake_after_write()
+    {
+      auto const readers =
+        !this->waiters().empty() ||
+        (!this->_upgradable._locked && !this->_upgradable.waiters().empty());
+      auto const writers = !this->_write.waiters().empty();
+      if (this->_fairness == Fairness::writers)
+      {
+        if (writers)
+          this->_wake_writers();
+        else if (readers)
+          this->_wake_readers();
+      }
+      else
+      {
+        if (readers)
+          this->_wake_readers();
+        else if (writers)
+          this->_wake_writers();
+      }
+    }
+
+    void
+    RWMutex::_rewake()
+    {
+      if (this->_write._locked)
+        return;
+      // Once the readers are gone, writers go first whatever the fairness:
+      // new readers only wait for them.
+      if (this->_readers == 0 && !this->_write.waiters().empty())
+        this->_wake_writers();
+      else if (!this->_upgrading &&
+               (this->_fairness == Fairness::readers ||
+                !this->_writers_pending()))
+        this->_wake_readers();
+    }
+
+    void
+    RWMutex::_wake_readers()
+    {
+      for (auto const& waiter: this->waiters())
+        this->_woken_readers.emplace(waiter.thread);
+      this->_signal();
+      if (!this->_upgradable._locked)
+      {
+        for (auto const& waiter: this->_upgradable.waiters())
+          this->_woken_readers.emplace(waiter.thread);
+        this->_upgradable._signal();
+      }
+    }
+
+    void
+    RWMutex::_wake_writers()
+    {
+      for (auto const& waiter: this->_write.waiters())
+        this->_woken_writers.emplace(waiter.thread);
+      this->_write._signal();
+    }
+
+    bool
+    RWMutex::_forget(Thread* thread)
+    {
+      this->_woken_writers.erase(thread);
+      return this->_woken_readers.erase(thread);
+    }
+
+    void
+    RWMutex::_abandon(Thread* thread)
+    {
+      ELLE_TRACE_SCOPE("%s: %s gave up", *this, *thread);
+      // Woken or not, it will not retry: do not hold others back for it.
+      this->_forget(thread);
+      this->_dequeued(thread, false);
+      // Whoever we were holding back may go.
+      this->_rewake();
+    }
+
+    /*-----------.
+    | Statistics |
+    `-----------*/
+
+    int
+    RWMutex::queue() const
+    {
+      return this->_waiting.size();
+    }
+
+    void
+    RWMutex::_queued(Thread* thread)
+    {
+      if (!this->_waiting.emplace(thread, Clock::now()).second)
+        return;
+      this->_statistics.max_queue =
+        std::max(this->_statistics.max_queue, this->_waiting.size());
+    }
+
+    void
+    RWMutex::_dequeued(Thread* thread, bool acquired)
+    {
+      auto it = this->_waiting.find(thread);
+      if (it == this->_waiting.end())
+        return;
+      if (acquired)
+      {
+        auto const waited = Clock::now() - it->second;
+        ++this->_statistics.contended;
+        this->_statistics.waited += waited;
+        this->_statistics.longest = std::max(this->_statistics.longest, waited);
+      }
+      this->_waiting.erase(it);
+    }
+
+    std::ostream&
+    operator <<(std::ostream& output, RWMutex::Fairness fairness)
+    {
+      switch (fairness)
+      {
+        case RWMutex::Fairness::readers:
+          return output << "readers";
+        case RWMutex::Fairness::writers:
+          return output << "writers";
+        case RWMutex::Fairness::phase_fair:
+          return output << "phase_fair";
+      }
+      elle::unreachable();
+    }
   }
 }
@@ -1,17 +1,100 @@
 #pragma once
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include <elle/attribute.hh>
 #include <elle/reactor/mutex.hh>
+#include <elle/reactor/signal.hh>
 
 namespace elle
 {
   namespace reactor
   {
+    /// A readers-writer lock.
+    ///
+    /// Locking the RWMutex itself locks it for reading, locking write() locks
+    /// it for writing and locking upgradable() takes a read lock that can
+    /// later be upgraded to a write lock. A Thread holding the write lock may
+    /// lock it again, for reading or writing.
+    ///
+    /// When both readers and writers are waiting, the Fairness decides who
+    /// goes first.
+    ///
+    /// \code{.cc}
+    ///
+    /// reactor::RWMutex mutex(reactor::RWMutex::Fairness::phase_fair);
+    /// {
+    ///   reactor::Lock read(mutex.upgradable());
+    ///   if (!cached(key))
+    ///   {
+    ///     mutex.upgrade();
+    ///     fill(key);
+    ///   }
+    /// }
+    /// if (mutex.write().try_lock_for(100ms))
+    /// {
+    ///   evict();
+    ///   mutex.write().release();
+    /// }
+    ///
+    /// \endcode
     class RWMutex
       : public Lockable
     {
+    /*------.
+    | Types |
+    `------*/
+    public:
+      /// Who goes first when both readers and writers are waiting.
+      enum class Fairness
+      {
+        /// New readers always get in while the lock is held for reading.
+        /// Writers may starve under a continuous flow of readers.
+        readers,
+        /// New readers wait as long as a writer is waiting. Readers may
+        /// starve under a continuous flow of writers, and a Thread that
+        /// already holds a read lock must not take it again.
+        writers,
+        /// Readers and writers take turns: new readers wait while a writer
+        /// is waiting, and releasing the write lock lets all the readers
+        /// waiting at that time in before the next writer.
+        phase_fair,
+      };
+
+      /// Contention statistics.
+      struct Statistics
+      {
+        /// Locks acquired for reading, including upgradable ones.
+        std::size_t reads = 0;
+        /// Locks acquired for writing, including upgrades.
+        std::size_t writes = 0;
+        /// Locks that were not acquired immediately.
+        std::size_t contended = 0;
+        /// Cumulated time spent waiting for contended locks.
+        Duration waited = Duration(0);
+        /// Longest time spent waiting for a lock.
+        Duration longest = Duration(0);
+        /// Largest number of Threads waiting at the same time.
+        std::size_t max_queue = 0;
+      };
+
+    /*-------------.
+    | Construction |
+    `-------------*/
     public:
-      RWMutex();
+      /// Create a RWMutex.
+      ///
+      /// \param fairness Who goes first when both readers and writers are
+      ///                 waiting.
+      RWMutex(Fairness fairness = Fairness::readers);
+      ELLE_ATTRIBUTE_R(Fairness, fairness);
+
+    /*--------.
+    | Reading |
+    `--------*/
+    public:
+      /// Whether the RWMutex is locked for reading.
       bool
       locked() const;
       virtual
@@ -20,7 +103,20 @@ namespace elle
       virtual
       bool
       acquire() override;
+    protected:
+      virtual
+      bool
+      _wait(Thread* thread, Waker const& waker) override;
+      virtual
+      void
+      _abandon(Thread* thread) override;
+    private:
+      ELLE_ATTRIBUTE_R(int, readers);
 
+    /*--------.
+    | Writing |
+    `--------*/
+    public:
       class WriteMutex
         : public Lockable
       {
@@ -40,8 +136,8 @@ namespace elle
         bool
         _wait(Thread* thread, Waker const& waker) override;
         virtual
-        Thread*
-        _signal_one() override;
+        void
+        _abandon(Thread* thread) override;
 
       private:
         ELLE_ATTRIBUTE(RWMutex&, owner);
@@ -49,15 +145,124 @@ namespace elle
         ELLE_ATTRIBUTE(int, locked_recursive);
         friend class RWMutex;
       };
-      WriteMutex& write();
+      WriteMutex&
+      write();
+    private:
+      WriteMutex _write;
 
-    protected:
-      virtual
+    /*----------.
+    | Upgrading |
+    `----------*/
+    public:
+      /// A read lock that can be upgraded to a write lock.
+      ///
+      /// Only one Thread at a time holds it, alongside plain readers.
+      class UpgradeMutex
+        : public Lockable
+      {
+      public:
+        UpgradeMutex(RWMutex& owner);
+        bool
+        locked() const;
+        /// Release the lock, downgrading it first if it was upgraded.
+        virtual
+        bool
+        release() override;
+        virtual
+        bool
+        acquire() override;
+
+      protected:
+        virtual
+        bool
+        _wait(Thread* thread, Waker const& waker) override;
+        virtual
+        void
+        _abandon(Thread* thread) override;
+
+      private:
+        ELLE_ATTRIBUTE(RWMutex&, owner);
+        ELLE_ATTRIBUTE(reactor::Thread*, locked);
+        friend class RWMutex;
+      };
+      UpgradeMutex&
+      upgradable();
+      /// Turn the upgradable lock of the current Thread into a write lock.
+      ///
+      /// New readers are held back while waiting for the current ones to
+      /// leave. The current Thread must not hold other read locks.
+      void
+      upgrade();
+      /// Turn the write lock obtained with upgrade back into an upgradable
+      /// read lock, letting readers in.
+      void
+      downgrade();
+    private:
+      UpgradeMutex _upgradable;
+      /// Whether the upgradable lock holder waits for readers to leave.
+      ELLE_ATTRIBUTE(bool, upgrading);
+      /// Signaled when the upgradable lock holder is the last reader.
+      ELLE_ATTRIBUTE(Signal, drained);
+
+    /*-----------.
+    | Scheduling |
+    `-----------*/
+    private:
+      enum class Mode
+      {
+        read,
+        write,
+        upgrade,
+      };
       bool
-      _wait(Thread* thread, Waker const& waker) override;
+      _acquire(Mode mode);
+      /// Whether \a thread may lock in \a mode.
+      bool
+      _admissible(Thread* thread, Mode mode, bool woken) const;
+      /// Whether a writer is waiting, or was woken and did not retry yet.
+      bool
+      _writers_pending() const;
+      /// Release a read lock.
+      void
+      _release_read();
+      /// Wake whoever comes next after a writer leaves.
+      void
+      _wake_after_write();
+      /// Wake whoever may go now that the lock state changed.
+      void
+      _rewake();
+      void
+      _wake_readers();
+      void
+      _wake_writers();
+      /// Forget about \a thread having been woken.
+      ///
+      /// \returns Whether it was woken as a reader.
+      bool
+      _forget(Thread* thread);
+      /// Readers woken by _wake_readers that did not retry nor give up yet.
+      ELLE_ATTRIBUTE(std::unordered_set<Thread*>, woken_readers);
+      /// Writers woken by _wake_writers that did not retry nor give up yet.
+      ELLE_ATTRIBUTE(std::unordered_set<Thread*>, woken_writers);
+
+    /*-----------.
+    | Statistics |
+    `-----------*/
+    public:
+      ELLE_ATTRIBUTE_R(Statistics, statistics);
+      /// Number of Threads currently waiting for the lock.
+      int
+      queue() const;
     private:
-      WriteMutex _write;
-      ELLE_ATTRIBUTE_R(int, readers);
+      void
+      _queued(Thread* thread);
+      void
+      _dequeued(Thread* thread, bool acquired);
+      /// Threads waiting for the lock and when they started to.
+      ELLE_ATTRIBUTE((std::unordered_map<Thread*, Time>), waiting);
     };
+
+    std::ostream&
+    operator <<(std::ostream& output, RWMutex::Fairness fairness);
   }
 }
@@ -158,7 +158,7 @@ namespace elle
             std::cerr << "      " << *t << std::endl;
           std::cerr << "    waiters:" << std::endl;
           for (auto t: thread.waiters())
-            std::cerr << "      " << *(t.first) << std::endl;
+            std::cerr << "      " << *(t.thread) << std::endl;
           std::cerr << "    backtrace:" << std::endl;
           // FIXME: Indent the backtrace
           std::cerr << thread.backtrace() << std::endl;
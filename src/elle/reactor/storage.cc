@@ -1,9 +1,50 @@
+#include <atomic>
+#include <vector>
+
 #include <elle/reactor/storage.hh>
 
 namespace elle
 {
   namespace reactor
   {
+    namespace
+    {
+      struct Slots
+      {
+        std::mutex mutex;
+        std::size_t next = 0;
+        std::vector<std::size_t> free;
+      };
+
+      Slots&
+      slots()
+      {
+        static auto res = Slots{};
+        return res;
+      }
+
+      std::atomic<std::uint64_t> generations{0};
+    }
+
+    LocalStorageBase::LocalStorageBase()
+      : _generation(++generations)
+    {
+      auto& s = slots();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (s.free.empty())
+        this->_index = s.next++;
+      else
+      {
+        this->_index = s.free.back();
+        s.free.pop_back();
+      }
+    }
 
+    LocalStorageBase::~LocalStorageBase()
+    {
+      auto& s = slots();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.free.emplace_back(this->_index);
+    }
   }
 }
@@ -1,9 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <mutex>
 #include <unordered_map>
 
-#include <boost/optional.hpp>
 #include <boost/signals2.hpp>
 
 #include <elle/reactor/fwd.hh>
@@ -12,17 +12,48 @@ namespace elle
 {
   namespace reactor
   {
-    /// XXX[doc].
+    /// The slot index shared by all LocalStorage types.
+    ///
+    /// Every LocalStorage reserves a slot index for its lifetime, and every
+    /// Thread keeps its values in a vector indexed by those slots. Indexes
+    /// are recycled, so each LocalStorage also gets a unique generation that
+    /// tells its values apart from those of a previous owner of the slot.
+    class LocalStorageBase
+    {
+    protected:
+      LocalStorageBase();
+      ~LocalStorageBase();
+      LocalStorageBase(LocalStorageBase const&) = delete;
+      LocalStorageBase&
+      operator =(LocalStorageBase const&) = delete;
+      /// The slot index of this storage in Thread values.
+      std::size_t _index;
+      /// The generation of this storage, never zero.
+      std::uint64_t _generation;
+    };
+
+    /// A value per Thread.
+    ///
+    /// Accessing the value of the current Thread is lock-free: it is a bounds
+    /// check and a pointer load in the Thread own slots. Values are destroyed
+    /// with their Thread, or with the storage if it is destroyed first: the
+    /// storage tracks, behind a lock taken on first access only, which
+    /// Threads hold a value. Outside of any Thread, a value per Scheduler,
+    /// respectively per process, is kept behind a lock.
     template <typename T>
     class LocalStorage
+      : public LocalStorageBase
     {
     public:
       using Self = LocalStorage<T>;
       LocalStorage();
       ~LocalStorage();
       operator T&();
+      /// The value of the current Thread, set to def on first access.
       T&
       get(T const& def);
+      /// The value of the current Thread, default constructed on first
+      /// access.
       T&
       get();
 
@@ -30,11 +61,17 @@ namespace elle
       template <typename Fun>
       T&
       _get(Fun fun);
+      template <typename Fun>
+      T&
+      _create(Thread& thread, Fun fun);
+      static
       void
-      _clean(Thread* t);
+      _destroy(void* value);
+      /// Values outside of any Thread, keyed by Scheduler.
       using Content = std::unordered_map<void*, T>;
       Content _content;
-      using Links = std::unordered_map<void*, boost::signals2::connection>;
+      /// Threads holding a value, to destroy it with this storage.
+      using Links = std::unordered_map<Thread*, boost::signals2::connection>;
       Links _links;
       std::mutex _mutex;
     };
@@ -1,4 +1,5 @@
-#include <elle/assert.hh>
+#include <memory>
+
 #include <elle/reactor/scheduler.hh>
 #include <elle/reactor/Thread.hh>
 
@@ -15,8 +16,16 @@ namespace elle
     LocalStorage<T>::~LocalStorage()
     {
       std::lock_guard<std::mutex> lock(this->_mutex);
-      for (auto const& i: this->_links)
-        i.second.disconnect();
+      for (auto const& link: this->_links)
+      {
+        link.second.disconnect();
+        auto& slot = link.first->_storage[this->_index];
+        if (slot.generation == this->_generation)
+        {
+          slot.destroy(slot.value);
+          slot = {};
+        }
+      }
     }
 
     template <typename T>
@@ -46,35 +55,61 @@ namespace elle
     {
       Scheduler* sched = Scheduler::scheduler();
       Thread* current = sched ? sched->current() : nullptr;
-      void* key = current ? static_cast<void*>(current)
-                          : static_cast<void*>(sched);
-      std::lock_guard<std::mutex> lock(this->_mutex);
-      auto it = this->_content.find(key);
-      if (it == this->_content.end())
+      if (current)
+      {
+        auto& slots = current->_storage;
+        if (this->_index < slots.size())
         {
-          auto& res = this->_content[key];
-          fun(res);
-          if (current)
-            this->_links[current]
-              = current->destructed().connect([this, current]
-                {
-                  this->_clean(current);
-                });
-          return res;
+          auto& slot = slots[this->_index];
+          if (slot.generation == this->_generation)
+            return *static_cast<T*>(slot.value);
         }
+        return this->_create(*current, std::move(fun));
+      }
+      std::lock_guard<std::mutex> lock(this->_mutex);
+      auto it = this->_content.find(sched);
+      if (it == this->_content.end())
+      {
+        auto& res = this->_content[sched];
+        fun(res);
+        return res;
+      }
       else
         return it->second;
     }
 
     template <typename T>
-    void
-    LocalStorage<T>::_clean(Thread* current)
+    template <typename Fun>
+    T&
+    LocalStorage<T>::_create(Thread& thread, Fun fun)
     {
+      auto value = std::make_unique<T>();
+      fun(*value);
+      auto& slots = thread._storage;
+      if (slots.size() <= this->_index)
+        slots.resize(this->_index + 1);
+      auto& slot = slots[this->_index];
+      slot.value = value.release();
+      slot.destroy = &Self::_destroy;
+      slot.generation = this->_generation;
+      // The Thread destroys the value if it dies first, and then only needs
+      // to be forgotten.
       std::lock_guard<std::mutex> lock(this->_mutex);
-      this->_links.erase(current);
-      auto it = this->_content.find(current);
-      ELLE_ASSERT_NEQ(it, this->_content.end());
-      this->_content.erase(it);
+      auto const t = &thread;
+      this->_links[t] = thread.destructed().connect(
+        [this, t]
+        {
+          std::lock_guard<std::mutex> lock(this->_mutex);
+          this->_links.erase(t);
+        });
+      return *static_cast<T*>(slot.value);
+    }
+
+    template <typename T>
+    void
+    LocalStorage<T>::_destroy(void* value)
+    {
+      delete static_cast<T*>(value);
     }
   }
 }
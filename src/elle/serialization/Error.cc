@@ -10,6 +10,10 @@ namespace elle
       : elle::Error(message)
     {}
 
+    Error::Error(elle::Backtrace bt, std::string const& message)
+      : elle::Error(std::move(bt), message)
+    {}
+
     Error::Error(SerializerIn& input)
       : elle::Error(input)
     {}
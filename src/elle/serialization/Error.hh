@@ -15,6 +15,11 @@ namespace elle
       ///
       /// @param message The message.
       Error(std::string const& message);
+      /// Construct a serialization Error with \a message.
+      ///
+      /// @param bt The Backtrace to attach to the Error.
+      /// @param message The message.
+      Error(elle::Backtrace bt, std::string const& message);
       /// Construct a serialization Error from a Serializer.
       ///
       /// @param input The serializer containing the representation of the
@@ -9,10 +9,15 @@ namespace elle
   namespace serialization
   {
     Serializer::Serializer(bool versioned)
-      : Serializer(Versions(), versioned)
+      : Serializer(SharedVersions(), versioned)
     {}
 
     Serializer::Serializer(Versions versions, bool versioned)
+      : Serializer(std::make_shared<Versions const>(std::move(versions)),
+                   versioned)
+    {}
+
+    Serializer::Serializer(SharedVersions versions, bool versioned)
       : _versioned(versioned)
       , _versions(std::move(versions))
     {
@@ -34,7 +39,7 @@ namespace elle
       , _entered(this->_serializer._enter(name))
     {
       if (this->_entered)
-        s._names.emplace_back(name);
+        s._names.emplace_back(&name);
     }
 
     Serializer::Entry::~Entry()
@@ -67,10 +72,11 @@ namespace elle
     Serializer::_leave(std::string const&)
     {}
 
-    std::string
+    std::string const&
     Serializer::current_name() const
     {
-      return this->_names.empty() ? "" : this->_names.back();
+      static auto const none = std::string();
+      return this->_names.empty() ? none : *this->_names.back();
     }
 
     void
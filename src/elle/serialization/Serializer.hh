@@ -358,6 +358,12 @@ namespace elle
     public:
       using Self = Serializer;
       using Versions = std::unordered_map<TypeInfo, Version>;
+      /// Versions shared, read-only, among serializers.
+      ///
+      /// Those of a serialization tag are computed from its `dependencies`
+      /// the first time it is used at a given version: the table must be
+      /// complete by then.
+      using SharedVersions = std::shared_ptr<Versions const>;
 
     /*-------------.
     | Construction |
@@ -374,6 +380,12 @@ namespace elle
       /// @param versioned Whether the Serializer will read or write the
       ///                  version of objects.
       Serializer(Versions versions, bool versioned);
+      /// Create a Serializer.
+      ///
+      /// @param versions A map of special Versions for given types, if any.
+      /// @param versioned Whether the Serializer will read or write the
+      ///                  version of objects.
+      Serializer(SharedVersions versions, bool versioned);
 
     /*-----------.
     | Properties |
@@ -392,7 +404,7 @@ namespace elle
       bool
       text() const;
       ELLE_ATTRIBUTE_R(bool, versioned);
-      ELLE_ATTRIBUTE_R(boost::optional<Versions>, versions);
+      ELLE_ATTRIBUTE_R(SharedVersions, versions);
 
     /*--------------.
     | Serialization |
@@ -565,7 +577,7 @@ namespace elle
       Entry
       enter(std::string const& name);
       /// Get the name of the current Entry.
-      std::string
+      std::string const&
       current_name() const;
     protected:
       /// Call when entering an entry or a collection.
@@ -585,7 +597,8 @@ namespace elle
       virtual
       void
       _leave(std::string const& name);
-      ELLE_ATTRIBUTE(std::vector<std::string>, names, protected);
+      /// The names of the current entries, owned by their callers.
+      ELLE_ATTRIBUTE(std::vector<std::string const*>, names, protected);
 
     protected:
       /// XXX[doc].
@@ -3,6 +3,11 @@
 #ifndef ELLE_SERIALIZATION_SERIALIZER_HXX
 # define ELLE_SERIALIZATION_SERIALIZER_HXX
 
+# include <atomic>
+# include <memory>
+# include <mutex>
+# include <vector>
+
 # include <boost/algorithm/string/replace.hpp>
 # include <boost/optional.hpp>
 
@@ -102,7 +107,7 @@ namespace elle
 
       template <typename T>
       std::enable_if_t<has_version_tag<T>(), elle::Version>
-      version_tag(boost::optional<Serializer::Versions> const& versions)
+      version_tag(Serializer::SharedVersions const& versions)
       {
         ELLE_LOG_COMPONENT("elle.serialization.Serializer");
         if (versions)
@@ -122,7 +127,7 @@ namespace elle
 
       template <typename T>
       std::enable_if_t<!has_version_tag<T>(), elle::Version>
-      version_tag(boost::optional<Serializer::Versions> const&)
+      version_tag(Serializer::SharedVersions const&)
       {
         ELLE_LOG_COMPONENT("elle.serialization.Serializer");
         ELLE_WARN("no serialization version tag for %s", elle::type_info<T>());
@@ -1645,6 +1650,51 @@ namespace elle
       {
         return std::unordered_map<elle::TypeInfo, elle::Version>();
       }
+
+      /// The versions of ST and its dependencies at a given version.
+      ///
+      /// They are computed once per version and shared by all serializers:
+      /// ST::dependencies must be complete before ST is first serialized,
+      /// later changes are not seen.
+      template <typename ST>
+      Serializer::SharedVersions
+      versions(elle::Version const& version)
+      {
+        using Cache =
+          std::unordered_map<elle::Version, Serializer::SharedVersions>;
+        // Published caches are never modified nor freed, so that lookups need
+        // no locking. Only a version seen for the first time takes the mutex,
+        // to publish an updated copy.
+        static auto cache = std::atomic<Cache const*>{nullptr};
+        static auto mutex = std::mutex{};
+        static auto caches = std::vector<std::unique_ptr<Cache const>>{};
+        auto const find = [&] (Cache const* c) -> Serializer::SharedVersions
+          {
+            if (c)
+            {
+              auto const it = c->find(version);
+              if (it != c->end())
+                return it->second;
+            }
+            return nullptr;
+          };
+        if (auto res = find(cache.load(std::memory_order_acquire)))
+          return res;
+        auto const lock = std::lock_guard<std::mutex>(mutex);
+        auto const current = cache.load(std::memory_order_relaxed);
+        if (auto res = find(current))
+          return res;
+        auto versions = dependencies<ST>(version, 42);
+        versions.emplace(elle::type_info<ST>(), version);
+        auto res =
+          std::make_shared<Serializer::Versions const>(std::move(versions));
+        auto next = current ?
+          std::make_unique<Cache>(*current) : std::make_unique<Cache>();
+        next->emplace(version, res);
+        caches.emplace_back(std::move(next));
+        cache.store(caches.back().get(), std::memory_order_release);
+        return res;
+      }
     }
 
     /*--------.
@@ -1659,12 +1709,10 @@ namespace elle
     }
 
     template <typename ST>
-    std::unordered_map<elle::TypeInfo, elle::Version>
+    Serializer::SharedVersions
     get_serialization_versions(elle::Version const& version)
     {
-      auto versions = ST::dependencies.at(version);
-      versions.emplace(elle::type_info<ST>(), version);
-      return versions;
+      return _details::versions<ST>(version);
     }
 
     template <typename Serialization, typename T, typename Serializer = void>
@@ -1674,11 +1722,10 @@ namespace elle
                 bool versioned,
                 boost::optional<Context const&> context = {})
     {
-      auto versions = get_serialization_versions
-        <typename _details::serialization_tag<T>::type>(version);
       typename Serialization::SerializerIn s(
         input,
-        versions,
+        get_serialization_versions
+          <typename _details::serialization_tag<T>::type>(version),
         versioned);
       if (context)
         s.set_context(context.get());
@@ -1837,15 +1884,10 @@ namespace elle
               elle::Version const& version,
               Args&& ... args)
     {
-      auto versions =
-        _details::dependencies<typename _details::serialization_tag<T>::type>(
-          version, 42);
-      versions.emplace(
-        elle::type_info<typename _details::serialization_tag<T>::type>(),
-        version);
       typename Serialization::SerializerOut s(
         output,
-        versions,
+        _details::versions<typename _details::serialization_tag<T>::type>(
+          version),
         std::forward<Args>(args)...);
       s.template serialize_forward<Serializer>(o);
     }
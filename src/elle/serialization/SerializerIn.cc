@@ -13,6 +13,11 @@ namespace elle
       : Super(std::move(versions), versioned)
     {}
 
+    SerializerIn::SerializerIn(SharedVersions versions,
+                               bool versioned)
+      : Super(std::move(versions), versioned)
+    {}
+
     bool
     SerializerIn::out() const
     {
@@ -38,6 +38,10 @@ namespace elle
       ///
       /// @see Serializer(Versions, bool);
       SerializerIn(Versions versions, bool versioned = true);
+      /// Construct a SerializerIn from an input stream.
+      ///
+      /// @see Serializer(SharedVersions, bool);
+      SerializerIn(SharedVersions versions, bool versioned = true);
 
     /*-----------.
     | Properties |
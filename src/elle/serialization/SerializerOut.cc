@@ -13,6 +13,11 @@ namespace elle
       : Super(std::move(versions), versioned)
     {}
 
+    SerializerOut::SerializerOut(SharedVersions versions,
+                                 bool versioned)
+      : Super(std::move(versions), versioned)
+    {}
+
     void
     SerializerOut::serialize(std::string const& name, char const* v)
     {
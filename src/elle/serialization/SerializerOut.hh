@@ -34,6 +34,10 @@ namespace elle
       ///
       /// @see Serializer(Versions, bool);
       SerializerOut(Versions versions, bool versioned = true);
+      /// Construct a SerializerOut from an output stream.
+      ///
+      /// @see Serializer(SharedVersions, bool);
+      SerializerOut(SharedVersions versions, bool versioned = true);
 
     /*-----------.
     | Properties |
@@ -23,6 +23,14 @@ namespace elle
       SerializerIn::SerializerIn(std::istream& input,
                                  Versions versions,
                                  bool versioned)
+        : SerializerIn(input,
+                       std::make_shared<Versions const>(std::move(versions)),
+                       versioned)
+      {}
+
+      SerializerIn::SerializerIn(std::istream& input,
+                                 SharedVersions versions,
+                                 bool versioned)
         : Super(std::move(versions), versioned)
         , _input(input)
       {
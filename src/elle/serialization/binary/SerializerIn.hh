@@ -33,6 +33,8 @@ namespace elle
         SerializerIn(std::istream& input, bool versioned = true);
         SerializerIn(std::istream& input,
                      Versions versions, bool versioned = true);
+        SerializerIn(std::istream& input,
+                     SharedVersions versions, bool versioned = true);
       private:
         void
         _check_magic(std::istream& input);
@@ -28,6 +28,14 @@ namespace elle
       SerializerOut::SerializerOut(std::ostream& output,
                                    Versions versions,
                                    bool versioned)
+        : SerializerOut(output,
+                        std::make_shared<Versions const>(std::move(versions)),
+                        versioned)
+      {}
+
+      SerializerOut::SerializerOut(std::ostream& output,
+                                   SharedVersions versions,
+                                   bool versioned)
         : Super(std::move(versions), versioned)
         , _output(output)
       {
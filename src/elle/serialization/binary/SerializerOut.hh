@@ -42,6 +42,11 @@ namespace elle
         /// @see elle::serialization::SerializerOut.
         SerializerOut(std::ostream& output,
                       Versions versions, bool versioned = true);
+        /// Construct a SerializerOut for binary.
+        ///
+        /// @see elle::serialization::SerializerOut.
+        SerializerOut(std::ostream& output,
+                      SharedVersions versions, bool versioned = true);
         virtual
         ~SerializerOut();
       private:
@@ -6,7 +6,8 @@ namespace elle
   namespace serialization
   {
     MissingKey::MissingKey(std::string const& field)
-      : Error(elle::sprintf("missing mandatory key: \"%s\"", field))
+      : Error(elle::Backtrace::capture(typeid(MissingKey), 1),
+              elle::sprintf("missing mandatory key: \"%s\"", field))
       , _field(field)
     {}
 
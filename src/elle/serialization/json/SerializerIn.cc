@@ -28,12 +28,20 @@ namespace elle
 
       SerializerIn::SerializerIn(std::istream& input,
                                  bool versioned)
-        : SerializerIn(input, Versions(), versioned)
+        : SerializerIn(input, SharedVersions(), versioned)
       {}
 
       SerializerIn::SerializerIn(std::istream& input,
                                  Versions versions,
                                  bool versioned)
+        : SerializerIn(input,
+                       std::make_shared<Versions const>(std::move(versions)),
+                       versioned)
+      {}
+
+      SerializerIn::SerializerIn(std::istream& input,
+                                 SharedVersions versions,
+                                 bool versioned)
         : Super(std::move(versions), versioned)
         , _partial(false)
         , _json([&]
@@ -190,15 +198,19 @@ namespace elle
       void
       SerializerIn::_serialize(elle::Buffer& buffer)
       {
-        // FIXME: don't copy
-        std::string str = this->_check_type(elle::json::Type::string);
-        std::stringstream encoded(str);
-        elle::format::base64::Stream base64(encoded);
+        auto const& str = this->_check_type(elle::json::Type::string)
+          .get_ref<std::string const&>();
+        try
         {
-          elle::IOStream output(buffer.ostreambuf());
-          std::copy(std::istreambuf_iterator<char>(base64),
-                    std::istreambuf_iterator<char>(),
-                    std::ostreambuf_iterator<char>(output));
+          auto decoded = elle::format::base64::decode(str);
+          if (buffer.empty())
+            buffer = std::move(decoded);
+          else
+            buffer.append(decoded.contents(), decoded.size());
+        }
+        catch (elle::Error const& e)
+        {
+          throw FieldError(this->current_name(), e.what());
         }
       }
 
@@ -267,7 +279,7 @@ namespace elle
         std::function<void (std::string const&)> const& f)
       {
         auto& current = *this->_current.back();
-        auto name = this->_names.empty() ? "" : this->_names.back();
+        auto const& name = this->current_name();
         if (current.is_object())
         {
           for (auto it = current.begin(); it != current.end(); ++it)
@@ -308,13 +320,12 @@ namespace elle
       {
         using elle::json::Type;
         auto& c = *this->_current.back();
-        auto name = this->_names.empty() ? "" : this->_names.back();
         if (c.type() == t ||
             t == Type::number_integer && c.type() == Type::number_unsigned)
           return c;
         else
-          throw TypeError(
-            name, elle::print("{}", t), elle::print("{}", c.type()));
+          throw TypeError(this->current_name(),
+                          elle::print("{}", t), elle::print("{}", c.type()));
       }
     }
   }
@@ -35,6 +35,11 @@ namespace elle
         /// @see elle::serialization::SerializerIn.
         SerializerIn(std::istream& input,
                      Versions versions, bool versioned = true);
+        /// Construct a SerializerIn for JSON.
+        ///
+        /// @see elle::serialization::SerializerIn.
+        SerializerIn(std::istream& input,
+                     SharedVersions versions, bool versioned = true);
         /// Construct a SerializerIn from a JSON object.
         ///
         /// @param input A json object.
@@ -34,6 +34,16 @@ namespace elle
                                    Versions versions,
                                    bool versioned,
                                    bool pretty)
+        : SerializerOut(output,
+                        std::make_shared<Versions const>(std::move(versions)),
+                        versioned,
+                        pretty)
+      {}
+
+      SerializerOut::SerializerOut(std::ostream& output,
+                                   SharedVersions versions,
+                                   bool versioned,
+                                   bool pretty)
         : Super(std::move(versions), versioned)
         , _pretty(pretty)
         , _output(output)
@@ -211,14 +221,8 @@ namespace elle
       void
       SerializerOut::_serialize(elle::Buffer& buffer)
       {
-        std::stringstream encoded;
-        {
-          elle::format::base64::Stream base64(encoded);
-          base64.write(reinterpret_cast<char*>(buffer.contents()),
-                       buffer.size());
-        }
         auto& current = this->_get_current();
-        current = encoded.str();
+        current = elle::format::base64::encode(buffer).string();
       }
 
       void
@@ -308,7 +312,7 @@ namespace elle
             ELLE_ASSERT_GT(signed(this->_current.size()), 1);
             auto& last = *this->_current[this->_current.size() - 2];
             if (last.is_object())
-              ELLE_ENFORCE(last.erase(this->_names.back()));
+              ELLE_ENFORCE(last.erase(*this->_names.back()));
           }
         }
       }
@@ -54,6 +54,15 @@ namespace elle
                       Versions versions,
                       bool versioned = true,
                       bool pretty = false);
+        /// Construct a SerializerOut for JSON.
+        ///
+        /// @see elle::serialization::SerializerOut
+        ///
+        /// @param pretty Whether the JSON should be formatted.
+        SerializerOut(std::ostream& output,
+                      SharedVersions versions,
+                      bool versioned = true,
+                      bool pretty = false);
         ~SerializerOut() noexcept(false);
 
       /*--------------.
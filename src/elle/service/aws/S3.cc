@@ -1,8 +1,11 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
+#include <elle/With.hh>
 #include <elle/cryptography/hash.hh>
+#include <elle/err.hh>
 #include <elle/finally.hh>
 #include <elle/format/base64.hh>
 #include <elle/format/hexadecimal.hh>
@@ -19,7 +22,11 @@
 #include <elle/reactor/http/exceptions.hh>
 #include <elle/reactor/http/EscapedString.hh>
 #include <elle/reactor/http/Request.hh>
+#include <elle/reactor/Scope.hh>
 #include <elle/reactor/scheduler.hh>
+#include <elle/reactor/semaphore.hh>
+#include <elle/reactor/signal.hh>
+#include <elle/reactor/Thread.hh>
 
 ELLE_LOG_COMPONENT("elle.services.aws.S3");
 
@@ -39,6 +46,26 @@ namespace elle
           std::chrono::seconds(getenv("INFINIT_S3_TIMEOUT", 500));
         auto const default_stall_timeout =
           std::chrono::seconds(getenv("INFINIT_S3_STALL_TIMEOUT", 300));
+
+        /// Whether a request failed with @a status.
+        bool
+        failed_with(AWSException const& e, http::StatusCode status)
+        {
+          if (!e.inner_exception())
+            return false;
+          try
+          {
+            std::rethrow_exception(e.inner_exception());
+          }
+          catch (RequestError const& inner)
+          {
+            return inner.http_status() == status;
+          }
+          catch (...)
+          {
+            return false;
+          }
+        }
       }
 
       // Stay as close as possible to reference java implementation from amazon
@@ -106,6 +133,8 @@ namespace elle
       S3::S3(aws::Credentials const& credentials)
         : _credentials(credentials)
         , _query_credentials()
+        , _unsigned_payload(false)
+        , _signing_keys()
       {}
 
       S3::S3(QueryCredentials query_credentials)
@@ -161,7 +190,8 @@ namespace elle
           "binary/octet-stream",
           object,
           {},
-          progress_callback);
+          progress_callback,
+          true);
         auto const& response = request->headers();
         auto etag = response.find("ETag");
         if (etag == response.end())
@@ -223,6 +253,15 @@ namespace elle
       elle::Buffer
       S3::get_object(std::string const& object_name,
                      RequestHeaders headers)
+      {
+        return this->_get_object(object_name, headers, nullptr);
+      }
+
+      elle::Buffer
+      S3::_get_object(std::string const& object_name,
+                      RequestHeaders const& headers,
+                      FileSize* total,
+                      std::string* etag)
       {
         ELLE_TRACE_SCOPE("%s: GET remote object", *this);
 
@@ -237,10 +276,14 @@ namespace elle
                                     RequestQuery(),
                                     headers);
         auto response = request->response();
-        std::string calcd_md5(this->_md5_digest(response));
-        if (request->headers().find("Etag") != request->headers().end())
+        auto const& response_headers = request->headers();
+        // A ranged GET is answered with the ETag of the whole object.
+        auto const range = response_headers.find("Content-Range");
+        if (range == response_headers.end() &&
+            response_headers.find("ETag") != response_headers.end())
         {
-          std::string aws_md5(request->headers().at("ETag"));
+          std::string calcd_md5(this->_md5_digest(response));
+          std::string aws_md5(response_headers.at("ETag"));
           // Remove quotes around MD5 sum from AWS.
           aws_md5 = aws_md5.substr(1, aws_md5.size() - 2);
           // AWS sends as ETAG for ranged get FULLMD5-CHUNK, we cannot validate
@@ -252,9 +295,210 @@ namespace elle
         }
         else
           ELLE_DUMP("server did not include ETag");
+        if (etag)
+        {
+          auto const it = response_headers.find("ETag");
+          *etag = it == response_headers.end() ? "" : it->second;
+        }
+        if (total)
+        {
+          // Content-Range: bytes <first>-<last>/<total>.
+          *total = response.size();
+          if (range != response_headers.end())
+          {
+            auto const slash = range->second.rfind('/');
+            if (slash != std::string::npos)
+              try
+              {
+                *total = boost::lexical_cast<FileSize>(
+                  range->second.substr(slash + 1));
+              }
+              catch (boost::bad_lexical_cast const&)
+              {
+                ELLE_WARN("%s: invalid Content-Range: %s",
+                          *this, range->second);
+              }
+          }
+        }
         return response;
       }
 
+      S3::FileSize
+      S3::upload_stream(std::istream& input,
+                        std::string const& object_name,
+                        int parallelism,
+                        FileSize part_size,
+                        StorageClass storage_class)
+      {
+        ELLE_TRACE_SCOPE("%s: upload stream to %s with %s parts in flight",
+                         *this, object_name, parallelism);
+        auto const upload_key = this->multipart_initialize(
+          object_name, "binary/octet-stream", storage_class);
+        auto chunks = std::vector<MultiPartChunk>{};
+        auto total = FileSize(0);
+        // Abort on every exit but success, cancellation included, lest the
+        // parts uploaded so far be kept, and billed, by S3.
+        elle::SafeFinally abort([&]
+          {
+            ELLE_WARN("%s: abort upload of %s", *this, object_name);
+            elle::With<elle::reactor::Thread::NonInterruptible>() << [&]
+            {
+              try
+              {
+                this->multipart_abort(object_name, upload_key);
+              }
+              catch (...)
+              {
+                ELLE_WARN("%s: unable to abort upload of %s: %s",
+                          *this, object_name, elle::exception_string());
+              }
+            };
+          });
+        auto slots = elle::reactor::Semaphore(parallelism);
+        elle::With<elle::reactor::Scope>() <<
+          [&] (elle::reactor::Scope& scope)
+          {
+            // Parts are started from this thread, not from a job of the
+            // scope: the scope reports a failed job to the thread that
+            // started it, which must not be one it terminates.
+            for (int index = 0; ; ++index)
+            {
+              while (!slots.acquire())
+                elle::reactor::wait(slots);
+              auto part = std::make_shared<elle::Buffer>(part_size);
+              input.read(reinterpret_cast<char*>(part->mutable_contents()),
+                         part_size);
+              part->size(input.gcount());
+              // An empty object still needs one part.
+              if (part->size() == 0 && index > 0)
+              {
+                slots.release();
+                break;
+              }
+              total += part->size();
+              chunks.emplace_back(index, "");
+              ELLE_DEBUG("%s: upload part %s of %s bytes",
+                         *this, index, part->size());
+              scope.run_background(
+                elle::print("part %s", index),
+                [&, index, part]
+                {
+                  elle::SafeFinally release([&] { slots.release(); });
+                  auto etag = this->multipart_upload(
+                    object_name, upload_key, *part, index);
+                  chunks[index].second = std::move(etag);
+                });
+              if (part->size() < part_size)
+                break;
+            }
+            elle::reactor::wait(scope);
+          };
+        this->multipart_finalize(object_name, upload_key, chunks);
+        abort.abort();
+        return total;
+      }
+
+      S3::FileSize
+      S3::download_to(std::string const& object_name,
+                      std::ostream& output,
+                      int parallelism,
+                      FileSize part_size)
+      {
+        ELLE_TRACE_SCOPE("%s: download %s with %s parts in flight",
+                         *this, object_name, parallelism);
+        // The ETag of the object the first part came from.
+        auto etag = std::string();
+        auto range = [&] (FileSize index, FileSize size)
+          {
+            auto const offset = index * part_size;
+            auto res = RequestHeaders{
+              {"Range", elle::print("bytes=%s-%s",
+                                    offset,
+                                    offset + std::min(part_size, size - offset)
+                                    - 1)},
+            };
+            if (!etag.empty())
+              res["If-Match"] = etag;
+            return res;
+          };
+        auto write = [&] (elle::Buffer const& part)
+          {
+            output.write(reinterpret_cast<char const*>(part.contents()),
+                         part.size());
+            if (!output)
+              elle::err("%s: unable to write %s", *this, object_name);
+          };
+        // The first part tells the object size.
+        auto total = FileSize(0);
+        try
+        {
+          write(this->_get_object(
+                  object_name,
+                  {{"Range", elle::print("bytes=0-%s", part_size - 1)}},
+                  &total, &etag));
+        }
+        catch (AWSException const& e)
+        {
+          // No range of an empty object is satisfiable.
+          if (!failed_with(e,
+                           http::StatusCode::Requested_Range_Not_Satisfiable))
+            throw;
+          ELLE_DEBUG("%s: %s is empty", *this, object_name);
+          return 0;
+        }
+        auto const parts = (total + part_size - 1) / part_size;
+        // Parts fetched but not written yet, and the next one to write.
+        auto fetched = std::unordered_map<FileSize, elle::Buffer>{};
+        auto next = FileSize(1);
+        auto writing = false;
+        auto written = elle::reactor::Signal{};
+        elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+        {
+          // Parts are started from this thread, as in upload_stream.
+          for (auto index = FileSize(1); index < parts; ++index)
+          {
+            // Bound parts being fetched or waiting to be written.
+            while (index >= next + parallelism)
+              elle::reactor::wait(written);
+            scope.run_background(
+              elle::print("part %s", index),
+              [&, index]
+              {
+                try
+                {
+                  fetched.emplace(
+                    index,
+                    this->_get_object(object_name, range(index, total),
+                                      nullptr));
+                }
+                catch (AWSException const& e)
+                {
+                  if (!failed_with(e, http::StatusCode::Precondition_Failed))
+                    throw;
+                  elle::err("%s: %s was overwritten while downloading it",
+                            *this, object_name);
+                }
+                // Only one thread writes, in order, as writing may yield.
+                if (writing)
+                  return;
+                writing = true;
+                elle::SafeFinally done([&] { writing = false; });
+                for (auto it = fetched.find(next);
+                     it != fetched.end();
+                     it = fetched.find(next))
+                {
+                  auto part = std::move(it->second);
+                  fetched.erase(it);
+                  write(part);
+                  ++next;
+                  written.signal();
+                }
+              });
+          }
+          elle::reactor::wait(scope);
+        };
+        return total;
+      }
 
       void
       S3::delete_folder()
@@ -279,12 +523,6 @@ namespace elle
           xml += "</Delete>";
           elle::ConstWeakBuffer payload(xml);
           // build the request
-          RequestHeaders headers;
-          auto hashed =
-            elle::cryptography::hash(
-              payload,
-              elle::cryptography::Oneway::md5);
-          headers["Content-MD5"] = elle::format::base64::encode(hashed).string();
           RequestQuery query;
           query["delete"] = "";
 
@@ -293,9 +531,12 @@ namespace elle
                                     "delete_folder",
                                     http::Method::POST,
                                     query,
-                                    headers,
+                                    RequestHeaders(),
                                     "text/xml",
-                                    payload);
+                                    payload,
+                                    {},
+                                    {},
+                                    true);
         }
         delete_object(this->_credentials.folder());
       }
@@ -500,16 +741,6 @@ namespace elle
         return elle::format::hexadecimal::encode(hashed);
       }
 
-      std::string
-      S3::_sha256_hexdigest(elle::ConstWeakBuffer const& buffer)
-      {
-        auto hashed =
-          elle::cryptography::hash(
-            buffer,
-            elle::cryptography::Oneway::sha256);
-        return elle::format::hexadecimal::encode(hashed);
-      }
-
       std::string
       S3::_amz_date(RequestTime const& request_time)
       {
@@ -584,10 +815,11 @@ namespace elle
             request_time, canonical_request.sha256_hash()));
         // Make Authorization header.
         // http://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
-        aws::SigningKey key(this->_credentials.secret_access_key(),
-                            request_time,
-                            _credentials.region(),
-                            Service::s3);
+        auto const& key = this->_signing_keys(
+          this->_credentials.secret_access_key(),
+          request_time,
+          this->_credentials.region(),
+          Service::s3);
         // Make authentication string.
         // Order matters for services like minio.
         // Add credential string.
@@ -772,7 +1004,8 @@ namespace
         std::string const& content_type,
         elle::ConstWeakBuffer const& payload,
         DurationOpt timeout_opt,
-        boost::optional<std::function<void (int)>> const& progress_callback
+        boost::optional<std::function<void (int)>> const& progress_callback,
+        bool content_md5
         )
       {
         auto const timeout
@@ -784,6 +1017,28 @@ namespace
         static int max_attempts = elle::os::getenv("INFINIT_S3_MAX_ATTEMPTS", 0);
         // If we receive a temporary redirect, we need to use a different host.
         auto override_host = boost::optional<std::string>{};
+        // Digest the payload once for all attempts, in a single pass if both
+        // digests are needed.
+        auto payload_sha256 = std::string("UNSIGNED-PAYLOAD");
+        auto payload_md5 = std::string{};
+        {
+          using elle::cryptography::Oneway;
+          auto oneways = std::vector<Oneway>{};
+          if (!this->_unsigned_payload)
+            oneways.push_back(Oneway::sha256);
+          if (content_md5)
+            oneways.push_back(Oneway::md5);
+          if (!oneways.empty())
+          {
+            auto const digests = elle::cryptography::hash(payload, oneways);
+            if (!this->_unsigned_payload)
+              payload_sha256 =
+                elle::format::hexadecimal::encode(digests.front());
+            if (content_md5)
+              payload_md5 =
+                elle::format::base64::encode(digests.back()).string();
+          }
+        }
         while (true)
         {
           URL const hostname(this->hostname(this->_credentials, override_host));
@@ -797,7 +1052,9 @@ namespace
           request_time -= this->_credentials.skew();
           RequestHeaders headers(extra_headers);
           headers["x-amz-date"] = this->_amz_date(request_time);
-          headers["x-amz-content-sha256"] = this->_sha256_hexdigest(payload);
+          headers["x-amz-content-sha256"] = payload_sha256;
+          if (content_md5)
+            headers["Content-MD5"] = payload_md5;
           if (this->_credentials.session_token())
           {
             headers["x-amz-security-token"] =
@@ -815,7 +1072,7 @@ namespace
           // http://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
           CanonicalRequest canonical_request(
             method, uri_encode(canonical_uri, false), query, headers,
-            this->_signed_headers(headers), this->_sha256_hexdigest(payload)
+            this->_signed_headers(headers), payload_sha256
           );
           http::Request::Configuration cfg(this->_initialize_request(
             kind, request_time, canonical_request, headers, timeout));
@@ -11,6 +11,7 @@
 #include <elle/service/aws/CanonicalRequest.hh>
 #include <elle/service/aws/Credentials.hh>
 #include <elle/service/aws/Exceptions.hh>
+#include <elle/service/aws/SigningKey.hh>
 #include <elle/service/aws/StringToSign.hh>
 
 namespace elle
@@ -152,6 +153,38 @@ namespace elle
         multipart_list(std::string const& object_name,
                        std::string const& upload_key);
 
+        /// Upload a stream as a multipart object.
+        ///
+        /// The stream is cut in parts of @a part_size bytes, up to
+        /// @a parallelism of which are uploaded concurrently, which bounds
+        /// memory usage to as many parts. Each part is retried like any other
+        /// request (see on_error); if one fails for good, the upload is
+        /// aborted. S3 requires parts of at least 5 MiB, except the last one.
+        ///
+        /// @return The number of bytes uploaded.
+        FileSize
+        upload_stream(std::istream& input,
+                      std::string const& object_name,
+                      int parallelism = 4,
+                      FileSize part_size = 8 * 1024 * 1024,
+                      StorageClass storage_class = StorageClass::Default);
+
+        /// Download an object to a stream.
+        ///
+        /// The object is fetched with ranged GETs of @a part_size bytes, up to
+        /// @a parallelism at a time, and written in order. At most
+        /// @a parallelism parts are held in memory. Parts are only accepted from
+        /// the version of the object the first one came from: if the object
+        /// is overwritten meanwhile, the download fails rather than mixing
+        /// versions.
+        ///
+        /// @return The object size.
+        FileSize
+        download_to(std::string const& object_name,
+                    std::ostream& output,
+                    int parallelism = 4,
+                    FileSize part_size = 8 * 1024 * 1024);
+
         /*-----------.
         | Attributes |
         `-----------*/
@@ -164,6 +197,13 @@ namespace elle
                  boost::optional<std::string> override_host = {}) const;
         ELLE_ATTRIBUTE(Credentials, credentials);
         ELLE_ATTRIBUTE(QueryCredentials, query_credentials);
+        /// Whether to skip payload hashing, sending UNSIGNED-PAYLOAD instead.
+        ///
+        /// This saves a pass over every uploaded buffer. Integrity of uploads
+        /// is still checked by S3 through Content-MD5, and the transport
+        /// through TLS.
+        ELLE_ATTRIBUTE_RW(bool, unsigned_payload);
+        ELLE_ATTRIBUTE(SigningKeyCache, signing_keys);
 
         /*--------.
         | Helpers |
@@ -178,9 +218,6 @@ namespace elle
         std::string
         _md5_digest(elle::ConstWeakBuffer const& buffer);
 
-        std::string
-        _sha256_hexdigest(elle::ConstWeakBuffer const& buffer);
-
         std::string
         _amz_date(RequestTime const& request_time);
 
@@ -194,6 +231,17 @@ namespace elle
         List
         _parse_list_xml(std::istream& stream);
 
+        /// Fetch an object, or a range of it.
+        ///
+        /// @param total If not null, set to the size of the whole object.
+        /// @param etag  If not null, set to the ETag of the whole object, if
+        ///              any.
+        elle::Buffer
+        _get_object(std::string const& object_name,
+                    RequestHeaders const& headers,
+                    FileSize* total,
+                    std::string* etag = nullptr);
+
         elle::reactor::http::Request::Configuration
         _initialize_request(RequestKind kind,
                             RequestTime request_time,
@@ -221,7 +269,8 @@ namespace elle
           std::string const& content_type = "application/json",
           elle::ConstWeakBuffer const& payload = elle::ConstWeakBuffer(),
           DurationOpt timeout = {},
-          boost::optional<ProgressCallback> const& progress_callback = {});
+          boost::optional<ProgressCallback> const& progress_callback = {},
+          bool content_md5 = false);
 
         /*----------.
         | Printable |
@@ -49,7 +49,7 @@ namespace elle
       {}
 
       std::string
-      SigningKey::sign_message(std::string const& message)
+      SigningKey::sign_message(std::string const& message) const
       {
         elle::Buffer digest = _aws_hmac(message, this->_key);
         return elle::format::hexadecimal::encode(digest);
@@ -61,6 +61,37 @@ namespace elle
         stream << "AWS signing key hex digest: "
                << elle::format::hexadecimal::encode(this->_key);
       }
+
+      SigningKeyCache::SigningKeyCache()
+        : _derivations(0)
+        , _date()
+        , _keys()
+      {}
+
+      SigningKey const&
+      SigningKeyCache::operator ()(std::string const& aws_secret,
+                                   RequestTime const& request_time,
+                                   std::string const& aws_region,
+                                   Service const& aws_service)
+      {
+        auto date = date::format("%Y%m%d", request_time);
+        if (date != this->_date)
+        {
+          this->_keys.clear();
+          this->_date = std::move(date);
+        }
+        // Credentials may be refreshed, hence the secret in the key.
+        auto scope = Scope(aws_secret, aws_region, aws_service);
+        auto it = this->_keys.find(scope);
+        if (it == this->_keys.end())
+        {
+          ++this->_derivations;
+          it = this->_keys.emplace(
+            std::move(scope),
+            SigningKey(aws_secret, request_time, aws_region, aws_service)).first;
+        }
+        return it->second;
+      }
     }
   }
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <map>
 #include <string>
+#include <tuple>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -29,7 +31,7 @@ namespace elle
                    Service const& aws_service);
 
         std::string
-        sign_message(std::string const& message);
+        sign_message(std::string const& message) const;
 
         ELLE_ATTRIBUTE_R(elle::Buffer, key);
 
@@ -41,6 +43,28 @@ namespace elle
         void
         print(std::ostream& stream) const;
       };
+
+      /// Signing keys derived once per day, region and service.
+      ///
+      /// Deriving a key takes four HMACs, while it only changes daily. Keys
+      /// of previous days are dropped on rollover.
+      class SigningKeyCache
+      {
+      public:
+        SigningKeyCache();
+        /// The signing key for the given parameters, derived if needed.
+        SigningKey const&
+        operator ()(std::string const& aws_secret,
+                    RequestTime const& request_time,
+                    std::string const& aws_region,
+                    Service const& aws_service);
+        /// Number of keys derived so far.
+        ELLE_ATTRIBUTE_R(int, derivations);
+      private:
+        using Scope = std::tuple<std::string, std::string, Service>;
+        ELLE_ATTRIBUTE(std::string, date);
+        ELLE_ATTRIBUTE((std::map<Scope, SigningKey>), keys);
+      };
     }
   }
 }
@@ -1,9 +1,13 @@
 #include <iostream>
 #include <sstream>
 
+#define ELLE_TEST_COUNT_ALLOCATIONS
 #include <elle/test.hh>
 
 #include <elle/Buffer.hh>
+#include <elle/IOStream.hh>
+#include <elle/bench.hh>
+#include <elle/print.hh>
 
 static
 void
@@ -196,10 +200,85 @@ test_capacity()
   BOOST_CHECK_GE(b.capacity(), 256);
 
   auto prev = b.capacity();
-  b.size(8);
+  b.size(48);
   BOOST_TEST(b.capacity() == prev);
   b.shrink_to_fit();
-  BOOST_TEST(b.capacity() == 8);
+  BOOST_TEST(b.capacity() == 48);
+  b.size(8);
+  b.shrink_to_fit();
+  BOOST_TEST(b.capacity() == elle::Buffer::inline_size);
+}
+
+static
+void
+test_inline()
+{
+  auto const data = std::string("0123456789abcdefghijklmnopqrstuvwxyz");
+  auto b = elle::Buffer(data.data(), 10);
+  BOOST_TEST(b.capacity() == elle::Buffer::inline_size);
+  auto moved = elle::Buffer(std::move(b));
+  BOOST_TEST(moved == data.substr(0, 10));
+  BOOST_TEST(moved.capacity() == elle::Buffer::inline_size);
+  // Grow out of the inline storage and back.
+  moved.append(data.data() + 10, data.size() - 10);
+  BOOST_TEST(moved == data);
+  BOOST_CHECK_GT(moved.capacity(), elle::Buffer::inline_size);
+  moved.size(4);
+  moved.shrink_to_fit();
+  BOOST_TEST(moved == data.substr(0, 4));
+  BOOST_TEST(moved.capacity() == elle::Buffer::inline_size);
+  {
+    auto copy = moved;
+    auto assigned = elle::Buffer(1024);
+    assigned = std::move(copy);
+    BOOST_TEST(assigned == data.substr(0, 4));
+  }
+  auto released = moved.release();
+  BOOST_TEST(released.second == 4);
+  BOOST_TEST(
+    elle::ConstWeakBuffer(released.first.get(), 4) == data.substr(0, 4));
+#ifdef ELLE_TEST_ALLOCATIONS
+  auto const before = allocations.load();
+  {
+    auto empty = elle::Buffer{};
+    auto small = elle::Buffer(data.data(), elle::Buffer::inline_size);
+    auto copy = small;
+    auto moved = std::move(copy);
+    moved.append("", 0);
+  }
+  BOOST_TEST(allocations.load() == before);
+#endif
+}
+
+// Moving a buffer keeps views of its heap content valid, but not views of
+// its inline storage, which is copied into the destination.
+static
+void
+test_inline_move()
+{
+  // The inline storage fits a SHA-256 digest and keeps a Buffer within a
+  // cache line.
+  BOOST_TEST(sizeof(elle::Buffer) <= 64u);
+  auto const data = std::string(elle::Buffer::inline_size + 1, 'x');
+  {
+    auto large = elle::Buffer(data);
+    auto const view = elle::ConstWeakBuffer(large);
+    auto moved = std::move(large);
+    BOOST_TEST(moved.contents() == view.contents());
+    BOOST_TEST(view == data);
+  }
+  {
+    auto small = elle::Buffer(data.data(), elle::Buffer::inline_size);
+    auto const contents = small.contents();
+    auto moved = std::move(small);
+    BOOST_TEST(moved.contents() != contents);
+    BOOST_TEST(moved == data.substr(0, elle::Buffer::inline_size));
+    // Moving into a SharedBuffer keeps it valid, as it reads the contents
+    // after the move.
+    auto shared = elle::SharedBuffer(std::move(moved));
+    BOOST_TEST(elle::ConstWeakBuffer(shared) ==
+               data.substr(0, elle::Buffer::inline_size));
+  }
 }
 
 static
@@ -226,6 +305,61 @@ test_assign()
   BOOST_TEST(b2.size() == 0);
 }
 
+static
+void
+shared()
+{
+  auto const data = std::string(1024, 'x') + "0123456789";
+  auto b = elle::Buffer(data);
+  auto const contents = b.contents();
+  auto s = elle::SharedBuffer(std::move(b));
+  BOOST_TEST(s.contents() == contents);
+  BOOST_TEST(s == data);
+  BOOST_TEST(s.use_count() == 1);
+  // Ranges share the memory.
+  auto r = s.range(1024);
+  BOOST_TEST(r.contents() == contents + 1024);
+  BOOST_TEST(r == "0123456789");
+  BOOST_TEST(r.range(1, 6) == "12345");
+  BOOST_TEST(r.range(5, -1) == "5678");
+  BOOST_TEST(r.range(-5, -3) == "56");
+  BOOST_TEST(s.use_count() == 2);
+  {
+    auto copy = r;
+    BOOST_TEST(copy == r);
+    BOOST_TEST(s.use_count() == 3);
+  }
+  auto moved = std::move(r);
+  BOOST_TEST(r.empty());
+  BOOST_TEST(moved == "0123456789");
+  BOOST_TEST(s.use_count() == 2);
+  BOOST_TEST(elle::ConstWeakBuffer(moved).contents() == contents + 1024);
+  BOOST_TEST(std::hash<elle::SharedBuffer>()(moved)
+             == std::hash<elle::ConstWeakBuffer>()("0123456789"));
+  BOOST_CHECK_LT(moved.range(0, 2), moved.range(1, 3));
+  // Small and copied buffers.
+  BOOST_TEST(elle::SharedBuffer(elle::Buffer("foo")) == "foo");
+  BOOST_TEST(elle::SharedBuffer(elle::ConstWeakBuffer("bar")) == "bar");
+  BOOST_TEST(elle::SharedBuffer().empty());
+  {
+    auto in = elle::SharedBuffer(elle::Buffer("10 11", 5));
+    elle::IOStream stream(in.istreambuf());
+    int x, y;
+    stream >> x >> y;
+    BOOST_TEST(x == 10);
+    BOOST_TEST(y == 11);
+  }
+#ifdef ELLE_TEST_ALLOCATIONS
+  auto const before = allocations.load();
+  {
+    auto copy = s;
+    auto range = copy.range(10, 20).range(2);
+    auto moved = std::move(range);
+  }
+  BOOST_TEST(allocations.load() == before);
+#endif
+}
+
 static
 void
 delete_noop(elle::Buffer::Byte*)
@@ -330,6 +464,60 @@ output()
   BOOST_TEST(buffer == "42");
 }
 
+static
+void
+output_large()
+{
+  auto payload = std::string(100000, 'x');
+  for (auto i = 0u; i < payload.size(); ++i)
+    payload[i] = 'a' + i % 26;
+  for (auto expected: {0, 16, 300000})
+  {
+    auto buffer = elle::Buffer("header", 6);
+    {
+      elle::IOStream stream(buffer.ostreambuf(expected));
+      // Small writes go through the put area, large ones directly to the
+      // buffer: their order must be preserved.
+      stream << 'A';
+      stream.write(payload.data(), payload.size());
+      stream << 'B';
+      stream.write(payload.data(), 1000);
+      stream.write(payload.data(), payload.size());
+      stream << 'C';
+    }
+    auto const expected_content =
+      "header" + ("A" + payload) + ("B" + payload.substr(0, 1000))
+      + payload + "C";
+    BOOST_TEST(buffer.string() == expected_content);
+    if (expected)
+      BOOST_TEST(buffer.capacity() >= 6u + expected);
+  }
+}
+
+static
+void
+output_benchmark()
+{
+  auto const chunk = std::string(8, 'x');
+  for (auto size = elle::Buffer::Size(1024);
+       size <= 64 * 1024 * 1024;
+       size *= 8)
+    for (auto hint: {false, true})
+    {
+      auto bench = elle::Bench<>(elle::print(
+        "bench.buffer.output.{}{}", size, hint ? ".hinted" : ""));
+      auto buffer = elle::Buffer{};
+      {
+        auto const s = bench.scoped();
+        elle::IOStream stream(
+          hint ? buffer.ostreambuf(size) : buffer.ostreambuf());
+        for (auto written = 0u; written < size; written += chunk.size())
+          stream.write(chunk.data(), chunk.size());
+      }
+      BOOST_TEST(buffer.size() == size);
+    }
+}
+
 static
 void
 input()
@@ -387,10 +575,14 @@ ELLE_TEST_SUITE()
   memory->add(BOOST_TEST_CASE(test_capacity));
   memory->add(BOOST_TEST_CASE(test_release));
   memory->add(BOOST_TEST_CASE(test_assign));
+  memory->add(BOOST_TEST_CASE(test_inline));
+  memory->add(BOOST_TEST_CASE(test_inline_move));
 
   boost::unit_test::test_suite* streams = BOOST_TEST_SUITE("streams");
   buffer->add(streams);
   streams->add(BOOST_TEST_CASE(output));
+  streams->add(BOOST_TEST_CASE(output_large));
+  streams->add(BOOST_TEST_CASE(output_benchmark), 0, 60);
   streams->add(BOOST_TEST_CASE(input));
 
   // WeakBuffer
@@ -419,4 +611,10 @@ ELLE_TEST_SUITE()
 
   master.add(BOOST_TEST_CASE(hash), 0, 1);
   master.add(BOOST_TEST_CASE(range), 0, 1);
+
+  // SharedBuffer
+  boost::unit_test::test_suite* sharedbuffer =
+    BOOST_TEST_SUITE("SharedBuffer");
+  master.add(sharedbuffer);
+  sharedbuffer->add(BOOST_TEST_CASE(shared));
 }
@@ -0,0 +1,247 @@
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <thread>
+
+#include <unistd.h>
+
+#define ELLE_TEST_COUNT_ALLOCATIONS
+#include <elle/test.hh>
+
+#include <elle/BufferPool.hh>
+#include <elle/bench.hh>
+#include <elle/log.hh>
+#include <elle/print.hh>
+
+ELLE_LOG_COMPONENT("elle.BufferPool.test");
+
+static
+void
+classes()
+{
+  BOOST_TEST(elle::BufferPool::class_size(33) == 512u);
+  BOOST_TEST(elle::BufferPool::class_size(512) == 512u);
+  BOOST_TEST(elle::BufferPool::class_size(513) == 768u);
+  BOOST_TEST(elle::BufferPool::class_size(20000) == 24576u);
+  BOOST_TEST(elle::BufferPool::class_size(135168) == 196608u);
+  BOOST_TEST(elle::BufferPool::class_size(4 * 1024 * 1024) == 4194304u);
+  BOOST_TEST(elle::BufferPool::class_size(4 * 1024 * 1024 + 1) == 0u);
+}
+
+static
+void
+reuse()
+{
+  auto& pool = elle::BufferPool::local();
+  pool.trim();
+  auto const hits = pool.hits();
+  auto const misses = pool.misses();
+  elle::Buffer::Byte const* contents = nullptr;
+  {
+    auto b = elle::Buffer(20000, pool);
+    BOOST_TEST(b.size() == 20000u);
+    BOOST_TEST(b.capacity() == 24576u);
+    contents = b.contents();
+  }
+  BOOST_TEST(pool.misses() == misses + 1);
+  BOOST_TEST(pool.cached() == 24576u);
+  {
+    // Same class, same block.
+    auto b = elle::Buffer(17000, pool);
+    BOOST_TEST(b.contents() == contents);
+    BOOST_TEST(pool.hits() == hits + 1);
+    BOOST_TEST(pool.cached() == 0u);
+    // Moving keeps the memory pooled.
+    auto moved = std::move(b);
+    BOOST_TEST(moved.contents() == contents);
+  }
+  BOOST_TEST(pool.cached() == 24576u);
+  {
+    // Small buffers are inline, huge ones are not pooled.
+    auto small = elle::Buffer(8, pool);
+    auto huge = elle::Buffer(8 * 1024 * 1024, pool);
+  }
+  BOOST_TEST(pool.cached() == 24576u);
+  {
+    // Released memory belongs to the caller.
+    auto b = elle::Buffer(20000, pool);
+    auto released = b.release();
+    BOOST_TEST(released.first.get() == contents);
+  }
+  BOOST_TEST(pool.cached() == 0u);
+}
+
+static
+void
+grow()
+{
+  auto& pool = elle::BufferPool::local();
+  pool.trim();
+  {
+    auto b = elle::Buffer(1000, pool);
+    b.size(3000);
+    BOOST_TEST(b.capacity() != elle::BufferPool::class_size(3000));
+  }
+  // Memory that left its class is freed.
+  BOOST_TEST(pool.cached() == 0u);
+}
+
+static
+void
+high_water()
+{
+  auto& pool = elle::BufferPool::local();
+  pool.trim();
+  pool.high_water(2048);
+  {
+    auto b1 = elle::Buffer(1024, pool);
+    auto b2 = elle::Buffer(1024, pool);
+    auto b3 = elle::Buffer(1024, pool);
+  }
+  BOOST_TEST(pool.cached() == 2048u);
+  pool.high_water(64 * 1024 * 1024);
+  {
+    auto b1 = elle::Buffer(1024, pool);
+    auto b2 = elle::Buffer(4096, pool);
+  }
+  BOOST_TEST(pool.cached() == 6144u);
+  pool.trim(1024);
+  BOOST_TEST(pool.cached() == 1024u);
+  pool.trim();
+  BOOST_TEST(pool.cached() == 0u);
+}
+
+static
+void
+threads()
+{
+  auto& pool = elle::BufferPool::local();
+  pool.trim();
+  auto b = elle::Buffer(1024, pool);
+  auto distinct = false;
+  auto cached = elle::Buffer::Size(0);
+  auto hits = std::size_t(0);
+  std::thread t(
+    [&]
+    {
+      auto& background = elle::BufferPool::local();
+      distinct = &background != &pool;
+      {
+        // Memory is given back to the destroying thread's pool.
+        auto moved = std::move(b);
+      }
+      cached = background.cached();
+      auto reused = elle::Buffer(1024, background);
+      hits = background.hits();
+    });
+  t.join();
+  BOOST_TEST(distinct);
+  BOOST_TEST(cached == 1024u);
+  BOOST_TEST(hits == 1u);
+  BOOST_TEST(pool.cached() == 0u);
+}
+
+/// Allocations and time to allocate, fill and free @a count buffers of
+/// @a size bytes.
+static
+void
+_benchmark(elle::Buffer::Size size, bool pooled)
+{
+  auto const count = 10000;
+  auto const name =
+    elle::print("bench.buffer_pool.{}{}", size, pooled ? ".pooled" : "");
+  auto bench = elle::Bench<>(name);
+#ifdef ELLE_TEST_ALLOCATIONS
+  auto allocs = elle::Bench<double>(name + ".allocations");
+  auto const before = allocations.load();
+#endif
+  auto const start = elle::Clock::now();
+  for (int i = 0; i < count; ++i)
+  {
+    auto b = pooled
+      ? elle::Buffer(size, elle::BufferPool::local())
+      : elle::Buffer(size);
+    b.mutable_contents()[size - 1] = i;
+  }
+  // Time the whole loop: a timer per buffer would cost as much as the
+  // allocation it measures.
+  bench.add((elle::Clock::now() - start) / count);
+#ifdef ELLE_TEST_ALLOCATIONS
+  allocs.add(double(allocations.load() - before) / count);
+#endif
+}
+
+static
+void
+benchmark()
+{
+  for (auto size: {1500, 20000, 135168})
+    for (auto pooled: {false, true})
+      _benchmark(size, pooled);
+}
+
+/// Resident set size in bytes, 0 if unknown.
+static
+std::size_t
+rss()
+{
+  auto statm = std::ifstream("/proc/self/statm");
+  auto size = std::size_t(0);
+  auto resident = std::size_t(0);
+  if (statm >> size >> resident)
+    return resident * sysconf(_SC_PAGESIZE);
+  return 0;
+}
+
+/// Mimic FuseContext::_loop_pool: receive requests in fuse_chan_bufsize
+/// buffers, keep a few queued for workers and reply with read payloads.
+static
+void
+fuse_rss()
+{
+  auto const buffer_size = elle::Buffer::Size(135168);
+  for (auto pooled: {false, true})
+  {
+    auto const before = rss();
+    auto bench = elle::Bench<>(
+      elle::print("bench.buffer_pool.fuse{}", pooled ? ".pooled" : ""));
+    auto const scope = bench.scoped();
+    auto requests = std::deque<elle::Buffer>{};
+    for (int i = 0; i < 20000; ++i)
+    {
+      auto request = pooled
+        ? elle::Buffer(buffer_size, elle::BufferPool::local())
+        : elle::Buffer(buffer_size);
+      // Most requests are small, read payloads are up to 128 KiB.
+      request.size(80);
+      requests.push_back(std::move(request));
+      auto reply = pooled
+        ? elle::Buffer(4096 * (1 + i % 32), elle::BufferPool::local())
+        : elle::Buffer(4096 * (1 + i % 32));
+      memset(reply.mutable_contents(), i, reply.size());
+      if (requests.size() > 16)
+        requests.pop_front();
+    }
+    requests.clear();
+    ELLE_LOG("FUSE reads%s: RSS grew by %s KiB",
+             pooled ? " (pooled)" : "",
+             (signed(rss()) - signed(before)) / 1024);
+  }
+  auto& pool = elle::BufferPool::local();
+  ELLE_LOG("pool: %s hits, %s misses, %s bytes cached",
+           pool.hits(), pool.misses(), pool.cached());
+  BOOST_CHECK_GT(pool.hits(), pool.misses());
+  pool.trim();
+}
+
+ELLE_TEST_SUITE()
+{
+  auto& suite = boost::unit_test::framework::master_test_suite();
+  suite.add(BOOST_TEST_CASE(classes));
+  suite.add(BOOST_TEST_CASE(reuse));
+  suite.add(BOOST_TEST_CASE(grow));
+  suite.add(BOOST_TEST_CASE(high_water));
+  suite.add(BOOST_TEST_CASE(threads));
+  suite.add(BOOST_TEST_CASE(benchmark), 0, 60);
+  suite.add(BOOST_TEST_CASE(fuse_rss), 0, 60);
+}
@@ -1,7 +1,14 @@
 #define ELLE_TEST_MODULE Exception
 
+#include <atomic>
+#include <thread>
+
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <elle/Error.hh>
+#include <elle/bench.hh>
+#include <elle/finally.hh>
+#include <elle/print.hh>
 #include <elle/test.hh>
 #include <elle/Exception.hh>
 
@@ -59,3 +66,193 @@ BOOST_AUTO_TEST_CASE(err)
   CHECK_THROW(elle::err("%s %s", 3), elle::Exception, "too few arguments");
   CHECK_THROW(elle::err("%s"), elle::Error, "%s");
 }
+
+namespace
+{
+  /// A control-flow error, like a closed connection.
+  class Disconnected
+    : public elle::Error
+  {
+  public:
+    Disconnected()
+      : elle::Error(elle::Backtrace::capture(typeid(Disconnected), 1),
+                    "disconnected")
+    {}
+  };
+
+  /// Throw @a T from @a depth frames down.
+  template <typename T>
+  ELLE_COMPILER_ATTRIBUTE_NO_INLINE
+  void
+  deep_throw(int depth)
+  {
+    if (depth == 0)
+      throw T();
+    deep_throw<T>(depth - 1);
+    // Prevent tail-call optimization.
+    asm volatile("");
+  }
+
+  template <typename T>
+  bool
+  captured(int depth = 0)
+  {
+    try
+    {
+      deep_throw<T>(depth);
+    }
+    catch (elle::Exception const& e)
+    {
+      return !e.backtrace().frames().empty();
+    }
+    elle::unreachable();
+  }
+
+  struct Default
+    : public elle::Exception
+  {
+    Default()
+      : elle::Exception("default")
+    {}
+  };
+
+  /// Restore the default backtrace configuration.
+  auto const restore = []
+  {
+    elle::Backtrace::policy(elle::Backtrace::Policy::always);
+    elle::Backtrace::depth(elle::Backtrace::max_depth);
+    elle::Backtrace::exclude(typeid(Disconnected), false);
+  };
+}
+
+BOOST_AUTO_TEST_CASE(policy)
+{
+  elle::SafeFinally reset(restore);
+#if ELLE_HAVE_BACKTRACE
+  BOOST_TEST(captured<Default>());
+#endif
+  elle::Backtrace::policy(elle::Backtrace::Policy::never);
+  BOOST_TEST(!captured<Default>());
+  BOOST_TEST(!captured<Disconnected>());
+  // Explicit captures are not subject to the policy.
+#if ELLE_HAVE_BACKTRACE
+  BOOST_TEST(!elle::Backtrace::current().frames().empty());
+  elle::Backtrace::policy(elle::Backtrace::Policy::sampled, 4);
+  auto count = 0;
+  for (int i = 0; i < 40; ++i)
+    if (captured<Default>())
+      ++count;
+  BOOST_TEST(count == 10);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(exclude)
+{
+  elle::SafeFinally reset(restore);
+  elle::Backtrace::exclude(typeid(Disconnected));
+  BOOST_TEST(!captured<Disconnected>());
+#if ELLE_HAVE_BACKTRACE
+  BOOST_TEST(captured<Default>());
+  elle::Backtrace::exclude(typeid(Disconnected), false);
+  BOOST_TEST(captured<Disconnected>());
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(depth)
+{
+  elle::SafeFinally reset(restore);
+  elle::Backtrace::depth(4);
+  try
+  {
+    deep_throw<Default>(16);
+  }
+  catch (elle::Exception const& e)
+  {
+    BOOST_TEST(e.backtrace().frames().size() <= 4u);
+  }
+#if ELLE_HAVE_BACKTRACE
+  // Explicit backtraces are complete.
+  BOOST_TEST(elle::Backtrace::current().frames().size() > 4u);
+#endif
+  elle::Backtrace::depth(1000);
+  BOOST_TEST(elle::Backtrace::depth() == elle::Backtrace::max_depth);
+}
+
+namespace
+{
+  /// Bench throwing and catching @a T from @a depth frames down.
+  template <typename T>
+  void
+  throw_catch(std::string const& name, int depth, int iterations)
+  {
+    auto bench = elle::Bench<>(elle::print("bench.backtrace.%s", name));
+    for (int i = 0; i < iterations; ++i)
+    {
+      auto const s = bench.scoped();
+      try
+      {
+        deep_throw<T>(depth);
+      }
+      catch (elle::Exception const&)
+      {}
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+  elle::SafeFinally reset(restore);
+  auto const iterations = 500;
+  throw_catch<Default>("always", 32, iterations);
+#if ELLE_HAVE_BACKTRACE
+  BOOST_TEST(captured<Default>(32));
+#endif
+  elle::Backtrace::policy(elle::Backtrace::Policy::sampled, 64);
+  throw_catch<Default>("sampled", 32, iterations);
+  elle::Backtrace::policy(elle::Backtrace::Policy::never);
+  throw_catch<Default>("never", 32, iterations);
+  BOOST_TEST(!captured<Default>(32));
+}
+
+/// Many threads losing their connection over and over, while the
+/// disconnections are excluded from capture.
+BOOST_AUTO_TEST_CASE(reconnect_storm)
+{
+  elle::SafeFinally reset(restore);
+  auto const storm = [] (std::string const& name)
+    {
+      auto bench =
+        elle::Bench<>(elle::print("bench.backtrace.reconnect_storm.%s", name));
+      auto const s = bench.scoped();
+      // Resolving backtraces is slow, stop looking once one was captured.
+      auto captured = std::atomic<bool>(false);
+      auto threads = std::vector<std::thread>{};
+      for (int t = 0; t < 8; ++t)
+        threads.emplace_back(
+          [&]
+          {
+            for (int i = 0; i < 200; ++i)
+              try
+              {
+                deep_throw<Disconnected>(24);
+              }
+              catch (Disconnected const& e)
+              {
+                if (!captured && !e.backtrace().frames().empty())
+                  captured = true;
+              }
+          });
+      for (auto& t: threads)
+        t.join();
+      return captured.load();
+    };
+#if ELLE_HAVE_BACKTRACE
+  BOOST_TEST(storm("capturing"));
+#endif
+  elle::Backtrace::exclude(typeid(Disconnected));
+  BOOST_TEST(!storm("excluded"));
+#if ELLE_HAVE_BACKTRACE
+  // Other errors still get their backtrace.
+  BOOST_TEST(captured<Default>());
+#endif
+}
@@ -1,14 +1,21 @@
 #include <filesystem>
 #include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
 #include <unordered_set>
 
+#include <elle/algorithm.hh>
+#include <elle/archive/archive.hh>
 #include <elle/archive/zip.hh>
 #include <elle/attribute.hh>
+#include <elle/bench.hh>
 #include <elle/filesystem.hh>
 #include <elle/filesystem/TemporaryDirectory.hh>
 #include <elle/filesystem/TemporaryFile.hh>
 #include <elle/Error.hh>
 #include <elle/os/environ.hh>
+#include <elle/print.hh>
 #include <elle/printf.hh>
 #include <elle/system/Process.hh>
 #include <elle/test.hh>
@@ -380,6 +387,174 @@ archiving_error(elle::archive::Format fmt)
   }
 }
 
+static
+std::string
+read_file(fs::path const& path)
+{
+  auto&& f = std::ifstream(path, std::ios_base::in | std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(f),
+                     std::istreambuf_iterator<char>());
+}
+
+/// Text with some entropy, spanning several compression blocks when large.
+static
+std::string
+text(std::size_t size, unsigned seed)
+{
+  auto random = std::minstd_rand(seed);
+  auto res = std::string{};
+  res.reserve(size + 16);
+  while (res.size() < size)
+  {
+    res += std::to_string(random());
+    res += random() % 8 ? ' ' : '\n';
+  }
+  res.resize(size);
+  return res;
+}
+
+/// A stream over @a data that cannot seek, like a pipe or a socket.
+class ForwardBuffer
+  : public std::streambuf
+{
+public:
+  ForwardBuffer(std::string data)
+    : _data(std::move(data))
+  {
+    this->setg(&this->_data[0], &this->_data[0], &this->_data[0]);
+  }
+
+protected:
+  int_type
+  underflow() override
+  {
+    auto const pos = this->gptr() - this->eback();
+    if (pos == std::ptrdiff_t(this->_data.size()))
+      return traits_type::eof();
+    // Hand out small chunks so reads straddle them.
+    auto const size = std::min<std::ptrdiff_t>(this->_data.size() - pos, 4096);
+    this->setg(&this->_data[0], &this->_data[pos], &this->_data[pos + size]);
+    return traits_type::to_int_type(*this->gptr());
+  }
+
+private:
+  ELLE_ATTRIBUTE(std::string, data);
+};
+
+static
+void
+archive_stream(elle::archive::Format fmt)
+{
+  auto const input = TemporaryDirectory("input");
+  auto const root = input.path() / ROOT;
+  fs::create_directories(root / SUB);
+  auto const contents = std::unordered_map<std::string, std::string>{
+    {"empty", ""},
+    {"small", "small"},
+    {"large", text(300000, 0)},
+    {SUB + "/large", text(500000, 1)},
+  };
+  for (auto const& c: contents)
+    std::ofstream(root / c.first) << c.second;
+  auto const parallel = elle::archive::Parallel{4, 1 << 20};
+  auto archive = std::stringstream{};
+  elle::archive::archive(fmt, {root}, archive, renamer_forbid, {}, false,
+                         parallel);
+  auto const check = [&] (fs::path const& output)
+    {
+      auto count = std::size_t(0);
+      for (auto p: fs::recursive_directory_iterator(output / ROOT))
+        if (!fs::is_directory(p))
+        {
+          ++count;
+          auto const name = p.path().lexically_relative(output / ROOT);
+          BOOST_TEST_CONTEXT(name)
+          {
+            BOOST_TEST_REQUIRE(elle::contains(contents, name.generic_string()));
+            BOOST_TEST(read_file(p) == contents.at(name.generic_string()));
+          }
+        }
+      BOOST_TEST(count == contents.size());
+    };
+  // From the stream.
+  {
+    auto const output = TemporaryDirectory("output");
+    auto data = std::stringstream(archive.str());
+    elle::archive::extract(data, output.path(), parallel);
+    check(output.path());
+  }
+  // From a stream that cannot seek.
+  {
+    auto const output = TemporaryDirectory("output");
+    auto buffer = ForwardBuffer(archive.str());
+    auto data = std::istream(&buffer);
+    BOOST_TEST(data.tellg() == -1);
+    elle::archive::extract(data, output.path(), parallel);
+    check(output.path());
+  }
+  // From a file, with the libarchive tools.
+  {
+    auto const path = TemporaryFile("archive");
+    std::ofstream(path.path(), std::ios_base::out | std::ios_base::binary)
+      << archive.str();
+    auto const output = TemporaryDirectory("output");
+    extract(fmt, path.path(), output.path(), true);
+    check(output.path());
+  }
+  // Sequentially, for comparison.
+  {
+    auto sequential = std::stringstream{};
+    elle::archive::archive(fmt, {root}, sequential, {}, {}, false, {1});
+    if (fmt == elle::archive::Format::zip)
+      BOOST_TEST(sequential.str() == archive.str());
+    auto const output = TemporaryDirectory("output");
+    elle::archive::extract(sequential, output.path(), {1});
+    check(output.path());
+  }
+}
+
+static
+void
+archive_benchmark()
+{
+  auto const input = TemporaryDirectory("input");
+  auto const root = input.path() / ROOT;
+  auto const dirs = RUNNING_ON_VALGRIND ? 2 : 100;
+  auto total = std::size_t(0);
+  for (int d = 0; d < dirs; ++d)
+  {
+    auto const dir = root / std::to_string(d);
+    fs::create_directories(dir);
+    for (int f = 0; f < 100; ++f)
+    {
+      auto const content = text(2048 + (d * 100 + f) % 4096, d * 100 + f);
+      std::ofstream(dir / std::to_string(f)) << content;
+      total += content.size();
+    }
+  }
+  for (auto threads: {1, 0})
+  {
+    auto const parallel = elle::archive::Parallel{threads};
+    auto const name = threads ? "sequential"s : "parallel"s;
+    auto archive = std::stringstream{};
+    {
+      auto bench = elle::Bench<>(elle::print("bench.archive.zip.{}", name));
+      auto const s = bench.scoped();
+      elle::archive::archive(
+        elle::archive::Format::zip, {root}, archive, {}, {}, false, parallel);
+    }
+    BOOST_TEST(archive.str().size() < total);
+    auto const output = TemporaryDirectory("output");
+    {
+      auto bench = elle::Bench<>(elle::print("bench.archive.unzip.{}", name));
+      auto const s = bench.scoped();
+      elle::archive::extract(archive, output.path(), parallel);
+    }
+    BOOST_TEST(read_file(output.path() / ROOT / "1" / "2") ==
+               read_file(root / "1" / "2"));
+  }
+}
+
 #define FORMAT(Fmt)                                     \
   namespace Fmt                                         \
   {                                                     \
@@ -391,6 +566,7 @@ archiving_error(elle::archive::Format fmt)
       void duplicate()    { archive_duplicate(fmt); }   \
       void symboliclink() { archive_symlink(fmt); }     \
       void error()        { archiving_error(fmt); }     \
+      void stream()       { archive_stream(fmt); }      \
     }                                                   \
   }
 
@@ -416,6 +592,7 @@ ELLE_TEST_SUITE()
     if (!musl)                                  \
       suite->add(BOOST_TEST_CASE(symboliclink));\
     suite->add(BOOST_TEST_CASE(error));         \
+    suite->add(BOOST_TEST_CASE(stream));        \
   }                                             \
 
   FORMAT(zip);
@@ -423,4 +600,6 @@ ELLE_TEST_SUITE()
   FORMAT(tar_gzip);
 
 #undef FORMAT
+
+  master.add(BOOST_TEST_CASE(archive_benchmark), 0, valgrind(120));
 }
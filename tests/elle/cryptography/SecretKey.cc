@@ -1,10 +1,13 @@
 #include "cryptography.hh"
 
+#include <elle/cryptography/Error.hh>
 #include <elle/cryptography/SecretKey.hh>
 #include <elle/cryptography/Cipher.hh>
 #include <elle/cryptography/Oneway.hh>
 #include <elle/cryptography/random.hh>
 
+#include <elle/bench.hh>
+#include <elle/print.hh>
 #include <elle/serialization/json.hh>
 
 using namespace std::literals;
@@ -227,6 +230,94 @@ test_operate()
   _test_operate_idea();
 }
 
+/*-----.
+| AEAD |
+`-----*/
+
+static
+void
+test_aead()
+{
+  using elle::cryptography::Cipher;
+  using elle::cryptography::Mode;
+  auto const key = test_generate_x<256>();
+  auto const input = elle::Buffer(_message);
+  // Buffers.
+  {
+    auto const code = key.encipher(input, Cipher::aes256, Mode::gcm);
+    BOOST_CHECK_NE(code, key.encipher(input, Cipher::aes256, Mode::gcm));
+    BOOST_CHECK_EQUAL(key.decipher(code, Cipher::aes256, Mode::gcm), input);
+    // Deciphering recognizes the format, whatever the mode.
+    BOOST_CHECK_EQUAL(key.decipher(code, Cipher::aes256), input);
+    // In place.
+    auto plain = key.decipher(
+      key.encipher(elle::Buffer(input), Cipher::aes256, Mode::gcm),
+      Cipher::aes256, Mode::gcm);
+    BOOST_CHECK_EQUAL(plain, input);
+    // Empty plain text.
+    BOOST_CHECK_EQUAL(
+      key.decipher(key.encipher(elle::Buffer(), Cipher::aes256, Mode::gcm),
+                   Cipher::aes256, Mode::gcm),
+      elle::Buffer());
+  }
+  // Streams.
+  {
+    std::stringstream plain(_message);
+    std::stringstream code;
+    key.encipher(plain, code, Cipher::aes128, Mode::gcm);
+    std::stringstream output;
+    key.decipher(code, output, Cipher::aes128, Mode::gcm);
+    BOOST_CHECK_EQUAL(output.str(), _message);
+  }
+  // Altered code, wrong key or cipher.
+  {
+    auto code = key.encipher(input, Cipher::aes256, Mode::gcm);
+    auto altered = code;
+    altered[altered.size() / 2] ^= 1;
+    BOOST_CHECK_THROW(key.decipher(altered, Cipher::aes256, Mode::gcm),
+                      elle::cryptography::Error);
+    BOOST_CHECK_THROW(
+      test_generate_x<256>().decipher(code, Cipher::aes256, Mode::gcm),
+      elle::cryptography::Error);
+    BOOST_CHECK_THROW(key.decipher(code, Cipher::aes128, Mode::gcm),
+                      elle::cryptography::Error);
+  }
+  // Code produced with the default mode remains decipherable.
+  {
+    auto const code = key.encipher(input, Cipher::aes256);
+    BOOST_CHECK_EQUAL(key.decipher(code, Cipher::aes256, Mode::gcm), input);
+  }
+  BOOST_CHECK_THROW(key.encipher(input, Cipher::blowfish, Mode::gcm),
+                    elle::cryptography::Error);
+}
+
+/// Round trips of various sizes, in both modes.
+///
+/// Timings are reported by `bench.cryptography.aead.*` benches.
+static
+void
+test_aead_sizes()
+{
+  using elle::cryptography::Cipher;
+  using elle::cryptography::Mode;
+  auto const key = test_generate_x<256>();
+  for (auto size: {1, 15, 16, 17, 4096, 1024 * 1024})
+  {
+    auto const plain = elle::cryptography::random::generate<elle::Buffer>(size);
+    for (auto mode: {Mode::cbc, Mode::gcm})
+    {
+      auto bench = elle::Bench<>(
+        elle::print("bench.cryptography.aead.%s.%s", mode, size));
+      auto code = elle::Buffer();
+      {
+        auto const s = bench.scoped();
+        code = key.encipher(plain, Cipher::aes256, mode);
+      }
+      BOOST_CHECK_EQUAL(key.decipher(code, Cipher::aes256, mode), plain);
+    }
+  }
+}
+
 /*----------.
 | Serialize |
 `----------*/
@@ -338,6 +429,8 @@ ELLE_TEST_SUITE()
   suite->add(BOOST_TEST_CASE(test_generate));
   suite->add(BOOST_TEST_CASE(test_construct));
   suite->add(BOOST_TEST_CASE(test_operate));
+  suite->add(BOOST_TEST_CASE(test_aead));
+  suite->add(BOOST_TEST_CASE(test_aead_sizes));
   suite->add(BOOST_TEST_CASE(test_serialize));
 
   boost::unit_test::framework::master_test_suite().add(suite);
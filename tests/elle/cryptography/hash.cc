@@ -157,6 +157,25 @@ test_blocks()
   test_blocks_x<elle::cryptography::Oneway::sha512>();
 }
 
+/*-------.
+| Fused |
+`-------*/
+
+static
+void
+test_fused()
+{
+  using elle::cryptography::Oneway;
+  // Larger than a block, to go through several.
+  auto const plain = elle::cryptography::random::generate<elle::Buffer>(200000);
+  auto const oneways = std::vector<Oneway>{
+    Oneway::sha256, Oneway::md5, Oneway::sha1};
+  auto const digests = elle::cryptography::hash(plain, oneways);
+  BOOST_REQUIRE_EQUAL(digests.size(), oneways.size());
+  for (auto i = 0u; i < oneways.size(); ++i)
+    BOOST_CHECK_EQUAL(digests[i], elle::cryptography::hash(plain, oneways[i]));
+}
+
 /*-----.
 | Main |
 `-----*/
@@ -169,6 +188,7 @@ ELLE_TEST_SUITE()
   suite->add(BOOST_TEST_CASE(test_operate));
   suite->add(BOOST_TEST_CASE(test_serialize));
   suite->add(BOOST_TEST_CASE(test_blocks));
+  suite->add(BOOST_TEST_CASE(test_fused));
 
   boost::unit_test::framework::master_test_suite().add(suite);
 }
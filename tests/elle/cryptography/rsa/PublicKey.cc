@@ -1,9 +1,13 @@
 #include "../cryptography.hh"
 
+#include <thread>
+
 #include <elle/cryptography/rsa/PublicKey.hh>
 #include <elle/cryptography/rsa/PrivateKey.hh>
 #include <elle/cryptography/rsa/KeyPair.hh>
 
+#include <elle/bench.hh>
+#include <elle/print.hh>
 #include <elle/serialization/json.hh>
 
 /*----------.
@@ -190,6 +194,86 @@ test_serialize()
   }
 }
 
+/*------.
+| Batch |
+`------*/
+
+static
+void
+test_verify_many()
+{
+  auto const keypair = elle::cryptography::rsa::keypair::generate(2048);
+  auto plains = std::vector<elle::Buffer>{};
+  for (int i = 0; i < 500; ++i)
+    plains.emplace_back(elle::sprintf("message %s", i));
+  auto const signed_ = keypair.k().sign_many(
+    std::vector<elle::ConstWeakBuffer>(plains.begin(), plains.end()));
+  BOOST_CHECK_EQUAL(signed_.statistics.items(), plains.size());
+  BOOST_CHECK_EQUAL(signed_.statistics.failures(), 0u);
+  auto signatures = std::vector<elle::Buffer>{};
+  for (auto const& r: signed_.results)
+    signatures.emplace_back(r.value.get());
+  // Batched signatures are regular signatures.
+  BOOST_CHECK(keypair.K().verify(signatures[42], plains[42]));
+  // Mismatches and malformed signatures are reported in order.
+  std::swap(plains[7], plains[8]);
+  signatures[100] = elle::Buffer("not a signature");
+  auto items = std::vector<elle::cryptography::rsa::PublicKey::Signed>{};
+  for (std::size_t i = 0; i < plains.size(); ++i)
+    items.emplace_back(signatures[i], plains[i]);
+  for (auto workers: {1, 4})
+  {
+    auto const verified = keypair.K().verify_many(
+      items,
+      elle::cryptography::rsa::defaults::signature_padding,
+      elle::cryptography::rsa::defaults::oneway,
+      workers);
+    BOOST_CHECK_EQUAL(verified.results.size(), items.size());
+    for (std::size_t i = 0; i < items.size(); ++i)
+    {
+      auto const& r = verified.results[i];
+      if (i == 100)
+      {
+        BOOST_CHECK(!r.value || !r.value.get());
+        continue;
+      }
+      BOOST_CHECK(r);
+      BOOST_CHECK_EQUAL(r.value.get(), i != 7 && i != 8);
+    }
+  }
+}
+
+/// Batch verification with increasing numbers of workers.
+///
+/// Timings are reported by `bench.cryptography.rsa.verify_many.*` benches.
+static
+void
+test_verify_many_workers()
+{
+  auto const keypair = elle::cryptography::rsa::keypair::generate(2048);
+  auto const plain = elle::Buffer("some block of data");
+  auto const signature = keypair.k().sign(plain);
+  auto const items = std::vector<elle::cryptography::rsa::PublicKey::Signed>(
+    256, {signature, plain});
+  auto const cores = std::max(1u, std::thread::hardware_concurrency());
+  for (auto workers = 1u; workers <= cores; workers *= 2)
+  {
+    auto bench = elle::Bench<>(
+      elle::print("bench.cryptography.rsa.verify_many.%s", workers));
+    auto const verified = [&]
+      {
+        auto const s = bench.scoped();
+        return keypair.K().verify_many(
+          items,
+          elle::cryptography::rsa::defaults::signature_padding,
+          elle::cryptography::rsa::defaults::oneway,
+          workers);
+      }();
+    BOOST_CHECK_EQUAL(verified.results.size(), items.size());
+    BOOST_CHECK_EQUAL(verified.statistics.failures(), 0u);
+  }
+}
+
 /*-----.
 | Main |
 `-----*/
@@ -204,6 +288,8 @@ ELLE_TEST_SUITE()
   suite->add(BOOST_TEST_CASE(test_operate));
   suite->add(BOOST_TEST_CASE(test_compare));
   suite->add(BOOST_TEST_CASE(test_serialize));
+  suite->add(BOOST_TEST_CASE(test_verify_many));
+  suite->add(BOOST_TEST_CASE(test_verify_many_workers));
 
   boost::unit_test::framework::master_test_suite().add(suite);
 }
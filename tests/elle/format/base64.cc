@@ -1,9 +1,15 @@
+#include <algorithm>
+#include <random>
 #include <string>
 
 #include <elle/Buffer.hh>
+#include <elle/bench.hh>
 #include <elle/format/base64.hh>
 #include <elle/format/base64url.hh>
+#include <elle/format/hexadecimal.hh>
+#include <elle/format/kernels.hh>
 #include <elle/log.hh>
+#include <elle/print.hh>
 #include <elle/test.hh>
 
 ELLE_LOG_COMPONENT("elle.format.base64.test");
@@ -125,6 +131,109 @@ values()
                     elle::WeakBuffer((void*)"89-_", 4));
 }
 
+static
+void
+invalid()
+{
+  BOOST_CHECK_THROW(elle::format::base64::decode("SGVsbG8"), elle::Error);
+  BOOST_CHECK_THROW(elle::format::base64::decode("SGVs*G8="), elle::Error);
+  BOOST_CHECK_THROW(elle::format::base64::decode("SGVsbG8-"), elle::Error);
+  BOOST_CHECK_EQUAL(elle::format::base64url::decode("SGVsbG8").string(),
+                    "Hello");
+  BOOST_CHECK_EQUAL(elle::format::base64url::decode("89+/").string(),
+                    "\xF3\xDF\xBF");
+  BOOST_CHECK_THROW(elle::format::hexadecimal::decode("0g"),
+                    std::runtime_error);
+}
+
+static
+std::string
+all_kernels[] = {"scalar", "sse4.1", "avx2", "neon"};
+
+/// Check every kernel supported by this CPU agrees with the scalar one.
+static
+void
+kernels()
+{
+  namespace format = elle::format;
+  std::string const original = format::_details::kernels();
+  auto random = std::minstd_rand(42);
+  for (auto size: {0, 1, 2, 3, 15, 16, 31, 32, 33, 63, 64, 100, 1000})
+  {
+    auto input = elle::Buffer(size);
+    for (auto& c: input)
+      c = random();
+    BOOST_REQUIRE(format::_details::kernels("scalar"));
+    auto const base64 = format::base64::encode(input);
+    auto const base64url = format::base64url::encode(input);
+    auto const hexadecimal = format::hexadecimal::encode(input);
+    for (auto const& name: all_kernels)
+    {
+      if (!format::_details::kernels(name))
+        continue;
+      ELLE_LOG("check %s kernels on %s bytes", name, size);
+      BOOST_CHECK_EQUAL(format::base64::encode(input), base64);
+      BOOST_CHECK_EQUAL(format::base64::decode(base64), input);
+      BOOST_CHECK_EQUAL(format::base64url::encode(input), base64url);
+      BOOST_CHECK_EQUAL(format::base64url::decode(base64url), input);
+      BOOST_CHECK_EQUAL(format::hexadecimal::encode(input), hexadecimal);
+      BOOST_CHECK_EQUAL(format::hexadecimal::decode(hexadecimal), input);
+      if (size >= 64)
+      {
+        // Corrupt the vectorized part of the input.
+        auto corrupted = base64;
+        corrupted[size / 2] = '*';
+        BOOST_CHECK_THROW(format::base64::decode(corrupted), elle::Error);
+        auto hex = hexadecimal;
+        hex[size / 2] = 'G';
+        BOOST_CHECK_THROW(format::hexadecimal::decode(hex),
+                          std::runtime_error);
+      }
+    }
+  }
+  format::_details::kernels(original);
+}
+
+static
+void
+benchmark()
+{
+  namespace format = elle::format;
+  std::string const original = format::_details::kernels();
+  auto const total = RUNNING_ON_VALGRIND ? 64 << 10 : 4 << 20;
+  for (auto const& name: all_kernels)
+  {
+    if (!format::_details::kernels(name))
+      continue;
+    for (auto size: {16, 256, 4096, 1 << 20})
+    {
+      auto const input = elle::Buffer(std::string(size, 'x'));
+      auto const encoded = format::base64::encode(input);
+      auto const hexadecimal = format::hexadecimal::encode(input);
+      auto const count = std::max(total / size, 1);
+      auto const measure = [&] (char const* what, auto const& f)
+        {
+          auto bench = elle::Bench<>(
+            elle::print("bench.format.{}.{}.{}", name, what, size));
+          for (int i = 0; i < count; ++i)
+          {
+            auto const s = bench.scoped();
+            f();
+          }
+        };
+      measure("base64.encode", [&] { format::base64::encode(input); });
+      measure("base64.decode", [&] { format::base64::decode(encoded); });
+      measure("hexadecimal.encode",
+              [&] { format::hexadecimal::encode(input); });
+      measure("hexadecimal.decode",
+              [&] { format::hexadecimal::decode(hexadecimal); });
+      BOOST_TEST(format::base64::decode(encoded) == input);
+      BOOST_TEST(format::hexadecimal::decode(hexadecimal) == input);
+    }
+  }
+  format::_details::kernels(original);
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
@@ -132,5 +241,8 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(streams));
   suite.add(BOOST_TEST_CASE(values));
   suite.add(BOOST_TEST_CASE(encode_to_and_decode_from_base64url));
+  suite.add(BOOST_TEST_CASE(invalid));
+  suite.add(BOOST_TEST_CASE(kernels));
+  suite.add(BOOST_TEST_CASE(benchmark), 0, valgrind(60));
 }
 
@@ -1,9 +1,15 @@
+#include <memory>
+#include <random>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
+#include <elle/bench.hh>
 #include <elle/format/gzip.hh>
 #include <elle/log.hh>
+#include <elle/print.hh>
 #include <elle/test.hh>
 
 ELLE_LOG_COMPONENT("elle.format.gzip.test");
@@ -121,6 +127,154 @@ flush()
 }
 
 
+/*---------.
+| Parallel |
+`---------*/
+
+static
+std::string
+inflate(std::stringstream& compressed)
+{
+  elle::format::gzip::Stream inflate(compressed, false);
+  return std::string(std::istreambuf_iterator<char>(inflate), {});
+}
+
+static
+void
+parallel_roundtrip(std::string const& content,
+                   int threads,
+                   elle::Buffer::Size block_size,
+                   int in_flight)
+{
+  ELLE_LOG("compress %s bytes by blocks of %s on %s threads",
+           content.size(), block_size, threads);
+  auto parallel = elle::format::gzip::Parallel{};
+  parallel.threads = threads;
+  parallel.block_size = block_size;
+  parallel.in_flight = in_flight;
+  std::stringstream compressed;
+  {
+    elle::format::gzip::Stream deflate(compressed, parallel);
+    deflate << content;
+  }
+  ELLE_LOG("compressed size: {}", compressed.str().size());
+  // Leave room for the GZIP header and trailer, and the final empty block.
+  BOOST_CHECK_LE(compressed.str().size(), content.size() * 80 / 100 + 32);
+  auto const data = inflate(compressed);
+  BOOST_TEST(content.size() == data.size());
+  BOOST_CHECK(content == data);
+}
+
+static
+void
+parallel()
+{
+  auto const data = content();
+  parallel_roundtrip(data, 1, 1 << 17, 0);
+  parallel_roundtrip(data, 4, 1 << 12, 0);
+  // More blocks than threads and in flight ones.
+  parallel_roundtrip(data, 3, 1 << 10, 2);
+  // Blocks smaller than a deflate window, exactly dividing the input.
+  parallel_roundtrip(data, 4, data.size() / 64, 5);
+  parallel_roundtrip("x", 2, 1 << 10, 0);
+}
+
+static
+void
+parallel_ratio()
+{
+  // Priming blocks with the end of the previous one keeps the ratio close to
+  // sequential compression.
+  auto const data = content();
+  std::stringstream sequential;
+  {
+    elle::format::gzip::Stream deflate(sequential, false);
+    deflate << data;
+  }
+  auto parallel = elle::format::gzip::Parallel{};
+  parallel.threads = 4;
+  std::stringstream compressed;
+  {
+    elle::format::gzip::Stream deflate(compressed, parallel);
+    deflate << data;
+  }
+  ELLE_LOG("sequential: {}, parallel: {}",
+           sequential.str().size(), compressed.str().size());
+  BOOST_CHECK_LE(compressed.str().size(), sequential.str().size() * 11 / 10);
+  BOOST_CHECK(inflate(compressed) == data);
+}
+
+static
+void
+parallel_level()
+{
+  auto const data = content();
+  auto parallel = elle::format::gzip::Parallel{};
+  parallel.level = 12;
+  std::stringstream compressed;
+  BOOST_CHECK_THROW((elle::format::gzip::Stream{compressed, parallel}),
+                    elle::Error);
+  auto size = std::size_t(0);
+  for (auto level: {1, 9})
+  {
+    parallel.level = level;
+    std::stringstream compressed;
+    {
+      elle::format::gzip::Stream deflate(compressed, parallel);
+      deflate << data;
+    }
+    if (size)
+      BOOST_CHECK_LE(compressed.str().size(), size);
+    size = compressed.str().size();
+    BOOST_CHECK(inflate(compressed) == data);
+  }
+}
+
+static
+void
+parallel_benchmark()
+{
+  // Text with some entropy, compressing more like logs than lorem ipsum
+  // repeated.
+  auto random = std::minstd_rand(0);
+  auto const words = std::vector<std::string>{
+    "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+    "elit", "etiam", "velit", "tortor", "facilisis", "eget", "nisl"};
+  auto const size = RUNNING_ON_VALGRIND ? 256 << 10 : 8 << 20;
+  std::string data;
+  data.reserve(size + 64);
+  while (data.size() < std::size_t(size))
+  {
+    data += words[random() % words.size()];
+    data += random() % 16 ? ' ' : '\n';
+    if (random() % 8 == 0)
+      data += std::to_string(random());
+  }
+  auto const measure = [&] (std::string const& what, auto make)
+    {
+      std::stringstream compressed;
+      auto bench = elle::Bench<>(elle::print("bench.format.gzip.{}", what));
+      {
+        auto const s = bench.scoped();
+        auto deflate = make(compressed);
+        deflate->write(data.data(), data.size());
+      }
+      BOOST_CHECK(inflate(compressed) == data);
+    };
+  measure("sequential",
+          [] (std::stringstream& s)
+          {
+            return std::make_unique<elle::format::gzip::Stream>(s, false);
+          });
+  for (auto threads: {1, 4, 16})
+    measure(elle::print("parallel.{}", threads),
+            [&] (std::stringstream& s)
+            {
+              auto parallel = elle::format::gzip::Parallel{};
+              parallel.threads = threads;
+              return std::make_unique<elle::format::gzip::Stream>(s, parallel);
+            });
+}
 
 ELLE_TEST_SUITE()
 {
@@ -135,4 +289,8 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(empty_content));
   suite.add(BOOST_TEST_CASE(empty_content_noflush));
   suite.add(BOOST_TEST_CASE(flush));
+  suite.add(BOOST_TEST_CASE(parallel));
+  suite.add(BOOST_TEST_CASE(parallel_ratio));
+  suite.add(BOOST_TEST_CASE(parallel_level));
+  suite.add(BOOST_TEST_CASE(parallel_benchmark), 0, valgrind(120));
 }
@@ -0,0 +1,388 @@
+#include <cstring>
+#include <limits>
+
+#include <boost/endian/conversion.hpp>
+
+#include <elle/nbd/Server.hh>
+#include <elle/test.hh>
+
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/network/Error.hh>
+#include <elle/reactor/network/TCPSocket.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/Thread.hh>
+
+using boost::endian::endian_reverse;
+
+ELLE_LOG_COMPONENT("elle.nbd.test");
+
+namespace
+{
+  /// A device in memory, whose commands can be held to control their
+  /// completion order.
+  class MemoryDevice
+    : public elle::nbd::Server::Device
+  {
+  public:
+    using Super = elle::nbd::Server::Device;
+    MemoryDevice(std::size_t size)
+      : Super("memory", size)
+      , data(size)
+    {
+      std::memset(this->data.mutable_contents(), 0, size);
+    }
+
+    elle::Buffer
+    read(uint64_t offset, uint32_t length) override
+    {
+      if (this->on_read)
+        this->on_read(offset);
+      return elle::Buffer(this->data.contents() + offset, length);
+    }
+
+    void
+    write(uint64_t offset, elle::Buffer data) override
+    {
+      ++this->writing;
+      this->wrote.open();
+      if (this->on_write)
+        this->on_write(offset);
+      std::memcpy(this->data.mutable_contents() + offset,
+                  data.contents(), data.size());
+      --this->writing;
+    }
+
+    void
+    write_zeroes(uint64_t offset, uint32_t length) override
+    {
+      std::memset(this->data.mutable_contents() + offset, 0, length);
+    }
+
+    void
+    sync() override
+    {
+      ++this->syncs;
+      if (this->writing)
+        ++this->early_syncs;
+    }
+
+    elle::Buffer data;
+    std::function<void (uint64_t)> on_read;
+    std::function<void (uint64_t)> on_write;
+    /// Opened when a write starts.
+    elle::reactor::Barrier wrote;
+    int writing = 0;
+    int syncs = 0;
+    /// Syncs that ran while a write was in progress.
+    int early_syncs = 0;
+  };
+
+  void
+  put_16(elle::Buffer& buffer, uint16_t i)
+  {
+    i = endian_reverse(i);
+    buffer.append(&i, sizeof i);
+  }
+
+  void
+  put_32(elle::Buffer& buffer, uint32_t i)
+  {
+    i = endian_reverse(i);
+    buffer.append(&i, sizeof i);
+  }
+
+  void
+  put_64(elle::Buffer& buffer, uint64_t i)
+  {
+    i = endian_reverse(i);
+    buffer.append(&i, sizeof i);
+  }
+
+  template <typename T>
+  T
+  get(elle::reactor::network::Socket& sock)
+  {
+    auto data = sock.read(sizeof(T));
+    T res;
+    std::memcpy(&res, data.contents(), sizeof(T));
+    return endian_reverse(res);
+  }
+
+  /// A structured reply chunk.
+  struct Chunk
+  {
+    uint16_t flags;
+    uint16_t type;
+    uint64_t handle;
+    elle::Buffer payload;
+  };
+
+  /// Minimal NBD client sending raw commands and reading raw replies.
+  class Client
+  {
+  public:
+    Client(int port, bool structured = false)
+      : sock("127.0.0.1", port)
+    {
+      BOOST_TEST(this->sock.read(16) ==
+                 elle::ConstWeakBuffer("NBDMAGICIHAVEOPT"));
+      get<uint16_t>(this->sock);
+      // Fixed newstyle, no zeroes.
+      this->sock.write(endian_reverse(uint32_t(3)));
+      auto const option = [&] (uint32_t option, std::string const& data)
+        {
+          auto request = elle::Buffer("IHAVEOPT");
+          put_32(request, option);
+          put_32(request, data.size());
+          request.append(data.data(), data.size());
+          this->sock.write(request);
+        };
+      if (structured)
+      {
+        option(8, "");
+        BOOST_TEST(get<uint64_t>(this->sock) == 0x3e889045565a9u);
+        BOOST_TEST(get<uint32_t>(this->sock) == 8u);
+        BOOST_TEST(get<uint32_t>(this->sock) == 1u);
+        BOOST_TEST(get<uint32_t>(this->sock) == 0u);
+      }
+      option(1, "memory");
+      this->size = get<uint64_t>(this->sock);
+      this->flags = get<uint16_t>(this->sock);
+    }
+
+    void
+    request(uint16_t command,
+            uint64_t handle,
+            uint64_t offset,
+            uint32_t length,
+            uint16_t flags = 0,
+            elle::ConstWeakBuffer payload = {})
+    {
+      auto request = elle::Buffer();
+      put_32(request, 0x25609513);
+      put_16(request, flags);
+      put_16(request, command);
+      request.append(&handle, sizeof handle);
+      put_64(request, offset);
+      put_32(request, length);
+      request.append(payload.contents(), payload.size());
+      this->sock.write(request);
+    }
+
+    /// Read a simple reply, returning its handle.
+    uint64_t
+    reply(uint32_t error = 0, uint32_t length = 0)
+    {
+      BOOST_TEST(get<uint32_t>(this->sock) == 0x67446698u);
+      BOOST_TEST(get<uint32_t>(this->sock) == error);
+      uint64_t handle;
+      this->sock.read(elle::WeakBuffer(&handle, sizeof handle));
+      if (length)
+        this->data = this->sock.read(length);
+      return handle;
+    }
+
+    Chunk
+    chunk()
+    {
+      BOOST_TEST(get<uint32_t>(this->sock) == 0x668e33efu);
+      auto res = Chunk{};
+      res.flags = get<uint16_t>(this->sock);
+      res.type = get<uint16_t>(this->sock);
+      this->sock.read(elle::WeakBuffer(&res.handle, sizeof res.handle));
+      res.payload = this->sock.read(get<uint32_t>(this->sock));
+      return res;
+    }
+
+    elle::reactor::network::TCPSocket sock;
+    uint64_t size;
+    uint16_t flags;
+    /// Data of the last read reply.
+    elle::Buffer data;
+  };
+
+  /// Serve @a device in the background for @a action.
+  void
+  serve(MemoryDevice& device, std::function<void (int port)> const& action)
+  {
+    elle::nbd::Server server(boost::asio::ip::address_v4::loopback(), 0);
+    server.add(device);
+    elle::reactor::Barrier listening;
+    int port = 0;
+    server.listening().connect(
+      [&] (int p)
+      {
+        port = p;
+        listening.open();
+      });
+    elle::reactor::Thread thread("server", [&] { server.run(); });
+    elle::reactor::wait(listening);
+    action(port);
+    thread.terminate_now();
+  }
+
+  namespace command
+  {
+    int constexpr read = 0;
+    int constexpr write = 1;
+    int constexpr disc = 2;
+    int constexpr flush = 3;
+  }
+}
+
+ELLE_TEST_SCHEDULED(export_flags)
+{
+  MemoryDevice device(1024 * 1024);
+  serve(device, [&] (int port)
+  {
+    Client client(port);
+    BOOST_TEST(client.size == device.size());
+    // Flags, flush, FUA, trim, DF, CAN_MULTI_CONN and cache.
+    BOOST_TEST(client.flags == 0x5ad);
+  });
+}
+
+/// Replies are sent as commands complete, not in request order.
+ELLE_TEST_SCHEDULED(out_of_order)
+{
+  MemoryDevice device(1024 * 1024);
+  elle::reactor::Barrier second;
+  device.on_read = [&] (uint64_t offset)
+    {
+      if (offset == 0)
+        elle::reactor::wait(second);
+      else
+        second.open();
+    };
+  serve(device, [&] (int port)
+  {
+    Client client(port);
+    client.request(command::read, 1, 0, 4096);
+    client.request(command::read, 2, 4096, 4096);
+    BOOST_TEST(client.reply(0, 4096) == 2u);
+    BOOST_TEST(client.reply(0, 4096) == 1u);
+  });
+}
+
+/// Structured reads skip zeroed blocks as holes, unless DF is set.
+ELLE_TEST_SCHEDULED(structured_read)
+{
+  MemoryDevice device(1024 * 1024);
+  std::memset(device.data.mutable_contents(), 'a', 4096);
+  std::memset(device.data.mutable_contents() + 3 * 4096, 'b', 4096);
+  serve(device, [&] (int port)
+  {
+    Client client(port, true);
+    client.request(command::read, 1, 0, 4 * 4096);
+    {
+      auto data = client.chunk();
+      BOOST_TEST(data.handle == 1u);
+      BOOST_TEST(data.type == 1);
+      BOOST_TEST(data.flags == 0);
+      BOOST_TEST(data.payload.size() == 8u + 4096);
+      BOOST_TEST(data.payload[8] == 'a');
+      auto hole = client.chunk();
+      BOOST_TEST(hole.type == 2);
+      BOOST_TEST(hole.flags == 0);
+      BOOST_TEST(hole.payload.size() == 12u);
+      auto last = client.chunk();
+      BOOST_TEST(last.type == 1);
+      BOOST_TEST(last.flags == 1);
+      BOOST_TEST(last.payload.size() == 8u + 4096);
+      BOOST_TEST(last.payload[8] == 'b');
+    }
+    // Don't fragment.
+    client.request(command::read, 2, 0, 4 * 4096, 1 << 2);
+    {
+      auto data = client.chunk();
+      BOOST_TEST(data.handle == 2u);
+      BOOST_TEST(data.type == 1);
+      BOOST_TEST(data.flags == 1);
+      BOOST_TEST(data.payload.size() == 8u + 4 * 4096);
+    }
+    // Errors come as error chunks.
+    client.request(command::read, 3, device.size(), 1);
+    {
+      auto error = client.chunk();
+      BOOST_TEST(error.handle == 3u);
+      BOOST_TEST(error.type == (1 << 15 | 1));
+      BOOST_TEST(error.flags == 1);
+    }
+  });
+}
+
+/// A flush covers writes still in progress when it arrives.
+ELLE_TEST_SCHEDULED(flush_waits_for_writes)
+{
+  MemoryDevice device(1024 * 1024);
+  elle::reactor::Barrier release;
+  device.on_write = [&] (uint64_t) { elle::reactor::wait(release); };
+  serve(device, [&] (int port)
+  {
+    Client client(port);
+    auto const data = std::string(4096, 'x');
+    client.request(command::write, 1, 0, data.size(), 0,
+                   elle::ConstWeakBuffer(data));
+    client.request(command::flush, 2, 0, 0);
+    elle::reactor::wait(device.wrote);
+    // Give the flush a chance to sync early.
+    for (int i = 0; i < 16; ++i)
+      elle::reactor::yield();
+    BOOST_TEST(device.syncs == 0);
+    release.open();
+    BOOST_TEST(client.reply() == 1u);
+    BOOST_TEST(client.reply() == 2u);
+    BOOST_TEST(device.syncs == 1);
+    BOOST_TEST(device.early_syncs == 0);
+  });
+}
+
+/// A disconnection lets in-flight commands reply first.
+ELLE_TEST_SCHEDULED(disconnect_drains)
+{
+  MemoryDevice device(1024 * 1024);
+  elle::reactor::Barrier release;
+  device.on_write = [&] (uint64_t) { elle::reactor::wait(release); };
+  serve(device, [&] (int port)
+  {
+    Client client(port);
+    auto const data = std::string(4096, 'x');
+    client.request(command::write, 1, 0, data.size(), 0,
+                   elle::ConstWeakBuffer(data));
+    client.request(command::disc, 2, 0, 0);
+    elle::reactor::wait(device.wrote);
+    release.open();
+    BOOST_TEST(client.reply() == 1u);
+    BOOST_TEST(device.data[0] == 'x');
+    BOOST_CHECK_THROW(client.sock.read(1),
+                      elle::reactor::network::ConnectionClosed);
+  });
+}
+
+/// Bounds checks must not overflow.
+ELLE_TEST_SCHEDULED(out_of_bounds)
+{
+  MemoryDevice device(1024 * 1024);
+  serve(device, [&] (int port)
+  {
+    Client client(port);
+    client.request(command::read, 1, device.size() - 10, 20);
+    BOOST_TEST(client.reply(22) == 1u);
+    client.request(
+      command::read, 2, std::numeric_limits<uint64_t>::max() - 10, 20);
+    BOOST_TEST(client.reply(22) == 2u);
+    client.request(command::read, 3, device.size() - 4096, 4096);
+    BOOST_TEST(client.reply(0, 4096) == 3u);
+  });
+}
+
+ELLE_TEST_SUITE()
+{
+  auto& suite = boost::unit_test::framework::master_test_suite();
+  suite.add(BOOST_TEST_CASE(export_flags), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(out_of_order), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(structured_read), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(flush_waits_for_writes), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(disconnect_drains), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(out_of_bounds), 0, valgrind(3));
+}
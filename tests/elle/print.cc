@@ -1,5 +1,9 @@
+#include <cstring>
+#include <iostream>
 #include <ostream>
+#include <sstream>
 
+#include <elle/bench.hh>
 #include <elle/print.hh>
 #include <elle/test.hh>
 
@@ -237,6 +241,83 @@ repr()
   BOOST_TEST(elle::print("{!r}", "foo\"bar") == "\"foo\\\"bar\"");
 }
 
+namespace detail
+{
+  struct nested
+  {
+    int i;
+  };
+
+  static
+  std::ostream&
+  operator <<(std::ostream& out, nested const& n)
+  {
+    return out << elle::print("nested({})", n.i);
+  }
+}
+
+static
+void
+cache()
+{
+  // The same address holding different formats.
+  char fmt[16];
+  std::strcpy(fmt, "a{}");
+  BOOST_TEST(elle::print(fmt, 1) == "a1");
+  std::strcpy(fmt, "b{}");
+  BOOST_TEST(elle::print(fmt, 2) == "b2");
+  BOOST_TEST(elle::print(std::string("c{}"), 3) == "c3");
+  BOOST_TEST(elle::print(std::string("c{}"), 4) == "c4");
+  // Printing to a string while printing to a string.
+  BOOST_TEST(elle::print("{} {}", detail::nested{1}, detail::nested{2}) ==
+             "nested(1) nested(2)");
+  // Formatting does not leak from one variable, or one print, to the next.
+  BOOST_TEST(elle::print("{!x} {}", 255, 255) == "ff 255");
+  BOOST_TEST(elle::print("{}", 255) == "255");
+  std::stringstream s;
+  elle::print(s, "%5s|", 42);
+  s << 42;
+  BOOST_TEST(s.str() == "   42|42");
+}
+
+static
+void
+benchmark()
+{
+  auto const n = 10000;
+  auto const bench = [&] (std::string const& name, auto const& f)
+    {
+      auto b = elle::Bench<>(elle::print("bench.print.%s", name));
+      auto size = std::size_t(0);
+      for (int i = 0; i < n; ++i)
+      {
+        auto const s = b.scoped();
+        size += f(i).size();
+      }
+      BOOST_TEST(size > 0u);
+    };
+  bench("literal",
+        [] (int i)
+        {
+          return elle::print("%s: fetch block %s from %s (%s bytes)",
+                             "elle.test", i, "peer", 4096);
+        });
+  auto const dynamic = std::string("{}: fetch block {} from {} ({} bytes)");
+  bench("dynamic",
+        [&] (int i)
+        {
+          return elle::print(dynamic, "elle.test", i, "peer", 4096);
+        });
+  // Every format is different: parsed every time, as before formats were
+  // cached.
+  bench("uncached",
+        [] (int i)
+        {
+          return elle::print(elle::print("\\{\\}: fetch block {} from \\{\\}", i),
+                             "elle.test", "peer");
+        });
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
@@ -259,4 +340,6 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(to_string));
   suite.add(BOOST_TEST_CASE(void_pointers));
   suite.add(BOOST_TEST_CASE(repr));
+  suite.add(BOOST_TEST_CASE(cache));
+  suite.add(BOOST_TEST_CASE(benchmark));
 }
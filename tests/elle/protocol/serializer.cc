@@ -1,9 +1,12 @@
+#define ELLE_TEST_COUNT_ALLOCATIONS
 #include <elle/protocol/Serializer.hh>
 
 #include <elle/IOStream.hh>
 #include <elle/ScopedAssignment.hh>
 #include <elle/With.hh>
+#include <elle/bench.hh>
 #include <elle/cast.hh>
+#include <elle/print.hh>
 #include <elle/test.hh>
 
 #include <elle/cryptography/random.hh>
@@ -498,6 +501,57 @@ ELLE_TEST_SCHEDULED(exchange)
   CASES(_exchange);
 }
 
+/// Number of allocations needed to send @a count packets of @a size bytes
+/// through a Channel.
+static
+std::size_t
+_channel_allocations(int count, elle::Buffer::Size size)
+{
+#ifdef ELLE_TEST_ALLOCATIONS
+  auto const packet = elle::Buffer(std::string(size, 'x'));
+  auto const before = allocations.load();
+  dialog<Connector>(
+    elle::Version(0, 3, 0),
+    false,
+    [] (Connector&) {},
+    [&] (elle::protocol::Serializer& s)
+    {
+      auto&& channels = elle::protocol::ChanneledStream(s);
+      auto channel = elle::protocol::Channel(channels);
+      for (int i = 0; i < count; ++i)
+        channel.write(packet);
+    },
+    [&] (elle::protocol::Serializer& s)
+    {
+      auto&& channels = elle::protocol::ChanneledStream(s);
+      auto channel = channels.accept();
+      for (int i = 0; i < count; ++i)
+        BOOST_CHECK_EQUAL(channel.read().size(), size);
+    });
+  return allocations.load() - before;
+#else
+  return 0;
+#endif
+}
+
+ELLE_TEST_SCHEDULED(channel_allocations)
+{
+  for (auto size: {0, 16, 1024, 65536})
+  {
+    // Subtract a single packet run to leave out the setup.
+    auto const count = 64;
+    auto const base = _channel_allocations(1, size);
+    auto const total = _channel_allocations(count + 1, size);
+    auto const per_packet = double(total - base) / count;
+    auto bench = elle::Bench<double>(
+      elle::print("bench.protocol.channel.allocations.{}", size));
+    bench.add(per_packet);
+    // A fixed cost for framing and the reactor, plus the socket reads a large
+    // packet arrives in.
+    BOOST_TEST(per_packet <= 16 + size / 512);
+  }
+}
+
 static
 void
 _connection_lost_reader(elle::Version const& version,
@@ -1093,6 +1147,7 @@ ELLE_TEST_SUITE()
   auto& suite = boost::unit_test::framework::master_test_suite();
   suite.add(BOOST_TEST_CASE(exchange_packets), 0, valgrind(10, 10));
   suite.add(BOOST_TEST_CASE(exchange), 0, valgrind(20, 10));
+  suite.add(BOOST_TEST_CASE(channel_allocations), 0, valgrind(10, 10));
   suite.add(BOOST_TEST_CASE(connection_lost_reader), 0, valgrind(3, 10));
   suite.add(BOOST_TEST_CASE(connection_lost_sender), 0, valgrind(3, 10));
   suite.add(BOOST_TEST_CASE(corruption), 0, valgrind(3, 10));
@@ -3,10 +3,15 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <chrono>
+#include <random>
+
 #include <boost/filesystem/fstream.hpp>
 
+#include <elle/bench.hh>
 #include <elle/finally.hh>
 #include <elle/os/environ.hh>
+#include <elle/print.hh>
 #include <elle/reactor/Barrier.hh>
 #include <elle/reactor/filesystem.hh>
 #include <elle/reactor/scheduler.hh>
@@ -385,10 +390,210 @@ test_xor()
   ELLE_TRACE("finished");
 }
 
+static
+void
+cache_lru()
+{
+  auto cache = elle::reactor::filesystem::PathCache{};
+  auto const a = std::make_shared<sum::Path>(1);
+  // Room for three entries with two-character paths.
+  cache.budget(3 * (256 + 2));
+  cache.set("/a", a);
+  cache.set("/b", std::make_shared<sum::Path>(2));
+  cache.set("/c", std::make_shared<sum::Path>(3));
+  BOOST_TEST(cache.size() == 3u * (256 + 2));
+  BOOST_TEST(cache.get("/a") == a);
+  cache.set("/d", std::make_shared<sum::Path>(4));
+  // "/b" was the least recently used.
+  BOOST_TEST(cache.evictions() == 1u);
+  BOOST_TEST(!cache.get("/b"));
+  BOOST_TEST(cache.get("/c"));
+  BOOST_TEST(cache.get("/d"));
+  BOOST_TEST(cache.hits() == 3u);
+  BOOST_TEST(cache.misses() == 1u);
+  BOOST_TEST(cache.extract("/a") == a);
+  BOOST_TEST(cache.size() == 2u * (256 + 2));
+  cache.clear();
+  BOOST_TEST(cache.size() == 0u);
+}
+
+static
+void
+cache_negative()
+{
+  auto cache = elle::reactor::filesystem::PathCache{};
+  cache.set_missing("/x");
+  BOOST_TEST(cache.missing("/x"));
+  BOOST_TEST(!cache.get("/x"));
+  BOOST_TEST(!cache.missing("/y"));
+  cache.set("/x", std::make_shared<sum::Path>(1));
+  BOOST_TEST(!cache.missing("/x"));
+  cache.negative_ttl(1ms);
+  cache.set_missing("/y");
+  std::this_thread::sleep_for(10ms);
+  BOOST_TEST(!cache.missing("/y"));
+  BOOST_TEST(cache.size() == 256u + 2);
+}
+
+static
+void
+cache_invalidate()
+{
+  auto cache = elle::reactor::filesystem::PathCache{};
+  for (auto path: {"/d", "/d/e", "/d/e/f", "/dx", "/e"})
+    cache.set(path, std::make_shared<sum::Path>(1));
+  cache.set_missing("/d/g");
+  cache.invalidate("/d");
+  for (auto path: {"/d", "/d/e", "/d/e/f"})
+    BOOST_TEST(!cache.get(path));
+  BOOST_TEST(!cache.missing("/d/g"));
+  BOOST_TEST(cache.get("/dx"));
+  BOOST_TEST(cache.get("/e"));
+  cache.invalidate("/");
+  BOOST_TEST(cache.size() == 0u);
+}
+
+static
+void
+cache_filesystem()
+{
+  auto&& fs = elle::reactor::filesystem::FileSystem(
+    std::make_unique<sum::Operations>(), true);
+  BOOST_TEST(fs.path("/1/2"));
+  BOOST_TEST(fs.get("/1/2"));
+  BOOST_CHECK_THROW(fs.path("/nope"), elle::reactor::filesystem::Error);
+  BOOST_TEST(fs.is_missing("/nope"));
+  // Children of a missing directory fail without asking it.
+  auto const misses = fs.cache().misses();
+  BOOST_CHECK_THROW(fs.path("/nope/1"), elle::reactor::filesystem::Error);
+  BOOST_TEST(fs.cache().misses() == misses + 1);
+  // A renamed directory takes its children along.
+  fs.invalidate("/1");
+  BOOST_TEST(!fs.get("/1"));
+  BOOST_TEST(!fs.get("/1/2"));
+  BOOST_TEST(fs.get("/"));
+}
+
+/// Run @a test with the low-level FUSE backend.
+static
+void
+lowlevel(std::function<void ()> const& test)
+{
+  elle::os::setenv("INFINIT_FUSE_LOWLEVEL", "1");
+  elle::SafeFinally restore([] { elle::os::unsetenv("INFINIT_FUSE_LOWLEVEL"); });
+  test();
+}
+
+/// Report the time per operation of @a action, which performs @a ops
+/// operations, as bench.reactor.filesystem.@a name.
+static
+void
+timed(std::string const& name, int ops, std::function<void ()> const& action)
+{
+  auto bench = elle::Bench<>(elle::print("bench.reactor.filesystem.{}", name));
+  auto const start = elle::Clock::now();
+  action();
+  bench.add((elle::Clock::now() - start) / ops);
+}
+
+/// fio-style run on @a file: sequential 1 MiB writes and reads, then
+/// random 4 KiB reads and writes.
+static
+void
+fio(bfs::path const& file, std::string const& backend)
+{
+  auto const size = 64 * 1024 * 1024;
+  auto const ops = 4096;
+  auto big = std::vector<char>(1024 * 1024, 'x');
+  auto small = std::vector<char>(4096, 'y');
+  int fd = ::open(file.string().c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  BOOST_REQUIRE_GE(fd, 0);
+  elle::SafeFinally closer([&] { ::close(fd); });
+  auto const chunks = int(size / big.size());
+  timed(backend + ".sequential_write", chunks, [&] {
+    for (off_t offset = 0; offset < size; offset += big.size())
+      BOOST_REQUIRE_EQUAL(::pwrite(fd, big.data(), big.size(), offset),
+                          signed(big.size()));
+    ::fsync(fd);
+  });
+  // Drop cached pages so reads go through the filesystem.
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  timed(backend + ".sequential_read", chunks, [&] {
+    for (off_t offset = 0; offset < size; offset += big.size())
+      BOOST_REQUIRE_EQUAL(::pread(fd, big.data(), big.size(), offset),
+                          signed(big.size()));
+  });
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  auto random = std::default_random_engine(42);
+  auto block = std::uniform_int_distribution<off_t>(0, size / 4096 - 1);
+  timed(backend + ".random_read", ops, [&] {
+    for (int i = 0; i < ops; ++i)
+      BOOST_REQUIRE_EQUAL(
+        ::pread(fd, small.data(), small.size(), block(random) * 4096),
+        signed(small.size()));
+  });
+  timed(backend + ".random_write", ops, [&] {
+    for (int i = 0; i < ops; ++i)
+      BOOST_REQUIRE_EQUAL(
+        ::pwrite(fd, small.data(), small.size(), block(random) * 4096),
+        signed(small.size()));
+    ::fsync(fd);
+  });
+}
+
+/// Compare both FUSE backends on a BindOperations passthrough.
+static
+void
+benchmark()
+{
+  for (auto ll: {false, true})
+  {
+    if (ll)
+      elle::os::setenv("INFINIT_FUSE_LOWLEVEL", "1");
+    elle::SafeFinally restore(
+      [] { elle::os::unsetenv("INFINIT_FUSE_LOWLEVEL"); });
+    auto const tmpmount = bfs::temp_directory_path() / bfs::unique_path();
+    auto const tmpsource = bfs::temp_directory_path() / bfs::unique_path();
+    elle::SafeFinally remover([&] {
+        boost::system::error_code erc;
+        bfs::remove(tmpmount, erc);
+        bfs::remove_all(tmpsource, erc);
+    });
+    bfs::create_directories(tmpmount);
+    bfs::create_directories(tmpsource);
+    elle::reactor::filesystem::FileSystem fs(
+      std::make_unique<elle::reactor::filesystem::BindOperations>(tmpsource),
+      false);
+    elle::reactor::Barrier* barrier;
+    elle::reactor::Scheduler* sched;
+    std::thread t([&] { run_filesystem(fs, tmpmount, &barrier, sched);});
+    if (sandbox)
+    {
+      t.join();
+      return;
+    }
+    std::this_thread::sleep_for(500ms);
+    fio(tmpmount / "fio", ll ? "lowlevel" : "highlevel");
+    bfs::remove(tmpmount / "fio");
+    sched->mt_run<void>("stop", [&] {fs.unmount();});
+    sched->mt_run<void>("stop", [&] {barrier->open();});
+    t.join();
+  }
+}
+
 ELLE_TEST_SUITE()
 {
   boost::unit_test::test_suite* filesystem = BOOST_TEST_SUITE("filesystem");
   boost::unit_test::framework::master_test_suite().add(filesystem);
+  filesystem->add(BOOST_TEST_CASE(cache_lru));
+  filesystem->add(BOOST_TEST_CASE(cache_negative));
+  filesystem->add(BOOST_TEST_CASE(cache_invalidate));
+  filesystem->add(BOOST_TEST_CASE(cache_filesystem));
   filesystem->add(BOOST_TEST_CASE(test_sum), 0, sandbox ? 0 : 20);
   filesystem->add(BOOST_TEST_CASE(test_xor), 0, sandbox ? 0 : 20);
+  filesystem->add(BOOST_TEST_CASE(std::bind(lowlevel, test_sum)),
+                  0, sandbox ? 0 : 20);
+  filesystem->add(BOOST_TEST_CASE(std::bind(lowlevel, test_xor)),
+                  0, sandbox ? 0 : 20);
+  filesystem->add(BOOST_TEST_CASE(benchmark), 0, sandbox ? 0 : 120);
 }
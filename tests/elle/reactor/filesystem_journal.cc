@@ -0,0 +1,274 @@
+#include <fcntl.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include <elle/bench.hh>
+#include <elle/finally.hh>
+#include <elle/os/environ.hh>
+#include <elle/test.hh>
+
+#include <elle/filesystem/TemporaryDirectory.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/filesystem_journal.hh>
+#include <elle/reactor/scheduler.hh>
+
+ELLE_LOG_COMPONENT("elle.reactor.filesystem.journal.test");
+
+namespace bfs = boost::filesystem;
+namespace rfs = elle::reactor::filesystem;
+namespace journal = rfs::journal;
+
+using namespace std::literals;
+
+/// Run a few operations on a journaled BindOperations of @a source.
+static
+void
+workload(bfs::path const& source, bfs::path const& path)
+{
+  auto ops = rfs::install_journal(
+    std::make_unique<rfs::BindOperations>(source), path.string());
+  ops->path("/dir")->mkdir(0755);
+  {
+    auto h = ops->path("/dir/file")->create(O_CREAT | O_RDWR, 0644);
+    for (int i = 0; i < 100; ++i)
+      h->write(elle::ConstWeakBuffer("journaled\n"), 10, i * 10);
+    char content[10];
+    BOOST_TEST(h->read(elle::WeakBuffer(content, 10), 10, 0) == 10);
+    h->close();
+  }
+  struct stat st;
+  ops->path("/dir/file")->stat(&st);
+  BOOST_TEST(st.st_size == 1000);
+  BOOST_CHECK_THROW(ops->path("/missing")->stat(&st), rfs::Error);
+  ops->path("/dir/file")->rename("/dir/renamed");
+}
+
+static
+void
+round_trip()
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const root = bfs::path(d.path().string());
+  auto const path = root / "journal";
+  {
+    journal::Writer w(path.string());
+    auto r = journal::Record{};
+    r.sequence = 1;
+    r.operation = journal::Operation::setxattr;
+    r.path = "/foo";
+    r.integers = {-1, 0, 1ll << 40};
+    r.strings = {"name", ""};
+    w.append(r);
+    auto reply = journal::Record{};
+    reply.sequence = 1;
+    reply.reply = true;
+    reply.operation = r.operation;
+    reply.code = EPERM;
+    reply.message = "denied";
+    w.append(reply, elle::ConstWeakBuffer("payload"));
+    w.flush();
+    BOOST_TEST(w.records() == 2u);
+  }
+  journal::Reader reader(path.string());
+  auto r = journal::Record{};
+  BOOST_TEST(reader.next(r));
+  BOOST_TEST(!r.reply);
+  BOOST_TEST(r.operation == journal::Operation::setxattr);
+  BOOST_TEST(r.path == "/foo");
+  BOOST_TEST(r.integers == (std::vector<std::int64_t>{-1, 0, 1ll << 40}));
+  BOOST_TEST(r.strings == (std::vector<std::string>{"name", ""}));
+  BOOST_TEST(reader.next(r));
+  BOOST_TEST(r.reply);
+  BOOST_TEST(r.code == EPERM);
+  BOOST_TEST(r.message == "denied");
+  BOOST_TEST(r.data == "payload");
+  BOOST_TEST(!reader.next(r));
+  BOOST_TEST(!reader.truncated());
+}
+
+static
+void
+corruption()
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const root = bfs::path(d.path().string());
+  auto const path = root / "journal";
+  workload(root, path);
+  auto const size = bfs::file_size(path);
+  // A torn last record ends the journal.
+  bfs::resize_file(path, size - 3);
+  {
+    journal::Reader reader(path.string());
+    auto r = journal::Record{};
+    auto count = 0;
+    while (reader.next(r))
+      ++count;
+    BOOST_TEST(count > 0);
+    BOOST_TEST(reader.truncated());
+  }
+  // Altered content does not go unnoticed.
+  {
+    std::fstream f(path.string(),
+                   std::ios::in | std::ios::out | std::ios::binary);
+    // Past the magic and the first record frame.
+    f.seekp(17);
+    f.put('\xff');
+  }
+  journal::Reader reader(path.string());
+  auto r = journal::Record{};
+  BOOST_CHECK_THROW(while (reader.next(r)); , elle::Error);
+}
+
+static
+void
+replay()
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const root = bfs::path(d.path().string());
+  auto const path = root / "journal";
+  bfs::create_directories(root / "source");
+  bfs::create_directories(root / "target");
+  workload(root / "source", path);
+  rfs::BindOperations target(root / "target");
+  auto const stats = journal::replay(path.string(), target);
+  ELLE_LOG("replay: %s", stats);
+  BOOST_TEST(stats.failures == 1u);
+  BOOST_TEST(stats.mismatches == 0u);
+  BOOST_TEST(bfs::file_size(root / "target/dir/renamed") == 1000u);
+  BOOST_TEST(!bfs::exists(root / "target/dir/file"));
+}
+
+static
+void
+group_commit()
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const root = bfs::path(d.path().string());
+  auto const count = 100000;
+  for (auto sync: {journal::Sync::never, journal::Sync::commit})
+  {
+    auto bench = elle::Bench<>(
+      elle::print("bench.journal.append.%s",
+                  sync == journal::Sync::never ? "never" : "commit"));
+    auto const start = std::chrono::steady_clock::now();
+    journal::Writer w((root / "journal").string(), sync);
+    auto r = journal::Record{};
+    r.operation = journal::Operation::stat;
+    r.path = "/some/directory/file";
+    for (int i = 1; i <= count; ++i)
+    {
+      r.sequence = i;
+      w.append(r);
+    }
+    w.flush();
+    bench.add((std::chrono::steady_clock::now() - start) / count);
+    ELLE_TRACE("%s records in %s commits, %s syncs",
+               w.records(), w.commits(), w.syncs());
+    BOOST_TEST(w.records() == std::size_t(count));
+    BOOST_TEST(w.commits() < w.records() / 100);
+    if (sync == journal::Sync::commit)
+      BOOST_TEST(w.syncs() >= w.commits());
+  }
+}
+
+/// Written records are synced at the interval even if nothing follows.
+static
+void
+sync_interval()
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const path = bfs::path(d.path().string()) / "journal";
+  journal::Writer w(path.string(), journal::Sync::interval, 50ms);
+  auto r = journal::Record{};
+  r.sequence = 1;
+  w.append(r);
+  while (w.syncs() == 0)
+    std::this_thread::sleep_for(10ms);
+  BOOST_TEST(w.records() == 1u);
+}
+
+static
+void
+invalid_sync()
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const root = bfs::path(d.path().string());
+  elle::os::setenv("INFINIT_FILESYSTEM_JOURNAL_SYNC", "often");
+  elle::SafeFinally unset(
+    [] { elle::os::unsetenv("INFINIT_FILESYSTEM_JOURNAL_SYNC"); });
+  BOOST_CHECK_THROW(
+    rfs::install_journal(std::make_unique<rfs::BindOperations>(root),
+                         (root / "journal").string()),
+    elle::Error);
+}
+
+/// A flush waits for its own records even when another flush is in
+/// progress.
+static
+void
+concurrent_flush()
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const path = bfs::path(d.path().string()) / "journal";
+  journal::Writer w(path.string(), journal::Sync::never, 1s, 1h);
+  auto mutex = std::mutex();
+  auto appended = std::size_t(0);
+  auto early = std::atomic<int>(0);
+  auto const flusher = [&]
+    {
+      auto r = journal::Record{};
+      for (int i = 0; i < 10000; ++i)
+      {
+        auto mine = std::size_t(0);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          r.sequence = ++appended;
+          w.append(r);
+          mine = appended;
+        }
+        w.flush();
+        if (w.records() < mine)
+          ++early;
+      }
+    };
+  std::thread first(flusher);
+  std::thread second(flusher);
+  first.join();
+  second.join();
+  BOOST_TEST(early == 0);
+  BOOST_TEST(w.records() == 20000u);
+}
+
+/// Flushing only blocks the calling reactor thread.
+ELLE_TEST_SCHEDULED(scheduled_flush)
+{
+  elle::filesystem::TemporaryDirectory d;
+  auto const path = bfs::path(d.path().string()) / "journal";
+  journal::Writer w(path.string(), journal::Sync::commit);
+  auto r = journal::Record{};
+  r.sequence = 1;
+  w.append(r);
+  auto ran = false;
+  elle::reactor::Thread other("other", [&] { ran = true; });
+  w.flush();
+  BOOST_TEST(ran);
+  BOOST_TEST(w.records() == 1u);
+  elle::reactor::wait(other);
+}
+
+ELLE_TEST_SUITE()
+{
+  auto& suite = boost::unit_test::framework::master_test_suite();
+  suite.add(BOOST_TEST_CASE(round_trip), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(corruption), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(replay), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(group_commit), 0, valgrind(30));
+  suite.add(BOOST_TEST_CASE(sync_interval), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(invalid_sync), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(concurrent_flush), 0, valgrind(10));
+  suite.add(BOOST_TEST_CASE(scheduled_flush), 0, valgrind(3));
+}
@@ -1,10 +1,19 @@
+#include <sstream>
 #include <utility>
 
+#include <curl/curl.h>
+
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
 #include <boost/algorithm/string.hpp>
 #include <elle/reactor/asio.hh>
 #include <boost/test/unit_test.hpp>
 
 #include <elle/Buffer.hh>
+#include <elle/bench.hh>
+#include <elle/finally.hh>
+#include <elle/log/TextLogger.hh>
 #include <elle/With.hh>
 #include <elle/test.hh>
 #include <elle/utility/Move.hh>
@@ -17,6 +26,7 @@
 #include <elle/reactor/http/exceptions.hh>
 #include <elle/reactor/network/Error.hh>
 #include <elle/reactor/network/TCPServer.hh>
+#include <elle/reactor/network/ssl-server.hh>
 #include <elle/reactor/scheduler.hh>
 #include <elle/reactor/semaphore.hh>
 #include <elle/reactor/signal.hh>
@@ -789,6 +799,509 @@ ELLE_TEST_SCHEDULED(redirection)
   BOOST_CHECK_EQUAL(r.headers().at("Location"), "http://example.org/other");
 }
 
+/*------------.
+| Connections |
+`------------*/
+
+namespace
+{
+  // A throwaway self-signed certificate for local HTTPS servers.
+  std::unique_ptr<elle::reactor::network::SSLCertificate>
+  self_signed_certificate()
+  {
+    auto res = std::make_unique<elle::reactor::network::SSLCertificate>(
+      boost::asio::ssl::context::sslv23_server);
+    auto key = elle::generic_unique_ptr<EVP_PKEY>(EVP_PKEY_new(),
+                                                  &EVP_PKEY_free);
+    {
+      auto e = elle::generic_unique_ptr<BIGNUM>(BN_new(), &BN_free);
+      BN_set_word(e.get(), RSA_F4);
+      auto rsa = RSA_new();
+      RSA_generate_key_ex(rsa, 2048, e.get(), nullptr);
+      EVP_PKEY_assign_RSA(key.get(), rsa);
+    }
+    auto x509 = elle::generic_unique_ptr<X509>(X509_new(), &X509_free);
+    ASN1_INTEGER_set(X509_get_serialNumber(x509.get()), 1);
+    X509_gmtime_adj(X509_get_notBefore(x509.get()), 0);
+    X509_gmtime_adj(X509_get_notAfter(x509.get()), 3600);
+    X509_set_pubkey(x509.get(), key.get());
+    auto name = X509_get_subject_name(x509.get());
+    X509_NAME_add_entry_by_txt(
+      name, "CN", MBSTRING_ASC,
+      reinterpret_cast<unsigned char const*>("127.0.0.1"), -1, -1, 0);
+    X509_set_issuer_name(x509.get(), name);
+    X509_sign(x509.get(), key.get(), EVP_sha256());
+    auto ctx = res->context().native_handle();
+    BOOST_REQUIRE(SSL_CTX_use_certificate(ctx, x509.get()) == 1);
+    BOOST_REQUIRE(SSL_CTX_use_PrivateKey(ctx, key.get()) == 1);
+    return res;
+  }
+
+  std::unique_ptr<HTTPServer>
+  small_server(bool https, bool keep_alive)
+  {
+    auto res = [&]
+      {
+        if (!https)
+          return std::make_unique<HTTPServer>();
+        auto server = std::make_unique<elle::reactor::network::SSLServer>(
+          self_signed_certificate());
+        server->listen();
+        return std::make_unique<HTTPServer>(std::move(server));
+      }();
+    res->keep_alive(keep_alive);
+    res->register_route(
+      "/small", elle::reactor::http::Method::GET,
+      [] (HTTPServer::Headers const&,
+          HTTPServer::Cookies const&,
+          HTTPServer::Parameters const&,
+          elle::Buffer const&) -> std::string
+      {
+        return "small";
+      });
+    return res;
+  }
+
+  auto
+  small_conf()
+  {
+    auto res = elle::reactor::http::Request::Configuration{};
+    res.ssl_verify_host(false);
+    return res;
+  }
+}
+
+ELLE_TEST_SCHEDULED(connection_reuse)
+{
+  auto server = small_server(false, true);
+  auto client = elle::reactor::http::Client{};
+  for (int i = 0; i < 5; ++i)
+    BOOST_TEST(client.get(server->url("small")) == "small");
+  auto const stats = client.statistics();
+  BOOST_TEST(stats.requests == 5);
+  BOOST_TEST(stats.connections == 1);
+  BOOST_TEST(stats.reused == 4);
+  BOOST_TEST(stats.http2 == 0);
+}
+
+ELLE_TEST_SCHEDULED(max_host_connections)
+{
+  auto server = small_server(false, true);
+  auto client = elle::reactor::http::Client{};
+  client.max_host_connections(1);
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+  {
+    for (int i = 0; i < 4; ++i)
+      scope.run_background(
+        elle::print("get {}", i),
+        [&]
+        {
+          BOOST_TEST(client.get(server->url("small")) == "small");
+        });
+    elle::reactor::wait(scope);
+  };
+  auto const stats = client.statistics();
+  BOOST_TEST(stats.requests == 4);
+  BOOST_TEST(stats.connections == 1);
+}
+
+namespace
+{
+  /// Read an HTTP response from a raw socket.
+  ///
+  /// @returns The status line and the body.
+  std::pair<std::string, std::string>
+  raw_response(elle::reactor::network::Socket& socket)
+  {
+    auto const head = socket.read_until("\r\n\r\n").string();
+    auto const status = head.substr(0, head.find("\r\n"));
+    auto const length = head.find("Content-Length: ");
+    BOOST_REQUIRE(length != std::string::npos);
+    auto const size = std::stoi(head.substr(length + 16));
+    return {status, socket.read(size).string()};
+  }
+}
+
+ELLE_TEST_SCHEDULED(keep_alive_errors)
+{
+  auto server = small_server(false, true);
+  elle::reactor::network::TCPSocket socket("127.0.0.1", server->port());
+  auto request = [&] (std::string const& r)
+    {
+      socket.write(elle::ConstWeakBuffer(r));
+      return raw_response(socket);
+    };
+  // Refused requests are read entirely, so the connection serves the next
+  // ones.
+  BOOST_TEST(request("GET /missing HTTP/1.1\r\n"
+                     "Content-Length: 0\r\n\r\n").first ==
+             "HTTP/1.1 404 Not Found");
+  BOOST_TEST(request("POST /small HTTP/1.1\r\n"
+                     "Content-Length: 19\r\n\r\n"
+                     "GET /small HTTP/1.1").first ==
+             "HTTP/1.1 405 Method Not Allowed");
+  BOOST_TEST(request("GET /small HTTP/1.1\r\n"
+                     "Content-Length: 0\r\n\r\n") ==
+             std::make_pair("HTTP/1.1 200 OK"s, "small"s));
+  // The end of an ill-formed request is unknown: close the connection.
+  BOOST_TEST(request("GET /small HTTP/1.1\r\n"
+                     "Content-Length: 1 2\r\n\r\n").first ==
+             "HTTP/1.1 400 Bad Request");
+  BOOST_CHECK_THROW(socket.read(1), elle::reactor::network::ConnectionClosed);
+}
+
+ELLE_TEST_SCHEDULED(keep_alive_hang_up)
+{
+  auto server = small_server(false, true);
+  auto output = std::stringstream{};
+  auto previous =
+    elle::log::logger(std::make_unique<elle::log::TextLogger>(output));
+  elle::SafeFinally restore([&] { elle::log::logger(std::move(previous)); });
+  {
+    elle::reactor::network::TCPSocket socket("127.0.0.1", server->port());
+    socket.write(elle::ConstWeakBuffer("GET /small HTTP/1.1\r\n"
+                                       "Content-Length: 0\r\n\r\n"));
+    BOOST_TEST(raw_response(socket).second == "small");
+  }
+  // Let the server notice the client is gone.
+  elle::reactor::sleep(valgrind(100ms));
+  // Hanging up between requests is how keep-alive connections end.
+  BOOST_TEST(output.str().find("internal error") == std::string::npos);
+}
+
+namespace
+{
+  /// A minimal HTTP/2 server, enough for curl to GET.
+  ///
+  /// Replies are held until concurrent streams are open, which proves they
+  /// are multiplexed on a single connection.
+  class Http2Server
+  {
+  public:
+    Http2Server(int concurrent)
+      : _concurrent(concurrent)
+      , _connections(0)
+      , _server(_alpn(self_signed_certificate()))
+      , _accepter("accept", [this] { this->_accept(); })
+    {
+      this->_server.listen();
+    }
+
+    ~Http2Server()
+    {
+      this->_accepter.terminate_now();
+    }
+
+    std::string
+    url(std::string const& path)
+    {
+      return elle::print("https://127.0.0.1:{}/{}", this->_server.port(), path);
+    }
+
+    ELLE_ATTRIBUTE(int, concurrent);
+    ELLE_ATTRIBUTE_R(int, connections);
+    ELLE_ATTRIBUTE(elle::reactor::network::SSLServer, server);
+    ELLE_ATTRIBUTE(elle::reactor::Thread, accepter);
+
+  private:
+    static
+    std::unique_ptr<elle::reactor::network::SSLCertificate>
+    _alpn(std::unique_ptr<elle::reactor::network::SSLCertificate> certificate)
+    {
+      SSL_CTX_set_alpn_select_cb(
+        certificate->context().native_handle(),
+        [] (SSL*, unsigned char const** out, unsigned char* outlen,
+            unsigned char const* in, unsigned int inlen, void*)
+        {
+          static unsigned char const h2[] = {2, 'h', '2'};
+          auto res = SSL_select_next_proto(
+            const_cast<unsigned char**>(out), outlen,
+            h2, sizeof h2, in, inlen);
+          return res == OPENSSL_NPN_NEGOTIATED ?
+            SSL_TLSEXT_ERR_OK : SSL_TLSEXT_ERR_NOACK;
+        },
+        nullptr);
+      return certificate;
+    }
+
+    void
+    _accept()
+    {
+      elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+      {
+        while (true)
+        {
+          auto socket = elle::utility::move_on_copy(this->_server.accept());
+          ++this->_connections;
+          scope.run_background(
+            "serve",
+            [this, socket]
+            {
+              try
+              {
+                this->_serve(**socket);
+              }
+              catch (elle::reactor::network::Error const&)
+              {}
+            });
+        }
+      };
+    }
+
+    static
+    void
+    _frame(elle::reactor::network::Socket& socket,
+           int type, int flags, int stream, std::string const& payload)
+    {
+      auto const size = payload.size();
+      auto const header = std::string{
+        char(size >> 16), char(size >> 8), char(size),
+        char(type), char(flags),
+        char(stream >> 24), char(stream >> 16), char(stream >> 8),
+        char(stream)};
+      socket.write(elle::ConstWeakBuffer(header + payload));
+    }
+
+    void
+    _serve(elle::reactor::network::Socket& socket)
+    {
+      auto const preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"s;
+      BOOST_TEST(socket.read(preface.size()).string() == preface);
+      enum {data = 0, headers = 1, settings = 4, ping = 6, goaway = 7};
+      auto const end_stream = 0x1;
+      auto const ack = 0x1;
+      auto const end_headers = 0x4;
+      _frame(socket, settings, 0, 0, "");
+      auto pending = std::vector<int>{};
+      while (true)
+      {
+        auto const header = socket.read(9);
+        auto const b = header.contents();
+        auto const size = (b[0] << 16) | (b[1] << 8) | b[2];
+        auto const type = b[3];
+        auto const flags = b[4];
+        auto const stream =
+          ((b[5] & 0x7f) << 24) | (b[6] << 16) | (b[7] << 8) | b[8];
+        auto const payload = socket.read(size).string();
+        if (type == settings && !(flags & ack))
+          _frame(socket, settings, ack, 0, "");
+        else if (type == ping && !(flags & ack))
+          _frame(socket, ping, ack, 0, payload);
+        else if (type == goaway)
+          return;
+        else if (type == headers && flags & end_stream)
+        {
+          pending.push_back(stream);
+          if (int(pending.size()) == this->_concurrent)
+          {
+            for (auto s: pending)
+            {
+              // ":status: 200", from the HPACK static table.
+              _frame(socket, headers, end_headers, s, "\x88");
+              _frame(socket, data, end_stream, s, "small");
+            }
+            pending.clear();
+          }
+        }
+      }
+    }
+  };
+}
+
+ELLE_TEST_SCHEDULED(http2_multiplexing)
+{
+  if (!(curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2))
+  {
+    BOOST_TEST_MESSAGE("curl lacks HTTP/2");
+    return;
+  }
+  auto const concurrent = 4;
+  Http2Server server(concurrent);
+  auto client = elle::reactor::http::Client{};
+  auto conf = small_conf();
+  conf.version(elle::reactor::http::Version::v20);
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+  {
+    for (int i = 0; i < concurrent; ++i)
+      scope.run_background(
+        elle::print("get {}", i),
+        [&]
+        {
+          BOOST_TEST(client.get(server.url("small"), conf) == "small");
+        });
+    elle::reactor::wait(scope);
+  };
+  auto const stats = client.statistics();
+  BOOST_TEST(stats.requests == concurrent);
+  BOOST_TEST(stats.http2 == concurrent);
+  BOOST_TEST(stats.connections == 1);
+  BOOST_TEST(server.connections() == 1);
+}
+
+// Small HTTPS GETs, with and without keep-alive. Durations are reported
+// with ELLE_LOG_LEVEL="bench.http.*:TRACE".
+ELLE_TEST_SCHEDULED(small_gets)
+{
+  auto const count = 100;
+  for (auto keep_alive: {false, true})
+  {
+    auto server = small_server(true, keep_alive);
+    auto client = elle::reactor::http::Client{};
+    {
+      auto bench = elle::Bench<>(elle::print(
+        "bench.http.small_gets.{}", keep_alive ? "keep_alive" : "close"));
+      for (int i = 0; i < count; ++i)
+      {
+        auto s = bench.scoped();
+        BOOST_TEST(client.get(server->url("small"), small_conf()) == "small");
+      }
+    }
+    auto const stats = client.statistics();
+    BOOST_TEST(stats.requests == count);
+    BOOST_TEST(stats.reused == (keep_alive ? count - 1 : 0));
+  }
+}
+
+namespace
+{
+  std::string
+  large_body(int size)
+  {
+    auto res = std::string(size, 0);
+    for (int i = 0; i < size; ++i)
+      res[i] = 'a' + i % 26;
+    return res;
+  }
+
+  std::unique_ptr<HTTPServer>
+  large_server(std::string const& body)
+  {
+    auto res = std::make_unique<HTTPServer>();
+    res->register_route(
+      "/large", elle::reactor::http::Method::GET,
+      [&body] (HTTPServer::Headers const&,
+               HTTPServer::Cookies const&,
+               HTTPServer::Parameters const&,
+               elle::Buffer const&) -> std::string
+      {
+        return body;
+      });
+    res->register_route(
+      "/echo", elle::reactor::http::Method::POST,
+      [] (HTTPServer::Headers const&,
+          HTTPServer::Cookies const&,
+          HTTPServer::Parameters const&,
+          elle::Buffer const& body) -> std::string
+      {
+        return body.string();
+      });
+    return res;
+  }
+
+  std::string
+  read_all(elle::reactor::http::Request& r, int chunk)
+  {
+    auto res = std::string{};
+    auto buffer = elle::Buffer(chunk);
+    while (auto read = r.read_into(buffer))
+      res.append(reinterpret_cast<char const*>(buffer.contents()), read);
+    return res;
+  }
+}
+
+ELLE_TEST_SCHEDULED(receive_backpressure)
+{
+  using elle::reactor::http::Request;
+  auto const body = large_body(4 * 1024 * 1024);
+  auto server = large_server(body);
+  auto conf = Request::Configuration{};
+  conf.receive_buffer_size(64 * 1024);
+  Request r(server->url("large"), elle::reactor::http::Method::GET, conf);
+  r.finalize();
+  // Let the transfer fill the buffer before consuming it.
+  elle::reactor::sleep(100ms);
+  BOOST_CHECK(read_all(r, 1000) == body);
+  BOOST_TEST(r.status() == elle::reactor::http::StatusCode::OK);
+  BOOST_TEST(r.receive_pause_count() > 0);
+}
+
+ELLE_TEST_SCHEDULED(read_into_mixed)
+{
+  using elle::reactor::http::Request;
+  auto const body = large_body(100000);
+  auto server = large_server(body);
+  auto conf = Request::Configuration{};
+  conf.receive_buffer_size(64 * 1024);
+  Request r(server->url("large"), elle::reactor::http::Method::GET, conf);
+  char head[10];
+  r.read(head, sizeof head);
+  auto res = std::string(head, sizeof head);
+  res += read_all(r, 4096);
+  BOOST_CHECK(res == body);
+}
+
+ELLE_TEST_SCHEDULED(wait_then_read)
+{
+  using elle::reactor::http::Request;
+  auto const body = large_body(1024 * 1024);
+  auto server = large_server(body);
+  auto conf = Request::Configuration{};
+  conf.receive_buffer_size(64 * 1024);
+  Request r(server->url("large"), elle::reactor::http::Method::GET, conf);
+  // Waiting without reading must not stall the transfer.
+  elle::reactor::wait(r);
+  BOOST_CHECK(r.response().string() == body);
+}
+
+ELLE_TEST_SCHEDULED(write_from)
+{
+  using elle::reactor::http::Request;
+  auto const body = large_body(256 * 1024);
+  auto server = large_server(body);
+  for (auto chunked: {false, true})
+  {
+    auto conf = Request::Configuration{};
+    conf.chunked_transfers(chunked);
+    Request r(server->url("echo"), elle::reactor::http::Method::POST,
+              "application/octet-stream", conf);
+    r << body.substr(0, 10);
+    r.write_from(elle::ConstWeakBuffer(body).range(10));
+    r.finalize();
+    BOOST_CHECK(r.response().string() == body);
+  }
+}
+
+// Download throughput through the stream interface and through read_into.
+ELLE_TEST_SCHEDULED(large_download)
+{
+  using elle::reactor::http::Request;
+  auto const body = large_body(32 * 1024 * 1024);
+  auto server = large_server(body);
+  for (auto direct: {false, true})
+  {
+    auto bench = elle::Bench<>(elle::print(
+      "bench.http.large_download.{}", direct ? "read_into" : "stream"));
+    auto size = std::size_t(0);
+    auto pauses = 0;
+    {
+      auto const s = bench.scoped();
+      Request r(server->url("large"));
+      if (direct)
+        size = read_all(r, 64 * 1024).size();
+      else
+      {
+        auto buffer = elle::Buffer(64 * 1024);
+        auto data = reinterpret_cast<char*>(buffer.mutable_contents());
+        while (r.read(data, buffer.size()) || r.gcount())
+          size += r.gcount();
+      }
+      pauses = r.receive_pause_count();
+    }
+    BOOST_TEST(size == body.size());
+    ELLE_LOG("%s: %s pauses", direct ? "read_into" : "stream", pauses);
+  }
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
@@ -819,4 +1332,15 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(query_string), 0, valgrind(1));
   suite.add(BOOST_TEST_CASE(keep_alive), 0, valgrind(1));
   suite.add(BOOST_TEST_CASE(redirection), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(connection_reuse), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(keep_alive_errors), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(keep_alive_hang_up), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(http2_multiplexing), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(max_host_connections), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(small_gets), 0, valgrind(20));
+  suite.add(BOOST_TEST_CASE(receive_backpressure), 0, valgrind(10));
+  suite.add(BOOST_TEST_CASE(read_into_mixed), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(wait_then_read), 0, valgrind(10));
+  suite.add(BOOST_TEST_CASE(write_from), 0, valgrind(10));
+  suite.add(BOOST_TEST_CASE(large_download), 0, valgrind(60));
 }
@@ -13,6 +13,7 @@
 #include <elle/reactor/asio.hh>
 #include <elle/reactor/Scope.hh>
 #include <elle/reactor/network/Error.hh>
+#include <elle/reactor/network/rdv.hh>
 #include <elle/reactor/network/resolve.hh>
 #include <elle/reactor/network/TCPServer.hh>
 #include <elle/reactor/network/TCPSocket.hh>
@@ -801,6 +802,59 @@ ELLE_TEST_SCHEDULED(async_write)
   elle::reactor::wait(read);
 }
 
+/*-----.
+| RDV |
+`-----*/
+
+static
+void
+rdv_encoding()
+{
+  namespace rdv = elle::reactor::network::rdv;
+  auto msg = rdv::Message{};
+  msg.id = "6f1c2b1e-96d4-4e52-8a3c-61c1b1d1a0f3";
+  msg.command = rdv::Command::connect_requested;
+  msg.source_endpoint = rdv::Endpoint(
+    boost::asio::ip::address::from_string("192.168.1.2"), 51234);
+  msg.target_endpoint = rdv::Endpoint(
+    boost::asio::ip::address::from_string("2001:db8::1"), 7890);
+  msg.target_address = "peer";
+  auto const check = [&] (rdv::Message const& m)
+    {
+      BOOST_TEST(m.id == msg.id);
+      BOOST_TEST(int(m.command) == int(msg.command));
+      BOOST_CHECK(m.source_endpoint == msg.source_endpoint);
+      BOOST_CHECK(m.target_endpoint == msg.target_endpoint);
+      BOOST_CHECK(m.target_address == msg.target_address);
+    };
+  for (auto e: {rdv::Encoding::json, rdv::Encoding::binary})
+  {
+    auto const data = rdv::pack(msg, e);
+    auto encoding = rdv::Encoding::json;
+    check(rdv::unpack(data, &encoding));
+    BOOST_TEST(int(encoding) == int(e));
+  }
+  // Binary messages are much smaller than JSON ones.
+  BOOST_TEST(rdv::pack(msg, rdv::Encoding::binary).size() <
+             rdv::pack(msg, rdv::Encoding::json).size() / 2);
+  // Legacy JSON without magic.
+  auto const legacy = elle::serialization::json::serialize(msg, false);
+  check(rdv::unpack(legacy));
+  // Optional fields.
+  auto ping = rdv::Message{};
+  ping.id = "ping";
+  ping.command = rdv::Command::ping;
+  auto const packed = rdv::pack(ping, rdv::Encoding::binary);
+  auto const unpacked = rdv::unpack(packed);
+  BOOST_TEST(unpacked.id == "ping");
+  BOOST_TEST(!unpacked.source_endpoint);
+  BOOST_TEST(!unpacked.target_address);
+  // Truncated messages.
+  auto const data = rdv::pack(msg, rdv::Encoding::binary);
+  auto const truncated = data.range(0, data.size() - 1);
+  BOOST_CHECK_THROW(rdv::unpack(truncated), elle::Error);
+}
+
 /*-----------.
 | Test suite |
 `-----------*/
@@ -840,4 +894,5 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(read_terminate_recover_iostream), 0, 1);
   suite.add(BOOST_TEST_CASE(read_terminate_deadlock), 0, 1);
   suite.add(BOOST_TEST_CASE(async_write), 0, 10);
+  suite.add(BOOST_TEST_CASE(rdv_encoding), 0, 1);
 }
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <elle/With.hh>
+#include <elle/bench.hh>
+#include <elle/log.hh>
+#include <elle/test.hh>
+
+#include <elle/reactor/ProducerPool.hh>
+#include <elle/reactor/Scope.hh>
+
+ELLE_LOG_COMPONENT("elle.reactor.ProducerPool.test");
+
+using namespace std::literals;
+
+/// Wait until @a pool holds @a size values.
+template <typename T>
+static
+void
+wait_size(elle::reactor::ProducerPool<T> const& pool, int size)
+{
+  while (pool.size() != size || pool.producing())
+    elle::reactor::sleep(1ms);
+}
+
+ELLE_TEST_SCHEDULED(get)
+{
+  // Productions still running when the pool is destroyed are abandoned, not
+  // waited for: share the counter with them.
+  auto count = std::make_shared<std::atomic<int>>(0);
+  elle::reactor::ProducerPool<int> pool(
+    [count]
+    {
+      std::this_thread::sleep_for(1ms);
+      return (*count)++;
+    },
+    8, 2);
+  auto values = std::vector<int>{};
+  for (int i = 0; i < 20; ++i)
+    values.emplace_back(pool.get());
+  std::sort(values.begin(), values.end());
+  BOOST_TEST((std::unique(values.begin(), values.end()) == values.end()));
+  BOOST_TEST(pool.produced() >= 20u);
+  auto recorded = std::size_t(0);
+  for (auto c: pool.latency())
+    recorded += c;
+  BOOST_TEST(recorded == pool.produced());
+}
+
+ELLE_TEST_SCHEDULED(watermark)
+{
+  elle::reactor::ProducerPool<int> pool([] { return 42; }, 10, 1, 5);
+  wait_size(pool, 10);
+  for (int i = 0; i < 5; ++i)
+    pool.get();
+  elle::reactor::sleep(20ms);
+  // Not below the low watermark yet.
+  BOOST_TEST(pool.size() == 5);
+  pool.get();
+  wait_size(pool, 10);
+  // The pool never overflows.
+  elle::reactor::sleep(20ms);
+  BOOST_TEST(pool.size() == 10);
+  for (int i = 0; i < 3; ++i)
+    pool.get();
+  pool.prefetch();
+  wait_size(pool, 10);
+}
+
+ELLE_TEST_SCHEDULED(throttle)
+{
+  auto loaded = true;
+  elle::reactor::ProducerPool<int> pool([] { return 42; }, 4);
+  pool.throttle([&] { return loaded; });
+  pool.throttle_delay(5ms);
+  elle::reactor::sleep(50ms);
+  // At most the production started before throttling.
+  BOOST_TEST(pool.size() <= 1);
+  loaded = false;
+  wait_size(pool, 4);
+}
+
+/// Waiting for a value leaves the scheduler running.
+ELLE_TEST_SCHEDULED(scheduler_not_blocked)
+{
+  // Production only completes once a reactor Thread released it, which it
+  // cannot do if the scheduler is blocked.
+  auto released = std::promise<void>();
+  auto const release = released.get_future().share();
+  elle::reactor::ProducerPool<int> pool(
+    [release]
+    {
+      release.wait();
+      return 42;
+    },
+    1);
+  elle::reactor::Thread releaser(
+    "releaser", [&] { released.set_value(); });
+  BOOST_TEST(pool.get() == 42);
+  BOOST_TEST(pool.misses() == 1u);
+  elle::reactor::wait(releaser);
+}
+
+/// Delays a ticking Thread suffers while a pool produces CPU-bound values,
+/// reported as bench.reactor.producer_pool.stall: its MAX is the longest
+/// stall of the scheduler.
+ELLE_TEST_SCHEDULED(stall_benchmark)
+{
+  auto bench = elle::Bench<>("bench.reactor.producer_pool.stall");
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+  {
+    s.run_background(
+      "ticker",
+      [&]
+      {
+        while (true)
+        {
+          auto const start = elle::Clock::now();
+          elle::reactor::sleep(1ms);
+          bench.add(elle::Clock::now() - start - 1ms);
+        }
+      });
+    // CPU-bound, like generating a key.
+    elle::reactor::ProducerPool<int> pool(
+      []
+      {
+        auto const end = std::chrono::steady_clock::now() + 20ms;
+        auto spins = 0;
+        while (std::chrono::steady_clock::now() < end)
+          ++spins;
+        return spins;
+      },
+      4);
+    for (int i = 0; i < 20; ++i)
+      pool.get();
+    s.terminate_now();
+  };
+  BOOST_TEST(bench.count() > 0);
+}
+
+ELLE_TEST_SUITE()
+{
+  auto& master = boost::unit_test::framework::master_test_suite();
+  master.add(BOOST_TEST_CASE(get), 0, valgrind(3));
+  master.add(BOOST_TEST_CASE(watermark), 0, valgrind(3));
+  master.add(BOOST_TEST_CASE(throttle), 0, valgrind(3));
+  master.add(BOOST_TEST_CASE(scheduler_not_blocked), 0, valgrind(3));
+  master.add(BOOST_TEST_CASE(stall_benchmark), 0, valgrind(10));
+}
@@ -1,9 +1,11 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 
 #include "reactor.hh"
 
+#include <elle/bench.hh>
 #include <elle/finally.hh>
 #include <elle/test.hh>
 
@@ -413,6 +415,89 @@ namespace waitable
     signal();
     elle::reactor::wait(waiter);
   }
+
+  // More Waitables than a wait keeps Waiters for on its stack.
+  ELLE_TEST_SCHEDULED(many)
+  {
+    auto barriers = std::vector<std::unique_ptr<elle::reactor::Barrier>>{};
+    auto waitables = elle::reactor::Waitables{};
+    for (int i = 0; i < 3 * elle::reactor::Thread::waiter_slots; ++i)
+    {
+      barriers.emplace_back(std::make_unique<elle::reactor::Barrier>());
+      waitables.emplace_back(barriers.back().get());
+    }
+    BOOST_CHECK(!elle::reactor::wait(waitables, 10ms));
+    for (auto const& b: barriers)
+      BOOST_CHECK(b->waiters().empty());
+    bool beacon = false;
+    elle::reactor::Thread waiter(
+      "waiter",
+      [&]
+      {
+        elle::reactor::wait(waitables);
+        beacon = true;
+      });
+    // Let the waiter start.
+    elle::reactor::yield();
+    elle::reactor::yield();
+    for (auto const& b: barriers)
+      BOOST_CHECK_EQUAL(b->waiters().size(), 1);
+    for (auto it = barriers.rbegin(); it != barriers.rend(); ++it)
+    {
+      BOOST_CHECK(!beacon);
+      (*it)->open();
+      elle::reactor::yield();
+    }
+    elle::reactor::wait(waiter);
+    BOOST_CHECK(beacon);
+    for (auto const& b: barriers)
+      BOOST_CHECK(b->waiters().empty());
+  }
+
+  ELLE_TEST_SCHEDULED(terminate_waiting)
+  {
+    elle::reactor::Barrier a;
+    elle::reactor::Barrier b;
+    elle::reactor::Thread waiter(
+      "waiter", [&] { elle::reactor::wait(elle::reactor::Waitables{&a, &b}); });
+    elle::reactor::yield();
+    elle::reactor::yield();
+    BOOST_CHECK_EQUAL(a.waiters().size(), 1);
+    BOOST_CHECK_EQUAL(b.waiters().size(), 1);
+    waiter.terminate_now();
+    BOOST_CHECK(a.waiters().empty());
+    BOOST_CHECK(b.waiters().empty());
+  }
+
+  ELLE_TEST_SCHEDULED(ping_pong)
+  {
+    auto const rounds = RUNNING_ON_VALGRIND ? 1000 : 20000;
+    elle::reactor::Barrier ping("ping");
+    elle::reactor::Barrier pong("pong");
+    auto pinged = 0;
+    elle::reactor::Thread ponger(
+      "ponger",
+      [&]
+      {
+        for (int i = 0; i < rounds; ++i)
+        {
+          elle::reactor::wait(ping);
+          ++pinged;
+          ping.close();
+          pong.open();
+        }
+      });
+    auto bench = elle::Bench<>("bench.reactor.ping_pong");
+    for (int i = 0; i < rounds; ++i)
+    {
+      auto const s = bench.scoped();
+      pong.close();
+      ping.open();
+      elle::reactor::wait(pong);
+      BOOST_TEST(pinged == i + 1);
+    }
+    elle::reactor::wait(ponger);
+  }
 }
 
 /*--------.
@@ -1786,6 +1871,253 @@ test_rw_mutex_both()
   sched.run();
 }
 
+namespace rw_mutex
+{
+  using Fairness = elle::reactor::RWMutex::Fairness;
+
+  /// Run a Thread that holds a lock on @a lockable until @a release opens,
+  /// logging @a name in @a order once it got it.
+  static
+  elle::reactor::Thread::unique_ptr
+  holder(std::string const& name,
+         elle::reactor::Lockable& lockable,
+         elle::reactor::Barrier& release,
+         std::vector<std::string>& order)
+  {
+    return elle::reactor::Thread::unique_ptr(
+      new elle::reactor::Thread(
+        name,
+        [&, name]
+        {
+          elle::reactor::Lock lock(lockable);
+          order.emplace_back(name);
+          elle::reactor::wait(release);
+        }));
+  }
+
+  static
+  void
+  settle()
+  {
+    for (int i = 0; i < 4; ++i)
+      elle::reactor::yield();
+  }
+
+  ELLE_TEST_SCHEDULED(writers_first)
+  {
+    elle::reactor::RWMutex mutex(Fairness::writers);
+    auto order = std::vector<std::string>{};
+    elle::reactor::Barrier release_r1, release;
+    release.open();
+    auto r1 = holder("r1", mutex, release_r1, order);
+    settle();
+    auto w = holder("w", mutex.write(), release, order);
+    settle();
+    auto r2 = holder("r2", mutex, release, order);
+    settle();
+    // The waiting writer holds the new reader back.
+    BOOST_TEST(order == (std::vector<std::string>{"r1"}));
+    BOOST_TEST(mutex.queue() == 2);
+    release_r1.open();
+    for (auto* t: {r1.get(), w.get(), r2.get()})
+      elle::reactor::wait(*t);
+    BOOST_TEST(order == (std::vector<std::string>{"r1", "w", "r2"}));
+    BOOST_TEST(mutex.statistics().contended == 2);
+    BOOST_TEST(mutex.statistics().max_queue == 2);
+  }
+
+  static
+  std::vector<std::string>
+  phases(Fairness fairness)
+  {
+    elle::reactor::RWMutex mutex(fairness);
+    auto order = std::vector<std::string>{};
+    elle::reactor::Barrier release_w1, release_readers, release;
+    release.open();
+    auto w1 = holder("w1", mutex.write(), release_w1, order);
+    settle();
+    auto r1 = holder("r1", mutex, release_readers, order);
+    auto r2 = holder("r2", mutex, release_readers, order);
+    auto w2 = holder("w2", mutex.write(), release, order);
+    settle();
+    release_w1.open();
+    settle();
+    // A reader showing up while r1 and r2 read and w2 waits.
+    auto r3 = holder("r3", mutex, release, order);
+    settle();
+    release_readers.open();
+    for (auto* t: {w1.get(), r1.get(), r2.get(), w2.get(), r3.get()})
+      elle::reactor::wait(*t);
+    return order;
+  }
+
+  ELLE_TEST_SCHEDULED(phase_fair)
+  {
+    // Readers waiting when the writer leaves go first, and late readers
+    // wait for the next writer.
+    BOOST_TEST(phases(Fairness::phase_fair) ==
+               (std::vector<std::string>{"w1", "r1", "r2", "w2", "r3"}));
+    // Late readers barge in.
+    BOOST_TEST(phases(Fairness::readers) ==
+               (std::vector<std::string>{"w1", "r1", "r2", "r3", "w2"}));
+  }
+
+  ELLE_TEST_SCHEDULED(upgrade)
+  {
+    elle::reactor::RWMutex mutex;
+    auto order = std::vector<std::string>{};
+    elle::reactor::Barrier release_r1, downgrade, release;
+    release.open();
+    auto r1 = holder("r1", mutex, release_r1, order);
+    settle();
+    elle::reactor::Thread upgrader(
+      "upgrader",
+      [&]
+      {
+        elle::reactor::Lock lock(mutex.upgradable());
+        order.emplace_back("upgradable");
+        mutex.upgrade();
+        order.emplace_back("upgraded");
+        elle::reactor::wait(downgrade);
+        mutex.downgrade();
+        order.emplace_back("downgraded");
+      });
+    settle();
+    // Only one upgradable lock at a time.
+    BOOST_TEST(!mutex.upgradable().try_lock_for(10ms));
+    // New readers wait for the upgrade.
+    auto r2 = holder("r2", mutex, release, order);
+    settle();
+    BOOST_TEST(order == (std::vector<std::string>{"r1", "upgradable"}));
+    release_r1.open();
+    settle();
+    BOOST_TEST(order ==
+               (std::vector<std::string>{"r1", "upgradable", "upgraded"}));
+    BOOST_TEST(mutex.write().locked());
+    downgrade.open();
+    elle::reactor::wait(*r2);
+    elle::reactor::wait(upgrader);
+    BOOST_TEST(order ==
+               (std::vector<std::string>{
+                 "r1", "upgradable", "upgraded", "downgraded", "r2"}));
+    // Releasing an upgraded lock downgrades it first.
+    {
+      elle::reactor::Lock lock(mutex.upgradable());
+      mutex.upgrade();
+      BOOST_TEST(mutex.write().locked());
+    }
+    BOOST_TEST(!mutex.locked());
+    BOOST_TEST(!mutex.write().locked());
+    BOOST_TEST(mutex.statistics().writes == 2);
+  }
+
+  ELLE_TEST_SCHEDULED(try_lock_for)
+  {
+    elle::reactor::RWMutex mutex(Fairness::writers);
+    auto order = std::vector<std::string>{};
+    elle::reactor::Barrier release_r1, release;
+    release.open();
+    auto r1 = holder("r1", mutex, release_r1, order);
+    settle();
+    // Shows up while the writer below waits.
+    auto r2 = holder("r2", mutex, release, order);
+    BOOST_TEST(!mutex.write().try_lock_for(10ms));
+    // The writer that gave up does not hold readers back anymore.
+    elle::reactor::wait(*r2);
+    BOOST_TEST(mutex.queue() == 0);
+    release_r1.open();
+    elle::reactor::wait(*r1);
+    BOOST_TEST(mutex.write().try_lock_for(10ms));
+    BOOST_TEST(mutex.write().locked());
+    mutex.write().release();
+    BOOST_TEST(mutex.try_lock_for(10ms));
+    mutex.release();
+    BOOST_TEST(!mutex.locked());
+  }
+
+  /// A reader woken by a leaving writer, but killed before it retries,
+  /// does not hold writers back.
+  ELLE_TEST_SCHEDULED(killed_reader)
+  {
+    for (auto fairness: {Fairness::readers, Fairness::phase_fair})
+    {
+      elle::reactor::RWMutex mutex(fairness);
+      auto order = std::vector<std::string>{};
+      elle::reactor::Barrier release_reader, release_writer;
+      auto reader = elle::reactor::Thread::unique_ptr();
+      elle::reactor::Thread writer(
+        "writer",
+        [&]
+        {
+          {
+            elle::reactor::Lock lock(mutex.write());
+            elle::reactor::wait(release_writer);
+          }
+          // The reader was woken, kill it before it runs again.
+          reader->terminate_now();
+        });
+      settle();
+      reader = holder("reader", mutex, release_reader, order);
+      settle();
+      release_writer.open();
+      elle::reactor::wait(writer);
+      BOOST_TEST(order.empty());
+      BOOST_TEST(mutex.queue() == 0);
+      BOOST_TEST(mutex.write().try_lock_for(10ms));
+      mutex.write().release();
+    }
+  }
+
+  ELLE_TEST_SCHEDULED(contention_benchmark)
+  {
+    auto const rounds = RUNNING_ON_VALGRIND ? 10 : 1000;
+    for (auto fairness:
+           {Fairness::readers, Fairness::writers, Fairness::phase_fair})
+    {
+      elle::reactor::RWMutex mutex(fairness);
+      auto threads = std::vector<elle::reactor::Thread::unique_ptr>{};
+      auto value = 0;
+      for (int i = 0; i < 16; ++i)
+        threads.emplace_back(new elle::reactor::Thread(
+          elle::print("reader {}", i),
+          [&]
+          {
+            for (int r = 0; r < rounds; ++r)
+            {
+              elle::reactor::Lock lock(mutex);
+              auto const v = value;
+              elle::reactor::yield();
+              BOOST_TEST(value == v);
+            }
+          }));
+      for (int i = 0; i < 2; ++i)
+        threads.emplace_back(new elle::reactor::Thread(
+          elle::print("writer {}", i),
+          [&]
+          {
+            for (int r = 0; r < rounds; ++r)
+            {
+              elle::reactor::Lock lock(mutex.write());
+              ++value;
+              elle::reactor::yield();
+            }
+          }));
+      auto bench = elle::Bench<>(
+        elle::print("bench.reactor.rw_mutex.{}", fairness));
+      {
+        auto const s = bench.scoped();
+        for (auto& t: threads)
+          elle::reactor::wait(*t);
+      }
+      BOOST_TEST(value == 2 * rounds);
+      auto const& stats = mutex.statistics();
+      BOOST_TEST(stats.reads == 16u * rounds);
+      BOOST_TEST(stats.writes == 2u * rounds);
+      BOOST_TEST(mutex.queue() == 0);
+    }
+  }
+}
+
 /*--------.
 | Storage |
 `--------*/
@@ -1818,6 +2150,115 @@ test_storage()
   sched.run();
 }
 
+static
+void
+test_storage_destruction()
+{
+  struct Counted
+  {
+    Counted()
+    {
+      ++alive();
+    }
+
+    ~Counted()
+    {
+      --alive();
+    }
+
+    static
+    int&
+    alive()
+    {
+      static int res = 0;
+      return res;
+    }
+  };
+  {
+    elle::reactor::Scheduler sched;
+    elle::reactor::Thread main(
+      sched, "main",
+      [&]
+      {
+        {
+          elle::reactor::LocalStorage<Counted> val;
+          elle::reactor::Thread t(
+            "t", [&] { val.get(); elle::reactor::yield(); });
+          val.get();
+          elle::reactor::wait(t);
+          BOOST_TEST(Counted::alive() == 2);
+        }
+        // Values die with their storage, even if their Thread lives on.
+        BOOST_TEST(Counted::alive() == 0);
+        elle::reactor::LocalStorage<Counted> reused;
+        reused.get();
+        BOOST_TEST(Counted::alive() == 1);
+        elle::reactor::LocalStorage<int> other;
+        BOOST_TEST(other.get(42) == 42);
+        BOOST_TEST(other.get(51) == 42);
+      });
+    sched.run();
+  }
+  BOOST_TEST(Counted::alive() == 0);
+}
+
+static
+void
+test_storage_benchmark()
+{
+  // The former implementation: a locked hash map keyed by Thread.
+  struct Locked
+  {
+    int&
+    get()
+    {
+      auto const key = static_cast<void*>(
+        elle::reactor::scheduler().current());
+      std::lock_guard<std::mutex> lock(this->mutex);
+      return this->content[key];
+    }
+
+    std::unordered_map<void*, int> content;
+    std::mutex mutex;
+  };
+  auto const rounds = RUNNING_ON_VALGRIND ? 1000 : 100000;
+  elle::reactor::Scheduler sched;
+  elle::reactor::Thread main(
+    sched, "main",
+    [&]
+    {
+      auto const bench = [&] (std::string const& name, auto& storage)
+        {
+          // Accesses are too short to be timed one by one.
+          auto b = elle::Bench<>(
+            elle::print("bench.reactor.storage.{}.{}", name, rounds));
+          {
+            auto const s = b.scoped();
+            for (int i = 0; i < rounds; ++i)
+              ++storage.get();
+          }
+          BOOST_TEST(storage.get() == rounds);
+        };
+      // Populate other Threads so the locked map is not trivially small.
+      auto locked = Locked{};
+      auto slotted = elle::reactor::LocalStorage<int>{};
+      auto threads = std::vector<elle::reactor::Thread::unique_ptr>{};
+      for (int i = 0; i < 64; ++i)
+        threads.emplace_back(new elle::reactor::Thread(
+          elle::print("thread {}", i),
+          [&]
+          {
+            locked.get();
+            slotted.get();
+          }));
+      for (auto& t: threads)
+        elle::reactor::wait(*t);
+      bench("locked", locked);
+      bench("slotted", slotted);
+    });
+  sched.run();
+}
+
 // Most likely a wine issue. To be investigated.
 #ifndef ELLE_WINDOWS
 static
@@ -3415,6 +3856,9 @@ ELLE_TEST_SUITE()
     subsuite->add(BOOST_TEST_CASE(boost_signal_args), 0, valgrind(1, 5));
     subsuite->add(BOOST_TEST_CASE(boost_signal_predicate), 0, valgrind(1, 5));
     subsuite->add(BOOST_TEST_CASE(boost_signal_waiter), 0, valgrind(1, 5));
+    subsuite->add(BOOST_TEST_CASE(many), 0, valgrind(1, 5));
+    subsuite->add(BOOST_TEST_CASE(terminate_waiting), 0, valgrind(1, 5));
+    subsuite->add(BOOST_TEST_CASE(ping_pong), 0, valgrind(10, 5));
   }
 
   boost::unit_test::test_suite* signals = BOOST_TEST_SUITE("Signals");
@@ -3578,10 +4022,21 @@ ELLE_TEST_SUITE()
   rwmtx->add(BOOST_TEST_CASE(test_rw_mutex_multi_read), 0, valgrind(1, 5));
   rwmtx->add(BOOST_TEST_CASE(test_rw_mutex_multi_write), 0, valgrind(1, 5));
   rwmtx->add(BOOST_TEST_CASE(test_rw_mutex_both), 0, valgrind(1, 5));
+  {
+    using namespace rw_mutex;
+    rwmtx->add(BOOST_TEST_CASE(writers_first), 0, valgrind(1, 5));
+    rwmtx->add(BOOST_TEST_CASE(phase_fair), 0, valgrind(1, 5));
+    rwmtx->add(BOOST_TEST_CASE(upgrade), 0, valgrind(1, 5));
+    rwmtx->add(BOOST_TEST_CASE(try_lock_for), 0, valgrind(1, 5));
+    rwmtx->add(BOOST_TEST_CASE(killed_reader), 0, valgrind(1, 5));
+    rwmtx->add(BOOST_TEST_CASE(contention_benchmark), 0, valgrind(5, 5));
+  }
 
   boost::unit_test::test_suite* storage = BOOST_TEST_SUITE("Storage");
   boost::unit_test::framework::master_test_suite().add(storage);
   storage->add(BOOST_TEST_CASE(test_storage), 0, valgrind(1, 5));
+  storage->add(BOOST_TEST_CASE(test_storage_destruction), 0, valgrind(1, 5));
+  storage->add(BOOST_TEST_CASE(test_storage_benchmark), 0, valgrind(5, 5));
 #if !defined ELLE_WINDOWS && !defined ELLE_ANDROID
   storage->add(BOOST_TEST_CASE(test_storage_multithread), 0, valgrind(3, 4));
 #endif
@@ -7,6 +7,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <elle/bench.hh>
 #include <elle/finally.hh>
 #include <elle/os/environ.hh>
 #include <elle/test.hh>
@@ -710,6 +711,176 @@ ELLE_TEST_SCHEDULED(shutdown_asynchronous_concurrent)
   };
 }
 
+/*-------------------.
+| Session resumption |
+`-------------------*/
+
+// Perform `count` handshakes with `server`, one connection at a time.
+static
+void
+handshakes(SSLServer& server,
+           std::shared_ptr<SSLCertificate> client,
+           int count)
+{
+  auto const port = std::to_string(server.port());
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+  {
+    scope.run_background(
+      "server",
+      [&]
+      {
+        for (int i = 0; i < count; ++i)
+          server.accept();
+      });
+    for (int i = 0; i < count; ++i)
+      SSLSocket("127.0.0.1", port, client);
+    elle::reactor::wait(scope);
+  };
+}
+
+ELLE_TEST_SCHEDULED(session_cache)
+{
+  auto certificate = load_certificate();
+  certificate->session_cache(16);
+  // Client side caching on the same context keeps server side resumption.
+  certificate->client_session_cache(4);
+  BOOST_TEST(
+    SSL_CTX_get_session_cache_mode(certificate->context().native_handle()) ==
+    SSL_SESS_CACHE_BOTH);
+  SSL_CTX_set_options(certificate->context().native_handle(),
+                      SSL_OP_NO_TICKET);
+  SSLServer server(std::move(certificate));
+  server.listen();
+  auto client = std::make_shared<SSLCertificate>();
+  client->client_session_cache(4);
+  handshakes(server, client, 3);
+  BOOST_TEST(server.handshakes() == 3);
+  BOOST_TEST(server.resumed_handshakes() == 2);
+  // Without a shared certificate, nothing is resumed.
+  handshakes(server, nullptr, 2);
+  BOOST_TEST(server.handshakes() == 5);
+  BOOST_TEST(server.resumed_handshakes() == 2);
+}
+
+ELLE_TEST_SCHEDULED(session_tickets)
+{
+  auto certificate = load_certificate();
+  certificate->session_tickets();
+  auto& tickets = *certificate;
+  SSLServer server(std::move(certificate));
+  server.listen();
+  auto client = std::make_shared<SSLCertificate>();
+  client->client_session_cache(4);
+  handshakes(server, client, 2);
+  BOOST_TEST(server.resumed_handshakes() == 1);
+  // Tickets issued under the previous key are accepted, and renewed.
+  tickets.rotate_session_ticket_key();
+  handshakes(server, client, 1);
+  BOOST_TEST(server.resumed_handshakes() == 2);
+  // Tickets issued under forgotten keys are not.
+  for (int i = 0; i < 3; ++i)
+    tickets.rotate_session_ticket_key();
+  handshakes(server, client, 1);
+  BOOST_TEST(server.resumed_handshakes() == 2);
+  BOOST_TEST(server.handshakes() == 4);
+}
+
+ELLE_TEST_SCHEDULED(background_handshake)
+{
+  elle::reactor::Barrier listening;
+  int port = 0;
+  elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+  {
+    scope.run_background(
+      "server",
+      [&]
+      {
+        SSLServer server(load_certificate());
+        server.background_handshake(true);
+        server.listen();
+        port = server.port();
+        listening.open();
+        auto socket = server.accept();
+        BOOST_TEST(socket->read(4).string() == "lulz");
+        socket->write(elle::ConstWeakBuffer("lol"));
+      });
+    scope.run_background(
+      "client",
+      [&]
+      {
+        elle::reactor::wait(listening);
+        SSLSocket socket("127.0.0.1", std::to_string(port));
+        socket.write(elle::ConstWeakBuffer("lulz"));
+        BOOST_TEST(socket.read(3).string() == "lol");
+      });
+    elle::reactor::wait(scope);
+  };
+}
+
+ELLE_TEST_SCHEDULED(background_handshake_timeout)
+{
+  SSLServer server(load_certificate(), valgrind(100ms));
+  server.background_handshake(true);
+  server.listen();
+  auto const port = std::to_string(server.port());
+  // A client that never speaks must not hold the server forever.
+  elle::reactor::network::TCPSocket mute("127.0.0.1", port);
+  elle::reactor::sleep(valgrind(500ms));
+  BOOST_TEST(server.handshakes() == 0);
+  handshakes(server, nullptr, 1);
+  BOOST_TEST(server.handshakes() == 1);
+}
+
+ELLE_TEST_SCHEDULED(background_handshake_mute_clients)
+{
+  SSLServer server(load_certificate());
+  server.background_handshake(true);
+  server.listen();
+  auto const port = std::to_string(server.port());
+  // More silent clients than the background pool has threads.
+  auto mute = std::vector<std::unique_ptr<elle::reactor::network::TCPSocket>>{};
+  for (int i = 0; i < 32; ++i)
+    mute.emplace_back(
+      std::make_unique<elle::reactor::network::TCPSocket>("127.0.0.1", port));
+  elle::reactor::sleep(valgrind(100ms));
+  // Waiting for them holds no background thread.
+  auto ran = false;
+  elle::reactor::background([&] { ran = true; });
+  BOOST_TEST(ran);
+  handshakes(server, nullptr, 1);
+  BOOST_TEST(server.handshakes() == 1);
+}
+
+// Full, resumed and background handshakes over loopback. Durations are
+// reported with ELLE_LOG_LEVEL="bench.ssl.*:TRACE".
+ELLE_TEST_SCHEDULED(handshake_rate)
+{
+  auto const count = 50;
+  auto bench = [&] (std::string const& name,
+                    bool resume,
+                    bool background)
+    {
+      auto certificate = load_certificate();
+      certificate->session_tickets();
+      SSLServer server(std::move(certificate));
+      server.background_handshake(background);
+      server.listen();
+      auto client = std::make_shared<SSLCertificate>();
+      if (resume)
+        client->client_session_cache(1);
+      {
+        auto b = elle::Bench<>("bench.ssl.handshake." + name);
+        auto s = b.scoped();
+        handshakes(server, client, count);
+      }
+      BOOST_TEST(server.handshakes() == count);
+      BOOST_TEST(server.resumed_handshakes() == (resume ? count - 1 : 0));
+    };
+  bench("full", false, false);
+  bench("resumed", true, false);
+  bench("background", false, true);
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
@@ -726,6 +897,13 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(shutdown_asynchronous_timeout), 0, valgrind(2));
   suite.add(BOOST_TEST_CASE(shutdown_asynchronous_concurrent), 0, valgrind(2));
   suite.add(BOOST_TEST_CASE(shutdown_timeout), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(session_cache), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(session_tickets), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(background_handshake), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(background_handshake_timeout), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(background_handshake_mute_clients), 0,
+            valgrind(10));
+  suite.add(BOOST_TEST_CASE(handshake_rate), 0, valgrind(10));
 
 }
 
@@ -2,12 +2,16 @@
 #include <list>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <elle/attribute.hh>
+#include <elle/bench.hh>
 #include <elle/filesystem/path.hh>
+#include <elle/print.hh>
 #include <elle/serialization/binary.hh>
 #include <elle/serialization/json.hh>
 #include <elle/serialization/json/Error.hh>
@@ -1703,6 +1707,175 @@ convert()
   }
 }
 
+namespace benchmark
+{
+  /// A small record, as found by the hundreds in messages.
+  struct Field
+  {
+    Field(int i)
+      : i(i)
+      , name("field " + std::to_string(i))
+      , ratio(i / 3.)
+      , flag(i % 2)
+    {}
+
+    Field(elle::serialization::SerializerIn& s)
+    {
+      this->serialize(s);
+    }
+
+    void
+    serialize(elle::serialization::Serializer& s)
+    {
+      s.serialize("i", this->i);
+      s.serialize("name", this->name);
+      s.serialize("ratio", this->ratio);
+      s.serialize("flag", this->flag);
+    }
+
+    int i;
+    std::string name;
+    double ratio;
+    bool flag;
+  };
+
+  struct serialization
+  {
+    static elle::Version version;
+    static std::unordered_map<
+      elle::Version, elle::serialization::Serializer::Versions> dependencies;
+  };
+  elle::Version serialization::version(0, 2, 0);
+  // Complete before first use: version tables are computed once.
+  std::unordered_map<elle::Version, elle::serialization::Serializer::Versions>
+    serialization::dependencies{
+    {
+      elle::Version(0, 2, 0),
+      {
+        {elle::type_info<Field>(), elle::Version(0, 1, 0)},
+        {elle::type_info<int>(), elle::Version(0, 1, 1)},
+        {elle::type_info<double>(), elle::Version(0, 1, 2)},
+        {elle::type_info<std::string>(), elle::Version(0, 1, 3)},
+        {elle::type_info<std::vector<int>>(), elle::Version(0, 1, 4)},
+        {elle::type_info<std::vector<std::string>>(), elle::Version(0, 1, 5)},
+      },
+    },
+  };
+
+  struct Small
+  {
+    using serialization_tag = benchmark::serialization;
+
+    Small(int i)
+      : i(i)
+    {}
+
+    Small(elle::serialization::SerializerIn& s, elle::Version const& v)
+    {
+      this->serialize(s, v);
+    }
+
+    void
+    serialize(elle::serialization::Serializer& s, elle::Version const&)
+    {
+      s.serialize("i", this->i);
+    }
+
+    int i;
+  };
+
+  template <typename Format>
+  char const*
+  name()
+  {
+    return std::is_same<Format, elle::serialization::Json>::value ?
+      "json" : "binary";
+  }
+}
+
+/// Messages made of many small fields, where per-field bookkeeping dominates.
+template <typename Format>
+static
+void
+benchmark_fields()
+{
+  using benchmark::Field;
+  auto const count = RUNNING_ON_VALGRIND ? 10 : 100;
+  auto fields = std::vector<Field>{};
+  for (int i = 0; i < 200; ++i)
+    fields.emplace_back(i);
+  auto const serialized =
+    elle::serialization::serialize<Format>(fields, false);
+  auto serialize = elle::Bench<>(
+    elle::print("bench.serialization.{}.fields.serialize",
+                benchmark::name<Format>()));
+  auto deserialize = elle::Bench<>(
+    elle::print("bench.serialization.{}.fields.deserialize",
+                benchmark::name<Format>()));
+  for (int i = 0; i < count; ++i)
+  {
+    {
+      auto const s = serialize.scoped();
+      elle::serialization::serialize<Format>(fields, false);
+    }
+    {
+      auto const s = deserialize.scoped();
+      elle::serialization::deserialize<Format, std::vector<Field>>(
+        serialized, false);
+    }
+  }
+  auto const res =
+    elle::serialization::deserialize<Format, std::vector<Field>>(
+      serialized, false);
+  BOOST_TEST(res.size() == fields.size());
+  BOOST_TEST(res.back().name == "field 199");
+}
+
+/// Versioned messages, whose dependency versions are looked up every time.
+template <typename Format>
+static
+void
+benchmark_versioned()
+{
+  using benchmark::Small;
+  using elle::type_info;
+  auto const count = RUNNING_ON_VALGRIND ? 100 : 10000;
+  auto const version = elle::Version(0, 2, 0);
+  // Dependency versions are computed once and shared.
+  BOOST_TEST(
+    elle::serialization::get_serialization_versions<
+      benchmark::serialization>(version) ==
+    elle::serialization::get_serialization_versions<
+      benchmark::serialization>(version));
+  BOOST_TEST(
+    elle::serialization::get_serialization_versions<
+      benchmark::serialization>(version)->at(type_info<double>()) ==
+    elle::Version(0, 1, 2));
+  auto const serialized =
+    elle::serialization::serialize<Format>(Small(42), version, false);
+  auto serialize = elle::Bench<>(
+    elle::print("bench.serialization.{}.versioned.serialize",
+                benchmark::name<Format>()));
+  auto deserialize = elle::Bench<>(
+    elle::print("bench.serialization.{}.versioned.deserialize",
+                benchmark::name<Format>()));
+  for (int i = 0; i < count; ++i)
+  {
+    {
+      auto const s = serialize.scoped();
+      elle::serialization::serialize<Format>(Small(42), version, false);
+    }
+    {
+      auto const s = deserialize.scoped();
+      elle::serialization::deserialize<Format, Small>(
+        serialized, version, false);
+    }
+  }
+  auto const res = elle::serialization::deserialize<Format, Small>(
+    serialized, version, false);
+  BOOST_TEST(res.i == 42);
+}
+
 #define FOR_ALL_SERIALIZATION_TYPES(Name)                               \
   {                                                                     \
     boost::unit_test::test_suite* subsuite = BOOST_TEST_SUITE(#Name);   \
@@ -1778,4 +1951,11 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(json_iso8601));
   suite.add(BOOST_TEST_CASE(json_unicode_surrogate));
   suite.add(BOOST_TEST_CASE(json_optionals));
+  {
+    auto subsuite = BOOST_TEST_SUITE("benchmark");
+    master.add(subsuite);
+    auto& suite = *subsuite;
+    FOR_ALL_SERIALIZATION_TYPES(benchmark_fields);
+    FOR_ALL_SERIALIZATION_TYPES(benchmark_versioned);
+  }
 }
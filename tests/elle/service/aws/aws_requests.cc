@@ -1,5 +1,15 @@
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <sstream>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
 #include <elle/Duration.hh>
+#include <elle/bench.hh>
 #include <elle/cryptography/hash.hh>
+#include <elle/err.hh>
 #include <elle/format/hexadecimal.hh>
 #include <elle/json/json.hh>
 #include <elle/service/aws/CanonicalRequest.hh>
@@ -11,6 +21,8 @@
 #include <elle/service/aws/StringToSign.hh>
 #include <elle/test.hh>
 
+#include <elle/reactor/network/Error.hh>
+#include <elle/reactor/network/http-server.hh>
 #include <elle/reactor/scheduler.hh>
 #include <elle/reactor/Thread.hh>
 
@@ -166,6 +178,433 @@ ELLE_TEST_SCHEDULED(sign_request)
     "c9d1c4e90e9f0b65ae4020a33bada35341ee2f8188c70b2a976e6e767414ed1f");
 }
 
+ELLE_TEST_SCHEDULED(signing_key_cache)
+{
+  using namespace date;
+  auto const secret = std::string("wJalrXUtnFEMI/K7MDENG+bPxRfiCYEXAMPLEKEY");
+  auto const morning = elle::Time(sys_days(2012_y/feb/15)) + 8h;
+  auto cache = elle::service::aws::SigningKeyCache{};
+  auto key = [&] (elle::Time time, std::string const& region)
+    {
+      return cache(secret, time, region, elle::service::aws::Service::s3)
+        .key();
+    };
+  auto const expected = elle::service::aws::SigningKey(
+    secret, morning, "us-east-1", elle::service::aws::Service::s3).key();
+  BOOST_TEST(key(morning, "us-east-1") == expected);
+  BOOST_TEST(key(morning + 8h, "us-east-1") == expected);
+  BOOST_TEST(cache.derivations() == 1);
+  BOOST_TEST(key(morning, "eu-west-1") != expected);
+  BOOST_TEST(cache.derivations() == 2);
+  // Next day.
+  BOOST_TEST(key(morning + 24h, "us-east-1") != expected);
+  BOOST_TEST(cache.derivations() == 3);
+}
+
+/*-----------------.
+| Local S3 server |
+`-----------------*/
+
+namespace
+{
+  /// A minimal S3 stand-in: plain and multipart uploads, and ranged GETs.
+  ///
+  /// Signatures are not checked. An optional latency is added to every
+  /// request to model the round trip to the actual service.
+  class S3Server
+    : public elle::reactor::network::HttpServer
+  {
+  public:
+    S3Server(elle::reactor::Duration latency = 0s)
+      : _latency(latency)
+      , _uploads()
+      , _upload_id(0)
+    {}
+
+    ~S3Server() override
+    {
+      this->_finalize();
+    }
+
+    elle::service::aws::Credentials
+    credentials()
+    {
+      return elle::service::aws::Credentials(
+        "access", "secret", "us-east-1", "bucket", "folder",
+        elle::print("http://127.0.0.1:%s", this->port()));
+    }
+
+    std::string const&
+    object(std::string const& name)
+    {
+      return this->objects.at("/bucket/folder/" + name);
+    }
+
+    /// Multipart uploads neither completed nor aborted.
+    std::size_t
+    pending_uploads() const
+    {
+      return this->_uploads.size();
+    }
+
+    std::unordered_map<std::string, std::string> objects;
+    int requests = 0;
+    /// Headers of the last request, lower-cased.
+    std::unordered_map<std::string, std::string> last_headers;
+    /// Called before answering every GET.
+    std::function<void ()> on_get;
+
+  protected:
+    void
+    _serve(std::unique_ptr<elle::reactor::network::Socket> socket) override
+    {
+      try
+      {
+        while (true)
+          this->_serve_one(*socket);
+      }
+      catch (elle::reactor::network::ConnectionClosed const&)
+      {}
+    }
+
+  private:
+    using Headers = std::unordered_map<std::string, std::string>;
+
+    std::string
+    _line(elle::reactor::network::Socket& socket)
+    {
+      auto line = socket.read_until("\r\n").string();
+      return line.substr(0, line.size() - 2);
+    }
+
+    void
+    _serve_one(elle::reactor::network::Socket& socket)
+    {
+      auto method = std::string{};
+      auto target = std::string{};
+      std::stringstream(this->_line(socket)) >> method >> target;
+      auto headers = Headers{};
+      for (auto line = this->_line(socket); !line.empty();
+           line = this->_line(socket))
+      {
+        auto const colon = line.find(':');
+        headers[boost::to_lower_copy(line.substr(0, colon))] =
+          boost::trim_copy(line.substr(colon + 1));
+      }
+      if (headers["expect"] == "100-continue")
+        socket.write("HTTP/1.1 100 Continue\r\n\r\n");
+      auto body = std::string(
+        boost::lexical_cast<std::size_t>(headers["content-length"]), 0);
+      if (!body.empty())
+        socket.read(elle::WeakBuffer(&body[0], body.size()));
+      auto const question = target.find('?');
+      auto const path = target.substr(0, question);
+      auto query = Headers{};
+      if (question != std::string::npos)
+      {
+        auto const query_string = target.substr(question + 1);
+        auto parameters = std::vector<std::string>{};
+        boost::split(parameters, query_string, boost::is_any_of("&"));
+        for (auto const& parameter: parameters)
+        {
+          auto const equal = parameter.find('=');
+          query[parameter.substr(0, equal)] =
+            equal == std::string::npos ? "" : parameter.substr(equal + 1);
+        }
+      }
+      ++this->requests;
+      this->last_headers = headers;
+      if (this->_latency != 0s)
+        elle::reactor::sleep(this->_latency);
+      auto reply = [&] (int code, std::string const& content,
+                        Headers const& extra = {})
+        {
+          auto answer = elle::print(
+            "HTTP/1.1 %s Stand-in\r\nContent-Length: %s\r\n",
+            code, content.size());
+          for (auto const& header: extra)
+            answer += elle::print("%s: %s\r\n", header.first, header.second);
+          answer += "\r\n" + content;
+          socket.write(answer);
+        };
+      if (method == "POST" && query.count("uploads"))
+      {
+        auto const id = std::to_string(++this->_upload_id);
+        this->_uploads[id];
+        reply(200, elle::print(
+                "<InitiateMultipartUploadResult><UploadId>%s</UploadId>"
+                "</InitiateMultipartUploadResult>", id));
+      }
+      else if (method == "PUT" && query.count("partNumber"))
+      {
+        auto const part = std::stoi(query["partNumber"]);
+        this->_uploads.at(query["uploadId"])[part] = std::move(body);
+        reply(200, "", {{"ETag", elle::print("\"part-%s\"", part)}});
+      }
+      else if (method == "POST" && query.count("uploadId"))
+      {
+        auto& object = this->objects[path];
+        object.clear();
+        for (auto const& part: this->_uploads.at(query["uploadId"]))
+          object += part.second;
+        this->_uploads.erase(query["uploadId"]);
+        reply(200, "<CompleteMultipartUploadResult>"
+                   "</CompleteMultipartUploadResult>");
+      }
+      else if (method == "DELETE" && query.count("uploadId"))
+      {
+        this->_uploads.erase(query["uploadId"]);
+        reply(204, "");
+      }
+      else if (method == "PUT")
+      {
+        this->objects[path] = std::move(body);
+        reply(200, "");
+      }
+      else if (method == "GET" && this->objects.count(path))
+      {
+        if (this->on_get)
+          this->on_get();
+        auto const& object = this->objects.at(path);
+        // Like those of multipart uploads, so that it is not checked against
+        // the MD5 of the content.
+        auto const etag = elle::print(
+          "\"%s-1\"", std::hash<std::string>()(object));
+        auto const range = headers.find("range");
+        auto const match = headers.find("if-match");
+        if (match != headers.end() && match->second != etag)
+          reply(412, "");
+        else if (range == headers.end())
+          reply(200, object);
+        else
+        {
+          // bytes=<first>-<last>
+          auto const dash = range->second.find('-');
+          auto const first = std::stoul(range->second.substr(6, dash - 6));
+          if (first >= object.size())
+          {
+            reply(416, "", {{"Content-Range",
+                             elle::print("bytes */%s", object.size())}});
+            return;
+          }
+          auto const last = std::min<std::size_t>(
+            std::stoul(range->second.substr(dash + 1)), object.size() - 1);
+          reply(206, object.substr(first, last - first + 1),
+                {{"Content-Range",
+                  elle::print("bytes %s-%s/%s", first, last, object.size())},
+                 {"ETag", etag}});
+        }
+      }
+      else
+        reply(404, "");
+    }
+
+    elle::reactor::Duration _latency;
+    std::unordered_map<std::string, std::map<int, std::string>> _uploads;
+    int _upload_id;
+  };
+
+  /// A stream buffer failing after a given number of bytes.
+  class FailingBuffer
+    : public std::streambuf
+  {
+  public:
+    FailingBuffer(std::string data, std::size_t fail_at)
+      : _data(std::move(data))
+      , _fail_at(fail_at)
+    {
+      this->setg(&this->_data[0], &this->_data[0], &this->_data[fail_at]);
+    }
+
+  protected:
+    int_type
+    underflow() override
+    {
+      elle::err("read failure at %s", this->_fail_at);
+    }
+
+  private:
+    std::string _data;
+    std::size_t _fail_at;
+  };
+
+  std::string
+  payload(int size)
+  {
+    auto res = std::string(size, 0);
+    for (int i = 0; i < size; ++i)
+      res[i] = 'a' + (i * 7) % 26;
+    return res;
+  }
+}
+
+ELLE_TEST_SCHEDULED(upload_stream)
+{
+  auto server = S3Server{};
+  auto s3 = elle::service::aws::S3(server.credentials());
+  // Several parts, the last one being partial.
+  auto const data = payload(10 * 1000 + 123);
+  auto input = std::stringstream(data);
+  BOOST_TEST(s3.upload_stream(input, "object", 3, 1000) == data.size());
+  BOOST_CHECK(server.object("object") == data);
+  // initialize + 11 parts + finalize.
+  BOOST_TEST(server.requests == 13);
+  // An empty stream still makes an object.
+  auto empty = std::stringstream();
+  BOOST_TEST(s3.upload_stream(empty, "empty", 3, 1000) == 0u);
+  BOOST_TEST(server.object("empty") == "");
+  BOOST_TEST(server.pending_uploads() == 0u);
+}
+
+ELLE_TEST_SCHEDULED(upload_stream_abort)
+{
+  auto server = S3Server{};
+  auto s3 = elle::service::aws::S3(server.credentials());
+  auto const data = payload(10 * 1000);
+  // A cancelled upload.
+  {
+    auto input = std::stringstream(data);
+    auto thread = elle::reactor::Thread(
+      "upload",
+      [&]
+      {
+        s3.upload_stream(input, "object", 1, 1000);
+      });
+    while (server.requests < 3)
+      elle::reactor::yield();
+    thread.terminate_now();
+    BOOST_TEST(server.pending_uploads() == 0u);
+    BOOST_CHECK(!server.objects.count("/bucket/folder/object"));
+  }
+  // A stream failing after a few parts.
+  {
+    auto buffer = FailingBuffer(data, 2500);
+    auto input = std::istream(&buffer);
+    input.exceptions(std::ios::badbit);
+    BOOST_CHECK_THROW(s3.upload_stream(input, "object", 3, 1000),
+                      std::exception);
+    BOOST_TEST(server.pending_uploads() == 0u);
+  }
+}
+
+ELLE_TEST_SCHEDULED(download_to)
+{
+  auto server = S3Server{};
+  auto s3 = elle::service::aws::S3(server.credentials());
+  auto const data = payload(10 * 1000 + 123);
+  s3.put_object(elle::ConstWeakBuffer(data), "object");
+  for (auto parallelism: {1, 4})
+  {
+    server.requests = 0;
+    auto output = std::stringstream();
+    BOOST_TEST(s3.download_to("object", output, parallelism, 1000) ==
+               data.size());
+    BOOST_CHECK(output.str() == data);
+    BOOST_TEST(server.requests == 11);
+    BOOST_TEST(server.last_headers.count("if-match") == 1u);
+  }
+  // Smaller than a part.
+  auto output = std::stringstream();
+  BOOST_TEST(s3.download_to("object", output, 4, 100000) == data.size());
+  BOOST_CHECK(output.str() == data);
+  BOOST_CHECK_THROW(s3.download_to("missing", output),
+                    elle::service::aws::AWSException);
+  // S3 refuses any range of an empty object.
+  s3.put_object(elle::ConstWeakBuffer(), "empty");
+  output.str("");
+  BOOST_TEST(s3.download_to("empty", output, 4, 1000) == 0u);
+  BOOST_TEST(output.str() == "");
+}
+
+ELLE_TEST_SCHEDULED(download_overwritten)
+{
+  auto server = S3Server{};
+  auto s3 = elle::service::aws::S3(server.credentials());
+  auto const data = payload(10 * 1000);
+  s3.put_object(elle::ConstWeakBuffer(data), "object");
+  auto gets = 0;
+  server.on_get = [&]
+    {
+      if (++gets == 3)
+        server.objects.at("/bucket/folder/object") = payload(20 * 1000);
+    };
+  // Parts of the new version must not follow those of the old one.
+  auto output = std::stringstream();
+  BOOST_CHECK_THROW(s3.download_to("object", output, 1, 1000), elle::Error);
+  BOOST_TEST(gets == 3);
+}
+
+ELLE_TEST_SCHEDULED(content_md5)
+{
+  auto server = S3Server{};
+  auto s3 = elle::service::aws::S3(server.credentials());
+  auto const data = payload(1000);
+  auto const sha256 = std::string(
+    "4256460c8769ec1a1d2a8e3edeeda0d3cc4fbc30b3c0f6a2b53da3ef9f60ea5e");
+  for (auto unsigned_payload: {false, true})
+  {
+    s3.unsigned_payload(unsigned_payload);
+    s3.put_object(elle::ConstWeakBuffer(data), "object");
+    auto const& headers = server.last_headers;
+    BOOST_TEST(headers.at("content-md5") == "9QiqSJEypJhQQgRd/uPMKg==");
+    BOOST_TEST(headers.at("x-amz-content-sha256") ==
+               (unsigned_payload ? "UNSIGNED-PAYLOAD" : sha256));
+  }
+}
+
+// CPU time per 4 MiB PUT, with signed and unsigned payloads.
+ELLE_TEST_SCHEDULED(put_cpu)
+{
+  auto server = S3Server{};
+  auto s3 = elle::service::aws::S3(server.credentials());
+  auto const data = payload(4 * 1024 * 1024);
+  auto const count = 10;
+  for (auto unsigned_payload: {false, true})
+  {
+    s3.unsigned_payload(unsigned_payload);
+    // The stand-in server shares the process, its CPU time is included.
+    auto bench = elle::Bench<>(elle::print(
+      "bench.aws.s3.put_cpu.{}", unsigned_payload ? "unsigned" : "signed"));
+    for (int i = 0; i < count; ++i)
+    {
+      auto const start = std::clock();
+      s3.put_object(elle::ConstWeakBuffer(data), "object");
+      bench.add(std::chrono::duration_cast<elle::Duration>(
+                  std::chrono::duration<double>(
+                    double(std::clock() - start) / CLOCKS_PER_SEC)));
+    }
+    BOOST_CHECK(server.object("object") == data);
+  }
+}
+
+// Transfer rate depending on the number of parts in flight, against a server
+// with a 20ms round trip.
+ELLE_TEST_SCHEDULED(transfer_rate)
+{
+  auto server = S3Server{20ms};
+  auto s3 = elle::service::aws::S3(server.credentials());
+  auto const data = payload(16 * 1024 * 1024);
+  auto const part_size = 512 * 1024;
+  for (auto parallelism: {1, 4, 16})
+  {
+    auto upload = elle::Bench<>(
+      elle::print("bench.aws.s3.upload_stream.{}", parallelism));
+    auto download = elle::Bench<>(
+      elle::print("bench.aws.s3.download_to.{}", parallelism));
+    {
+      auto const s = upload.scoped();
+      auto input = std::stringstream(data);
+      s3.upload_stream(input, "object", parallelism, part_size);
+    }
+    auto output = std::stringstream();
+    {
+      auto const s = download.scoped();
+      s3.download_to("object", output, parallelism, part_size);
+    }
+    BOOST_CHECK(output.str() == data);
+  }
+}
+
 // // Should only be run manually with generated crendentials.
 // ELLE_TEST_SCHEDULED(s3_put)
 // {
@@ -221,6 +660,14 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(string_to_sign), 0, timeout);
   suite.add(BOOST_TEST_CASE(signing_key), 0, timeout);
   suite.add(BOOST_TEST_CASE(sign_request), 0, timeout);
+  suite.add(BOOST_TEST_CASE(signing_key_cache), 0, timeout);
+  suite.add(BOOST_TEST_CASE(upload_stream), 0, timeout);
+  suite.add(BOOST_TEST_CASE(upload_stream_abort), 0, timeout);
+  suite.add(BOOST_TEST_CASE(download_to), 0, timeout);
+  suite.add(BOOST_TEST_CASE(download_overwritten), 0, timeout);
+  suite.add(BOOST_TEST_CASE(content_md5), 0, timeout);
+  suite.add(BOOST_TEST_CASE(put_cpu), 0, timeout * 10);
+  suite.add(BOOST_TEST_CASE(transfer_rate), 0, timeout * 10);
 
   // Should only be run manually with generated crendentials.
   // suite.add(BOOST_TEST_CASE(s3_put), 0, timeout * 3);
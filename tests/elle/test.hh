@@ -328,6 +328,51 @@ operator delete(void* p) noexcept
 
 #endif
 
+/*------------.
+| Allocations |
+`------------*/
+
+// Define ELLE_TEST_COUNT_ALLOCATIONS before including this header to count
+// calls to malloc and realloc in `allocations`.  Only available with glibc,
+// in which case ELLE_TEST_ALLOCATIONS is defined.
+#if defined ELLE_TEST_COUNT_ALLOCATIONS && defined __GLIBC__
+
+# include <atomic>
+
+# define ELLE_TEST_ALLOCATIONS 1
+
+extern "C"
+{
+  void*
+  __libc_malloc(std::size_t size) noexcept;
+  void*
+  __libc_realloc(void* p, std::size_t size) noexcept;
+}
+
+namespace
+{
+  /// Number of calls to malloc and realloc so far.
+  std::atomic<std::size_t> allocations(0);
+}
+
+extern "C"
+void*
+malloc(std::size_t size) noexcept
+{
+  ++allocations;
+  return __libc_malloc(size);
+}
+
+extern "C"
+void*
+realloc(void* p, std::size_t size) noexcept
+{
+  ++allocations;
+  return __libc_realloc(p, size);
+}
+
+#endif
+
 #ifdef __arm__
 # define ARM_FACTOR 1
 #else